@@ -26,92 +26,465 @@ distribution.
 
 #include "tinyxml.h"
 
+#include <cctype>
+#include <cstring>
+#include <typeinfo>
 #include <sstream>
 #include <iostream>
 #include <fstream>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <algorithm>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#	define TIXML_SSE2 1
+#	include <emmintrin.h>
+#	if defined( _MSC_VER )
+#		include <intrin.h>
+#	endif
+#else
+#	define TIXML_SSE2 0
+#endif
 using namespace std;
 
 bool TiXmlBase::condenseWhiteSpace = true;
 
-void TiXmlBase::EncodeString( const std::string& str, std::string* outString )
+
+const char* TiXmlBase::SkipSpace( const char* p, const char* end )
 {
-	int i=0;
+	// XML's white space only: isspace() would depend on the locale.
+	while ( p < end && ( *p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' ) )
+		++p;
+	return p;
+}
 
-	while( i<(int)str.length() )
+
+int TiXmlBase::ReadBool( std::string_view str, bool* value )
+{
+	const char* end = str.data() + str.size();
+	const char* p = SkipSpace( str.data(), end );
+	while ( end > p && ( end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\n' || end[-1] == '\r' ) )
+		--end;
+
+	static const std::string_view words[] = { "true", "yes", "1", "false", "no", "0" };
+	for( int i=0; i<6; ++i )
 	{
-		unsigned char c = (unsigned char) str[i];
+		const std::string_view word = words[i];
+		if ( (size_t) ( end - p ) != word.size() )
+			continue;
+		size_t k = 0;
+		while ( k < word.size() && tolower( (unsigned char) p[k] ) == word[k] )
+			++k;
+		if ( k == word.size() )
+		{
+			*value = ( i < 3 );
+			return TIXML_SUCCESS;
+		}
+	}
+	return TIXML_WRONG_TYPE;
+}
+
 
-		if (    c == '&' 
-		     && i < ( (int)str.length() - 2 )
-			 && str[i+1] == '#'
-			 && str[i+2] == 'x' )
+/*	The optional index of the children of a node. See TiXmlNode::EnableChildIndex().
+	Children are grouped by value, so the n-th child (or child element) with a given
+	name is a vector lookup, and each child knows its place in its group so the
+	named sibling functions are a single step.
+*/
+class TiXmlChildIndex
+{
+public:
+	struct Group
+	{
+		std::vector< const TiXmlNode* > nodes;			// children with this value, in order
+		std::vector< const TiXmlElement* > elements;	// the elements of 'nodes', in order
+	};
+	struct Position
+	{
+		int child;		// position in 'children'
+		int node;		// position in Group::nodes
+		int element;	// position in Group::elements, or -1 for non-elements
+	};
+
+	TiXmlChildIndex() : stale( true ) {}
+
+	void Rebuild( const TiXmlNode* parent )
+	{
+		children.clear();
+		elements.clear();
+		groups.clear();
+		names.clear();
+		positions.clear();
+		for( const TiXmlNode* node = parent->FirstChild(); node; node = node->NextSibling() )
+			Append( node );
+		stale.store( false, std::memory_order_release );
+	}
+
+	void Append( const TiXmlNode* node )
+	{
+		Groups::iterator it = groups.find( node->ValueStr() );
+		if ( it == groups.end() )
 		{
-			// Hexadecimal character reference.
-			// Pass through unchanged.
-			// &#xA9;	-- copyright symbol, for example.
-			//
-			// The -1 is a bug fix from Rob Laveaux. It keeps
-			// an overflow from happening if there is no ';'.
-			// There are actually 2 ways to exit this loop -
-			// while fails (error case) and break (semicolon found).
-			// However, there is no mechanism (currently) for
-			// this function to return an error.
-			while ( i<(int)str.length()-1 )
-			{
-				outString->append( str.c_str() + i, 1 );
-				++i;
-				if ( str[i] == ';' )
-					break;
-			}
+			names.push_back( node->ValueStr() );
+			it = groups.emplace( names.back(), Group() ).first;
 		}
-		else if ( c == '&' )
+		Group& group = it->second;
+		Position pos = { (int)children.size(), (int)group.nodes.size(), -1 };
+
+		children.push_back( node );
+		group.nodes.push_back( node );
+		if ( node->ToElement() )
 		{
-			outString->append( entity[0].str, entity[0].strLength );
-			++i;
+			pos.element = (int)group.elements.size();
+			elements.push_back( node->ToElement() );
+			group.elements.push_back( node->ToElement() );
 		}
-		else if ( c == '<' )
+		positions[ node ] = pos;
+	}
+
+	// A lookup by a view of 'value' makes no string of it.
+	const Group* Find( std::string_view value ) const
+	{
+		Groups::const_iterator it = groups.find( value );
+		return ( it == groups.end() ) ? 0 : &it->second;
+	}
+
+	const Position& PositionOf( const TiXmlNode* node ) const
+	{
+		std::unordered_map< const TiXmlNode*, Position >::const_iterator it = positions.find( node );
+		assert( it != positions.end() );
+		return it->second;
+	}
+
+	// The first of 'nodes' that comes after 'child' in document order.
+	template< typename T >
+	const T* After( const std::vector< const T* >& nodes, const TiXmlNode* child ) const
+	{
+		int limit = PositionOf( child ).child;
+		int low = 0, high = (int)nodes.size();
+		while ( low < high )
 		{
-			outString->append( entity[1].str, entity[1].strLength );
-			++i;
+			int mid = ( low + high ) / 2;
+			if ( PositionOf( nodes[mid] ).child <= limit )
+				low = mid + 1;
+			else
+				high = mid;
 		}
-		else if ( c == '>' )
+		return ( low < (int)nodes.size() ) ? nodes[low] : 0;
+	}
+
+	std::vector< const TiXmlNode* > children;
+	std::vector< const TiXmlElement* > elements;
+	typedef std::unordered_map< std::string_view, Group > Groups;
+	Groups groups;					// keyed by views of 'names'
+	std::deque< std::string > names;	// never moved, so the keys stay good
+	std::unordered_map< const TiXmlNode*, Position > positions;
+	// Children changed in a way Append() can't track. Set only by a
+	// writer; readers that find it set rebuild under 'rebuilding'.
+	std::atomic< bool > stale;
+	std::mutex rebuilding;
+};
+
+
+namespace {
+
+// How many documents have an element or text index. While there are
+// none, changes to the tree don't go looking for their document.
+std::atomic< int > indexedDocuments( 0 );
+
+// Calls f( element ) for 'top', if it is an element, and every element below, in document order.
+template< typename F > void ForEachElement( const TiXmlNode* top, F f )
+{
+	const TiXmlNode* node = top;
+	while ( node )
+	{
+		if ( node->Type() == TiXmlNode::TINYXML_ELEMENT )
+			f( static_cast< const TiXmlElement* >( node ) );
+		if ( node->FirstChild() )
 		{
-			outString->append( entity[2].str, entity[2].strLength );
-			++i;
+			node = node->FirstChild();
+			continue;
 		}
-		else if ( c == '\"' )
+		while ( node != top && !node->NextSibling() )
+			node = node->Parent();
+		if ( node == top )
+			return;
+		node = node->NextSibling();
+	}
+}
+
+} // namespace
+
+
+/*	The optional index of the elements of a document. See
+	TiXmlDocument::EnableElementIndex(). Each element gets a number that
+	grows in document order, so the lists, which are kept in that order,
+	can be searched and changed in place.
+*/
+class TiXmlElementIndex
+{
+public:
+	typedef std::vector< const TiXmlElement* > List;
+	typedef std::unordered_map< std::string, List > Lists;
+
+	TiXmlElementIndex() : next( 0 ), stale( true )	{}
+
+	void Rebuild( const TiXmlDocument* document )
+	{
+		order.clear();
+		names.clear();
+		for( auto& values : attributes )
+			values.second.clear();
+		next = 0;
+		ForEachElement( document, [this]( const TiXmlElement* element ) { Append( element ); } );
+		stale = false;
+	}
+
+	// 'element' comes after every element indexed so far.
+	void Append( const TiXmlElement* element )
+	{
+		order[ element ] = next++;
+		names[ element->ValueStr() ].push_back( element );
+		if ( attributes.empty() )
+			return;
+		for( const TiXmlAttribute* attrib = element->FirstAttribute(); attrib; attrib = attrib->Next() )
 		{
-			outString->append( entity[3].str, entity[3].strLength );
-			++i;
+			std::unordered_map< std::string, Lists >::iterator values = attributes.find( attrib->NameTStr() );
+			if ( values != attributes.end() )
+				values->second[ attrib->ValueStr() ].push_back( element );
 		}
-		else if ( c == '\'' )
+	}
+
+	// 'node' was just linked in at the end of the document.
+	void Added( const TiXmlNode* node )
+	{
+		if ( !stale )
+			ForEachElement( node, [this]( const TiXmlElement* element ) { Append( element ); } );
+	}
+
+	// 'node' is about to leave the document.
+	void Removing( const TiXmlNode* node )
+	{
+		if ( stale )
+			return;
+		// Each removal shifts a list along, so following a large one
+		// costs more than building the index again.
+		int count = 0;
+		ForEachElement( node, [&count]( const TiXmlElement* ) { ++count; } );
+		if ( count > 64 )
 		{
-			outString->append( entity[4].str, entity[4].strLength );
-			++i;
+			stale = true;
+			return;
 		}
-		else if ( c < 32 )
+		ForEachElement( node, [this]( const TiXmlElement* element ) {
+			if ( order.find( element ) == order.end() )
+				return;
+			Erase( &names, element->ValueStr(), element );
+			for( const TiXmlAttribute* attrib = element->FirstAttribute(); attrib; attrib = attrib->Next() )
+				Unindex( element, attrib );
+			order.erase( element );
+		} );
+	}
+
+	// Around a change to the name of 'element'.
+	void Unname( const TiXmlElement* element )
+	{
+		if ( !stale )
+			Erase( &names, element->ValueStr(), element );
+	}
+	void Name( const TiXmlElement* element )
+	{
+		if ( !stale )
+			Insert( &names, element->ValueStr(), element );
+	}
+
+	// Takes 'attrib' of 'element' out of the index, or puts it in, if its name is indexed.
+	void Unindex( const TiXmlElement* element, const TiXmlAttribute* attrib )
+	{
+		std::unordered_map< std::string, Lists >::iterator values = attributes.find( attrib->NameTStr() );
+		if ( values != attributes.end() )
+			Erase( &values->second, attrib->ValueStr(), element );
+	}
+	void Index( const TiXmlElement* element, const TiXmlAttribute* attrib )
+	{
+		std::unordered_map< std::string, Lists >::iterator values = attributes.find( attrib->NameTStr() );
+		if ( values != attributes.end() )
+			Insert( &values->second, attrib->ValueStr(), element );
+	}
+
+	// Keep the lists in document order, and drop the ones that empty.
+	void Insert( Lists* lists, const std::string& key, const TiXmlElement* element )
+	{
+		std::unordered_map< const TiXmlElement*, unsigned long long >::const_iterator it = order.find( element );
+		if ( it == order.end() )
+			return;
+		List& list = (*lists)[ key ];
+		list.insert( LowerBound( list, it->second ), element );
+	}
+	void Erase( Lists* lists, const std::string& key, const TiXmlElement* element )
+	{
+		Lists::iterator list = lists->find( key );
+		std::unordered_map< const TiXmlElement*, unsigned long long >::const_iterator it = order.find( element );
+		if ( list == lists->end() || it == order.end() )
+			return;
+		List::iterator pos = LowerBound( list->second, it->second );
+		if ( pos != list->second.end() && *pos == element )
+			list->second.erase( pos );
+		if ( list->second.empty() )
+			lists->erase( list );
+	}
+	List::iterator LowerBound( List& list, unsigned long long position ) const
+	{
+		return std::lower_bound( list.begin(), list.end(), position, [this]( const TiXmlElement* e, unsigned long long p ) {
+			return order.find( e )->second < p;
+		} );
+	}
+
+	std::unordered_map< const TiXmlElement*, unsigned long long > order;
+	Lists names;
+	std::unordered_map< std::string, Lists > attributes;	// the indexed names, then the values
+	unsigned long long next;
+	bool stale;		// the document changed in a way the index can't follow
+};
+
+
+namespace {
+
+// What each byte becomes when escaped; length 0 for bytes that are
+// written as they are. Built at compile time from the same entities the
+// parser reads, plus character references for the control characters.
+struct TiXmlEscape
+{
+	unsigned char length;
+	char text[7];
+};
+
+struct TiXmlEscapeTable
+{
+	TiXmlEscape escape[256];
+};
+
+constexpr TiXmlEscapeTable MakeEscapeTable()
+{
+	TiXmlEscapeTable table = {};
+	const char hex[] = "0123456789ABCDEF";
+	for( int c=0; c<32; ++c )
+	{
+		// &#xHH;
+		TiXmlEscape& e = table.escape[c];
+		e.length = 6;
+		e.text[0] = '&'; e.text[1] = '#'; e.text[2] = 'x';
+		e.text[3] = hex[ c >> 4 ]; e.text[4] = hex[ c & 15 ]; e.text[5] = ';';
+	}
+	const char* entities[] = { "&amp;", "&lt;", "&gt;", "&quot;", "&apos;" };
+	const char chars[] = { '&', '<', '>', '\"', '\'' };
+	for( int i=0; i<5; ++i )
+	{
+		TiXmlEscape& e = table.escape[ (unsigned char) chars[i] ];
+		for( const char* p = entities[i]; *p; ++p )
+			e.text[ e.length++ ] = *p;
+	}
+	return table;
+}
+
+constexpr TiXmlEscapeTable escapeTable = MakeEscapeTable();
+
+
+inline bool NeedsEscape( unsigned char c, TiXmlEscapeMode mode )
+{
+	return escapeTable.escape[c].length && ( mode == TIXML_ESCAPE_ATTRIBUTE || ( c != '\"' && c != '\'' ) );
+}
+
+
+#if TIXML_SSE2
+inline int LowestBit( unsigned mask )
+{
+#	if defined( _MSC_VER )
+	unsigned long index;
+	_BitScanForward( &index, mask );
+	return (int) index;
+#	else
+	return __builtin_ctz( mask );
+#	endif
+}
+#endif
+
+
+// The first byte in [p, end) that needs escaping, or end.
+const char* FindEscape( const char* p, const char* end, TiXmlEscapeMode mode )
+{
+#if TIXML_SSE2
+	// 16 bytes at a time: compare against each special character, and
+	// against 0x1f for the control characters (x <= 0x1f when min(x, 0x1f) == x).
+	// In text mode the quote comparisons look for '&' again, which costs
+	// nothing and keeps one loop for both modes.
+	const bool attribute = ( mode == TIXML_ESCAPE_ATTRIBUTE );
+	const __m128i amp = _mm_set1_epi8( '&' );
+	const __m128i lt = _mm_set1_epi8( '<' );
+	const __m128i gt = _mm_set1_epi8( '>' );
+	const __m128i quot = _mm_set1_epi8( attribute ? '\"' : '&' );
+	const __m128i apos = _mm_set1_epi8( attribute ? '\'' : '&' );
+	const __m128i control = _mm_set1_epi8( 0x1f );
+
+	while ( end - p >= 16 )
+	{
+		__m128i x = _mm_loadu_si128( (const __m128i*) p );
+		__m128i hit = _mm_or_si128(
+						_mm_or_si128( _mm_cmpeq_epi8( x, amp ), _mm_cmpeq_epi8( x, lt ) ),
+						_mm_or_si128( _mm_cmpeq_epi8( x, gt ), _mm_cmpeq_epi8( _mm_min_epu8( x, control ), x ) ) );
+		hit = _mm_or_si128( hit, _mm_or_si128( _mm_cmpeq_epi8( x, quot ), _mm_cmpeq_epi8( x, apos ) ) );
+		unsigned mask = (unsigned) _mm_movemask_epi8( hit );
+		if ( mask )
+			return p + LowestBit( mask );
+		p += 16;
+	}
+#endif
+	while ( p < end && !NeedsEscape( (unsigned char) *p, mode ) )
+		++p;
+	return p;
+}
+
+} // namespace
+
+
+void TiXmlBase::EncodeString( const std::string& str, std::string* outString, TiXmlEscapeMode mode )
+{
+	const char* p = str.data();
+	const char* const end = p + str.size();
+
+	while ( p < end )
+	{
+		const char* special = FindEscape( p, end, mode );
+		outString->append( p, special - p );
+		if ( special == end )
+			break;
+
+		if (    *special == '&'
+			 && end - special > 2
+			 && special[1] == '#'
+			 && special[2] == 'x' )
 		{
-			// Easy pass at non-alpha/numeric/symbol
-			// Below 32 is symbolic.
-			char buf[ 32 ];
-			
-			#if defined(TIXML_SNPRINTF)		
-				TIXML_SNPRINTF( buf, sizeof(buf), "&#x%02X;", (unsigned) ( c & 0xff ) );
-			#else
-				sprintf( buf, "&#x%02X;", (unsigned) ( c & 0xff ) );
-			#endif		
-
-			//*ME:	warning C4267: convert 'size_t' to 'int'
-			//*ME:	Int-Cast to make compiler happy ...
-			outString->append( buf, (int)strlen( buf ) );
-			++i;
+			// Hexadecimal character reference.
+			// Pass through unchanged.
+			// &#xA9;	-- copyright symbol, for example.
+			//
+			// Everything up to the ';' is copied; the ';' itself, or the
+			// last character if there is none, is then handled as usual.
+			const char* q = special;
+			while ( q < end - 1 )
+			{
+				++q;
+				if ( *q == ';' )
+					break;
+			}
+			outString->append( special, q - special );
+			p = q;
 		}
 		else
 		{
-			//char realc = (char) c;
-			//outString->append( &realc, 1 );
-			*outString += (char) c;	// somewhat more efficient function call.
-			++i;
+			const TiXmlEscape& e = escapeTable.escape[ (unsigned char) *special ];
+			outString->append( e.text, e.length );
+			p = special + 1;
 		}
 	}
 }
@@ -125,6 +498,7 @@ TiXmlNode::TiXmlNode( NodeType _type ) : TiXmlBase()
 	lastChild = 0;
 	prev = 0;
 	next = 0;
+	childIndex = 0;
 }
 
 
@@ -139,19 +513,326 @@ TiXmlNode::~TiXmlNode()
 		node = node->next;
 		delete temp;
 	}	
+	delete childIndex;
+}
+
+
+void TiXmlNode::SetValue( const std::string& _value )
+{
+	// The document's indexes file elements by name, and texts by their words.
+	TiXmlDocument* document = ( type == TINYXML_ELEMENT || type == TINYXML_TEXT ) ? IndexedDocument() : 0;
+	if ( document )
+		ValueChanging( document );
+	value = _value;
+	if ( document )
+		ValueChanged( document );
+	// The parent's index groups its children by value.
+	if ( parent )
+		parent->ChildrenChanged();
+}
+
+
+void TiXmlNode::SetValue( std::string&& _value )
+{
+	TiXmlDocument* document = ( type == TINYXML_ELEMENT || type == TINYXML_TEXT ) ? IndexedDocument() : 0;
+	if ( document )
+		ValueChanging( document );
+	value = std::move( _value );
+	if ( document )
+		ValueChanged( document );
+	if ( parent )
+		parent->ChildrenChanged();
+}
+
+
+void TiXmlNode::ValueChanging( TiXmlDocument* document )
+{
+	if ( type == TINYXML_TEXT )
+		document->TextChanging( static_cast< const TiXmlText* >( this ) );
+	else if ( document->elementIndex )
+		document->elementIndex->Unname( static_cast< const TiXmlElement* >( this ) );
+}
+
+
+void TiXmlNode::ValueChanged( TiXmlDocument* document )
+{
+	if ( type == TINYXML_TEXT )
+		document->TextChanged( static_cast< const TiXmlText* >( this ) );
+	else if ( document->elementIndex )
+		document->elementIndex->Name( static_cast< const TiXmlElement* >( this ) );
+}
+
+
+void TiXmlNode::EnableChildIndex( bool enable )
+{
+	if ( enable && !childIndex )
+	{
+		childIndex = new TiXmlChildIndex();
+	}
+	else if ( !enable )
+	{
+		delete childIndex;
+		childIndex = 0;
+	}
+}
+
+
+void TiXmlNode::ChildrenChanged()
+{
+	if ( childIndex )
+		childIndex->stale = true;
+}
+
+
+const TiXmlChildIndex* TiXmlNode::ChildIndex() const
+{
+	// Readers of a shared document may all find the index stale; one
+	// rebuilds it, and the others wait and then use it.
+	if ( childIndex && childIndex->stale.load( std::memory_order_acquire ) )
+	{
+		std::lock_guard< std::mutex > lock( childIndex->rebuilding );
+		if ( childIndex->stale.load( std::memory_order_relaxed ) )
+			childIndex->Rebuild( this );
+	}
+	return childIndex;
+}
+
+
+TiXmlDocument* TiXmlNode::IndexedDocument() const
+{
+	if ( indexedDocuments.load( std::memory_order_relaxed ) == 0 )
+		return 0;
+	const TiXmlNode* top = this;
+	while ( top->parent )
+		top = top->parent;
+	if ( top->type != TINYXML_DOCUMENT )
+		return 0;
+	TiXmlDocument* document = const_cast< TiXmlDocument* >( static_cast< const TiXmlDocument* >( top ) );
+	return ( document->elementIndex || document->textIndex ) ? document : 0;
+}
+
+
+TiXmlElementIndex* TiXmlNode::ElementIndex() const
+{
+	TiXmlDocument* document = IndexedDocument();
+	return document ? document->elementIndex : 0;
+}
+
+
+int TiXmlNode::ChildCount() const
+{
+	if ( const TiXmlChildIndex* index = ChildIndex() )
+		return (int)index->children.size();
+
+	int count = 0;
+	for( const TiXmlNode* node = firstChild; node; node = node->next )
+		++count;
+	return count;
+}
+
+
+const TiXmlNode* TiXmlNode::ChildAt( int count ) const
+{
+	if ( count < 0 )
+		return 0;
+	if ( const TiXmlChildIndex* index = ChildIndex() )
+		return ( count < (int)index->children.size() ) ? index->children[count] : 0;
+
+	const TiXmlNode* child = firstChild;
+	for( int i=0; child && i<count; ++i )
+		child = child->next;
+	return child;
+}
+
+
+const TiXmlElement* TiXmlNode::ChildElementAt( int count ) const
+{
+	if ( count < 0 )
+		return 0;
+	if ( const TiXmlChildIndex* index = ChildIndex() )
+		return ( count < (int)index->elements.size() ) ? index->elements[count] : 0;
+
+	const TiXmlElement* child = FirstChildElement();
+	for( int i=0; child && i<count; ++i )
+		child = child->NextSiblingElement();
+	return child;
+}
+
+
+const TiXmlNode* TiXmlNode::ChildAt( const char* _value, int count ) const
+{
+	if ( count < 0 )
+		return 0;
+	if ( const TiXmlChildIndex* index = ChildIndex() )
+	{
+		const TiXmlChildIndex::Group* group = index->Find( _value );
+		return ( group && count < (int)group->nodes.size() ) ? group->nodes[count] : 0;
+	}
+
+	const TiXmlNode* child = FirstChild( _value );
+	for( int i=0; child && i<count; ++i )
+		child = child->NextSibling( _value );
+	return child;
+}
+
+
+const TiXmlElement* TiXmlNode::ChildElementAt( const char* _value, int count ) const
+{
+	if ( count < 0 )
+		return 0;
+	if ( const TiXmlChildIndex* index = ChildIndex() )
+	{
+		const TiXmlChildIndex::Group* group = index->Find( _value );
+		return ( group && count < (int)group->elements.size() ) ? group->elements[count] : 0;
+	}
+
+	const TiXmlElement* child = FirstChildElement( _value );
+	for( int i=0; child && i<count; ++i )
+		child = child->NextSiblingElement( _value );
+	return child;
 }
 
 
 void TiXmlNode::CopyTo( TiXmlNode* target ) const
 {
-	target->SetValue (value.c_str() );
+	target->SetValue( value );
 	target->userData = userData; 
 	target->location = location;
 }
 
 
+bool TiXmlNode::IsLibraryType() const
+{
+	const std::type_info& t = typeid( *this );
+	switch ( type )
+	{
+		case TINYXML_DOCUMENT:		return t == typeid( TiXmlDocument );
+		case TINYXML_ELEMENT:		return t == typeid( TiXmlElement );
+		case TINYXML_COMMENT:		return t == typeid( TiXmlComment );
+		case TINYXML_UNKNOWN:		return t == typeid( TiXmlUnknown );
+		case TINYXML_TEXT:			return t == typeid( TiXmlText );
+		case TINYXML_DECLARATION:	return t == typeid( TiXmlDeclaration );
+		default:					return false;
+	}
+}
+
+
+TiXmlNode* TiXmlNode::CloneShallow( TiXmlDocument* pool ) const
+{
+	assert( type != TINYXML_DOCUMENT );		// never a child
+	TiXmlNode* clone = 0;
+	if ( pool )
+	{
+		clone = pool->NewNode( type );
+	}
+	else
+	{
+		switch ( type )
+		{
+			case TINYXML_ELEMENT:		clone = new TiXmlElement( std::string() );	break;
+			case TINYXML_COMMENT:		clone = new TiXmlComment();					break;
+			case TINYXML_UNKNOWN:		clone = new TiXmlUnknown();					break;
+			case TINYXML_TEXT:			clone = new TiXmlText( std::string() );		break;
+			case TINYXML_DECLARATION:	clone = new TiXmlDeclaration();				break;
+			default:					return 0;
+		}
+	}
+
+	// assign() reuses whatever capacity a recycled node brings along.
+	clone->value.assign( value );
+	clone->userData = userData;
+	clone->location = location;
+
+	switch ( type )
+	{
+		case TINYXML_ELEMENT:
+			static_cast<const TiXmlElement*>( this )->CopyAttributesTo( static_cast<TiXmlElement*>( clone ), pool );
+			break;
+		case TINYXML_TEXT:
+			static_cast<TiXmlText*>( clone )->cdata = static_cast<const TiXmlText*>( this )->cdata;
+			break;
+		case TINYXML_DECLARATION:
+		{
+			const TiXmlDeclaration* from = static_cast<const TiXmlDeclaration*>( this );
+			TiXmlDeclaration* to = static_cast<TiXmlDeclaration*>( clone );
+			to->version.assign( from->version );
+			to->encoding.assign( from->encoding );
+			to->standalone.assign( from->standalone );
+			break;
+		}
+		default:
+			break;
+	}
+	return clone;
+}
+
+
+void TiXmlNode::CloneChildrenTo( TiXmlNode* target ) const
+{
+	TiXmlDocument* pool = target->GetDocument();
+	const TiXmlNode* from = firstChild;
+	TiXmlNode* into = target;
+
+	while ( from )
+	{
+		// A subclass copies itself, and everything below it.
+		bool own = from->IsLibraryType();
+		TiXmlNode* clone = own ? from->CloneShallow( pool ) : from->Clone();
+		if ( clone )
+			into->LinkEndChild( clone );
+
+		if ( own && from->firstChild )
+		{
+			// Down a level, on both sides.
+			from = from->firstChild;
+			into = clone;
+			continue;
+		}
+		// Up until there is a next sibling, or we are back at the top.
+		while ( !from->next )
+		{
+			from = from->parent;
+			if ( from == this )
+				return;
+			into = into->parent;
+		}
+		from = from->next;
+	}
+}
+
+
+void TiXmlNode::MoveTo( TiXmlNode* target )
+{
+	assert( target != this );
+	target->Clear();
+	target->value = std::move( value );
+	target->userData = userData;
+	target->location = location;
+	value.clear();
+	userData = 0;
+
+	target->firstChild = firstChild;
+	target->lastChild = lastChild;
+	for( TiXmlNode* node = firstChild; node; node = node->next )
+		node->parent = target;
+	firstChild = 0;
+	lastChild = 0;
+
+	ChildrenChanged();
+	target->ChildrenChanged();
+	// Our value is gone, which matters to an index on our parent.
+	if ( parent )
+		parent->ChildrenChanged();
+	if ( TiXmlDocument* document = IndexedDocument() )
+		document->IndexStale();
+	if ( TiXmlDocument* document = target->IndexedDocument() )
+		document->IndexStale();
+}
+
+
 void TiXmlNode::Clear()
 {
+	TiXmlDocument* document = IndexedDocument();
 	TiXmlNode* node = firstChild;
 	TiXmlNode* temp = 0;
 
@@ -159,11 +840,17 @@ void TiXmlNode::Clear()
 	{
 		temp = node;
 		node = node->next;
+		if ( document )
+		{
+			document->IndexRemoving( temp );
+			temp->parent = 0;
+		}
 		delete temp;
 	}	
 
 	firstChild = 0;
 	lastChild = 0;
+	ChildrenChanged();
 }
 
 
@@ -194,21 +881,42 @@ TiXmlNode* TiXmlNode::LinkEndChild( TiXmlNode* node )
 		firstChild = node;			// it was an empty list.
 
 	lastChild = node;
+
+	if ( childIndex && !childIndex->stale )
+		childIndex->Append( node );
+	if ( TiXmlDocument* document = IndexedDocument() )
+		document->IndexAdded( node );
 	return node;
 }
 
 
-TiXmlNode* TiXmlNode::InsertEndChild( const TiXmlNode& addThis )
+TiXmlNode* TiXmlNode::LinkEndChild( std::unique_ptr<TiXmlNode> addThis )
 {
-	if ( addThis.Type() == TiXmlNode::TINYXML_DOCUMENT )
-	{
-		if ( GetDocument() ) 
-		{
-			string str;
-			GetDocument()->SetError(TIXML_ERROR_DOCUMENT_TOP_ONLY, str.begin(),str.end() , 0, TIXML_ENCODING_UNKNOWN);
-		}
+	if ( !addThis )
 		return 0;
+	return LinkEndChild( addThis.release() );
+}
+
+
+bool TiXmlNode::RejectDocument( const TiXmlNode& addThis )
+{
+	if ( addThis.Type() != TiXmlNode::TINYXML_DOCUMENT )
+		return false;
+
+	// A document can never be a child.	Thanks to Noam.
+	if ( GetDocument() ) 
+	{
+		string str;
+		GetDocument()->SetError(TIXML_ERROR_DOCUMENT_TOP_ONLY, str.begin(),str.end() , 0, TIXML_ENCODING_UNKNOWN);
 	}
+	return true;
+}
+
+
+TiXmlNode* TiXmlNode::InsertEndChild( const TiXmlNode& addThis )
+{
+	if ( RejectDocument( addThis ) )
+		return 0;
 	TiXmlNode* node = addThis.Clone();
 	if ( !node )
 		return 0;
@@ -217,22 +925,44 @@ TiXmlNode* TiXmlNode::InsertEndChild( const TiXmlNode& addThis )
 }
 
 
+TiXmlNode* TiXmlNode::InsertEndChild( TiXmlNode&& addThis )
+{
+	if ( RejectDocument( addThis ) )
+		return 0;
+	TiXmlNode* node = addThis.MoveClone();
+	if ( !node )
+		return 0;
+
+	return LinkEndChild( node );
+}
+
+
 TiXmlNode* TiXmlNode::InsertBeforeChild( TiXmlNode* beforeThis, const TiXmlNode& addThis )
 {	
 	if ( !beforeThis || beforeThis->parent != this ) {
 		return 0;
 	}
-	if ( addThis.Type() == TiXmlNode::TINYXML_DOCUMENT )
-	{
-		if (GetDocument())
-		{
-			string str;
-			GetDocument()->SetError(TIXML_ERROR_DOCUMENT_TOP_ONLY, str.begin(),str.end() , 0, TIXML_ENCODING_UNKNOWN);
-		}
+	if ( RejectDocument( addThis ) )
+		return 0;
+
+	return LinkBeforeChild( beforeThis, addThis.Clone() );
+}
+
+
+TiXmlNode* TiXmlNode::InsertBeforeChild( TiXmlNode* beforeThis, TiXmlNode&& addThis )
+{	
+	if ( !beforeThis || beforeThis->parent != this ) {
 		return 0;
 	}
+	if ( RejectDocument( addThis ) )
+		return 0;
 
-	TiXmlNode* node = addThis.Clone();
+	return LinkBeforeChild( beforeThis, addThis.MoveClone() );
+}
+
+
+TiXmlNode* TiXmlNode::LinkBeforeChild( TiXmlNode* beforeThis, TiXmlNode* node )
+{
 	if ( !node )
 		return 0;
 	node->parent = this;
@@ -249,6 +979,9 @@ TiXmlNode* TiXmlNode::InsertBeforeChild( TiXmlNode* beforeThis, const TiXmlNode&
 		firstChild = node;
 	}
 	beforeThis->prev = node;
+	ChildrenChanged();
+	if ( TiXmlDocument* document = IndexedDocument() )
+		document->IndexAdded( node );
 	return node;
 }
 
@@ -258,17 +991,27 @@ TiXmlNode* TiXmlNode::InsertAfterChild( TiXmlNode* afterThis, const TiXmlNode& a
 	if ( !afterThis || afterThis->parent != this ) {
 		return 0;
 	}
-	if ( addThis.Type() == TiXmlNode::TINYXML_DOCUMENT )
-	{
-		if (GetDocument())
-		{
-			string str;
-			GetDocument()->SetError(TIXML_ERROR_DOCUMENT_TOP_ONLY, str.begin(),str.end() , 0, TIXML_ENCODING_UNKNOWN);
-		}
+	if ( RejectDocument( addThis ) )
+		return 0;
+
+	return LinkAfterChild( afterThis, addThis.Clone() );
+}
+
+
+TiXmlNode* TiXmlNode::InsertAfterChild( TiXmlNode* afterThis, TiXmlNode&& addThis )
+{
+	if ( !afterThis || afterThis->parent != this ) {
 		return 0;
 	}
+	if ( RejectDocument( addThis ) )
+		return 0;
 
-	TiXmlNode* node = addThis.Clone();
+	return LinkAfterChild( afterThis, addThis.MoveClone() );
+}
+
+
+TiXmlNode* TiXmlNode::LinkAfterChild( TiXmlNode* afterThis, TiXmlNode* node )
+{
 	if ( !node )
 		return 0;
 	node->parent = this;
@@ -285,6 +1028,9 @@ TiXmlNode* TiXmlNode::InsertAfterChild( TiXmlNode* afterThis, const TiXmlNode& a
 		lastChild = node;
 	}
 	afterThis->next = node;
+	ChildrenChanged();
+	if ( TiXmlDocument* document = IndexedDocument() )
+		document->IndexAdded( node );
 	return node;
 }
 
@@ -297,20 +1043,35 @@ TiXmlNode* TiXmlNode::ReplaceChild( TiXmlNode* replaceThis, const TiXmlNode& wit
 	if ( replaceThis->parent != this )
 		return 0;
 
-	if ( withThis.ToDocument() ) {
-		// A document can never be a child.	Thanks to Noam.
-		TiXmlDocument* document = GetDocument();
-		if (document)
-		{
-			string str;
-			document->SetError(TIXML_ERROR_DOCUMENT_TOP_ONLY, str.begin(),str.end() , 0, TIXML_ENCODING_UNKNOWN);
-		}
+	if ( RejectDocument( withThis ) )
 		return 0;
-	}
 
-	TiXmlNode* node = withThis.Clone();
+	return LinkReplaceChild( replaceThis, withThis.Clone() );
+}
+
+
+TiXmlNode* TiXmlNode::ReplaceChild( TiXmlNode* replaceThis, TiXmlNode&& withThis )
+{
+	if ( !replaceThis )
+		return 0;
+
+	if ( replaceThis->parent != this )
+		return 0;
+
+	if ( RejectDocument( withThis ) )
+		return 0;
+
+	return LinkReplaceChild( replaceThis, withThis.MoveClone() );
+}
+
+
+TiXmlNode* TiXmlNode::LinkReplaceChild( TiXmlNode* replaceThis, TiXmlNode* node )
+{
 	if ( !node )
 		return 0;
+	TiXmlDocument* document = IndexedDocument();
+	if ( document )
+		document->IndexRemoving( replaceThis );
 
 	node->next = replaceThis->next;
 	node->prev = replaceThis->prev;
@@ -325,12 +1086,41 @@ TiXmlNode* TiXmlNode::ReplaceChild( TiXmlNode* replaceThis, const TiXmlNode& wit
 	else
 		firstChild = node;
 
+	replaceThis->parent = 0;
 	delete replaceThis;
 	node->parent = this;
+	ChildrenChanged();
+	if ( document )
+		document->IndexAdded( node );
 	return node;
 }
 
 
+std::unique_ptr<TiXmlNode> TiXmlNode::DetachChild( TiXmlNode* removeThis )
+{
+	if ( !removeThis || removeThis->parent != this )
+		return std::unique_ptr<TiXmlNode>();
+	if ( TiXmlDocument* document = IndexedDocument() )
+		document->IndexRemoving( removeThis );
+
+	if ( removeThis->next )
+		removeThis->next->prev = removeThis->prev;
+	else
+		lastChild = removeThis->prev;
+
+	if ( removeThis->prev )
+		removeThis->prev->next = removeThis->next;
+	else
+		firstChild = removeThis->next;
+
+	removeThis->parent = 0;
+	removeThis->prev = 0;
+	removeThis->next = 0;
+	ChildrenChanged();
+	return std::unique_ptr<TiXmlNode>( removeThis );
+}
+
+
 bool TiXmlNode::RemoveChild( TiXmlNode* removeThis )
 {
 	if ( !removeThis ) {
@@ -342,6 +1132,8 @@ bool TiXmlNode::RemoveChild( TiXmlNode* removeThis )
 		assert( 0 );
 		return false;
 	}
+	if ( TiXmlDocument* document = IndexedDocument() )
+		document->IndexRemoving( removeThis );
 
 	if ( removeThis->next )
 		removeThis->next->prev = removeThis->prev;
@@ -353,12 +1145,17 @@ bool TiXmlNode::RemoveChild( TiXmlNode* removeThis )
 	else
 		firstChild = removeThis->next;
 
+	removeThis->parent = 0;
 	delete removeThis;
+	ChildrenChanged();
 	return true;
 }
 
 const TiXmlNode* TiXmlNode::FirstChild( const char * _value ) const
 {
+	if ( childIndex )
+		return ChildAt( _value, 0 );
+
 	const TiXmlNode* node;
 	for ( node = firstChild; node; node = node->next )
 	{
@@ -411,6 +1208,21 @@ const TiXmlNode* TiXmlNode::IterateChildren( const char * val, const TiXmlNode*
 
 const TiXmlNode* TiXmlNode::NextSibling( const char * _value ) const 
 {
+	if ( parent && parent->childIndex )
+	{
+		const TiXmlChildIndex* index = parent->ChildIndex();
+		const TiXmlChildIndex::Group* group = index->Find( _value );
+		if ( !group )
+			return 0;
+		if ( value == _value )
+		{
+			// Our own group: simply the next one along.
+			int pos = index->PositionOf( this ).node;
+			return ( pos+1 < (int)group->nodes.size() ) ? group->nodes[pos+1] : 0;
+		}
+		return index->After( group->nodes, this );
+	}
+
 	const TiXmlNode* node;
 	for ( node = next; node; node = node->next )
 	{
@@ -439,6 +1251,7 @@ void TiXmlElement::RemoveAttribute(const std::string& name)
 	TiXmlAttribute* node = attributeSet.Find( name );
 	if ( node )
 	{
+		AttributeChanging( node );
 		attributeSet.Remove( node );
 		delete node;
 	}
@@ -461,6 +1274,9 @@ const TiXmlElement* TiXmlNode::FirstChildElement() const
 
 const TiXmlElement* TiXmlNode::FirstChildElement( const char * _value ) const
 {
+	if ( childIndex )
+		return ChildElementAt( _value, 0 );
+
 	const TiXmlNode* node;
 
 	for (	node = FirstChild( _value );
@@ -491,6 +1307,18 @@ const TiXmlElement* TiXmlNode::NextSiblingElement() const
 
 const TiXmlElement* TiXmlNode::NextSiblingElement( const char * _value ) const
 {
+	if ( parent && parent->childIndex )
+	{
+		const TiXmlChildIndex* index = parent->ChildIndex();
+		const TiXmlChildIndex::Group* group = index->Find( _value );
+		if ( !group )
+			return 0;
+		const TiXmlChildIndex::Position& pos = index->PositionOf( this );
+		if ( value == _value && pos.element >= 0 )
+			return ( pos.element+1 < (int)group->elements.size() ) ? group->elements[pos.element+1] : 0;
+		return index->After( group->elements, this );
+	}
+
 	const TiXmlNode* node;
 
 	for (	node = NextSibling( _value );
@@ -532,147 +1360,94 @@ TiXmlElement::TiXmlElement( const std::string& _value )
 }
 
 
-TiXmlElement::TiXmlElement( const TiXmlElement& copy)
+TiXmlElement::TiXmlElement( std::string&& _value ) 
 	: TiXmlNode( TiXmlNode::TINYXML_ELEMENT )
 {
 	firstChild = lastChild = 0;
-	copy.CopyTo( this );	
+	value = std::move( _value );
 }
 
 
-TiXmlElement& TiXmlElement::operator=( const TiXmlElement& base )
+TiXmlElement::TiXmlElement( const TiXmlElement& copy)
+	: TiXmlNode( TiXmlNode::TINYXML_ELEMENT )
 {
-	ClearThis();
-	base.CopyTo( this );
-	return *this;
+	firstChild = lastChild = 0;
+	copy.CopyTo( this );	
 }
 
 
-TiXmlElement::~TiXmlElement()
+TiXmlElement::TiXmlElement( TiXmlElement&& other )
+	: TiXmlNode( TiXmlNode::TINYXML_ELEMENT )
 {
-	ClearThis();
+	other.MoveTo( this );
 }
 
 
-void TiXmlElement::ClearThis()
-{
-	Clear();
-	while( attributeSet.First() )
-	{
-		TiXmlAttribute* node = attributeSet.First();
-		attributeSet.Remove( node );
-		delete node;
-	}
-}
-
-std::string TiXmlElement::Attribute( const std::string& name ) const
+TiXmlElement& TiXmlElement::operator=( const TiXmlElement& base )
 {
-	const TiXmlAttribute* attrib = attributeSet.Find( name );
-	if ( attrib )
-		return attrib->ValueStr();
-	return {};
+	ClearThis();
+	base.CopyTo( this );
+	return *this;
 }
 
 
-
-string TiXmlElement::Attribute( const std::string & name, int* i ) const
+TiXmlElement& TiXmlElement::operator=( TiXmlElement&& base )
 {
-	const TiXmlAttribute* attrib = attributeSet.Find( name );
-	std::string result;
-
-	if ( attrib ) {
-		result = attrib->ValueStr();
-		if ( i ) {
-			attrib->QueryIntValue( i );
-		}
-	}
-	return result;
-}
-
-std::string TiXmlElement::Attribute( const std::string & name, double* d ) const
-{
-	const TiXmlAttribute* attrib = attributeSet.Find( name );
-	std::string result;
-
-	if ( attrib ) {
-		result = attrib->ValueStr();
-		if ( d ) {
-			attrib->QueryDoubleValue( d );
-		}
+	if ( this != &base )
+	{
+		ClearThis();
+		base.MoveTo( this );
 	}
-	return result;
-}
-
-
-int TiXmlElement::QueryIntAttribute( const std::string & name, int* ival ) const
-{
-	const TiXmlAttribute* attrib = attributeSet.Find( name );
-	if ( !attrib )
-		return TIXML_NO_ATTRIBUTE;
-	return attrib->QueryIntValue( ival );
+	return *this;
 }
 
 
-int TiXmlElement::QueryUnsignedAttribute( const std::string & name, unsigned* value ) const
+TiXmlElement::~TiXmlElement()
 {
-	const TiXmlAttribute* node = attributeSet.Find( name );
-	if ( !node )
-		return TIXML_NO_ATTRIBUTE;
-
-	int ival = 0;
-	int result = node->QueryIntValue( &ival );
-	*value = (unsigned)ival;
-	return result;
+	ClearThis();
 }
 
 
-int TiXmlElement::QueryBoolAttribute( const std::string & name, bool* bval ) const
+void TiXmlElement::ClearThis()
 {
-	const TiXmlAttribute* node = attributeSet.Find( name );
-	if ( !node )
-		return TIXML_NO_ATTRIBUTE;
-	
-	int result = TIXML_WRONG_TYPE;
-	if (    StringEqual( node->ValueStr(), "true", true ) 
-		 || StringEqual(node->ValueStr() , "yes", true )
-		 || StringEqual(node->ValueStr() , "1", true ) )
-	{
-		*bval = true;
-		result = TIXML_SUCCESS;
-	}
-	else if (    StringEqual(node->ValueStr(),  "false", true )
-			  || StringEqual(node->ValueStr(),  "no", true )
-			  || StringEqual(node->ValueStr(),  "0", true ) )
+	Clear();
+	// Remove from the back: it doesn't shift the rest of the set.
+	while( attributeSet.Last() )
 	{
-		*bval = false;
-		result = TIXML_SUCCESS;
+		TiXmlAttribute* node = attributeSet.Last();
+		attributeSet.Remove( node );
+		delete node;
 	}
-	return result;
 }
 
-
-int TiXmlElement::QueryDoubleAttribute( const std::string & name, double* dval ) const
+std::string TiXmlElement::Attribute( const std::string& name ) const
 {
 	const TiXmlAttribute* attrib = attributeSet.Find( name );
-	if ( !attrib )
-		return TIXML_NO_ATTRIBUTE;
-	return attrib->QueryDoubleValue( dval );
+	if ( attrib )
+		return attrib->ValueStr();
+	return {};
 }
 
-void TiXmlElement::SetAttribute( const std::string& name, int val )
-{	
-	TiXmlAttribute* attrib = attributeSet.FindOrCreate( name );
-	if ( attrib ) {
-		attrib->SetIntValue( val );
-	}
+
+
+const std::string* TiXmlElement::Attribute( std::string_view name, int* i ) const
+{
+	const TiXmlAttribute* attrib = attributeSet.Find( name );
+	if ( !attrib )
+		return 0;
+	if ( i )
+		attrib->QueryIntValue( i );
+	return &attrib->ValueStr();
 }
 
-void TiXmlElement::SetDoubleAttribute( const std::string& name, double val )
-{	
-	TiXmlAttribute* attrib = attributeSet.FindOrCreate( name );
-	if ( attrib ) {
-		attrib->SetDoubleValue( val );
-	}
+const std::string* TiXmlElement::Attribute( std::string_view name, double* d ) const
+{
+	const TiXmlAttribute* attrib = attributeSet.Find( name );
+	if ( !attrib )
+		return 0;
+	if ( d )
+		attrib->QueryDoubleValue( d );
+	return &attrib->ValueStr();
 }
 
 
@@ -680,7 +1455,10 @@ void TiXmlElement::SetAttribute( const char * cname, const char * cvalue )
 {
 	TiXmlAttribute* attrib = attributeSet.FindOrCreate( cname );
 	if ( attrib ) {
+		TiXmlElementIndex* index = AttributeChanging( attrib );
 		attrib->SetValue( cvalue );
+		if ( index )
+			AttributeChanged( index, attrib );
 	}
 }
 
@@ -688,86 +1466,97 @@ void TiXmlElement::SetAttribute( const std::string& _name, const std::string& _v
 {
 	TiXmlAttribute* attrib = attributeSet.FindOrCreate( _name );
 	if ( attrib ) {
+		TiXmlElementIndex* index = AttributeChanging( attrib );
 		attrib->SetValue( _value );
+		if ( index )
+			AttributeChanged( index, attrib );
 	}
 }
 
-
-void TiXmlElement::Print(std::ostream & file, int depth) const
+void TiXmlElement::SetAttribute( const std::string& _name, std::string&& _value )
 {
-	int i;
-	assert( file );
-	for ( i=0; i<depth; i++ ) {
-		file<<"    ";
+	TiXmlAttribute* attrib = attributeSet.FindOrCreate( _name );
+	if ( attrib ) {
+		TiXmlElementIndex* index = AttributeChanging( attrib );
+		attrib->SetValue( std::move( _value ) );
+		if ( index )
+			AttributeChanged( index, attrib );
 	}
+}
 
-	file<< "<"<<value<<"";
 
-	const TiXmlAttribute* attrib;
-	for ( attrib = attributeSet.First(); attrib; attrib = attrib->Next() )
-	{
-		file<< " " ;
-		attrib->Print( file, depth );
-	}
+TiXmlElementIndex* TiXmlElement::AttributeChanging( const TiXmlAttribute* attrib )
+{
+	TiXmlElementIndex* index = ElementIndex();
+	if ( !index || index->stale || index->attributes.empty() )
+		return 0;
+	index->Unindex( this, attrib );
+	return index;
+}
 
-	// There are 3 different formatting approaches:
-	// 1) An element without children is printed as a <foo /> node
-	// 2) An element with only a text child is printed as <foo> text </foo>
-	// 3) An element with children is printed on multiple lines.
-	TiXmlNode* node;
-	if ( !firstChild )
-	{
-		file<< " />" ;
-	}
-	else if ( firstChild == lastChild && firstChild->ToText() )
-	{
-		file<< ">" ;
-		firstChild->Print( file, depth + 1 );
-		file<< "</"<<value<<">";
-	}
-	else
-	{
-		file<< ">" ;
 
-		for ( node = firstChild; node; node=node->NextSibling() )
-		{
-			if ( !node->ToText() )
-			{
-				file<< "\n" ;
-			}
-			node->Print( file, depth+1 );
-		}
-		file<< "\n" ;
-		for( i=0; i<depth; ++i ) {
-			file<< "    " ;
-		}
-		file<< "</"<<value<<">";
-	}
+void TiXmlElement::AttributeChanged( TiXmlElementIndex* index, const TiXmlAttribute* attrib )
+{
+	index->Index( this, attrib );
 }
 
 
 void TiXmlElement::CopyTo( TiXmlElement* target ) const
 {
+	// The attributes are copied behind the back of any element index.
+	if ( TiXmlElementIndex* index = target->ElementIndex() )
+		index->stale = true;
+
 	// superclass:
 	TiXmlNode::CopyTo( target );
 
 	// Element class: 
 	// Clone the attributes, then clone the children.
-	const TiXmlAttribute* attribute = 0;
-	for(	attribute = attributeSet.First();
-	attribute;
-	attribute = attribute->Next() )
+	if ( target->attributeSet.Count() == 0 )
 	{
-		target->SetAttribute( attribute->NameTStr(), attribute->ValueStr() );
+		CopyAttributesTo( target, target->GetDocument() );
+	}
+	else
+	{
+		const TiXmlAttribute* attribute = 0;
+		for(	attribute = attributeSet.First();
+		attribute;
+		attribute = attribute->Next() )
+		{
+			target->SetAttribute( attribute->NameTStr(), attribute->ValueStr() );
+		}
 	}
 
-	TiXmlNode* node = 0;
-	for ( node = firstChild; node; node = node->NextSibling() )
+	CloneChildrenTo( target );
+}
+
+
+void TiXmlElement::CopyAttributesTo( TiXmlElement* target, TiXmlDocument* pool ) const
+{
+	// The names are unique in the source, so no lookups: size the set once
+	// and append.
+	target->attributeSet.Reserve( target->attributeSet.Count() + attributeSet.Count() );
+	for( const TiXmlAttribute* attribute = attributeSet.First(); attribute; attribute = attribute->Next() )
 	{
-		target->LinkEndChild( node->Clone() );
+		TiXmlAttribute* copy = pool ? pool->NewAttribute() : new TiXmlAttribute();
+		copy->name.assign( attribute->name );
+		copy->value.assign( attribute->value );
+		copy->userData = attribute->userData;
+		copy->location = attribute->location;
+		target->attributeSet.Add( copy );
 	}
 }
 
+void TiXmlElement::MoveTo( TiXmlElement* target )
+{
+	// superclass: value and children
+	TiXmlNode::MoveTo( target );
+
+	// Element class: the attributes change hands as a block.
+	target->attributeSet.MoveFrom( attributeSet );
+}
+
+
 bool TiXmlElement::Accept( TiXmlVisitor* visitor ) const
 {
 	if ( visitor->VisitEnter( *this, attributeSet.First() ) ) 
@@ -793,6 +1582,18 @@ TiXmlNode* TiXmlElement::Clone() const
 }
 
 
+TiXmlNode* TiXmlElement::MoveClone()
+{
+	// A subclass would lose its type, and its fields, in a moved copy.
+	if ( !IsLibraryType() )
+		return Clone();
+
+	TiXmlElement* clone = new TiXmlElement( std::string() );
+	MoveTo( clone );
+	return clone;
+}
+
+
 const char* TiXmlElement::GetText() const
 {
 	const TiXmlNode* child = this->FirstChild();
@@ -806,7 +1607,7 @@ const char* TiXmlElement::GetText() const
 }
 
 
-TiXmlDocument::TiXmlDocument() : TiXmlNode( TiXmlNode::TINYXML_DOCUMENT )
+TiXmlDocument::TiXmlDocument() : TiXmlNode( TiXmlNode::TINYXML_DOCUMENT ), elementIndex( 0 ), textIndex( 0 )
 {
 	tabsize = 4;
 	useMicrosoftBOM = false;
@@ -821,7 +1622,7 @@ TiXmlDocument::TiXmlDocument() : TiXmlNode( TiXmlNode::TINYXML_DOCUMENT )
 //	ClearError();
 //}
 
-TiXmlDocument::TiXmlDocument( const std::string& documentName ) : TiXmlNode( TiXmlNode::TINYXML_DOCUMENT )
+TiXmlDocument::TiXmlDocument( const std::string& documentName ) : TiXmlNode( TiXmlNode::TINYXML_DOCUMENT ), elementIndex( 0 ), textIndex( 0 )
 {
 	tabsize = 4;
 	useMicrosoftBOM = false;
@@ -830,16 +1631,34 @@ TiXmlDocument::TiXmlDocument( const std::string& documentName ) : TiXmlNode( TiX
 }
 
 
-TiXmlDocument::TiXmlDocument( const TiXmlDocument& copy ) : TiXmlNode( TiXmlNode::TINYXML_DOCUMENT )
+TiXmlDocument::TiXmlDocument( const TiXmlDocument& copy ) : TiXmlNode( TiXmlNode::TINYXML_DOCUMENT ), elementIndex( 0 ), textIndex( 0 )
 {
 	copy.CopyTo( this );
 }
 
 
+TiXmlDocument::TiXmlDocument( TiXmlDocument&& other ) : TiXmlNode( TiXmlNode::TINYXML_DOCUMENT ), elementIndex( 0 ), textIndex( 0 )
+{
+	other.MoveTo( this );
+}
+
+
 TiXmlDocument& TiXmlDocument::operator=( const TiXmlDocument& copy )
 {
-	Clear();
-	copy.CopyTo( this );
+	if ( this != &copy )
+	{
+		// Reset() rather than Clear(): the copy is built from our old nodes.
+		Reset();
+		copy.CopyTo( this );
+	}
+	return *this;
+}
+
+
+TiXmlDocument& TiXmlDocument::operator=( TiXmlDocument&& other )
+{
+	if ( this != &other )
+		other.MoveTo( this );
 	return *this;
 }
 
@@ -855,12 +1674,36 @@ bool TiXmlDocument::SaveFile() const
 	return SaveFile( Value() );
 }
 
+namespace {
+
+// The compression of a file, from its first bytes. The stream is left at the start.
+TiXmlCompression ReadCompression( std::istream& in )
+{
+	unsigned char magic[4] = { 0, 0, 0, 0 };
+	in.read( (char*) magic, sizeof( magic ) );
+	std::streamsize got = in.gcount();
+	in.clear();
+	in.seekg( 0 );
+
+	if ( got >= 2 && magic[0] == 0x1f && magic[1] == 0x8b )
+		return TIXML_COMPRESSION_GZIP;
+	if ( got == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd )
+		return TIXML_COMPRESSION_ZSTD;
+	return TIXML_COMPRESSION_NONE;
+}
+
+} // namespace
+
+
 bool TiXmlDocument::LoadFile( const std::string & filename, TiXmlEncoding encoding )
 {
 	value = filename;
 
 	// reading in binary mode so that tinyxml can normalize the EOL
-	ifstream file( value);	
+	// (compressed files must be: their bytes are not text)
+	ifstream sniff( value, ios::in | ios::binary );
+	ifstream file( value, ReadCompression( sniff ) != TIXML_COMPRESSION_NONE ? ios::in | ios::binary : ios::in );
+	sniff.close();
 
 	if ( file )
 	{
@@ -888,14 +1731,34 @@ bool TiXmlDocument::LoadFile(std::ifstream &file, TiXmlEncoding encoding)
 	Clear();
 	location.Clear();
 
-	// Get the file size, so we can pre-allocate the string. HUGE speed impact.
-	string::size_type length = 0;
-	stringstream ss;
-	ss << file.rdbuf();
-	auto str = ss.str();
-	length = str.length();
-	ss.str("");
-	ss.clear();
+	// A compressed file is known by its first bytes, and decompressed
+	// a chunk at a time straight into the text to parse.
+	TiXmlCompression compression = ReadCompression( file );
+
+	string str;
+	if ( compression != TIXML_COMPRESSION_NONE )
+	{
+		if ( !ReadCompressed( file, compression, &str ) )
+		{
+			string none;
+			SetError( TIXML_ERROR_COMPRESSION, none.begin(), none.end(), 0, TIXML_ENCODING_UNKNOWN );
+			return false;
+		}
+	}
+	else
+	{
+		// Get the file size, so we can pre-allocate the string. HUGE speed impact.
+		file.seekg( 0, std::ios::end );
+		std::streamoff size = file.tellg();
+		file.seekg( 0 );
+		if ( size > 0 )
+		{
+			str.resize( (size_t) size );
+			file.read( &str[0], size );
+			str.resize( (size_t) file.gcount() );
+		}
+	}
+	string::size_type length = str.length();
 
 	// Strange case, but good to handle up front.
 	if ( length <= 0 )
@@ -905,41 +1768,406 @@ bool TiXmlDocument::LoadFile(std::ifstream &file, TiXmlEncoding encoding)
 		return false;
 	}
 
-	const char CR = 0x0d;
-	const char LF = 0x0a;
+	const char CR = 0x0d;
+	const char LF = 0x0a;
+
+	Parse( str.begin(),str.end(), 0, encoding );
+
+	return !Error();
+}
+
+
+bool TiXmlDocument::SaveFile(const std::string& filename) const
+{
+	return SaveFile( filename, CompressionOf( filename ) );
+}
+
+bool TiXmlDocument::SaveFile( const std::string& filename, TiXmlCompression compression ) const
+{
+#ifndef TIXML_USE_ZLIB
+	if ( compression == TIXML_COMPRESSION_GZIP )
+		return false;
+#endif
+#ifndef TIXML_USE_ZSTD
+	if ( compression == TIXML_COMPRESSION_ZSTD )
+		return false;
+#endif
+
+	// The old c stuff lives on...
+	FILE* file = fopen( filename.c_str(), compression == TIXML_COMPRESSION_NONE ? "w" : "wb" );
+	if ( !file )
+		return false;
+	bool result = false;
+	{
+		// Buffered here, a block at a time, so stdio's own buffer is bypassed.
+		TiXmlFileSink sink( file );
+		if ( compression == TIXML_COMPRESSION_NONE )
+		{
+			result = Save( &sink );
+		}
+#ifdef TIXML_USE_ZLIB
+		else if ( compression == TIXML_COMPRESSION_GZIP )
+		{
+			TiXmlGzipSink gzip( &sink );
+			result = Save( &gzip ) && gzip.Finish();
+		}
+#endif
+#ifdef TIXML_USE_ZSTD
+		else if ( compression == TIXML_COMPRESSION_ZSTD )
+		{
+			TiXmlZstdSink zstd( &sink );
+			result = Save( &zstd ) && zstd.Finish();
+		}
+#endif
+	}
+	return fclose( file ) == 0 && result;
+}
+
+TiXmlCompression TiXmlDocument::CompressionOf( const std::string& filename )
+{
+	size_t length = filename.size();
+	if ( length > 3 && filename.compare( length - 3, 3, ".gz" ) == 0 )
+		return TIXML_COMPRESSION_GZIP;
+	if ( length > 4 && filename.compare( length - 4, 4, ".zst" ) == 0 )
+		return TIXML_COMPRESSION_ZSTD;
+	return TIXML_COMPRESSION_NONE;
+}
+
+bool TiXmlDocument::SaveFile(std::ofstream &fout) const
+{
+	TiXmlStreamSink sink( fout );
+	return Save( &sink ) && fout.good();
+}
+
+bool TiXmlDocument::Save( TiXmlOutputSink* sink ) const
+{
+	if ( useMicrosoftBOM ) 
+	{
+		const char bom[] = { (char) 0xefU, (char) 0xbbU, (char) 0xbfU };
+		sink->Write( bom, sizeof( bom ) );
+	}
+	TiXmlPrinter printer( sink );
+	Accept( &printer );
+	return sink->Flush();
+}
+
+
+TiXmlDocument::~TiXmlDocument()
+{
+	// Children are deleted while we are still a document, and without an index to update.
+	EnableElementIndex( false );
+	EnableTextIndex( false );
+	Clear();
+	ShrinkToFit();
+}
+
+
+void TiXmlDocument::EnableElementIndex( bool enable )
+{
+	if ( enable && !elementIndex )
+	{
+		if ( !textIndex )
+			++indexedDocuments;
+		elementIndex = new TiXmlElementIndex();
+	}
+	else if ( !enable && elementIndex )
+	{
+		delete elementIndex;
+		elementIndex = 0;
+		if ( !textIndex )
+			--indexedDocuments;
+	}
+}
+
+
+void TiXmlDocument::EnableTextIndex( bool enable )
+{
+	if ( enable && !textIndex )
+	{
+		if ( !elementIndex )
+			++indexedDocuments;
+		textIndex = new TiXmlTextIndex();
+	}
+	else if ( !enable && textIndex )
+	{
+		delete textIndex;
+		textIndex = 0;
+		if ( !elementIndex )
+			--indexedDocuments;
+	}
+}
+
+
+const TiXmlTextIndex* TiXmlDocument::TextIndex() const
+{
+	if ( textIndex && textIndex->stale )
+		textIndex->Build( this );
+	return textIndex;
+}
+
+
+void TiXmlDocument::IndexAdded( const TiXmlNode* node )
+{
+	// Only what lands at the very end of the document can be appended.
+	for( const TiXmlNode* n = node; n->Parent(); n = n->Parent() )
+	{
+		if ( n->NextSibling() )
+		{
+			IndexStale();
+			return;
+		}
+		// The parser sets the parent before linking a node in; its
+		// children are added along with it.
+		if ( n->Parent()->LastChild() != n )
+			return;
+	}
+	if ( elementIndex )
+		elementIndex->Added( node );
+	if ( textIndex )
+		textIndex->Append( node );
+}
+
+
+void TiXmlDocument::IndexRemoving( const TiXmlNode* node )
+{
+	if ( elementIndex )
+		elementIndex->Removing( node );
+	// Text numbers follow document order; leaving a gap is not worth it.
+	if ( textIndex )
+		textIndex->stale = true;
+}
+
+
+void TiXmlDocument::IndexStale()
+{
+	if ( elementIndex )
+		elementIndex->stale = true;
+	if ( textIndex )
+		textIndex->stale = true;
+}
+
+
+void TiXmlDocument::TextChanging( const TiXmlText* text )
+{
+	if ( textIndex )
+		textIndex->Changing( text );
+}
+
+
+void TiXmlDocument::TextChanged( const TiXmlText* text )
+{
+	if ( textIndex )
+		textIndex->Changed( text );
+}
+
+
+void TiXmlDocument::UpdateIndexes()
+{
+	if ( elementIndex && elementIndex->stale )
+		elementIndex->Rebuild( this );
+	if ( textIndex && textIndex->stale )
+		textIndex->Build( this );
+}
+
+
+void TiXmlDocument::CopyIndexesTo( TiXmlDocument* target ) const
+{
+	target->EnableElementIndex( false );
+	if ( elementIndex )
+	{
+		target->EnableElementIndex();
+		for( const auto& values : elementIndex->attributes )
+			target->IndexAttribute( values.first );
+	}
+	target->EnableTextIndex( textIndex != 0 );
+}
+
+
+void TiXmlDocument::IndexAttribute( const std::string& name )
+{
+	EnableElementIndex();
+	if ( elementIndex->attributes.emplace( name, TiXmlElementIndex::Lists() ).second )
+		elementIndex->stale = true;
+}
+
+
+const std::vector< const TiXmlElement* >& TiXmlDocument::GetElementsByTagName( const std::string& name ) const
+{
+	static const TiXmlElementIndex::List none;
+	if ( !elementIndex )
+		return none;
+	if ( elementIndex->stale )
+		elementIndex->Rebuild( this );
+	TiXmlElementIndex::Lists::const_iterator it = elementIndex->names.find( name );
+	return ( it == elementIndex->names.end() ) ? none : it->second;
+}
+
+
+void TiXmlDocument::GetElementsByTagName( const std::string& name, std::vector< const TiXmlElement* >* found ) const
+{
+	if ( elementIndex )
+	{
+		*found = GetElementsByTagName( name );
+		return;
+	}
+	found->clear();
+	ForEachElement( this, [&]( const TiXmlElement* element ) {
+		if ( element->ValueStr() == name )
+			found->push_back( element );
+	} );
+}
+
+
+const TiXmlElement* TiXmlDocument::GetElementByAttribute( const std::string& name, const std::string& value ) const
+{
+	if ( elementIndex )
+	{
+		std::unordered_map< std::string, TiXmlElementIndex::Lists >::const_iterator values = elementIndex->attributes.find( name );
+		if ( values != elementIndex->attributes.end() )
+		{
+			if ( elementIndex->stale )
+				elementIndex->Rebuild( this );
+			TiXmlElementIndex::Lists::const_iterator it = values->second.find( value );
+			return ( it == values->second.end() ) ? 0 : it->second.front();
+		}
+	}
+
+	const TiXmlElement* found = 0;
+	ForEachElement( this, [&]( const TiXmlElement* element ) {
+		const TiXmlAttribute* attrib = found ? 0 : element->FindAttribute( name );
+		if ( attrib && attrib->ValueStr() == value )
+			found = element;
+	} );
+	return found;
+}
+
+
+void TiXmlDocument::Reset()
+{
+	// Recycle back to front: the free lists are stacks, so the nodes come
+	// out again in document order, and a message of the same shape lands
+	// every string in a buffer that has already grown to fit it.
+	TiXmlNode* node = lastChild;
+	firstChild = 0;
+	lastChild = 0;
+	while ( node )
+	{
+		TiXmlNode* prevNode = node->prev;
+		RecycleNode( node );
+		node = prevNode;
+	}
+	ChildrenChanged();
+	IndexStale();
+
+	ClearError();
+	location.Clear();
+	useMicrosoftBOM = false;
+}
+
+
+void TiXmlDocument::ShrinkToFit()
+{
+	for( int i=0; i<TINYXML_TYPECOUNT; ++i )
+	{
+		for( size_t j=0; j<freeNodes[i].size(); ++j )
+			delete freeNodes[i][j];
+		std::vector<TiXmlNode*>().swap( freeNodes[i] );
+	}
+	for( size_t j=0; j<freeAttributes.size(); ++j )
+		delete freeAttributes[j];
+	std::vector<TiXmlAttribute*>().swap( freeAttributes );
+}
+
+
+TiXmlNode* TiXmlDocument::NewNode( NodeType nodeType )
+{
+	std::vector<TiXmlNode*>& pool = freeNodes[ nodeType ];
+	if ( !pool.empty() )
+	{
+		TiXmlNode* node = pool.back();
+		pool.pop_back();
+		return node;
+	}
+
+	switch ( nodeType )
+	{
+		case TINYXML_ELEMENT:		return new TiXmlElement( "" );
+		case TINYXML_COMMENT:		return new TiXmlComment();
+		case TINYXML_UNKNOWN:		return new TiXmlUnknown();
+		case TINYXML_TEXT:			return new TiXmlText( "" );
+		case TINYXML_DECLARATION:	return new TiXmlDeclaration();
+		default:
+			assert( 0 );			// documents are never pooled
+			return 0;
+	}
+}
+
 
-	Parse( str.begin(),str.end(), 0, encoding );
+TiXmlAttribute* TiXmlDocument::NewAttribute()
+{
+	if ( freeAttributes.empty() )
+		return new TiXmlAttribute();
 
-	return !Error();
+	TiXmlAttribute* attrib = freeAttributes.back();
+	freeAttributes.pop_back();
+	return attrib;
 }
 
 
-bool TiXmlDocument::SaveFile(const std::string& filename) const
+void TiXmlDocument::RecycleNode( TiXmlNode* node )
 {
-	// The old c stuff lives on...
-	ofstream f( filename);
-	if ( f )
+	assert( node->Type() != TINYXML_DOCUMENT );
+
+	TiXmlNode* child = node->lastChild;
+	while ( child )
 	{
-		bool result = SaveFile( f );
-		return result;
+		TiXmlNode* prevChild = child->prev;
+		RecycleNode( child );
+		child = prevChild;
 	}
-	return false;
-}
+	node->firstChild = 0;
+	node->lastChild = 0;
 
-bool TiXmlDocument::SaveFile(std::ofstream &fout) const
-{
-	if ( useMicrosoftBOM ) 
+	// Only the library's own types go back in the free lists, which hand
+	// nodes out as those types; a subclass of the application's is deleted.
+	if ( !node->IsLibraryType() )
 	{
-		const unsigned char TIXML_UTF_LEAD_0 = 0xefU;
-		const unsigned char TIXML_UTF_LEAD_1 = 0xbbU;
-		const unsigned char TIXML_UTF_LEAD_2 = 0xbfU;
+		delete node;
+		return;
+	}
 
-		fout.put(TIXML_UTF_LEAD_0);
-		fout.put( TIXML_UTF_LEAD_1 );
-		fout.put( TIXML_UTF_LEAD_2 );
+	// Back to the state of a freshly constructed node. clear() keeps
+	// the capacity of the strings, which is the point.
+	node->parent = 0;
+	node->prev = 0;
+	node->next = 0;
+	node->firstChild = 0;
+	node->lastChild = 0;
+	node->EnableChildIndex( false );
+	node->value.clear();
+	node->userData = 0;
+	node->location.Clear();
+
+	switch ( node->Type() )
+	{
+		case TINYXML_ELEMENT:
+			static_cast<TiXmlElement*>( node )->attributeSet.ReleaseTo( freeAttributes );
+			break;
+		case TINYXML_TEXT:
+			static_cast<TiXmlText*>( node )->cdata = false;
+			break;
+		case TINYXML_DECLARATION:
+		{
+			TiXmlDeclaration* decl = static_cast<TiXmlDeclaration*>( node );
+			decl->version.clear();
+			decl->encoding.clear();
+			decl->standalone.clear();
+			break;
+		}
+		default:
+			break;
 	}
-	Print( fout, 0 );
-	return (fout.good());
+	freeNodes[ node->Type() ].push_back( node );
 }
 
 
@@ -953,12 +2181,44 @@ void TiXmlDocument::CopyTo( TiXmlDocument* target ) const
 	target->tabsize = tabsize;
 	target->errorLocation = errorLocation;
 	target->useMicrosoftBOM = useMicrosoftBOM;
+	// The indexes are not copied, only asked for: the copy builds its own.
+	CopyIndexesTo( target );
 
-	TiXmlNode* node = 0;
-	for ( node = firstChild; node; node = node->NextSibling() )
-	{
-		target->LinkEndChild( node->Clone() );
-	}	
+	CloneChildrenTo( target );
+}
+
+
+void TiXmlDocument::MoveTo( TiXmlDocument* target )
+{
+	// The children come along, and with them every node below: they
+	// find their document by walking up, so nothing else needs fixing.
+	TiXmlNode::MoveTo( target );
+
+	target->error = error;
+	target->errorId = errorId;
+	target->errorDesc = std::move( errorDesc );
+	target->tabsize = tabsize;
+	target->errorLocation = errorLocation;
+	target->useMicrosoftBOM = useMicrosoftBOM;
+	CopyIndexesTo( target );
+	ClearError();
+	useMicrosoftBOM = false;
+
+	// The free lists are swapped, so neither document leaks storage.
+	for( int i=0; i<TINYXML_TYPECOUNT; ++i )
+		target->freeNodes[i].swap( freeNodes[i] );
+	target->freeAttributes.swap( freeAttributes );
+}
+
+
+TiXmlNode* TiXmlDocument::MoveClone()
+{
+	if ( !IsLibraryType() )
+		return Clone();
+
+	TiXmlDocument* clone = new TiXmlDocument();
+	MoveTo( clone );
+	return clone;
 }
 
 
@@ -973,17 +2233,6 @@ TiXmlNode* TiXmlDocument::Clone() const
 }
 
 
-void TiXmlDocument::Print(std::ostream & file, int depth) const
-{
-	assert( file );
-	for ( const TiXmlNode* node=FirstChild(); node; node=node->NextSibling() )
-	{
-		node->Print( file, depth );
-		 file<< "\n";
-	}
-}
-
-
 bool TiXmlDocument::Accept( TiXmlVisitor* visitor ) const
 {
 	if ( visitor->VisitEnter( *this ) )
@@ -998,114 +2247,138 @@ bool TiXmlDocument::Accept( TiXmlVisitor* visitor ) const
 }
 
 
-const TiXmlAttribute* TiXmlAttribute::Next() const
+TiXmlDoubleBufferedDocument::TiXmlDoubleBufferedDocument()
+	: current( std::make_shared<TiXmlDocument>() ), version( 0 )
 {
-	// We are using knowledge of the sentinel. The sentinel
-	// have a value or name.
-	if ( next->value.empty() && next->name.empty() )
-		return 0;
-	return next;
 }
 
-/*
-TiXmlAttribute* TiXmlAttribute::Next()
+
+TiXmlDoubleBufferedDocument::TiXmlDoubleBufferedDocument( TiXmlDocument&& document )
+	: version( 0 )
+{
+	std::shared_ptr<TiXmlDocument> first = std::make_shared<TiXmlDocument>( std::move( document ) );
+	Publish( std::move( first ) );
+	version.store( 0, std::memory_order_release );
+}
+
+
+void TiXmlDoubleBufferedDocument::Replace( TiXmlDocument&& document )
+{
+	std::lock_guard<std::mutex> lock( writer );
+	Publish( std::make_shared<TiXmlDocument>( std::move( document ) ) );
+}
+
+
+std::shared_ptr<TiXmlDocument> TiXmlDoubleBufferedDocument::Draft()
+{
+	Snapshot now = std::atomic_load( &current );
+
+	// A retired version nobody else holds can't be picked up again (it is
+	// no longer current), so its storage is ours to overwrite.
+	if ( retired && retired.use_count() == 1 )
+	{
+		std::atomic_thread_fence( std::memory_order_acquire );	// the last reader is done with it
+		std::shared_ptr<TiXmlDocument> draft = std::move( retired );
+		*draft = *now;
+		return draft;
+	}
+	retired.reset();
+	return std::make_shared<TiXmlDocument>( *now );
+}
+
+
+void TiXmlDoubleBufferedDocument::Publish( std::shared_ptr<TiXmlDocument> draft )
+{
+	// The document's indexes are rebuilt lazily, which would be a write
+	// from the const API. Bring them up to date while the version is still
+	// private. Child indexes need nothing: they rebuild under their own lock.
+	draft->UpdateIndexes();
+
+	Snapshot published( std::move( draft ) );
+	Snapshot old = std::atomic_exchange( &current, published );
+	retired = std::const_pointer_cast<TiXmlDocument>( old );
+	version.fetch_add( 1, std::memory_order_acq_rel );
+}
+
+
+const TiXmlAttribute* TiXmlAttribute::Next() const
 {
-	// We are using knowledge of the sentinel. The sentinel
-	// have a value or name.
-	if ( next->value.empty() && next->name.empty() )
+	if ( !set || index+1 >= set->count )
 		return 0;
-	return next;
+	return set->slots[ index+1 ];
 }
-*/
+
 
 const TiXmlAttribute* TiXmlAttribute::Previous() const
 {
-	// We are using knowledge of the sentinel. The sentinel
-	// have a value or name.
-	if ( prev->value.empty() && prev->name.empty() )
+	if ( !set || index <= 0 )
 		return 0;
-	return prev;
+	return set->slots[ index-1 ];
 }
 
-/*
-TiXmlAttribute* TiXmlAttribute::Previous()
+
+void TiXmlAttribute::SetName( const std::string & _name )
 {
-	// We are using knowledge of the sentinel. The sentinel
-	// have a value or name.
-	if ( prev->value.empty() && prev->name.empty() )
-		return 0;
-	return prev;
+	name = _name;
+	// The hash index is keyed on the name.
+	if ( set && set->table )
+		set->Rehash();
 }
-*/
+
 
 void TiXmlAttribute::Print(std::ostream & file, int depth, std::string * str ) const
 {
-	std::string n, v;
-
-	EncodeString( name, &n );
-	EncodeString( value, &v );
+	const char quote = ( value.find( '\"' ) == std::string::npos ) ? '\"' : '\'';
 
-	if (value.find ('\"') == std::string::npos) {
-		if ( file ) {
-			file<< n<<"=\""<<v<<"\"";
-		}
-		if ( str ) {
-			(*str) += n; (*str) += "=\""; (*str) += v; (*str) += "\"";
-		}
+	if ( str ) {
+		// Straight into the output, no temporaries.
+		EncodeString( name, str );
+		(*str) += '=';
+		(*str) += quote;
+		EncodeString( value, str );
+		(*str) += quote;
 	}
-	else {
-		if ( file ) {
-			file<< n<<"='"<<v<<"'";
-		}
-		if ( str ) {
-			(*str) += n; (*str) += "='"; (*str) += v; (*str) += "'";
-		}
+	if ( file ) {
+		std::string n, v;
+		EncodeString( name, &n );
+		EncodeString( value, &v );
+		file<< n<<"="<<quote<<v<<quote;
 	}
 }
 
 
 int TiXmlAttribute::QueryIntValue( int* ival ) const
 {
-	size_t idx = 0;
-	int temp = stoi(value, &idx);
-	if (idx != 0)
-	{
-		*ival = temp;
-		return TIXML_SUCCESS;
-	}
-	return TIXML_WRONG_TYPE;
+	return ReadValue( value, ival );
 }
 
 int TiXmlAttribute::QueryDoubleValue( double* dval ) const
 {
-	size_t idx=0;
-	double temp = stod(value,&idx);
-	if (idx != 0)
-	{
-		*dval = temp;
-		return TIXML_SUCCESS;
-	}
-	return TIXML_WRONG_TYPE;
+	return ReadValue( value, dval );
 }
 
 void TiXmlAttribute::SetIntValue( int _value )
 {
-	SetValue(to_string(_value));
+	SetValueOf( _value );
 }
 
 void TiXmlAttribute::SetDoubleValue( double _value )
 {
-	SetValue (to_string(_value));
+	SetValueOf( _value );
 }
 
 int TiXmlAttribute::IntValue() const
 {
-	return stoi (value);
+	int result = 0;
+	QueryIntValue( &result );
+	return result;
 }
 
 double  TiXmlAttribute::DoubleValue() const
 {
-	return stod (value);
+	double result = 0;
+	QueryDoubleValue( &result );
+	return result;
 }
 
 
@@ -1123,14 +2396,11 @@ TiXmlComment& TiXmlComment::operator=( const TiXmlComment& base )
 }
 
 
-void TiXmlComment::Print(std::ostream & file, int depth) const
+TiXmlComment& TiXmlComment::operator=( TiXmlComment&& base )
 {
-	assert( file );
-	for ( int i=0; i<depth; i++ )
-	{
-		file<<  "    " ;
-	}
-	file<< "<!--"<<value<<"-->";
+	if ( this != &base )
+		base.MoveTo( this );
+	return *this;
 }
 
 
@@ -1140,6 +2410,12 @@ void TiXmlComment::CopyTo( TiXmlComment* target ) const
 }
 
 
+void TiXmlComment::MoveTo( TiXmlComment* target )
+{
+	TiXmlNode::MoveTo( target );
+}
+
+
 bool TiXmlComment::Accept( TiXmlVisitor* visitor ) const
 {
 	return visitor->Visit( *this );
@@ -1158,24 +2434,14 @@ TiXmlNode* TiXmlComment::Clone() const
 }
 
 
-void TiXmlText::Print(std::ostream & file, int depth) const
+TiXmlNode* TiXmlComment::MoveClone()
 {
-	assert( file );
-	if ( cdata )
-	{
-		int i;
-		file<< "\n" ;
-		for ( i=0; i<depth; i++ ) {
-			file<< "    " ;
-		}
-		file<< "<![CDATA["<<value<<"]]>\n";	// unformatted output
-	}
-	else
-	{
-		std::string buffer;
-		EncodeString( value, &buffer );
-		file<<buffer;
-	}
+	if ( !IsLibraryType() )
+		return Clone();
+
+	TiXmlComment* clone = new TiXmlComment();
+	MoveTo( clone );
+	return clone;
 }
 
 
@@ -1186,6 +2452,13 @@ void TiXmlText::CopyTo( TiXmlText* target ) const
 }
 
 
+void TiXmlText::MoveTo( TiXmlText* target )
+{
+	TiXmlNode::MoveTo( target );
+	target->cdata = cdata;
+}
+
+
 bool TiXmlText::Accept( TiXmlVisitor* visitor ) const
 {
 	return visitor->Visit( *this );
@@ -1205,6 +2478,17 @@ TiXmlNode* TiXmlText::Clone() const
 }
 
 
+TiXmlNode* TiXmlText::MoveClone()
+{
+	if ( !IsLibraryType() )
+		return Clone();
+
+	TiXmlText* clone = new TiXmlText( std::string() );
+	MoveTo( clone );
+	return clone;
+}
+
+
 TiXmlDeclaration::TiXmlDeclaration( const char * _version,
 									const char * _encoding,
 									const char * _standalone )
@@ -1233,6 +2517,13 @@ TiXmlDeclaration::TiXmlDeclaration( const TiXmlDeclaration& copy )
 }
 
 
+TiXmlDeclaration::TiXmlDeclaration( TiXmlDeclaration&& other )
+	: TiXmlNode( TiXmlNode::TINYXML_DECLARATION )
+{
+	other.MoveTo( this );
+}
+
+
 TiXmlDeclaration& TiXmlDeclaration::operator=( const TiXmlDeclaration& copy )
 {
 	Clear();
@@ -1241,6 +2532,14 @@ TiXmlDeclaration& TiXmlDeclaration::operator=( const TiXmlDeclaration& copy )
 }
 
 
+TiXmlDeclaration& TiXmlDeclaration::operator=( TiXmlDeclaration&& other )
+{
+	if ( this != &other )
+		other.MoveTo( this );
+	return *this;
+}
+
+
 void TiXmlDeclaration::Print(std::ostream & file, int depth, std::string * str ) const
 {
 	if ( file ) file<<"<?xml " ;
@@ -1273,6 +2572,19 @@ void TiXmlDeclaration::CopyTo( TiXmlDeclaration* target ) const
 }
 
 
+void TiXmlDeclaration::MoveTo( TiXmlDeclaration* target )
+{
+	TiXmlNode::MoveTo( target );
+
+	target->version = std::move( version );
+	target->encoding = std::move( encoding );
+	target->standalone = std::move( standalone );
+	version.clear();
+	encoding.clear();
+	standalone.clear();
+}
+
+
 bool TiXmlDeclaration::Accept( TiXmlVisitor* visitor ) const
 {
 	return visitor->Visit( *this );
@@ -1291,11 +2603,14 @@ TiXmlNode* TiXmlDeclaration::Clone() const
 }
 
 
-void TiXmlUnknown::Print(std::ostream & file, int depth) const
+TiXmlNode* TiXmlDeclaration::MoveClone()
 {
-	for ( int i=0; i<depth; i++ )
-		file<< "    ";
-	file<< "<"<<value<<">";
+	if ( !IsLibraryType() )
+		return Clone();
+
+	TiXmlDeclaration* clone = new TiXmlDeclaration();
+	MoveTo( clone );
+	return clone;
 }
 
 
@@ -1305,6 +2620,12 @@ void TiXmlUnknown::CopyTo( TiXmlUnknown* target ) const
 }
 
 
+void TiXmlUnknown::MoveTo( TiXmlUnknown* target )
+{
+	TiXmlNode::MoveTo( target );
+}
+
+
 bool TiXmlUnknown::Accept( TiXmlVisitor* visitor ) const
 {
 	return visitor->Visit( *this );
@@ -1323,70 +2644,244 @@ TiXmlNode* TiXmlUnknown::Clone() const
 }
 
 
+TiXmlNode* TiXmlUnknown::MoveClone()
+{
+	if ( !IsLibraryType() )
+		return Clone();
+
+	TiXmlUnknown* clone = new TiXmlUnknown();
+	MoveTo( clone );
+	return clone;
+}
+
+
 TiXmlAttributeSet::TiXmlAttributeSet()
 {
-	sentinel.next = &sentinel;
-	sentinel.prev = &sentinel;
+	slots = inlineSlots;
+	count = 0;
+	capacity = INLINE_SLOTS;
+	table = 0;
+	tableMask = 0;
 }
 
 
 TiXmlAttributeSet::~TiXmlAttributeSet()
 {
-	assert( sentinel.next == &sentinel );
-	assert( sentinel.prev == &sentinel );
+	assert( count == 0 );
+	if ( slots != inlineSlots )
+		delete [] slots;
+	delete [] table;
+}
+
+
+unsigned TiXmlAttributeSet::Hash( std::string_view name )
+{
+	// FNV-1a. Attribute names are short; this is plenty.
+	unsigned h = 2166136261u;
+	for( size_t i=0; i<name.size(); ++i )
+	{
+		h ^= (unsigned char) name[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+
+void TiXmlAttributeSet::Reserve( int newCapacity )
+{
+	if ( newCapacity <= capacity )
+		return;
+
+	TiXmlAttribute** newSlots = new TiXmlAttribute*[ newCapacity ];
+	for( int i=0; i<count; ++i )
+		newSlots[i] = slots[i];
+	if ( slots != inlineSlots )
+		delete [] slots;
+	slots = newSlots;
+	capacity = newCapacity;
+}
+
+
+void TiXmlAttributeSet::Rehash()
+{
+	if ( count < INDEX_THRESHOLD )
+	{
+		delete [] table;
+		table = 0;
+		tableMask = 0;
+		return;
+	}
+
+	// Keep the load factor at or below 1/2.
+	unsigned size = 16;
+	while ( size < (unsigned)count * 2 )
+		size *= 2;
+
+	if ( !table || size != tableMask+1 )
+	{
+		delete [] table;
+		table = new int[ size ];
+		tableMask = size - 1;
+	}
+	for( unsigned i=0; i<size; ++i )
+		table[i] = 0;
+
+	for( int i=0; i<count; ++i )
+	{
+		unsigned h = Hash( slots[i]->name ) & tableMask;
+		while ( table[h] )
+			h = ( h + 1 ) & tableMask;
+		table[h] = i + 1;
+	}
 }
 
 
 void TiXmlAttributeSet::Add( TiXmlAttribute* addMe )
 {
-	assert( !Find( std::string( addMe->NameTStr() ) ) );	// Shouldn't be multiply adding to the set.
+	assert( !addMe->set );
+	assert( !Find( addMe->NameTStr() ) );	// Shouldn't be multiply adding to the set.
 
-	addMe->next = &sentinel;
-	addMe->prev = sentinel.prev;
+	if ( count == capacity )
+		Reserve( capacity * 2 );
 
-	sentinel.prev->next = addMe;
-	sentinel.prev      = addMe;
+	addMe->set = this;
+	addMe->index = count;
+	slots[ count++ ] = addMe;
+
+	if ( table && (unsigned)count * 2 <= tableMask + 1 )
+	{
+		// Room in the existing index: just insert.
+		unsigned h = Hash( addMe->name ) & tableMask;
+		while ( table[h] )
+			h = ( h + 1 ) & tableMask;
+		table[h] = count;
+	}
+	else if ( count >= INDEX_THRESHOLD )
+	{
+		Rehash();
+	}
 }
 
+
 void TiXmlAttributeSet::Remove( TiXmlAttribute* removeMe )
 {
-	TiXmlAttribute* node;
+	if ( removeMe->set != this )
+	{
+		assert( 0 );		// we tried to remove a non-linked attribute.
+		return;
+	}
+	assert( slots[ removeMe->index ] == removeMe );
 
-	for( node = sentinel.next; node != &sentinel; node = node->next )
+	for( int i=removeMe->index+1; i<count; ++i )
 	{
-		if ( node == removeMe )
-		{
-			node->prev->next = node->next;
-			node->next->prev = node->prev;
-			node->next = 0;
-			node->prev = 0;
-			return;
-		}
+		slots[i-1] = slots[i];
+		slots[i-1]->index = i-1;
 	}
-	assert( 0 );		// we tried to remove a non-linked attribute.
+	--count;
+
+	removeMe->set = 0;
+	removeMe->index = -1;
+
+	// Positions have shifted; removal is rare enough to simply rebuild.
+	if ( table )
+		Rehash();
 }
 
-TiXmlAttribute* TiXmlAttributeSet::Find( const std::string& name ) const
+
+TiXmlAttribute* TiXmlAttributeSet::Find( std::string_view name ) const
 {
-	for( TiXmlAttribute* node = sentinel.next; node != &sentinel; node = node->next )
+	if ( table )
 	{
-		if ( node->name == name )
-			return node;
+		unsigned h = Hash( name ) & tableMask;
+		while ( table[h] )
+		{
+			TiXmlAttribute* node = slots[ table[h]-1 ];
+			if ( node->name == name )
+				return node;
+			h = ( h + 1 ) & tableMask;
+		}
+		return 0;
+	}
+
+	for( int i=0; i<count; ++i )
+	{
+		if ( slots[i]->name == name )
+			return slots[i];
 	}
 	return 0;
 }
 
-TiXmlAttribute* TiXmlAttributeSet::FindOrCreate( const std::string& _name )
+TiXmlAttribute* TiXmlAttributeSet::FindOrCreate( std::string_view _name )
 {
 	TiXmlAttribute* attrib = Find( _name );
 	if ( !attrib ) {
 		attrib = new TiXmlAttribute();
+		attrib->SetName( std::string( _name ) );
 		Add( attrib );
-		attrib->SetName( _name );
 	}
 	return attrib;
 }
 
+
+void TiXmlAttributeSet::MoveFrom( TiXmlAttributeSet& other )
+{
+	assert( count == 0 );
+	if ( &other == this )
+		return;
+
+	if ( other.slots == other.inlineSlots )
+	{
+		// Few enough to fit our slots, whatever they are.
+		for( int i=0; i<other.count; ++i )
+			slots[i] = other.slots[i];
+	}
+	else
+	{
+		if ( slots != inlineSlots )
+			delete [] slots;
+		slots = other.slots;
+		capacity = other.capacity;
+		other.slots = other.inlineSlots;
+		other.capacity = INLINE_SLOTS;
+	}
+	count = other.count;
+	other.count = 0;
+
+	delete [] table;
+	table = other.table;
+	tableMask = other.tableMask;
+	other.table = 0;
+	other.tableMask = 0;
+
+	for( int i=0; i<count; ++i )
+		slots[i]->set = this;
+}
+
+
+void TiXmlAttributeSet::ReleaseTo( std::vector<TiXmlAttribute*>& pool )
+{
+	// Last first, so the pool hands them out again in document order.
+	for( int i=count-1; i>=0; --i )
+	{
+		TiXmlAttribute* attrib = slots[i];
+		attrib->set = 0;
+		attrib->index = -1;
+		attrib->document = 0;
+		attrib->name.clear();
+		attrib->value.clear();
+		attrib->userData = 0;
+		attrib->location.Clear();
+		pool.push_back( attrib );
+	}
+	count = 0;
+
+	if ( table )
+	{
+		for( unsigned i=0; i<=tableMask; ++i )
+			table[i] = 0;
+	}
+}
+
 std::istream& operator>> (std::istream & in, TiXmlNode & base)
 {
 	std::string tag;
@@ -1400,10 +2895,11 @@ std::istream& operator>> (std::istream & in, TiXmlNode & base)
 
 std::ostream& operator<< (std::ostream & out, const TiXmlNode & base)
 {
-	TiXmlPrinter printer;
+	TiXmlStreamSink sink( out );
+	TiXmlPrinter printer( &sink );
 	printer.SetStreamPrinting();
 	base.Accept( &printer );
-	out << printer.Str();
+	sink.Flush();
 
 	return out;
 }
@@ -1411,14 +2907,24 @@ std::ostream& operator<< (std::ostream & out, const TiXmlNode & base)
 
 std::string& operator<< (std::string& out, const TiXmlNode& base )
 {
-	TiXmlPrinter printer;
+	TiXmlStringSink sink( &out );
+	TiXmlPrinter printer( &sink );
 	printer.SetStreamPrinting();
 	base.Accept( &printer );
-	out.append( printer.Str() );
 
 	return out;
 }
 
+
+void TiXmlNode::Print( std::ostream& file, int depth ) const
+{
+	TiXmlStreamSink sink( file );
+	TiXmlPrinter printer( &sink );
+	printer.SetDepth( depth );
+	Accept( &printer );
+	sink.Flush();
+}
+
 TiXmlHandle TiXmlHandle::FirstChild() const
 {
 	if ( node )
@@ -1470,18 +2976,7 @@ TiXmlHandle TiXmlHandle::FirstChildElement( const char * value ) const
 TiXmlHandle TiXmlHandle::Child( int count ) const
 {
 	if ( node )
-	{
-		int i;
-		TiXmlNode* child = node->FirstChild();
-		for (	i=0;
-				child && i<count;
-				child = child->NextSibling(), ++i )
-		{
-			// nothing
-		}
-		if ( child )
-			return TiXmlHandle( child );
-	}
+		return TiXmlHandle( node->ChildAt( count ) );
 	return TiXmlHandle( 0 );
 }
 
@@ -1489,18 +2984,7 @@ TiXmlHandle TiXmlHandle::Child( int count ) const
 TiXmlHandle TiXmlHandle::Child( const char* value, int count ) const
 {
 	if ( node )
-	{
-		int i;
-		TiXmlNode* child = node->FirstChild( value );
-		for (	i=0;
-				child && i<count;
-				child = child->NextSibling( value ), ++i )
-		{
-			// nothing
-		}
-		if ( child )
-			return TiXmlHandle( child );
-	}
+		return TiXmlHandle( node->ChildAt( value, count ) );
 	return TiXmlHandle( 0 );
 }
 
@@ -1508,18 +2992,7 @@ TiXmlHandle TiXmlHandle::Child( const char* value, int count ) const
 TiXmlHandle TiXmlHandle::ChildElement( int count ) const
 {
 	if ( node )
-	{
-		int i;
-		TiXmlElement* child = node->FirstChildElement();
-		for (	i=0;
-				child && i<count;
-				child = child->NextSiblingElement(), ++i )
-		{
-			// nothing
-		}
-		if ( child )
-			return TiXmlHandle( child );
-	}
+		return TiXmlHandle( node->ChildElementAt( count ) );
 	return TiXmlHandle( 0 );
 }
 
@@ -1527,24 +3000,60 @@ TiXmlHandle TiXmlHandle::ChildElement( int count ) const
 TiXmlHandle TiXmlHandle::ChildElement( const char* value, int count ) const
 {
 	if ( node )
+		return TiXmlHandle( node->ChildElementAt( value, count ) );
+	return TiXmlHandle( 0 );
+}
+
+
+size_t TiXmlPrinter::EstimateSize( const TiXmlDocument& doc ) const
+{
+	size_t size = 0;
+	int level = 0;
+	for( const TiXmlNode* node = doc.FirstChild(); node; )
 	{
-		int i;
-		TiXmlElement* child = node->FirstChildElement( value );
-		for (	i=0;
-				child && i<count;
-				child = child->NextSiblingElement( value ), ++i )
+		size += level * indent.size() + lineBreak.size();
+		if ( const TiXmlElement* element = node->ToElement() )
 		{
-			// nothing
+			// Start and end tags, each on its own line.
+			size += level * indent.size() + lineBreak.size() + 2 * element->ValueStr().size() + 5;
+			for( const TiXmlAttribute* attrib = element->FirstAttribute(); attrib; attrib = attrib->Next() )
+				size += attrib->NameTStr().size() + attrib->ValueStr().size() + 4;
 		}
-		if ( child )
-			return TiXmlHandle( child );
+		else
+		{
+			// Room for the markup around it, and for some escaping.
+			const std::string& value = node->ValueStr();
+			size += value.size() + value.size() / 16 + 12;
+			if ( const TiXmlDeclaration* declaration = node->ToDeclaration() )
+				size += declaration->Version().size() + declaration->Encoding().size() + declaration->Standalone().size() + 48;
+		}
+
+		if ( node->FirstChild() )
+		{
+			node = node->FirstChild();
+			++level;
+			continue;
+		}
+		while ( node != &doc && !node->NextSibling() )
+		{
+			node = node->Parent();
+			--level;
+		}
+		node = ( node == &doc ) ? 0 : node->NextSibling();
 	}
-	return TiXmlHandle( 0 );
+	return size;
 }
 
 
-bool TiXmlPrinter::VisitEnter( const TiXmlDocument& )
+bool TiXmlPrinter::VisitEnter( const TiXmlDocument& doc )
 {
+	// Grow the buffer once, rather than all along the way. A sink that
+	// drains as it goes needs no more than it has, so the tree isn't
+	// walked for it.
+	if ( !sink )
+		buffer.reserve( buffer.size() + EstimateSize( doc ) );
+	else if ( sink->WantsReserve() )
+		sink->Reserve( EstimateSize( doc ) );
 	return true;
 }
 
@@ -1555,25 +3064,31 @@ bool TiXmlPrinter::VisitExit( const TiXmlDocument& )
 
 bool TiXmlPrinter::VisitEnter( const TiXmlElement& element, const TiXmlAttribute* firstAttribute )
 {
-	DoIndent();
-	buffer += "<";
-	buffer += element.Value();
+	std::string& out = Out();
+	DoIndent( out );
+	out += '<';
+	out += element.ValueStr();
 
 	for( const TiXmlAttribute* attrib = firstAttribute; attrib; attrib = attrib->Next() )
 	{
-		buffer += " ";
-		ofstream fout;
-		attrib->Print( fout, 0, &buffer );
+		const std::string& value = attrib->ValueStr();
+		const char quote = ( value.find( '\"' ) == std::string::npos ) ? '\"' : '\'';
+		out += ' ';
+		TiXmlBase::EncodeString( attrib->NameTStr(), &out );
+		out += '=';
+		out += quote;
+		TiXmlBase::EncodeString( value, &out );
+		out += quote;
 	}
 
 	if ( !element.FirstChild() ) 
 	{
-		buffer += " />";
-		DoLineBreak();
+		out += " />";
+		DoLineBreak( out );
 	}
 	else 
 	{
-		buffer += ">";
+		out += ">";
 		if (    element.FirstChild()->ToText()
 			  && element.LastChild() == element.FirstChild()
 			  && element.FirstChild()->ToText()->CDATA() == false )
@@ -1583,16 +3098,18 @@ bool TiXmlPrinter::VisitEnter( const TiXmlElement& element, const TiXmlAttribute
 		}
 		else
 		{
-			DoLineBreak();
+			DoLineBreak( out );
 		}
 	}
 	++depth;	
+	Done();
 	return true;
 }
 
 
 bool TiXmlPrinter::VisitExit( const TiXmlElement& element )
 {
+	std::string& out = Out();
 	--depth;
 	if ( !element.FirstChild() ) 
 	{
@@ -1606,73 +3123,93 @@ bool TiXmlPrinter::VisitExit( const TiXmlElement& element )
 		}
 		else
 		{
-			DoIndent();
+			DoIndent( out );
 		}
-		buffer += "</";
-		buffer += element.Value();
-		buffer += ">";
-		DoLineBreak();
+		out += "</";
+		out += element.ValueStr();
+		out += '>';
+		DoLineBreak( out );
 	}
+	Done();
 	return true;
 }
 
 
 bool TiXmlPrinter::Visit( const TiXmlText& text )
 {
+	std::string& out = Out();
 	if ( text.CDATA() )
 	{
-		DoIndent();
-		buffer += "<![CDATA[";
-		buffer += text.Value();
-		buffer += "]]>";
-		DoLineBreak();
+		DoIndent( out );
+		out += "<![CDATA[";
+		out += text.ValueStr();
+		out += "]]>";
+		DoLineBreak( out );
 	}
 	else if ( simpleTextPrint )
 	{
-		std::string str;
-		TiXmlBase::EncodeString( text.ValueTStr(), &str );
-		buffer += str;
+		TiXmlBase::EncodeString( text.ValueTStr(), &out, TIXML_ESCAPE_TEXT );
 	}
 	else
 	{
-		DoIndent();
-		std::string str;
-		TiXmlBase::EncodeString( text.ValueTStr(), &str );
-		buffer += str;
-		DoLineBreak();
+		DoIndent( out );
+		TiXmlBase::EncodeString( text.ValueTStr(), &out, TIXML_ESCAPE_TEXT );
+		DoLineBreak( out );
 	}
+	Done();
 	return true;
 }
 
 
 bool TiXmlPrinter::Visit( const TiXmlDeclaration& declaration )
 {
-	DoIndent();
-	ofstream fout;
-	declaration.Print( fout, 0, &buffer );
-	DoLineBreak();
+	std::string& out = Out();
+	DoIndent( out );
+	out += "<?xml ";
+	if ( !declaration.Version().empty() ) {
+		out += "version=\"";
+		out += declaration.Version();
+		out += "\" ";
+	}
+	if ( !declaration.Encoding().empty() ) {
+		out += "encoding=\"";
+		out += declaration.Encoding();
+		out += "\" ";
+	}
+	if ( !declaration.Standalone().empty() ) {
+		out += "standalone=\"";
+		out += declaration.Standalone();
+		out += "\" ";
+	}
+	out += "?>";
+	DoLineBreak( out );
+	Done();
 	return true;
 }
 
 
 bool TiXmlPrinter::Visit( const TiXmlComment& comment )
 {
-	DoIndent();
-	buffer += "<!--";
-	buffer += comment.Value();
-	buffer += "-->";
-	DoLineBreak();
+	std::string& out = Out();
+	DoIndent( out );
+	out += "<!--";
+	out += comment.ValueStr();
+	out += "-->";
+	DoLineBreak( out );
+	Done();
 	return true;
 }
 
 
 bool TiXmlPrinter::Visit( const TiXmlUnknown& unknown )
 {
-	DoIndent();
-	buffer += "<";
-	buffer += unknown.Value();
-	buffer += ">";
-	DoLineBreak();
+	std::string& out = Out();
+	DoIndent( out );
+	out += '<';
+	out += unknown.ValueStr();
+	out += '>';
+	DoLineBreak( out );
+	Done();
 	return true;
 }
 
@@ -50,6 +50,23 @@ distribution.
 #include <string>
 #include <iostream>
 #include <sstream>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <map>
+#include <functional>
+#include <cstdio>
+#include <charconv>
+#include <type_traits>
+#include <tuple>
+#include <iterator>
+#include <cstddef>
+#ifdef __cpp_lib_ranges
+#include <ranges>
+#endif
 
 // Deprecated library function hell. Compilers want to use the
 // new safe versions. This probably doesn't fully address the problem,
@@ -79,13 +96,20 @@ distribution.
 #endif	
 
 class TiXmlDocument;
+class TiXmlNode;
 class TiXmlElement;
 class TiXmlComment;
 class TiXmlUnknown;
 class TiXmlAttribute;
+class TiXmlAttributeSet;
 class TiXmlText;
 class TiXmlDeclaration;
 class TiXmlParsingData;
+class TiXmlChildIndex;
+class TiXmlElementIndex;
+class TiXmlTextIndex;
+class TiXmlFrozenDocument;
+class TiXmlOutputSink;
 
 const int TIXML_MAJOR_VERSION = 2;
 const int TIXML_MINOR_VERSION = 6;
@@ -153,7 +177,8 @@ enum
 { 
 	TIXML_SUCCESS,
 	TIXML_NO_ATTRIBUTE,
-	TIXML_WRONG_TYPE
+	TIXML_WRONG_TYPE,
+	TIXML_NO_TEXT			// TiXmlElement::QueryText() of an element without text
 };
 
 
@@ -167,6 +192,26 @@ enum TiXmlEncoding
 
 const TiXmlEncoding TIXML_DEFAULT_ENCODING = TIXML_ENCODING_UNKNOWN;
 
+/** Where an escaped string is going. Attribute values escape both quote
+	characters; text has no need to, and is shorter for it.
+*/
+enum TiXmlEscapeMode
+{
+	TIXML_ESCAPE_ATTRIBUTE,
+	TIXML_ESCAPE_TEXT
+};
+
+/** How a file is compressed. Loading tells from the first bytes of the
+	file; saving picks it from the file name, or is told. gzip needs the
+	library built with TIXML_USE_ZLIB, zstd with TIXML_USE_ZSTD.
+*/
+enum TiXmlCompression
+{
+	TIXML_COMPRESSION_NONE,
+	TIXML_COMPRESSION_GZIP,
+	TIXML_COMPRESSION_ZSTD
+};
+
 /** TiXmlBase is a base class for every class in TinyXml.
 	It does little except to establish that TinyXml classes
 	can be printed and provide some utility functions.
@@ -194,6 +239,7 @@ class TiXmlBase
 	friend class TiXmlNode;
 	friend class TiXmlElement;
 	friend class TiXmlDocument;
+	friend class TiXmlPullParser;
 
 public:
 	TiXmlBase()	:	userData(0)		{}
@@ -254,9 +300,26 @@ public:
 		TiXmlParsingData* data, TiXmlEncoding encoding /*= TIXML_ENCODING_UNKNOWN */ ) = 0;
 
 	/** Expands entities in a string. Note this should not contian the tag's '<', '>', etc, 
-		or they will be transformed into entities!
+		or they will be transformed into entities! The result is appended to 'out'.
+		Runs of characters that need no escaping are found many bytes at a
+		time and copied as a block.
+	*/
+	static void EncodeString( const std::string& str, std::string* out, TiXmlEscapeMode mode = TIXML_ESCAPE_ATTRIBUTE );
+
+	/** Reads a value from the start of a string: an integer of any width,
+		float, double, bool, or an enum by its underlying type. White space
+		before it is skipped. A number is read as far as it goes, so "2.0"
+		reads as the int 2; a bool is "true", "yes", "1", "false", "no" or
+		"0", in any case. Doesn't depend on the locale, never throws, and
+		allocates nothing. Returns TIXML_SUCCESS, or TIXML_WRONG_TYPE (also
+		for a number out of range) and leaves 'value' as it was.
 	*/
-	static void EncodeString( const std::string& str, std::string* out );
+	template< typename T > static int ReadValue( std::string_view str, T* value );
+	/** Appends a value as text that ReadValue() reads back exactly. Floating
+		point values take the shortest such form: 0.1 is "0.1", 3.0 is "3".
+		Bools are "true" and "false".
+	*/
+	template< typename T > static void WriteValue( T value, std::string* out );
 
 	enum
 	{
@@ -276,6 +339,8 @@ public:
 		TIXML_ERROR_EMBEDDED_NULL,
 		TIXML_ERROR_PARSING_CDATA,
 		TIXML_ERROR_DOCUMENT_TOP_ONLY,
+		TIXML_ERROR_DECODING_COMPACT,
+		TIXML_ERROR_COMPRESSION,
 
 		TIXML_ERROR_STRING_COUNT
 	};
@@ -316,7 +381,7 @@ protected:
 		TiXmlEncoding encoding );	// the current encoding
 
 	// If an entity has been found, transform it into a character.
-	static std::string::const_iterator GetEntity( std::string::const_iterator first, std::string::const_iterator last, char & value, int & length, TiXmlEncoding encoding );
+	static std::string::const_iterator GetEntity( std::string::const_iterator first, std::string::const_iterator last, char* value, int & length, TiXmlEncoding encoding );
 
 	// Get a character, while interpreting entities.
 	// The length can be from 0 to 4 bytes.
@@ -325,7 +390,7 @@ protected:
 		assert(first!=last);
 		if ( encoding == TIXML_ENCODING_UTF8 )
 		{
-			length = utf8ByteTable[ *(first) ];
+			length = utf8ByteTable[ (unsigned char) *(first) ];
 			assert( length >= 0 && length < 5 );
 		}
 		else
@@ -336,7 +401,7 @@ protected:
 		if ( length == 1 )
 		{
 			if ( *first == '&' )
-				return GetEntity( first,last, *_value, length, encoding );
+				return GetEntity( first,last, _value, length, encoding );
 			*_value = *first;
 			return first+1;
 		}
@@ -344,7 +409,7 @@ protected:
 		{
 			//strncpy( _value, p, *length );	// lots of compilers don't like this function (unsafe),
 												// and the null terminator isn't needed
-			for( int i=0; first[i] && i<length; ++i ) {
+			for( int i=0; i<length && first+i!=last && first[i]; ++i ) {
 				_value[i] = first[i];
 			}
 			return first + (length);
@@ -361,6 +426,8 @@ protected:
 	// to English words: StringEqual( p, "version", true ) is fine.
 	static bool StringEqual(	std::string::const_iterator first, std::string::const_iterator last,
 		const std::string & tag, bool ignoreCase );
+	static bool StringEqual(	std::string::const_iterator first, std::string::const_iterator last,
+		const char* tag, bool ignoreCase );
 	static bool StringEqual(const std::string &str,	const std::string& tag, bool ignoreCase) 
 	{
 		return StringEqual(str.begin(), str.end(), tag, ignoreCase);
@@ -368,6 +435,10 @@ protected:
 
 	static const char* errorString[ TIXML_ERROR_STRING_COUNT ];
 
+	// For ReadValue(): the position after leading white space, and bools.
+	static const char* SkipSpace( const char* p, const char* end );
+	static int ReadBool( std::string_view str, bool* value );
+
 	TiXmlCursor location;
 
     /// Field containing a generic user pointer
@@ -412,6 +483,214 @@ private:
 };
 
 
+template< typename T > int TiXmlBase::ReadValue( std::string_view str, T* value )
+{
+	if constexpr ( std::is_same_v< T, bool > )
+	{
+		return ReadBool( str, value );
+	}
+	else if constexpr ( std::is_enum_v< T > )
+	{
+		std::underlying_type_t< T > n;
+		int result = ReadValue( str, &n );
+		if ( result == TIXML_SUCCESS )
+			*value = static_cast< T >( n );
+		return result;
+	}
+	else
+	{
+		static_assert( std::is_arithmetic_v< T >, "ReadValue() reads numbers, bools and enums" );
+		const char* end = str.data() + str.size();
+		const char* p = SkipSpace( str.data(), end );
+		if ( p < end && *p == '+' )		// from_chars takes '-' but not '+'
+		{
+			if ( ++p < end && *p == '-' )
+				return TIXML_WRONG_TYPE;
+		}
+		T n;
+		std::from_chars_result result = std::from_chars( p, end, n );
+		if ( result.ec != std::errc() )
+			return TIXML_WRONG_TYPE;
+		*value = n;
+		return TIXML_SUCCESS;
+	}
+}
+
+template< typename T > void TiXmlBase::WriteValue( T value, std::string* out )
+{
+	if constexpr ( std::is_same_v< T, bool > )
+	{
+		out->append( value ? "true" : "false" );
+	}
+	else if constexpr ( std::is_enum_v< T > )
+	{
+		WriteValue( static_cast< std::underlying_type_t< T > >( value ), out );
+	}
+	else
+	{
+		static_assert( std::is_arithmetic_v< T >, "WriteValue() writes numbers, bools and enums" );
+		char buffer[ 64 ];		// the longest long double is under 50
+		std::to_chars_result result = std::to_chars( buffer, buffer + sizeof( buffer ), value );
+		out->append( buffer, result.ptr - buffer );
+	}
+}
+
+
+/** A forward iterator over the children of a node (or, with DEEP, all
+	the nodes under it in document order), yielding T*. When T is
+	TiXmlElement only elements are visited, optionally only those with a
+	given name. Nodes are told apart by their stored type, not ToElement(),
+	so stepping is a few loads and compares.
+
+	Get one from TiXmlNode::Children(), Elements(), Descendants() or
+	DescendantElements(). Changing the tree invalidates the iterators
+	that point at removed nodes, as it would the pointers.
+*/
+template< typename T, bool DEEP = false > class TiXmlNodeIterator
+{
+public:
+	/// TiXmlNode, const if T is.
+	typedef std::conditional_t< std::is_const_v< T >, const TiXmlNode, TiXmlNode > Base;
+
+	typedef std::forward_iterator_tag iterator_category;
+	typedef T* value_type;
+	typedef T* reference;
+	typedef void pointer;
+	typedef std::ptrdiff_t difference_type;
+
+	/// The end of any range.
+	TiXmlNodeIterator() : node( 0 ), root( 0 ) {}
+	/// From 'first', or the first node after it that matches, within 'root' if DEEP.
+	TiXmlNodeIterator( Base* first, const Base* _root, std::string_view _name ) : node( first ), root( _root ), name( _name )	{ Skip(); }
+
+	T* operator*() const								{ return static_cast< T* >( node ); }
+	TiXmlNodeIterator& operator++()						{ Step(); Skip(); return *this; }
+	TiXmlNodeIterator operator++( int )					{ TiXmlNodeIterator was = *this; ++*this; return was; }
+	bool operator==( const TiXmlNodeIterator& other ) const	{ return node == other.node; }
+	bool operator!=( const TiXmlNodeIterator& other ) const	{ return node != other.node; }
+
+private:
+	static constexpr bool ELEMENTS = !std::is_same_v< std::remove_const_t< T >, TiXmlNode >;
+
+	void Step()
+	{
+		if constexpr ( DEEP )
+		{
+			if ( node->FirstChild() )
+			{
+				node = node->FirstChild();
+				return;
+			}
+			while ( node != root && !node->NextSibling() )
+				node = node->Parent();
+			node = ( node == root ) ? 0 : node->NextSibling();
+		}
+		else
+		{
+			node = node->NextSibling();
+		}
+	}
+
+	void Skip()
+	{
+		if constexpr ( ELEMENTS )
+		{
+			while ( node && ( node->Type() != Base::TINYXML_ELEMENT || ( !name.empty() && node->ValueStr() != name ) ) )
+				Step();
+		}
+	}
+
+	Base* node;
+	const Base* root;
+	std::string_view name;
+};
+
+
+/** The nodes a TiXmlNodeIterator visits, as a range for range-based for,
+	the standard algorithms and std::ranges (where it is a borrowed view:
+	it is only a pair of pointers and a name, and its iterators outlive it).
+	The name is not copied; it has to outlive the range.
+*/
+template< typename T, bool DEEP = false > class TiXmlNodeRange
+#ifdef __cpp_lib_ranges
+	: public std::ranges::view_base
+#endif
+{
+public:
+	typedef TiXmlNodeIterator< T, DEEP > iterator;
+	typedef iterator const_iterator;
+	typedef typename iterator::Base Base;
+
+	TiXmlNodeRange() : first( 0 ), root( 0 ) {}
+	TiXmlNodeRange( Base* _first, const Base* _root, std::string_view _name = std::string_view() ) : first( _first ), root( _root ), name( _name ) {}
+
+	iterator begin() const		{ return iterator( first, root, name ); }
+	iterator end() const		{ return iterator(); }
+	bool empty() const			{ return begin() == end(); }
+
+private:
+	Base* first;
+	const Base* root;
+	std::string_view name;
+};
+
+
+/** A forward iterator over the attributes of an element, in document
+	order, yielding A*. It steps through the element's array of
+	attributes, so adding or removing attributes invalidates it.
+*/
+template< typename A > class TiXmlAttributeIterator
+{
+public:
+	typedef std::forward_iterator_tag iterator_category;
+	typedef A* value_type;
+	typedef A* reference;
+	typedef void pointer;
+	typedef std::ptrdiff_t difference_type;
+
+	TiXmlAttributeIterator() : slot( 0 ) {}
+	explicit TiXmlAttributeIterator( TiXmlAttribute* const* _slot ) : slot( _slot ) {}
+
+	A* operator*() const									{ return *slot; }
+	TiXmlAttributeIterator& operator++()					{ ++slot; return *this; }
+	TiXmlAttributeIterator operator++( int )				{ TiXmlAttributeIterator was = *this; ++slot; return was; }
+	bool operator==( const TiXmlAttributeIterator& other ) const	{ return slot == other.slot; }
+	bool operator!=( const TiXmlAttributeIterator& other ) const	{ return slot != other.slot; }
+
+private:
+	TiXmlAttribute* const* slot;
+};
+
+
+/// The attributes of an element, as a range. See TiXmlElement::Attributes().
+template< typename A > class TiXmlAttributeRange
+#ifdef __cpp_lib_ranges
+	: public std::ranges::view_base
+#endif
+{
+public:
+	typedef TiXmlAttributeIterator< A > iterator;
+	typedef iterator const_iterator;
+
+	TiXmlAttributeRange() : first( 0 ), last( 0 ) {}
+	TiXmlAttributeRange( TiXmlAttribute* const* _first, TiXmlAttribute* const* _last ) : first( _first ), last( _last ) {}
+
+	iterator begin() const		{ return iterator( first ); }
+	iterator end() const		{ return iterator( last ); }
+	bool empty() const			{ return first == last; }
+	size_t size() const			{ return last - first; }
+
+private:
+	TiXmlAttribute* const* first;
+	TiXmlAttribute* const* last;
+};
+
+#ifdef __cpp_lib_ranges
+template< typename T, bool DEEP > inline constexpr bool std::ranges::enable_borrowed_range< TiXmlNodeRange< T, DEEP > > = true;
+template< typename A > inline constexpr bool std::ranges::enable_borrowed_range< TiXmlAttributeRange< A > > = true;
+#endif
+
+
 /** The parent class for everything in the Document Object Model.
 	(Except for attributes).
 	Nodes have siblings, a parent, and children. A node can be
@@ -500,7 +779,9 @@ public:
 		@endverbatim
 	*/
 	/// STL std::string form.
-	void SetValue( const std::string& _value )	{ value = _value; }
+	void SetValue( const std::string& _value );
+	/// Takes over the string instead of copying it.
+	void SetValue( std::string&& _value );
 
 	/// Delete all the children of this node. Does not affect 'this'.
 	void Clear();
@@ -561,11 +842,44 @@ public:
 	const TiXmlNode* IterateChildren( const std::string& _value, const TiXmlNode* previous ) const	{	return IterateChildren (_value.c_str (), previous);	}	///< STL std::string form.
 	TiXmlNode* IterateChildren( const std::string& _value, const TiXmlNode* previous ) {	return IterateChildren (_value.c_str (), previous);	}	///< STL std::string form.
 
+	/** The children of this node, as a range:
+		@verbatim
+			for( TiXmlElement* item : order->Elements( "Item" ) )
+				item->QueryIntAttribute( "qty", &qty );
+			auto children = order->Children();
+			size_t comments = std::count_if( children.begin(), children.end(), IsComment );
+		@endverbatim
+		Children() has every child, Elements() the child elements, all of
+		them or those named 'name'. The name is not copied: pass a literal
+		or a string that outlives the loop.
+	*/
+	TiXmlNodeRange< const TiXmlNode > Children() const							{ return TiXmlNodeRange< const TiXmlNode >( firstChild, this ); }
+	TiXmlNodeRange< TiXmlNode > Children()										{ return TiXmlNodeRange< TiXmlNode >( firstChild, this ); }
+	TiXmlNodeRange< const TiXmlElement > Elements( std::string_view name = std::string_view() ) const	{ return TiXmlNodeRange< const TiXmlElement >( firstChild, this, name ); }
+	TiXmlNodeRange< TiXmlElement > Elements( std::string_view name = std::string_view() )				{ return TiXmlNodeRange< TiXmlElement >( firstChild, this, name ); }
+
+	/// Every node under this one, not counting itself, in document order.
+	TiXmlNodeRange< const TiXmlNode, true > Descendants() const					{ return TiXmlNodeRange< const TiXmlNode, true >( firstChild, this ); }
+	TiXmlNodeRange< TiXmlNode, true > Descendants()								{ return TiXmlNodeRange< TiXmlNode, true >( firstChild, this ); }
+	/// The elements under this one, all of them or those named 'name', in document order.
+	TiXmlNodeRange< const TiXmlElement, true > DescendantElements( std::string_view name = std::string_view() ) const	{ return TiXmlNodeRange< const TiXmlElement, true >( firstChild, this, name ); }
+	TiXmlNodeRange< TiXmlElement, true > DescendantElements( std::string_view name = std::string_view() )				{ return TiXmlNodeRange< TiXmlElement, true >( firstChild, this, name ); }
+
 	/** Add a new node related to this. Adds a child past the LastChild.
 		Returns a pointer to the new object or NULL if an error occured.
 	*/
 	TiXmlNode* InsertEndChild( const TiXmlNode& addThis );
 
+	/** Like InsertEndChild(), but the content and children of 'addThis' are
+		moved into the new node rather than cloned. 'addThis' is left empty:
+		@verbatim
+		TiXmlElement item( "Item" );
+		item.SetAttribute( "id", "1" );
+		list->InsertEndChild( std::move( item ) );
+		@endverbatim
+		This works for the other Insert functions and ReplaceChild() as well.
+	*/
+	TiXmlNode* InsertEndChild( TiXmlNode&& addThis );
 
 	/** Add a new node related to this. Adds a child past the LastChild.
 
@@ -578,24 +892,42 @@ public:
 	*/
 	TiXmlNode* LinkEndChild( TiXmlNode* addThis );
 
+	/** Add a new node related to this, taking ownership from a unique_ptr.
+		Returns the (now tinyXml owned) node, or NULL if an error occured.
+	*/
+	TiXmlNode* LinkEndChild( std::unique_ptr<TiXmlNode> addThis );
+
 	/** Add a new node related to this. Adds a child before the specified child.
 		Returns a pointer to the new object or NULL if an error occured.
 	*/
 	TiXmlNode* InsertBeforeChild( TiXmlNode* beforeThis, const TiXmlNode& addThis );
+	TiXmlNode* InsertBeforeChild( TiXmlNode* beforeThis, TiXmlNode&& addThis );	///< Moves 'addThis', see InsertEndChild().
 
 	/** Add a new node related to this. Adds a child after the specified child.
 		Returns a pointer to the new object or NULL if an error occured.
 	*/
 	TiXmlNode* InsertAfterChild(  TiXmlNode* afterThis, const TiXmlNode& addThis );
+	TiXmlNode* InsertAfterChild(  TiXmlNode* afterThis, TiXmlNode&& addThis );	///< Moves 'addThis', see InsertEndChild().
 
 	/** Replace a child of this node.
 		Returns a pointer to the new object or NULL if an error occured.
 	*/
 	TiXmlNode* ReplaceChild( TiXmlNode* replaceThis, const TiXmlNode& withThis );
+	TiXmlNode* ReplaceChild( TiXmlNode* replaceThis, TiXmlNode&& withThis );	///< Moves 'withThis', see InsertEndChild().
 
 	/// Delete a child of this node.
 	bool RemoveChild( TiXmlNode* removeThis );
 
+	/** Unlink a child of this node, with all of its children, and hand it
+		to the caller. Nothing is copied, so this is how to move a subtree
+		to another place, or another document:
+		@verbatim
+		otherParent->LinkEndChild( parent->DetachChild( child ) );
+		@endverbatim
+		Returns null if 'removeThis' is not a child of this node.
+	*/
+	std::unique_ptr<TiXmlNode> DetachChild( TiXmlNode* removeThis );
+
 	/// Navigate to a sibling node.
 	const TiXmlNode* PreviousSibling() const			{ return prev; }
 	TiXmlNode* PreviousSibling()						{ return prev; }
@@ -674,6 +1006,55 @@ public:
 	/// Returns true if this node has no children.
 	bool NoChildren() const						{ return !firstChild; }
 
+	/** Turn on (or off) the child index of this node. The index is opt-in and
+		per node: it costs memory, and is only worth it for nodes with many
+		children that are looked up by position or by name.
+
+		With the index, ChildCount(), ChildAt(), ChildElementAt(), FirstChild( name ),
+		FirstChildElement( name ), NextSibling( name ) and NextSiblingElement( name ) 
+		on the children, IterateChildren( name, ... ) and the TiXmlHandle Child()
+		and ChildElement() calls are all constant time instead of a walk of the
+		sibling list.
+
+		LinkEndChild() and InsertEndChild() keep the index up to date. Other
+		changes to the children (insert, replace, remove, or SetValue() on a child)
+		mark it stale, and it is rebuilt on the next lookup. The rebuild takes a
+		lock of the index's own, so lookups from several threads at once are
+		safe as long as none of them changes the node.
+	*/
+	void EnableChildIndex( bool enable = true );
+	/// True if EnableChildIndex() has been called on this node.
+	bool HasChildIndex() const					{ return childIndex != 0; }
+
+	/// The number of children of this node.
+	int ChildCount() const;
+
+	/// The child at 'index' (the first child is 0), or null if there is no such child.
+	const TiXmlNode* ChildAt( int index ) const;
+	TiXmlNode* ChildAt( int index ) {
+		return const_cast< TiXmlNode* >( (const_cast< const TiXmlNode* >(this))->ChildAt( index ) );
+	}
+
+	/** The child element at 'index', or null. Only elements are counted: the first
+		child element is 0, the second 1, etc.
+	*/
+	const TiXmlElement* ChildElementAt( int index ) const;
+	TiXmlElement* ChildElementAt( int index ) {
+		return const_cast< TiXmlElement* >( (const_cast< const TiXmlNode* >(this))->ChildElementAt( index ) );
+	}
+
+	/// The 'index' child with the given 'value', or null.
+	const TiXmlNode* ChildAt( const char* value, int index ) const;
+	TiXmlNode* ChildAt( const char* _value, int index ) {
+		return const_cast< TiXmlNode* >( (const_cast< const TiXmlNode* >(this))->ChildAt( _value, index ) );
+	}
+
+	/// The 'index' child element with the given 'value', or null.
+	const TiXmlElement* ChildElementAt( const char* value, int index ) const;
+	TiXmlElement* ChildElementAt( const char* _value, int index ) {
+		return const_cast< TiXmlElement* >( (const_cast< const TiXmlNode* >(this))->ChildElementAt( _value, index ) );
+	}
+
 	virtual const TiXmlDocument*    ToDocument()    const { return 0; } ///< Cast to a more defined type. Will return null if not of the requested type.
 	virtual const TiXmlElement*     ToElement()     const { return 0; } ///< Cast to a more defined type. Will return null if not of the requested type.
 	virtual const TiXmlComment*     ToComment()     const { return 0; } ///< Cast to a more defined type. Will return null if not of the requested type.
@@ -693,6 +1074,14 @@ public:
 	*/
 	virtual TiXmlNode* Clone() const = 0;
 
+	/** Create a new node of the same type and move the value, attributes and
+		children of this node into it. This node is left empty but valid,
+		and stays where it is in the DOM. The memory must be deleted by the caller.
+		A node type that doesn't override it, and any subclass of the
+		library's node classes, is copied with Clone() instead.
+	*/
+	virtual TiXmlNode* MoveClone()					{ return Clone(); }
+
 	/** Accept a hierchical visit the nodes in the TinyXML DOM. Every node in the 
 		XML tree will be conditionally visited and the host will be called back
 		via the TiXmlVisitor interface.
@@ -717,12 +1106,43 @@ public:
 	*/
 	virtual bool Accept( TiXmlVisitor* visitor ) const = 0;
 
+	/** Formatted print of this node and its children to a stream. Goes
+		through a TiXmlPrinter and a TiXmlStreamSink, so the output is the
+		same as the printer's and reaches the stream in large blocks.
+	*/
+	virtual void Print( std::ostream& file, int depth ) const;
+
 protected:
 	TiXmlNode( NodeType _type );
 
 	// Copy to the allocated object. Shared functionality between Clone, Copy constructor,
 	// and the assignment operator.
 	void CopyTo( TiXmlNode* target ) const;
+	/*	Clones the children of this node, and everything below them, onto the
+		end of 'target'. One preorder pass: no recursion and no virtual Clone()
+		per node. Nodes and attributes come from the free lists of the target's
+		document when there is one, so copying a template into a Reset()
+		document reuses its storage. A node of an application subclass is
+		copied, with its subtree, by its own Clone().
+	*/
+	void CloneChildrenTo( TiXmlNode* target ) const;
+	// A copy of this node without its children. 'pool' may be null.
+	TiXmlNode* CloneShallow( TiXmlDocument* pool ) const;
+	// True if this node is exactly the library's class for its Type(), not
+	// a subclass of the application's. Only those are copied, moved and
+	// recycled field by field; a subclass goes through its virtual Clone().
+	bool IsLibraryType() const;
+
+	// Same for the move constructors and assignment: steals the value and
+	// the children. Children 'target' already had are deleted.
+	void MoveTo( TiXmlNode* target );
+
+	// Sets the error and returns true if 'addThis' is a document, which can never be a child.
+	bool RejectDocument( const TiXmlNode& addThis );
+	// The linking behind the Insert and Replace functions. They take ownership of 'node'.
+	TiXmlNode* LinkBeforeChild( TiXmlNode* beforeThis, TiXmlNode* node );
+	TiXmlNode* LinkAfterChild( TiXmlNode* afterThis, TiXmlNode* node );
+	TiXmlNode* LinkReplaceChild( TiXmlNode* replaceThis, TiXmlNode* node );
 
 	    // The real work of the input operator.
 	virtual void StreamIn( std::istream* in, std::string* tag ) = 0;
@@ -741,6 +1161,20 @@ protected:
 	TiXmlNode*		prev;
 	TiXmlNode*		next;
 
+	TiXmlChildIndex*	childIndex;		// null unless EnableChildIndex() was called
+
+	// Tell the child index (if any) that the children changed in a way it can't track.
+	void ChildrenChanged();
+	// The child index, rebuilt first if it is stale. Null if there is no index.
+	const TiXmlChildIndex* ChildIndex() const;
+	// The document this node is in, if it has an element or text index.
+	TiXmlDocument* IndexedDocument() const;
+	// The element index of the document this node is in. Null if it has none.
+	TiXmlElementIndex* ElementIndex() const;
+	// Around a change to the value, for the document's indexes.
+	void ValueChanging( TiXmlDocument* document );
+	void ValueChanged( TiXmlDocument* document );
+
 private:
 	TiXmlNode( const TiXmlNode& )=delete;				// not implemented.
 	void operator=( const TiXmlNode& base )=delete;	// not allowed.
@@ -757,13 +1191,15 @@ private:
 class TiXmlAttribute : public TiXmlBase
 {
 	friend class TiXmlAttributeSet;
+	friend class TiXmlElement;
 
 public:
 	/// Construct an empty attribute.
 	TiXmlAttribute() : TiXmlBase()
 	{
 		document = 0;
-		prev = next = 0;
+		set = 0;
+		index = -1;
 	}
 
 	/// Construct an attribute with a name and value.
@@ -772,15 +1208,16 @@ public:
 		name = _name;
 		value = _value;
 		document = 0;
-		prev = next = 0;
+		set = 0;
+		index = -1;
 	}
 
-	std::string ValueStr() const	{ return value; }				///< Return the value of this attribute.
-	int				IntValue() const;									///< Return the value of this attribute, converted to an integer.
-	double			DoubleValue() const;								///< Return the value of this attribute, converted to a double.
+	const std::string& ValueStr() const	{ return value; }		///< Return the value of this attribute.
+	int				IntValue() const;									///< Return the value of this attribute, converted to an integer, or 0.
+	double			DoubleValue() const;								///< Return the value of this attribute, converted to a double, or 0.
 
 	// Get the tinyxml string representation
-	std::string NameTStr() const { return name; }
+	const std::string& NameTStr() const { return name; }
 
 	/** QueryIntValue examines the value string. It is an alternative to the
 		IntValue() method with richer error checking.
@@ -794,12 +1231,17 @@ public:
 	int QueryIntValue( int* _value ) const;
 	/// QueryDoubleValue examines the value string. See QueryIntValue().
 	int QueryDoubleValue( double* _value ) const;
+	/// Query for any type TiXmlBase::ReadValue() reads: integers, float, double, bool, enums.
+	template< typename T > int QueryValue( T* _value ) const		{ return ReadValue( value, _value ); }
 
-	void SetName( const std::string & _name )	{ name = _name; }				///< Set the name of this attribute.
+	void SetName( const std::string & _name );							///< Set the name of this attribute.
 	void SetValue( const std::string & _value )	{ value = _value; }				///< Set the value.
+	void SetValue( std::string&& _value )		{ value = std::move( _value ); }	///< Set the value, taking over the string.
 
 	void SetIntValue( int _value );										///< Set the value from an integer.
-	void SetDoubleValue( double _value );								///< Set the value from a double.
+	void SetDoubleValue( double _value );								///< Set the value from a double, in the shortest form that reads back exactly.
+	/// Set the value from any type TiXmlBase::WriteValue() writes. Reuses the value's storage.
+	template< typename T > void SetValueOf( T _value )				{ value.clear(); WriteValue( _value, &value ); }
 
 	/// Get the next sibling attribute in the DOM. Returns null at end.
 	const TiXmlAttribute* Next() const;
@@ -839,8 +1281,8 @@ private:
 	TiXmlDocument*	document;	// A pointer back to a document, for error reporting.
 	std::string name;
 	std::string value;
-	TiXmlAttribute*	prev;
-	TiXmlAttribute*	next;
+	TiXmlAttributeSet*	set;	// The set this attribute is linked into, or null.
+	int				index;		// Position in the set, in document order.
 };
 
 
@@ -849,15 +1291,24 @@ private:
 	
 	The set can be changed transparent to the Element and Declaration
 	classes that use it, but NOT transparent to the Attribute
-	which has to implement a next() and previous() method. Which makes
-	it a bit problematic and prevents the use of STL.
-
-	This version is implemented with circular lists because:
-		- I like circular lists
-		- it demonstrates some independence from the (typical) doubly linked list.
+	which has to implement a next() and previous() method.
+
+	The attributes are kept in document order in a contiguous array of
+	pointers, so Next() and Previous() are a simple index step. Most elements
+	have only a handful of attributes: those fit in a small inline array and
+	are found with a linear scan. Once an element grows past INDEX_THRESHOLD
+	attributes, an open addressing hash table (of positions in the array)
+	is built so Find() stays constant time, and parsing an element with N
+	attributes is O(N) rather than O(N*N).
+
+	The attributes themselves are still allocated one by one, so pointers
+	returned by First(), Find() and friends stay valid while other
+	attributes are added or removed.
 */
 class TiXmlAttributeSet
 {
+	friend class TiXmlAttribute;
+
 public:
 	TiXmlAttributeSet();
 	~TiXmlAttributeSet();
@@ -865,22 +1316,49 @@ public:
 	void Add( TiXmlAttribute* attribute );
 	void Remove( TiXmlAttribute* attribute );
 
-	const TiXmlAttribute* First()	const	{ return ( sentinel.next == &sentinel ) ? 0 : sentinel.next; }
-	TiXmlAttribute* First()					{ return ( sentinel.next == &sentinel ) ? 0 : sentinel.next; }
-	const TiXmlAttribute* Last() const		{ return ( sentinel.prev == &sentinel ) ? 0 : sentinel.prev; }
-	TiXmlAttribute* Last()					{ return ( sentinel.prev == &sentinel ) ? 0 : sentinel.prev; }
+	const TiXmlAttribute* First()	const	{ return count ? slots[0] : 0; }
+	TiXmlAttribute* First()					{ return count ? slots[0] : 0; }
+	const TiXmlAttribute* Last() const		{ return count ? slots[count-1] : 0; }
+	TiXmlAttribute* Last()					{ return count ? slots[count-1] : 0; }
+
+	/// The number of attributes in the set.
+	int Count() const						{ return count; }
 
-	TiXmlAttribute*	Find( const std::string & name ) const;
-	TiXmlAttribute* FindOrCreate(const std::string& _name);
+	TiXmlAttribute*	Find( std::string_view name ) const;
+	TiXmlAttribute* FindOrCreate( std::string_view _name );
+
+	/*	[internal use] Unlinks every attribute and appends it to 'pool', 
+		keeping the slot array and hash index for the next user.
+	*/
+	void ReleaseTo( std::vector<TiXmlAttribute*>& pool );
+	// [internal use] Takes over all the attributes of 'other'. This set must be empty.
+	void MoveFrom( TiXmlAttributeSet& other );
+	// [internal use] Makes room for 'newCapacity' attributes without reallocating.
+	void Reserve( int newCapacity );
+	// [internal use] The attributes in order, Count() of them, for TiXmlElement::Attributes().
+	TiXmlAttribute* const* Slots() const	{ return slots; }
 
 
 private:
-	//*ME:	Because of hidden/disabled copy-construktor in TiXmlAttribute (sentinel-element),
-	//*ME:	this class must be also use a hidden/disabled copy-constructor !!!
 	TiXmlAttributeSet( const TiXmlAttributeSet& )=delete;	// not allowed
 	void operator=( const TiXmlAttributeSet& )=delete;	// not allowed (as TiXmlAttribute)
 
-	TiXmlAttribute sentinel;
+	enum
+	{
+		INLINE_SLOTS = 4,		// attributes stored without a heap allocation
+		INDEX_THRESHOLD = 8		// attribute count at which the hash index is built
+	};
+
+	static unsigned Hash( std::string_view name );
+	void Rehash();				// rebuild the hash index from scratch
+
+	TiXmlAttribute** slots;		// points at inlineSlots, or a heap array for wide elements
+	int count;
+	int capacity;
+	TiXmlAttribute* inlineSlots[ INLINE_SLOTS ];
+
+	int* table;					// hash index: position+1 in 'slots', 0 for an empty bucket
+	unsigned tableMask;			// table size - 1, a power of 2. Only valid if 'table'.
 };
 
 
@@ -890,16 +1368,24 @@ private:
 */
 class TiXmlElement : public TiXmlNode
 {
+	friend class TiXmlNode;
+	friend class TiXmlDocument;
+	friend class TiXmlCompactDecoder;
 public:
 	/// Construct an element.
 	TiXmlElement (const char * in_value);
 
 	/// std::string constructor.
 	TiXmlElement( const std::string& _value );
+	/// Takes over the name string.
+	TiXmlElement( std::string&& _value );
 
 	TiXmlElement( const TiXmlElement& );
+	/// Takes the attributes and children of 'other', leaving it empty.
+	TiXmlElement( TiXmlElement&& other );
 
 	TiXmlElement& operator=( const TiXmlElement& base );
+	TiXmlElement& operator=( TiXmlElement&& base );
 
 	virtual ~TiXmlElement();
 
@@ -908,13 +1394,16 @@ public:
 	*/
 	std::string Attribute( const std::string & name ) const;
 
+	/// The attribute called 'name', or null. Looks it up without copying anything.
+	const TiXmlAttribute* FindAttribute( std::string_view name ) const	{ return attributeSet.Find( name ); }
+
 	/** Given an attribute name, Attribute() returns the value
 		for the attribute of that name, or null if none exists.
 		If the attribute exists and can be converted to an integer,
 		the integer value will be put in the return 'i', if 'i'
 		is non-null.
 	*/
-	std::string Attribute( const std::string & name, int* i ) const;
+	const std::string* Attribute( std::string_view name, int* i ) const;
 
 	/** Given an attribute name, Attribute() returns the value
 		for the attribute of that name, or null if none exists.
@@ -922,7 +1411,7 @@ public:
 		the double value will be put in the return 'd', if 'd'
 		is non-null.
 	*/
-	std::string Attribute( const std::string & name, double* d ) const;
+	const std::string* Attribute( std::string_view name, double* d ) const;
 
 	/** QueryIntAttribute examines the attribute - it is an alternative to the
 		Attribute() method with richer error checking.
@@ -930,59 +1419,60 @@ public:
 		the call returns TIXML_SUCCESS. If it is not
 		an integer, it returns TIXML_WRONG_TYPE. If the attribute
 		does not exist, then TIXML_NO_ATTRIBUTE is returned.
+
+		The Query methods read with TiXmlBase::ReadValue(): no exceptions,
+		no allocation, and the same in every locale.
 	*/	
-	int QueryIntAttribute( const std::string & name, int* _value ) const;
+	int QueryIntAttribute( std::string_view name, int* _value ) const			{ return QueryValueAttribute( name, _value ); }
 	/// QueryUnsignedAttribute examines the attribute - see QueryIntAttribute().
-	int QueryUnsignedAttribute( const std::string & name, unsigned* _value ) const;
+	int QueryUnsignedAttribute( std::string_view name, unsigned* _value ) const	{ return QueryValueAttribute( name, _value ); }
 	/** QueryBoolAttribute examines the attribute - see QueryIntAttribute(). 
 		Note that '1', 'true', or 'yes' are considered true, while '0', 'false'
 		and 'no' are considered false.
 	*/
-	int QueryBoolAttribute( const std::string & name, bool* _value ) const;
+	int QueryBoolAttribute( std::string_view name, bool* _value ) const			{ return QueryValueAttribute( name, _value ); }
 	/// QueryDoubleAttribute examines the attribute - see QueryIntAttribute().
-	int QueryDoubleAttribute( const std::string & name, double* _value ) const;
+	int QueryDoubleAttribute( std::string_view name, double* _value ) const		{ return QueryValueAttribute( name, _value ); }
 	/// QueryFloatAttribute examines the attribute - see QueryIntAttribute().
-	int QueryFloatAttribute( const std::string & name, float* _value ) const {
-		double d;
-		int result = QueryDoubleAttribute( name, &d );
-		if ( result == TIXML_SUCCESS ) {
-			*_value = (float)d;
-		}
-		return result;
-	}
+	int QueryFloatAttribute( std::string_view name, float* _value ) const		{ return QueryValueAttribute( name, _value ); }
 
 	/// QueryStringAttribute examines the attribute - see QueryIntAttribute().
-	int QueryStringAttribute( const std::string & name, std::string &_value ) const {
-		std::string str = Attribute( name );
-		if ( str.empty() ) {
-			_value = std::move( str );
-			return TIXML_SUCCESS;
-		}
-		return TIXML_NO_ATTRIBUTE;
+	int QueryStringAttribute( std::string_view name, std::string &_value ) const {
+		return QueryValueAttribute( name, &_value );
 	}
 
 	/** Template form of the attribute query which will try to read the
 		attribute into the specified type. Very easy, very powerful, but
 		be careful to make sure to call this with the correct type.
+
+		Numbers of every width, bools and enums are read with
+		TiXmlBase::ReadValue(); other types with their operator>>.
 		
-		NOTE: This method doesn't work correctly for 'string' types that contain spaces.
+		NOTE: operator>> doesn't work correctly for 'string' types that contain spaces.
 
 		@return TIXML_SUCCESS, TIXML_WRONG_TYPE, or TIXML_NO_ATTRIBUTE
 	*/
-	template< typename T > int QueryValueAttribute( const std::string& name, T* outValue ) const
+	template< typename T > int QueryValueAttribute( std::string_view name, T* outValue ) const
 	{
 		const TiXmlAttribute* node = attributeSet.Find( name );
 		if ( !node )
 			return TIXML_NO_ATTRIBUTE;
 
-		std::stringstream sstream( node->ValueStr() );
-		sstream >> *outValue;
-		if ( !sstream.fail() )
-			return TIXML_SUCCESS;
-		return TIXML_WRONG_TYPE;
+		if constexpr ( std::is_arithmetic_v< T > || std::is_enum_v< T > )
+		{
+			return node->QueryValue( outValue );
+		}
+		else
+		{
+			std::stringstream sstream( node->ValueStr() );
+			sstream >> *outValue;
+			if ( !sstream.fail() )
+				return TIXML_SUCCESS;
+			return TIXML_WRONG_TYPE;
+		}
 	}
 
-	int QueryValueAttribute( const std::string& name, std::string* outValue ) const
+	int QueryValueAttribute( std::string_view name, std::string* outValue ) const
 	{
 		const TiXmlAttribute* node = attributeSet.Find( name );
 		if ( !node )
@@ -991,6 +1481,18 @@ public:
 		return TIXML_SUCCESS;
 	}
 
+	/** Reads the text of this element, as GetText() finds it, into a
+		number, bool or enum with TiXmlBase::ReadValue().
+		@return TIXML_SUCCESS, TIXML_WRONG_TYPE, or TIXML_NO_TEXT
+	*/
+	template< typename T > int QueryText( T* outValue ) const
+	{
+		const TiXmlNode* text = FirstChild();
+		if ( !text || text->Type() != TINYXML_TEXT )
+			return TIXML_NO_TEXT;
+		return TiXmlBase::ReadValue( text->ValueStr(), outValue );
+	}
+
 	/** Sets an attribute of name to a given value. The attribute
 		will be created if it does not exist, or changed if it does.
 	*/
@@ -998,10 +1500,26 @@ public:
 
 	/// STL std::string form.
 	void SetAttribute( const std::string& name, const std::string& _value );
+	///< STL std::string form, taking over the value string.
+	void SetAttribute( const std::string& name, std::string&& _value );
 	///< STL std::string form.
-	void SetAttribute( const std::string& name, int _value );
-	///< STL std::string form.
-	void SetDoubleAttribute( const std::string& name, double value );
+	void SetAttribute( std::string_view name, int _value )				{ SetValueAttribute( name, _value ); }
+	///< STL std::string form. Written in the shortest form that reads back exactly.
+	void SetDoubleAttribute( std::string_view name, double value )		{ SetValueAttribute( name, value ); }
+	/** Sets an attribute to any number, bool or enum, with TiXmlBase::WriteValue().
+		Changing an attribute that exists allocates nothing.
+	*/
+	template< typename T > void SetValueAttribute( std::string_view name, T _value )
+	{
+		TiXmlAttribute* attrib = attributeSet.FindOrCreate( name );
+		if ( attrib )
+		{
+			TiXmlElementIndex* index = AttributeChanging( attrib );
+			attrib->SetValueOf( _value );
+			if ( index )
+				AttributeChanged( index, attrib );
+		}
+	}
 	/** Sets an attribute of name to a given value. The attribute
 		will be created if it does not exist, or changed if it does.
 	*/
@@ -1014,6 +1532,14 @@ public:
 	const TiXmlAttribute* LastAttribute()	const 	{ return attributeSet.Last(); }		///< Access the last attribute in this element.
 	TiXmlAttribute* LastAttribute()					{ return attributeSet.Last(); }
 
+	/** The attributes of this element in document order, as a range:
+		@verbatim
+			for( const TiXmlAttribute* attribute : element->Attributes() )
+		@endverbatim
+	*/
+	TiXmlAttributeRange< const TiXmlAttribute > Attributes() const	{ return TiXmlAttributeRange< const TiXmlAttribute >( attributeSet.Slots(), attributeSet.Slots() + attributeSet.Count() ); }
+	TiXmlAttributeRange< TiXmlAttribute > Attributes()				{ return TiXmlAttributeRange< TiXmlAttribute >( attributeSet.Slots(), attributeSet.Slots() + attributeSet.Count() ); }
+
 	/** Convenience function for easy access to the text inside an element. Although easy
 		and concise, GetText() is limited compared to getting the TiXmlText child
 		and accessing it directly.
@@ -1050,9 +1576,8 @@ public:
 
 	/// Creates a new Element and returns it - the returned element is a copy.
 	virtual TiXmlNode* Clone() const;
-	// Print the Element to a FILE stream.
-	virtual void Print(std::ostream& file, int depth) const;
-
+	/// Creates a new Element and moves the content of this one into it.
+	virtual TiXmlNode* MoveClone();
 	/*	Attribtue parsing starts: next char past '<'
 						 returns: next char past '>'
 	*/
@@ -1068,6 +1593,9 @@ public:
 protected:
 
 	void CopyTo( TiXmlElement* target ) const;
+	// Appends copies of our attributes to 'target', which must not have any of the same names.
+	void CopyAttributesTo( TiXmlElement* target, TiXmlDocument* pool ) const;
+	void MoveTo( TiXmlElement* target );
 	void ClearThis();	// like clear, but initializes 'this' object as well
 
 	// Used to be public [internal use]
@@ -1079,6 +1607,13 @@ protected:
 	std::string::const_iterator ReadValue( std::string::const_iterator first, std::string::const_iterator last, TiXmlParsingData* prevData, TiXmlEncoding encoding );
 
 private:
+	/*	Around a change to the value of 'attrib': takes it out of the
+		document's element index, and returns the index if there is one;
+		then puts it back.
+	*/
+	TiXmlElementIndex* AttributeChanging( const TiXmlAttribute* attrib );
+	void AttributeChanged( TiXmlElementIndex* index, const TiXmlAttribute* attrib );
+
 	TiXmlAttributeSet attributeSet;
 };
 
@@ -1095,15 +1630,16 @@ public:
 		SetValue( _value );
 	}
 	TiXmlComment( const TiXmlComment& );
+	TiXmlComment( TiXmlComment&& other ) : TiXmlNode( TiXmlNode::TINYXML_COMMENT ) { other.MoveTo( this ); }
 	TiXmlComment& operator=( const TiXmlComment& base );
+	TiXmlComment& operator=( TiXmlComment&& base );
 
 	virtual ~TiXmlComment()	{}
 
 	/// Returns a copy of this Comment.
 	virtual TiXmlNode* Clone() const;
-	// Write this Comment to a FILE stream.
-	virtual void Print(std::ostream& file, int depth) const;
-
+	/// Returns a new Comment, with the text moved out of this one.
+	virtual TiXmlNode* MoveClone();
 	/*	Attribtue parsing starts: at the ! of the !--
 						 returns: next char past '>'
 	*/
@@ -1118,6 +1654,7 @@ public:
 
 protected:
 	void CopyTo( TiXmlComment* target ) const;
+	void MoveTo( TiXmlComment* target );
 
 	// used to be public
 	virtual void StreamIn( std::istream * in, std::string * tag );
@@ -1135,7 +1672,9 @@ private:
 */
 class TiXmlText : public TiXmlNode
 {
+	friend class TiXmlNode;
 	friend class TiXmlElement;
+	friend class TiXmlDocument;
 public:
 	/** Constructor for text element. By default, it is treated as 
 		normal, encoded text. If you want it be output as a CDATA text
@@ -1150,11 +1689,17 @@ public:
 		SetValue( initValue );
 	}
 
+	/// Constructor, taking over the string.
+	TiXmlText( std::string&& initValue ) :
+		TiXmlNode( TiXmlNode::TINYXML_TEXT )
+	{
+		SetValue( std::move( initValue ) );
+	}
+
 	TiXmlText( const TiXmlText& copy ) : TiXmlNode( TiXmlNode::TINYXML_TEXT )	{ copy.CopyTo( this ); }
+	TiXmlText( TiXmlText&& other ) : TiXmlNode( TiXmlNode::TINYXML_TEXT )		{ other.MoveTo( this ); }
 	TiXmlText& operator=( const TiXmlText& base )							 	{ base.CopyTo( this ); return *this; }
-
-	// Write this text object to a FILE stream.
-	virtual void Print(std::ostream& file, int depth) const;
+	TiXmlText& operator=( TiXmlText&& base )									{ if ( this != &base ) base.MoveTo( this ); return *this; }
 
 	/// Queries whether this represents text using a CDATA section.
 	bool CDATA() const				{ return cdata; }
@@ -1173,7 +1718,9 @@ public:
 protected :
 	///  [internal use] Creates a new Element and returns it.
 	virtual TiXmlNode* Clone() const;
+	virtual TiXmlNode* MoveClone();
 	void CopyTo( TiXmlText* target ) const;
+	void MoveTo( TiXmlText* target );
 
 	bool Blank() const;	// returns true if all white space and new lines
 	// [internal use]
@@ -1199,6 +1746,9 @@ private:
 */
 class TiXmlDeclaration : public TiXmlNode
 {
+	friend class TiXmlNode;
+	friend class TiXmlDocument;
+	friend class TiXmlCompactDecoder;
 public:
 	/// Construct an empty declaration.
 	TiXmlDeclaration()   : TiXmlNode( TiXmlNode::TINYXML_DECLARATION ) {}
@@ -1214,23 +1764,27 @@ public:
 						const char* _standalone );
 
 	TiXmlDeclaration( const TiXmlDeclaration& copy );
+	TiXmlDeclaration( TiXmlDeclaration&& other );
 	TiXmlDeclaration& operator=( const TiXmlDeclaration& copy );
+	TiXmlDeclaration& operator=( TiXmlDeclaration&& other );
 
 	virtual ~TiXmlDeclaration()	{}
 
 	/// Version. Will return an empty string if none was found.
-	std::string Version() const			{ return version; }
+	const std::string& Version() const		{ return version; }
 	/// Encoding. Will return an empty string if none was found.
-	std::string Encoding() const		{ return encoding; }
+	const std::string& Encoding() const		{ return encoding; }
 	/// Is this a standalone document?
-	std::string Standalone() const		{ return standalone; }
+	const std::string& Standalone() const	{ return standalone; }
 
 	/// Creates a copy of this Declaration and returns it.
 	virtual TiXmlNode* Clone() const;
+	/// Creates a new Declaration and moves the content of this one into it.
+	virtual TiXmlNode* MoveClone();
 	// Print this declaration to a FILE stream.
 	virtual void Print(std::ostream& file, int depth, std::string* str ) const;
 	virtual void Print(std::ostream & file, int depth) const {
-		Print( file, depth, 0 );
+		TiXmlNode::Print( file, depth );
 	}
 
 	std::string::const_iterator Parse(std::string::const_iterator first, std::string::const_iterator last, TiXmlParsingData* data, TiXmlEncoding encoding )override;
@@ -1244,6 +1798,7 @@ public:
 
 protected:
 	void CopyTo( TiXmlDeclaration* target ) const;
+	void MoveTo( TiXmlDeclaration* target );
 	// used to be public
 	virtual void StreamIn( std::istream * in, std::string * tag );
 
@@ -1269,13 +1824,14 @@ public:
 	virtual ~TiXmlUnknown() {}
 
 	TiXmlUnknown( const TiXmlUnknown& copy ) : TiXmlNode( TiXmlNode::TINYXML_UNKNOWN )		{ copy.CopyTo( this ); }
+	TiXmlUnknown( TiXmlUnknown&& other ) : TiXmlNode( TiXmlNode::TINYXML_UNKNOWN )			{ other.MoveTo( this ); }
 	TiXmlUnknown& operator=( const TiXmlUnknown& copy )										{ copy.CopyTo( this ); return *this; }
+	TiXmlUnknown& operator=( TiXmlUnknown&& other )											{ if ( this != &other ) other.MoveTo( this ); return *this; }
 
 	/// Creates a copy of this Unknown and returns it.
 	virtual TiXmlNode* Clone() const;
-	// Print this Unknown to a FILE stream.
-	virtual void Print(std::ostream& file, int depth) const;
-
+	/// Creates a new Unknown and moves the content of this one into it.
+	virtual TiXmlNode* MoveClone();
 	std::string::const_iterator Parse(std::string::const_iterator first, std::string::const_iterator last, TiXmlParsingData* data, TiXmlEncoding encoding)override;
 
 	virtual const TiXmlUnknown*     ToUnknown()     const	{ return this; } ///< Cast to a more defined type. Will return null not of the requested type.
@@ -1287,6 +1843,7 @@ public:
 
 protected:
 	void CopyTo( TiXmlUnknown* target ) const;
+	void MoveTo( TiXmlUnknown* target );
 
 	virtual void StreamIn( std::istream * in, std::string * tag );
 
@@ -1301,6 +1858,7 @@ private:
 */
 class TiXmlDocument : public TiXmlNode
 {
+	friend class TiXmlNode;		// for the element index
 public:
 	/// Create an empty document, that has no name.
 	TiXmlDocument();
@@ -1311,9 +1869,12 @@ public:
 	TiXmlDocument( const std::string& documentName );
 
 	TiXmlDocument( const TiXmlDocument& copy );
+	/// Takes the content of 'other', which is left empty. Nothing is copied.
+	TiXmlDocument( TiXmlDocument&& other );
 	TiXmlDocument& operator=( const TiXmlDocument& copy );
+	TiXmlDocument& operator=( TiXmlDocument&& other );
 
-	virtual ~TiXmlDocument() {}
+	virtual ~TiXmlDocument();
 
 	/** Load a file using the current document value.
 		Returns true if successful. Will delete any existing
@@ -1337,6 +1898,53 @@ public:
 
 	bool SaveFile(const std::string& filename) const;		///< STL std::string version.
 
+	/** Save compressed, the output compressed on the fly. SaveFile(filename)
+		comes here for a name ending in ".gz" or ".zst". Fails for a
+		compression the library was built without.
+	*/
+	bool SaveFile( const std::string& filename, TiXmlCompression compression ) const;
+	/// Which compression a file name asks for: gzip for ".gz", zstd for ".zst".
+	static TiXmlCompression CompressionOf( const std::string& filename );
+
+	/** Write the document, formatted, to any sink and flush it. Returns
+		true if every write succeeded. SaveFile() comes down to this.
+	*/
+	bool Save( TiXmlOutputSink* sink ) const;
+
+	/** Deletes the content of the document, like Clear(), but keeps the
+		nodes, attributes and their string buffers so the next Parse() can
+		reuse them instead of going back to the heap. Also clears the error
+		state. A document that is Reset() and re-parsed with messages of a
+		similar shape settles into parsing without any allocation:
+		@verbatim
+		TiXmlDocument doc;
+		for( ;; ) {
+			doc.Reset();
+			doc.Parse( msg.begin(), msg.end() );
+			...
+		}
+		@endverbatim
+		Any pointer into the old content is invalid after Reset(). The 
+		document name, tab size and child index setting are kept.
+	*/
+	void Reset();
+
+	/// Frees the nodes and attributes kept for reuse by Reset().
+	void ShrinkToFit();
+
+	/** Makes a compact read-only copy of the document, for fast traversal
+		and a small memory footprint. See TiXmlFrozenDocument.
+	*/
+	TiXmlFrozenDocument Freeze() const;
+
+	/** Save the document as a binary image, to be mapped back with
+		TiXmlFrozenDocument::LoadBinary() or Load(). If 'sourcePath' is
+		given, the image is tied to that file, so pass it only when the
+		document holds what the file does (read with LoadFile() and not
+		changed since). Returns true if successful.
+	*/
+	bool SaveBinary( const std::string& path, const std::string& sourcePath = std::string() ) const;
+
 	/** Parse the given null terminated block of xml data. Passing in an encoding to this
 		method (either TIXML_ENCODING_LEGACY or TIXML_ENCODING_UTF8 will force TinyXml
 		to use that encoding, regardless of what TinyXml might otherwise try to detect.
@@ -1413,6 +2021,61 @@ public:
 												//errorLocation.last = 0; 
 											}
 
+	/** Index the elements of the document by name, for GetElementsByTagName(),
+		and by the values of the attributes named with IndexAttribute(), for
+		GetElementByAttribute(). The index is built in one pass by the first
+		lookup, then kept up to date as the document changes: nodes added at
+		the end of the document, as the parser and LinkEndChild() add them,
+		are appended to it, and RemoveChild(), renaming an element with
+		SetValue(), SetAttribute() and RemoveAttribute() change it in place.
+		Inserting before or after a node, replacing one, or removing a large
+		part of the document leaves it to be rebuilt by the next lookup, as
+		the child index is. Changing a TiXmlAttribute directly, rather than
+		through its element, is not seen. A copy of the document is indexed
+		the same way.
+	*/
+	void EnableElementIndex( bool enable = true );
+	/// True if EnableElementIndex() has been called.
+	bool HasElementIndex() const			{ return elementIndex != 0; }
+	/// Index the values of attributes called 'name' too. Enables the index.
+	void IndexAttribute( const std::string& name );
+	/** Rebuild the element and text indexes now if they are out of date,
+		rather than in the next lookup. Lookups on an up to date index don't write to the document,
+		so threads may then share it until it changes.
+	*/
+	void UpdateIndexes();
+
+	/** The elements called 'name', in document order, straight from the
+		element index: no copy is made, and the list is good until the
+		document changes. Without EnableElementIndex() the list is empty;
+		use the overload below to walk the document instead.
+	*/
+	const std::vector< const TiXmlElement* >& GetElementsByTagName( const std::string& name ) const;
+	/** Fill 'found' with the elements called 'name', in document order:
+		a copy of the index's list, or, without the index, a walk.
+	*/
+	void GetElementsByTagName( const std::string& name, std::vector< const TiXmlElement* >* found ) const;
+	/** The first element, in document order, whose attribute 'name' is
+		'value', or null. A hash lookup if 'name' is indexed, else a walk.
+	*/
+	const TiXmlElement* GetElementByAttribute( const std::string& name, const std::string& value ) const;
+	TiXmlElement* GetElementByAttribute( const std::string& name, const std::string& value ) {
+		return const_cast< TiXmlElement* >( (const_cast< const TiXmlDocument* >(this))->GetElementByAttribute( name, value ) );
+	}
+
+	/** Keep a TiXmlTextIndex of the document's text. It is built by the
+		first TextIndex(), on a thread per core, and then follows changes:
+		text added at the end of the document is appended, and text
+		changed with SetValue() is indexed again in place. Other changes to
+		the tree leave it to be rebuilt by the next TextIndex(), or by
+		UpdateIndexes(). A copy of the document keeps a text index too.
+	*/
+	void EnableTextIndex( bool enable = true );
+	/** The text index, brought up to date; null without EnableTextIndex().
+		Ask for it again after changing the document.
+	*/
+	const TiXmlTextIndex* TextIndex() const;
+
 	/** Write the document to standard out using formatted printing ("pretty print"). */
 	void Print() const						{ Print( std::cout, 0 ); }
 
@@ -1422,10 +2085,17 @@ public:
 	*/
 	//char* PrintToMemory() const; 
 
-	/// Print this Document to a FILE stream.
-	virtual void Print(std::ostream & file, int depth = 0 ) const;
+	/// Print this Document to a stream.
+	virtual void Print(std::ostream & file, int depth = 0 ) const	{ TiXmlNode::Print( file, depth ); }
 	// [internal use]
 	void SetError( int err, std::string::const_iterator first, std::string::const_iterator last, TiXmlParsingData* prevData, TiXmlEncoding encoding );
+	/*	[internal use] Node and attribute allocation for the parser. These
+		hand out storage recycled by Reset() when there is any.
+	*/
+	TiXmlNode* NewNode( NodeType nodeType );
+	TiXmlAttribute* NewAttribute();
+	// [internal use] Takes back an unlinked node and all of its children.
+	void RecycleNode( TiXmlNode* node );
 
 	virtual const TiXmlDocument*    ToDocument()    const { return this; } ///< Cast to a more defined type. Will return null not of the requested type.
 	virtual TiXmlDocument*          ToDocument()          { return this; } ///< Cast to a more defined type. Will return null not of the requested type.
@@ -1437,10 +2107,14 @@ public:
 protected :
 	// [internal use]
 	virtual TiXmlNode* Clone() const;
+	virtual TiXmlNode* MoveClone();
 	virtual void StreamIn( std::istream * in, std::string * tag );
 
 private:
 	void CopyTo( TiXmlDocument* target ) const;
+	void MoveTo( TiXmlDocument* target );
+	// Decompress the rest of a stream into text, a chunk at a time.
+	static bool ReadCompressed( std::istream& in, TiXmlCompression compression, std::string* text );
 
 	bool error;
 	int  errorId;
@@ -1448,9 +2122,214 @@ private:
 	int tabsize;
 	TiXmlCursor errorLocation;
 	bool useMicrosoftBOM;		// the UTF-8 BOM were found when read. Note this, and try to write.
+
+	// Storage kept by Reset(), by node type. Each is used as a stack.
+	std::vector<TiXmlNode*> freeNodes[ TINYXML_TYPECOUNT ];
+	std::vector<TiXmlAttribute*> freeAttributes;
+
+	// What the indexes need to know of changes to the tree.
+	void IndexAdded( const TiXmlNode* node );
+	void IndexRemoving( const TiXmlNode* node );
+	void IndexStale();
+	void TextChanging( const TiXmlText* text );
+	void TextChanged( const TiXmlText* text );
+	// Enables the indexes of 'target' as ours are, with nothing in them yet.
+	void CopyIndexesTo( TiXmlDocument* target ) const;
+
+	TiXmlElementIndex* elementIndex;		// null unless EnableElementIndex() was called
+	TiXmlTextIndex* textIndex;				// null unless EnableTextIndex() was called
+};
+
+
+/** A document that many threads read while, now and then, another
+	thread changes it, kept as two full copies: the published one that
+	readers share, and a private one that the writer edits. Readers take
+	the published version with Current(): an atomic load of a shared
+	pointer, so they never wait for a writer and never see an edit half
+	done. A version stays valid, unchanged, for as long as somebody holds
+	on to it.
+	@verbatim
+	TiXmlDoubleBufferedDocument config( std::move( loadedDoc ) );
+
+	// any reader thread
+	TiXmlDoubleBufferedDocument::Snapshot snap = config.Current();
+	const TiXmlElement* limits = snap->RootElement()->FirstChildElement( "Limits" );
+
+	// the admin thread
+	config.Update( []( TiXmlDocument& doc ) {
+		doc.RootElement()->FirstChildElement( "Limits" )->SetAttribute( "max", 20 );
+		return true;
+	} );
+	@endverbatim
+
+	Every Update() copies the whole current version and edits the copy,
+	so an edit costs O(n) in the size of the document, however small it
+	is. This is not copy-on-write: versions share no subtrees, since a
+	TinyXML node links to its parent and siblings, and finds its document
+	by walking up, so a node can only be in one tree. What it saves over
+	a Clone() per edit is the allocation: the copy is made with the single
+	pass clone into the storage of the version before last, once no reader
+	holds it any more. It suits documents that are read far more often
+	than they change. Old versions are deleted when their last reader
+	lets go of them.
+
+	Writers are serialized with a mutex. Readers must treat a Snapshot as
+	read only; all const methods of the DOM are safe to call concurrently
+	on it. Its element and text indexes are brought up to date before it
+	is published, and a child index rebuilds under a lock of its own.
+*/
+class TiXmlDoubleBufferedDocument
+{
+public:
+	typedef std::shared_ptr<const TiXmlDocument> Snapshot;
+
+	/// Starts with an empty document, as version 0.
+	TiXmlDoubleBufferedDocument();
+	/// Starts with 'document', as version 0.
+	explicit TiXmlDoubleBufferedDocument( TiXmlDocument&& document );
+
+	/// The current version. Never blocks.
+	Snapshot Current() const				{ return std::atomic_load( &current ); }
+	/// Goes up by one every time a version is published.
+	unsigned long Version() const			{ return version.load( std::memory_order_acquire ); }
+
+	/** Applies 'edit' to a full copy of the current version. 'edit' is
+		called as bool edit( TiXmlDocument& ), and the copy is published if
+		it returns true. Returns what 'edit' returned.
+	*/
+	template< typename Edit > bool Update( Edit edit )
+	{
+		std::lock_guard<std::mutex> lock( writer );
+		std::shared_ptr<TiXmlDocument> draft = Draft();
+		if ( !edit( *draft ) )
+		{
+			retired = std::move( draft );	// keep the storage for next time
+			return false;
+		}
+		Publish( std::move( draft ) );
+		return true;
+	}
+
+	/// Publishes 'document' as the new version, without a copy.
+	void Replace( TiXmlDocument&& document );
+
+private:
+	TiXmlDoubleBufferedDocument( const TiXmlDoubleBufferedDocument& )=delete;
+	void operator=( const TiXmlDoubleBufferedDocument& )=delete;
+
+	// A writable copy of the current version. Called with the writer lock.
+	std::shared_ptr<TiXmlDocument> Draft();
+	// Makes 'draft' the current version. Called with the writer lock.
+	void Publish( std::shared_ptr<TiXmlDocument> draft );
+
+	Snapshot current;							// only through std::atomic_load/store
+	std::shared_ptr<TiXmlDocument> retired;		// a previous version, reused once no reader holds it
+	std::atomic<unsigned long> version;
+	std::mutex writer;
+};
+
+
+// [internal use] The calls TiXmlWalk() makes: the walker's member if it
+// has a matching one, else true, as TiXmlVisitor's defaults do.
+struct TiXmlWalkCall
+{
+	template< typename W > static auto Enter( W& w, const TiXmlDocument& document, int ) -> decltype( bool( w.VisitEnter( document ) ) )	{ return w.VisitEnter( document ); }
+	template< typename W > static auto Enter( W& w, const TiXmlElement& element, int ) -> decltype( bool( w.VisitEnter( element, element.FirstAttribute() ) ) )	{ return w.VisitEnter( element, element.FirstAttribute() ); }
+	template< typename W, typename N > static bool Enter( W&, const N&, long )					{ return true; }
+	template< typename W, typename N > static auto Exit( W& w, const N& node, int ) -> decltype( bool( w.VisitExit( node ) ) )	{ return w.VisitExit( node ); }
+	template< typename W, typename N > static bool Exit( W&, const N&, long )					{ return true; }
+	template< typename W, typename N > static auto Visit( W& w, const N& node, int ) -> decltype( bool( w.Visit( node ) ) )		{ return w.Visit( node ); }
+	template< typename W, typename N > static bool Visit( W&, const N&, long )					{ return true; }
+
+	template< typename W > static bool Exit( W& w, const TiXmlNode* node )
+	{
+		if ( node->Type() == TiXmlNode::TINYXML_ELEMENT )
+			return Exit( w, static_cast< const TiXmlElement& >( *node ), 0 );
+		return Exit( w, static_cast< const TiXmlDocument& >( *node ), 0 );
+	}
 };
 
 
+/** Walks 'node' and everything under it the way node.Accept( &visitor )
+	does, but with the calls resolved at compile time. 'walker' is any
+	type with members named as in TiXmlVisitor, each optional:
+	@verbatim
+	struct CountItems
+	{
+		int items = 0;
+		bool VisitEnter( const TiXmlElement& element, const TiXmlAttribute* ) { items += element.ValueStr() == "Item"; return true; }
+		bool Visit( const TiXmlText& ) { return true; }
+	};
+	CountItems count;
+	TiXmlWalk( doc, count );
+	@endverbatim
+	Missing members count as returning true. The pruning is Accept()'s:
+	false from VisitEnter() skips the children, and false from Visit() or
+	VisitExit() skips the rest of the siblings, the parent's VisitExit()
+	still being called. Returns what Accept() would.
+
+	Nodes are told apart by their stored type, so there is no virtual
+	call per node, and the members can be inlined into the loop. The walk
+	follows the parent and sibling links rather than recursing, so deep
+	documents don't use up the stack.
+*/
+template< typename Walker > bool TiXmlWalk( const TiXmlNode& node, Walker&& walker )
+{
+	const TiXmlNode* at = &node;
+	for( ;; )
+	{
+		bool more = true;
+		switch ( at->Type() )
+		{
+			case TiXmlNode::TINYXML_DOCUMENT:
+				if ( TiXmlWalkCall::Enter( walker, static_cast< const TiXmlDocument& >( *at ), 0 ) && at->FirstChild() )
+				{
+					at = at->FirstChild();
+					continue;
+				}
+				more = TiXmlWalkCall::Exit( walker, static_cast< const TiXmlDocument& >( *at ), 0 );
+				break;
+			case TiXmlNode::TINYXML_ELEMENT:
+				if ( TiXmlWalkCall::Enter( walker, static_cast< const TiXmlElement& >( *at ), 0 ) && at->FirstChild() )
+				{
+					at = at->FirstChild();
+					continue;
+				}
+				more = TiXmlWalkCall::Exit( walker, static_cast< const TiXmlElement& >( *at ), 0 );
+				break;
+			case TiXmlNode::TINYXML_TEXT:
+				more = TiXmlWalkCall::Visit( walker, static_cast< const TiXmlText& >( *at ), 0 );
+				break;
+			case TiXmlNode::TINYXML_COMMENT:
+				more = TiXmlWalkCall::Visit( walker, static_cast< const TiXmlComment& >( *at ), 0 );
+				break;
+			case TiXmlNode::TINYXML_DECLARATION:
+				more = TiXmlWalkCall::Visit( walker, static_cast< const TiXmlDeclaration& >( *at ), 0 );
+				break;
+			case TiXmlNode::TINYXML_UNKNOWN:
+				more = TiXmlWalkCall::Visit( walker, static_cast< const TiXmlUnknown& >( *at ), 0 );
+				break;
+			default:
+				break;
+		}
+
+		// 'at' is done: on to its next sibling, or out of its parent.
+		for( ;; )
+		{
+			if ( at == &node )
+				return more;
+			if ( more && at->NextSibling() )
+			{
+				at = at->NextSibling();
+				break;
+			}
+			at = at->Parent();
+			more = TiXmlWalkCall::Exit( walker, at );
+		}
+	}
+}
+
+
 /**
 	A TiXmlHandle is a class that wraps a node pointer with null checks; this is
 	an incredibly useful thing. Note that TiXmlHandle is not part of the TinyXml
@@ -1520,7 +2399,8 @@ private:
 
 	It seems reasonable, but it is in fact two embedded while loops. The Child method is 
 	a linear walk to find the element, so this code would iterate much more than it needs 
-	to. Instead, prefer:
+	to. (Unless the parent has a child index: see TiXmlNode::EnableChildIndex().) 
+	Instead, prefer:
 
 	@verbatim
 	TiXmlElement* child = docHandle.FirstChild( "Document" ).FirstChild( "Element" ).FirstChild( "Child" ).ToElement();
@@ -1609,15 +2489,515 @@ private:
 };
 
 
-/** Print to memory functionality. The TiXmlPrinter is useful when you need to:
-
-	-# Print to memory (especially in non-STL mode)
+/** The nodes, or attributes, that a TiXmlXPath selected. Keep one and
+	pass it to every Select(): the vectors, and the scratch space the
+	evaluation uses, keep their storage between calls.
+*/
+class TiXmlXPathResult
+{
+public:
+	/// The selected nodes, in document order. Empty if the expression selects attributes.
+	const std::vector< const TiXmlNode* >& Nodes() const				{ return nodes; }
+	/// The selected attributes, in document order.
+	const std::vector< const TiXmlAttribute* >& Attributes() const		{ return attributes; }
+
+	/// Number of nodes or attributes selected.
+	size_t Size() const								{ return nodes.size() + attributes.size(); }
+	bool Empty() const								{ return nodes.empty() && attributes.empty(); }
+	/// The first node, or null.
+	const TiXmlNode* FirstNode() const				{ return nodes.empty() ? 0 : nodes.front(); }
+	/// The first node, as an element, or null.
+	const TiXmlElement* FirstElement() const		{ return nodes.empty() ? 0 : nodes.front()->ToElement(); }
+	/// The first attribute, or null.
+	const TiXmlAttribute* FirstAttribute() const	{ return attributes.empty() ? 0 : attributes.front(); }
+
+private:
+	friend class TiXmlXPath;
+	friend class TiXmlXPathSet;
+
+	std::vector< const TiXmlNode* > nodes;
+	std::vector< const TiXmlNode* > scratch;		// the context of the current step
+	std::vector< const TiXmlAttribute* > attributes;
+	std::vector< int > counters;					// positions, per level of a descendant walk
+	std::vector< char > matched;					// whether each node on the walk's path matched
+};
+
+
+/** A compiled XPath location path, for finding nodes without chains of
+	TiXmlHandle calls. Compile once, select many times:
+	@verbatim
+	TiXmlXPath path( "/Orders/Order[@status='open']/Item[2]" );
+	TiXmlXPathResult result;
+	path.Select( &doc, &result );
+	for( const TiXmlNode* item : result.Nodes() )
+		...
+	@endverbatim
+	The subset understood:
+	- steps separated by '/' (child) or '//' (descendant), optionally
+	  starting with either to begin at the document,
+	- a name, '*' for any element, 'text()', or '.',
+	- a last step of '@name' or '@*', which selects attributes,
+	- predicates: [3] by position, counted from 1; [@a] for an attribute
+	  that exists; [@a='v'] and [@a!='v'] on its value; [name='v'] on the
+	  text of a child element. A step can have several.
+
+	As in XPath, positions count among the siblings under each parent that
+	passed the predicates before, so //Item[1] is every Item that is the
+	first in its parent. Results are in document order, without
+	duplicates.
+
+	Compiling makes a plan of steps; selecting runs it straight into the
+	result, with no node sets copied between calls. A child step by name
+	goes through FirstChildElement( name ) and ChildElementAt(), so it
+	uses the child index of any node that has one (see
+	TiXmlNode::EnableChildIndex()), and a first '//name' step comes from
+	the element index of a document that has one (see
+	TiXmlDocument::EnableElementIndex()). A plan is read-only once compiled, so
+	threads can share one; each needs its own TiXmlXPathResult.
+*/
+class TiXmlXPath
+{
+public:
+	TiXmlXPath() : absolute( false )				{}
+	/// Compile 'expression'. Check Error().
+	explicit TiXmlXPath( std::string_view expression ) : absolute( false )	{ Compile( expression ); }
+
+	/// Compile 'expression', replacing the plan. False if it is not in the subset.
+	bool Compile( std::string_view expression );
+
+	/** A compiled expression from a cache shared by the whole program, so
+		the same string is only compiled once. The plan may have an error.
+		The cache forgets everything once it holds CACHE_SIZE expressions.
+	*/
+	static std::shared_ptr< const TiXmlXPath > Cached( const std::string& expression );
+	static void ClearCache();
+	enum { CACHE_SIZE = 1024 };
+
+	/** Select from 'context' into 'result'. An expression starting with
+		'/' starts at the top of the tree 'context' is in. False if the
+		plan has an error; an empty result is not an error.
+	*/
+	bool Select( const TiXmlNode* context, TiXmlXPathResult* result ) const;
+	/// Whether the last step selects attributes.
+	bool SelectsAttributes() const					{ return !steps.empty() && steps.back().axis == AXIS_ATTRIBUTE; }
+
+	const std::string& Expression() const			{ return expression; }
+	bool Error() const								{ return !errorDesc.empty(); }
+	/// What is wrong with the expression, and where.
+	const char* ErrorDesc() const					{ return errorDesc.c_str(); }
+
+private:
+	enum Axis { AXIS_CHILD, AXIS_SELF, AXIS_ATTRIBUTE };
+	enum Test { TEST_NAME, TEST_ELEMENT, TEST_TEXT, TEST_NODE };
+
+	struct Predicate
+	{
+		enum Kind { POSITION, HAS_ATTRIBUTE, ATTRIBUTE_EQUALS, ATTRIBUTE_NOT_EQUALS, CHILD_EQUALS };
+		Kind kind;
+		int position;
+		std::string name;
+		std::string value;
+	};
+
+	struct Step
+	{
+		Axis axis;
+		bool descendant;		// after '//'
+		Test test;
+		std::string name;
+		std::vector< Predicate > predicates;
+		size_t positions;		// how many predicates are POSITION
+	};
+
+	bool Fail( const char* what, size_t offset );
+	static bool Matches( const Step& step, const TiXmlNode* node, int* counters );
+	// Each appends what 'step' selects from 'context' to 'out'.
+	void SelectChildren( const Step& step, const TiXmlNode* context, std::vector< const TiXmlNode* >* out, TiXmlXPathResult* result ) const;
+	// Returns whether any match is inside another.
+	bool SelectDescendants( const Step& step, const TiXmlNode* context, std::vector< const TiXmlNode* >* out, TiXmlXPathResult* result ) const;
+	void SelectAttributes( const Step& step, const TiXmlNode* context, TiXmlXPathResult* result ) const;
+	// A first '//name' from a document with an element index, from the index.
+	bool IndexedDescendants( const Step& step, const std::vector< const TiXmlNode* >& contexts, std::vector< const TiXmlNode* >* out, bool* nested ) const;
+
+	friend class TiXmlStreamXPath;
+	friend class TiXmlXPathSet;
+
+	std::vector< Step > steps;
+	bool absolute;
+	std::string expression;
+	std::string errorDesc;
+};
+
+
+/** An inverted index of the words in the text nodes under a node, for
+	finding text without visiting every TiXmlText:
+	@verbatim
+	doc.EnableTextIndex();
+	std::vector< const TiXmlElement* > found;
+	doc.TextIndex()->FindElements( "stainless steel", TiXmlTextIndex::MATCH_PHRASE, &found );
+	@endverbatim
+	Words are runs of letters and digits, matched without regard to ASCII
+	case; bytes from 0x80 up are letters, so UTF-8 words stay whole. Each
+	term has a posting list: every place it occurs, in document order.
+
+	Build() tokenizes on several threads, each taking a run of the text
+	nodes, and joins their lists. An index built this way describes the
+	tree as it was; the one a document owns (see
+	TiXmlDocument::EnableTextIndex()) follows its changes.
+*/
+class TiXmlTextIndex
+{
+public:
+	/// Where a term occurs.
+	struct Posting
+	{
+		unsigned text;		///< the text node, for Text()
+		unsigned position;	///< the place of the term among the words of the text, from 0
+		unsigned offset;	///< where the term starts in the text's value, in bytes
+	};
+
+	enum Match
+	{
+		MATCH_ALL,			///< texts with every word of the query
+		MATCH_ANY,			///< texts with any of them
+		MATCH_PHRASE		///< texts with all of them, one after another
+	};
+
+	/// Build on this many threads; 0 for one per core.
+	explicit TiXmlTextIndex( int threads = 0 );
+
+	/// Index the text nodes under 'node', replacing what the index held.
+	void Build( const TiXmlNode* node );
+
+	/// Splits 'text' into terms as the index does, appending them to 'terms'.
+	static void Tokenize( std::string_view text, std::vector< std::string >* terms );
+
+	/// Where 'term', already lower case, occurs; null if nowhere.
+	const std::vector< Posting >* Postings( std::string_view term ) const;
+	/// The text node a Posting refers to.
+	const TiXmlText* Text( unsigned text ) const	{ return texts[ text ]; }
+	/// Number of text nodes indexed.
+	size_t TextCount() const						{ return texts.size(); }
+	/// Number of distinct terms.
+	size_t TermCount() const						{ return terms.size(); }
+
+	/** The text nodes that match 'query', in document order, into
+		'found', which is cleared first. Returns how many. An empty query
+		matches nothing.
+	*/
+	size_t Find( std::string_view query, Match match, std::vector< const TiXmlText* >* found ) const;
+	/// As Find(), but the elements holding the texts, each once.
+	size_t FindElements( std::string_view query, Match match, std::vector< const TiXmlElement* >* found ) const;
+
+private:
+	friend class TiXmlDocument;
+	typedef std::unordered_map< std::string, std::vector< Posting > > Terms;
+
+	// The text numbers matching 'query', in order.
+	void Select( std::string_view query, Match match, std::vector< unsigned >* numbers ) const;
+	// Index one text, numbered 'number', into 'into'.
+	static void Add( const TiXmlText* text, unsigned number, Terms* into );
+
+	// For the document's own index: text appended at the end of the
+	// document, and text about to change and just changed.
+	void Append( const TiXmlNode* node );
+	void Changing( const TiXmlText* text );
+	void Changed( const TiXmlText* text );
+
+	int threads;
+	Terms terms;
+	std::vector< const TiXmlText* > texts;		// by number, in document order
+	std::unordered_map< const TiXmlText*, unsigned > numbers;
+	bool stale;		// the document changed in a way the index can't follow
+};
+
+
+/** Where printed XML goes. Writers append to Buffer() and call Poll()
+	when they reach a convenient point; once the buffer holds Capacity()
+	bytes it is handed to Drain() in one piece and emptied. So output
+	reaches the file, socket or stream in a few large writes, and however
+	large the document, only about a buffer's worth of it (or one node,
+	if a node is bigger than that) is ever held in memory.
+
+	Derive from it and implement Drain() for other destinations. Call
+	Flush() at the end: the sinks below flush when they go away too, but
+	a destructor can't report a failed write.
+	@verbatim
+	TiXmlFileSink sink( stdout );
+	doc.Save( &sink );
+	@endverbatim
+*/
+class TiXmlOutputSink
+{
+public:
+	enum { DEFAULT_CAPACITY = 64 * 1024 };
+
+	explicit TiXmlOutputSink( size_t capacity = DEFAULT_CAPACITY );
+	virtual ~TiXmlOutputSink()						{}
+
+	/// Append bytes. A block of Capacity() or more goes straight to Drain(), after what is pending.
+	void Write( const char* data, size_t size );
+	void Write( const std::string& str )			{ Write( str.data(), str.size() ); }
+
+	/// The pending output, for writers that append to it directly. Call Poll() after.
+	std::string& Buffer()							{ return *out; }
+	/// Drain the buffer if it has reached capacity.
+	void Poll()										{ if ( out->size() >= capacity ) Flush(); }
+	/// Pass on everything pending. Returns false if this or any earlier write failed.
+	virtual bool Flush();
+	/// False once a write has failed. Output after that is discarded.
+	bool Good() const								{ return good; }
+	/// Whether Reserve() is of use, so that a writer knows to work out the size at all.
+	virtual bool WantsReserve() const				{ return false; }
+	/// A hint of how much output is coming, for sinks that keep all of it.
+	virtual void Reserve( size_t )					{}
+
+	size_t Capacity() const							{ return capacity; }
+
+protected:
+	// For sinks that append to a string of their own instead of buffering.
+	TiXmlOutputSink( std::string* target, size_t _capacity ) : out( target ), capacity( _capacity ), good( true ) {}
+
+	/// Deliver one block of output. Return false if it couldn't be written.
+	virtual bool Drain( const char* data, size_t size ) = 0;
+
+private:
+	TiXmlOutputSink( const TiXmlOutputSink& );			// not allowed.
+	void operator=( const TiXmlOutputSink& );			// not allowed.
+
+	std::string buffer;
+	std::string* out;
+	size_t capacity;
+	bool good;
+};
+
+
+/// Appends to a std::string. There is nothing to drain: the string is the buffer.
+class TiXmlStringSink : public TiXmlOutputSink
+{
+public:
+	explicit TiXmlStringSink( std::string* str ) : TiXmlOutputSink( str, (size_t) -1 ) {}
+
+	virtual bool Flush()							{ return true; }
+	virtual bool WantsReserve() const				{ return true; }
+	virtual void Reserve( size_t size )				{ Buffer().reserve( Buffer().size() + size ); }
+
+protected:
+	virtual bool Drain( const char*, size_t )		{ return true; }
+};
+
+
+/// Writes to a file descriptor, with write() (_write() on Windows). The descriptor is not closed.
+class TiXmlFdSink : public TiXmlOutputSink
+{
+public:
+	explicit TiXmlFdSink( int _fd, size_t capacity = DEFAULT_CAPACITY ) : TiXmlOutputSink( capacity ), fd( _fd ) {}
+	~TiXmlFdSink()									{ Flush(); }
+
+protected:
+	virtual bool Drain( const char* data, size_t size );
+
+private:
+	int fd;
+};
+
+
+/// Writes to a FILE*, and flushes it on Flush(). The file is not closed.
+class TiXmlFileSink : public TiXmlOutputSink
+{
+public:
+	explicit TiXmlFileSink( FILE* _file, size_t capacity = DEFAULT_CAPACITY ) : TiXmlOutputSink( capacity ), file( _file ) {}
+	~TiXmlFileSink()								{ Flush(); }
+
+	virtual bool Flush();
+
+protected:
+	virtual bool Drain( const char* data, size_t size );
+
+private:
+	FILE* file;
+};
+
+
+/// Writes to a std::ostream, and flushes it on Flush().
+class TiXmlStreamSink : public TiXmlOutputSink
+{
+public:
+	explicit TiXmlStreamSink( std::ostream& _stream, size_t capacity = DEFAULT_CAPACITY ) : TiXmlOutputSink( capacity ), stream( _stream ) {}
+	~TiXmlStreamSink()								{ Flush(); }
+
+	virtual bool Flush();
+
+protected:
+	virtual bool Drain( const char* data, size_t size );
+
+private:
+	std::ostream& stream;
+};
+
+
+/** Hands each block to a function, which returns false to report a
+	failed write. For sockets, compressors and the like:
+	@verbatim
+	TiXmlCallbackSink sink( [&]( const char* data, size_t size ) {
+		return send( socket, data, size, 0 ) == (ssize_t) size;
+	} );
+	@endverbatim
+*/
+class TiXmlCallbackSink : public TiXmlOutputSink
+{
+public:
+	typedef std::function< bool( const char* data, size_t size ) > Callback;
+
+	explicit TiXmlCallbackSink( Callback _callback, size_t capacity = DEFAULT_CAPACITY ) : TiXmlOutputSink( capacity ), callback( std::move( _callback ) ) {}
+	~TiXmlCallbackSink()							{ Flush(); }
+
+protected:
+	virtual bool Drain( const char* data, size_t size )	{ return callback( data, size ); }
+
+private:
+	Callback callback;
+};
+
+
+#ifdef TIXML_USE_ZLIB
+/** Compresses to gzip format, with zlib, into another sink. Finish()
+	ends the stream and flushes the target; the destructor does that if
+	it wasn't done, but can't report a failure. TiXmlDocument::SaveFile()
+	uses it for ".gz" names.
+	@verbatim
+	TiXmlFdSink socketSink( socket );
+	TiXmlGzipSink gzip( &socketSink );
+	doc.Save( &gzip );
+	gzip.Finish();
+	@endverbatim
+*/
+class TiXmlGzipSink : public TiXmlOutputSink
+{
+public:
+	/// level is zlib's, 1 (fastest) to 9 (smallest).
+	explicit TiXmlGzipSink( TiXmlOutputSink* target, int level = 6 );
+	~TiXmlGzipSink();
+
+	/// Compress what is pending, end the stream, and flush the target.
+	bool Finish();
+
+protected:
+	virtual bool Drain( const char* data, size_t size );
+
+private:
+	bool Compress( const char* data, size_t size, bool end );
+
+	TiXmlOutputSink* target;
+	void* stream;			// z_stream
+	std::string chunk;
+	bool finished;
+};
+#endif
+
+
+#ifdef TIXML_USE_ZSTD
+/// Compresses to zstd format into another sink. Used like TiXmlGzipSink.
+class TiXmlZstdSink : public TiXmlOutputSink
+{
+public:
+	/// level is zstd's, 1 (fastest) to 19 (smallest).
+	explicit TiXmlZstdSink( TiXmlOutputSink* target, int level = 3 );
+	~TiXmlZstdSink();
+
+	/// Compress what is pending, end the frame, and flush the target.
+	bool Finish();
+
+protected:
+	virtual bool Drain( const char* data, size_t size );
+
+private:
+	bool Compress( const char* data, size_t size, bool end );
+
+	TiXmlOutputSink* target;
+	void* stream;			// ZSTD_CStream
+	std::string chunk;
+	bool finished;
+};
+#endif
+
+
+/** Reads the decompressed text of another stream, one block at a time, so
+	a compressed file can be read by a TiXmlPullParser, and so by
+	TiXmlStreamXPath and TiXmlXPathSet, in bounded memory:
+	@verbatim
+	std::ifstream file( "orders.xml.gz", std::ios::binary );
+	TiXmlDecompressStream xml( &file );
+	TiXmlPullParser parser( &xml );
+	@endverbatim
+	Input that is corrupt or cut short ends the text early, and Error()
+	says so. gzip needs the library built with TIXML_USE_ZLIB, zstd with
+	TIXML_USE_ZSTD; without, the text is empty and Error() is true.
+*/
+class TiXmlDecompressStream : public std::istream
+{
+public:
+	/// Tells the compression from the first bytes; plain text is passed through.
+	explicit TiXmlDecompressStream( std::istream* source );
+	/// Reads 'source' as 'compression'.
+	TiXmlDecompressStream( std::istream* source, TiXmlCompression compression );
+
+	/// True if the input was corrupt, cut short, or of a format not built in.
+	bool Error() const							{ return buffer.failed; }
+	/** The size of the text, as the input claims it, once reading has
+		begun; 0 if it doesn't say. Only a hint: it is never trusted
+		beyond what the compressed size allows, or 64 MB.
+	*/
+	size_t ExpectedSize() const					{ return buffer.expected; }
+
+private:
+	TiXmlDecompressStream( const TiXmlDecompressStream& )=delete;
+	void operator=( const TiXmlDecompressStream& )=delete;
+
+	class Buffer : public std::streambuf
+	{
+	public:
+		Buffer( std::istream* source, TiXmlCompression compression, bool detect );
+		~Buffer();
+
+		size_t expected;
+		bool failed;
+
+	protected:
+		virtual int_type underflow();
+		virtual std::streamsize xsgetn( char* s, std::streamsize n );
+
+	private:
+		void Start();
+		bool Fill();
+		// Up to 'size' bytes of text into 'out'; 0 at the end.
+		size_t Decompress( char* out, size_t size );
+
+		std::istream* source;
+		TiXmlCompression compression;
+		bool detect;			// tell the compression from the first bytes
+		void* stream;			// z_stream or ZSTD_DStream
+		std::string input, output;
+		size_t next, available;	// what is left of 'input'
+		bool started, ended, pending;
+	};
+	Buffer buffer;
+};
+
+
+/** Print to memory functionality. The TiXmlPrinter is useful when you need to:
+
+	-# Print to memory (especially in non-STL mode)
 	-# Control formatting (line endings, etc.)
 
 	When constructed, the TiXmlPrinter is in its default "pretty printing" mode.
 	Before calling Accept() you can call methods to control the printing
 	of the XML document. After TiXmlNode::Accept() is called, the printed document can
-	be accessed via the CStr(), Str(), and Size() methods.
+	be accessed via the Str(), View() and Size() methods.
+
+	Given a TiXmlOutputSink, the printer writes there instead, and
+	Str() stays empty. The sink is not flushed; that is up to the caller,
+	or done by TiXmlDocument::Save().
 
 	TiXmlPrinter uses the Visitor API.
 	@verbatim
@@ -1625,14 +3005,17 @@ private:
 	printer.SetIndent( "\t" );
 
 	doc.Accept( &printer );
-	fprintf( stdout, "%s", printer.CStr() );
+	fprintf( stdout, "%s", printer.Str().c_str() );
 	@endverbatim
 */
 class TiXmlPrinter : public TiXmlVisitor
 {
 public:
 	TiXmlPrinter() : depth( 0 ), simpleTextPrint( false ),
-					 buffer(), indent( "    " ), lineBreak( "\n" ) {}
+					 buffer(), indent( "    " ), lineBreak( "\n" ), sink( 0 ) {}
+	/// A printer that writes to the given sink.
+	explicit TiXmlPrinter( TiXmlOutputSink* _sink ) : depth( 0 ), simpleTextPrint( false ),
+					 buffer(), indent( "    " ), lineBreak( "\n" ), sink( _sink ) {}
 
 	virtual bool VisitEnter( const TiXmlDocument& doc );
 	virtual bool VisitExit( const TiXmlDocument& doc );
@@ -1665,26 +3048,1417 @@ public:
 	void SetStreamPrinting()						{ indent = "";
 													  lineBreak = "";
 													}	
+	/// Send the output to a sink, or back to the printer's own string if null.
+	void SetSink( TiXmlOutputSink* _sink )			{ sink = _sink; }
+	/// Start indenting at this level, when printing a fragment of a larger document.
+	void SetDepth( int _depth )						{ depth = _depth; }
+
 	/// Return the length of the result string.
 	size_t Size()									{ return buffer.size(); }
 
 	/// Return the result.
-	std::string Str()						{ return buffer; }
+	const std::string& Str() const					{ return buffer; }
+	/// Return the result, without a copy. Valid until the printer prints again or goes away.
+	std::string_view View() const					{ return buffer; }
+	/// Move the result out, leaving the printer empty and ready for another document.
+	std::string TakeStr()							{ std::string result; result.swap( buffer ); return result; }
+	/// Empty the result but keep its storage, so printing the next document needn't allocate.
+	void Clear()									{ buffer.clear(); depth = 0; simpleTextPrint = false; }
 
 private:
-	void DoIndent()	{
+	std::string& Out()		{ return sink ? sink->Buffer() : buffer; }
+	void Done()				{ if ( sink ) sink->Poll(); }
+	void DoIndent( std::string& out ) {
 		for( int i=0; i<depth; ++i )
-			buffer += indent;
+			out += indent;
 	}
-	void DoLineBreak() {
-		buffer += lineBreak;
+	void DoLineBreak( std::string& out ) {
+		out += lineBreak;
 	}
+	// Upper bound guess of the printed size of a document, to reserve once.
+	size_t EstimateSize( const TiXmlDocument& doc ) const;
 
 	int depth;
 	bool simpleTextPrint;
 	std::string buffer;
 	std::string indent;
 	std::string lineBreak;
+	TiXmlOutputSink* sink;
+};
+
+
+/** Prints on several threads, to the same bytes as TiXmlPrinter. The
+	tree is cut into runs of siblings of about SetGrainSize() bytes each;
+	an element too big for one run gets its start and end tags printed
+	here and its children cut again, one level deeper. Worker threads
+	print the runs, each with a TiXmlPrinter started at the run's depth,
+	and the runs go to the sink in document order as they are done.
+	Only a few runs per thread are held at a time, so memory stays
+	bounded however large the document.
+	@verbatim
+	TiXmlFdSink sink( fd );
+	TiXmlParallelPrinter printer;
+	printer.Print( doc, &sink );
+	@endverbatim
+	The nodes must not change while they are printed. Unlike
+	TiXmlDocument::Save(), no byte order mark is written.
+*/
+class TiXmlParallelPrinter
+{
+public:
+	enum { DEFAULT_GRAIN = 256 * 1024 };
+
+	/// Use this many threads; 0 for one per core. With one, printing is a plain TiXmlPrinter's.
+	explicit TiXmlParallelPrinter( int threads = 0 );
+
+	void SetIndent( const std::string& _indent )		{ indent = _indent; }
+	void SetLineBreak( const std::string& _lineBreak )	{ lineBreak = _lineBreak; }
+	void SetStreamPrinting()							{ indent = ""; lineBreak = ""; }
+	/// The printed size to aim for per run, estimated.
+	void SetGrainSize( size_t bytes )					{ grain = bytes ? bytes : 1; }
+
+	/// Print a node and its children, or all of a document, and flush the sink.
+	bool Print( const TiXmlNode& node, TiXmlOutputSink* sink );
+
+private:
+	int threads;
+	size_t grain;
+	std::string indent;
+	std::string lineBreak;
+};
+
+
+/** Runs a TiXmlVisitor over a large tree on several threads. The tree is
+	cut into tasks of about SetGrainSize() nodes, and each task gets its
+	own copy of the visitor. The copies are then folded into the
+	original, in document order, by a reduce step:
+	@verbatim
+	struct Counter : public TiXmlVisitor {
+		size_t elements = 0;
+		bool VisitEnter( const TiXmlElement&, const TiXmlAttribute* ) { ++elements; return true; }
+	};
+	Counter total;
+	TiXmlParallelTraversal traversal;
+	traversal.Accept( doc, &total, []( Counter& into, const Counter& part ) { into.elements += part.elements; } );
+	@endverbatim
+	Tasks are cut as the work goes, not in a pass beforehand. A run of
+	siblings too big for one task is halved, and the second half is left
+	for an idle thread to steal. A single element too big for one task
+	gets its VisitEnter() and VisitExit() on a copy of its own, and its
+	children become a new run. So a copy sees whole subtrees, but not the
+	elements above them. False from VisitEnter() skips the children as
+	usual. False from Visit() or VisitExit() only ends the task it
+	happened in.
+
+	The copies are made from the visitor as Accept() finds it, so it
+	should be in its starting state. Trees of fewer than SetSerialLimit()
+	nodes, or a traversal with one thread, are visited with node.Accept(
+	visitor ) and no reduce step at all.
+
+	The nodes must not change while they are visited, and visitors must
+	not look anything up that rebuilds a stale index from a const method;
+	TiXmlDocument::UpdateIndexes() before the traversal rules that out.
+	A TiXmlDoubleBufferedDocument snapshot never changes: the overload taking
+	one holds on to it until the traversal is done.
+*/
+class TiXmlParallelTraversal
+{
+public:
+	enum
+	{
+		DEFAULT_GRAIN = 4096,				///< nodes per task
+		DEFAULT_SERIAL_LIMIT = 65536		///< nodes below which the traversal is serial
+	};
+
+	/// Use this many threads; 0 for one per core. With one, every traversal is serial.
+	explicit TiXmlParallelTraversal( int threads = 0 );
+
+	/// The number of nodes to aim for per task.
+	void SetGrainSize( size_t nodes )		{ grain = nodes ? nodes : 1; }
+	/// Trees with fewer nodes than this are visited serially.
+	void SetSerialLimit( size_t nodes )		{ serialLimit = nodes; }
+
+	/** Visit 'node' and everything under it with copies of 'visitor',
+		then call reduce( *visitor, copy ) for each copy in document order.
+		V is a copyable TiXmlVisitor.
+	*/
+	template< typename V, typename Reduce > void Accept( const TiXmlNode& node, V* visitor, Reduce reduce )
+	{
+		static_assert( std::is_base_of_v< TiXmlVisitor, V >, "TiXmlParallelTraversal runs a TiXmlVisitor" );
+		std::vector< std::unique_ptr< TiXmlVisitor > > copies;
+		if ( !Run( node, [visitor]() { return std::unique_ptr< TiXmlVisitor >( new V( *visitor ) ); }, &copies ) )
+		{
+			node.Accept( visitor );
+			return;
+		}
+		for( const std::unique_ptr< TiXmlVisitor >& copy : copies )
+			reduce( *visitor, static_cast< const V& >( *copy ) );
+	}
+
+	/// Visit a version of a TiXmlDoubleBufferedDocument, keeping it alive until done.
+	template< typename V, typename Reduce > void Accept( TiXmlDoubleBufferedDocument::Snapshot snapshot, V* visitor, Reduce reduce )
+	{
+		if ( snapshot )
+			Accept( *snapshot, visitor, reduce );
+	}
+
+	/// How many copies the last Accept() reduced; 0 if it was serial.
+	size_t Tasks() const					{ return tasks; }
+
+private:
+	typedef std::function< std::unique_ptr< TiXmlVisitor >() > Copier;
+
+	// Visits 'node' in tasks, each with a visitor from 'copy', into
+	// 'copies' in document order. False, having done nothing, if the
+	// traversal should be serial.
+	bool Run( const TiXmlNode& node, const Copier& copy, std::vector< std::unique_ptr< TiXmlVisitor > >* copies );
+
+	int threads;
+	size_t grain;
+	size_t serialLimit;
+	size_t tasks;
+};
+
+
+/** Writes XML straight to a TiXmlOutputSink, without building a document
+	first. Memory use stays the same however much is written: the open
+	element names and the attribute names of the current start tag, and
+	the sink's buffer.
+	@verbatim
+	TiXmlFdSink sink( fd );
+	TiXmlStreamWriter writer( &sink );
+	writer.PushDeclaration( "1.0", "UTF-8", "" );
+	writer.OpenElement( "Orders" );
+	for( ... ) {
+		writer.OpenElement( "Order" );
+		writer.PushAttribute( "id", id );
+		writer.PushText( note );
+		writer.CloseElement();
+	}
+	writer.CloseElement();
+	writer.Finish();
+	@endverbatim
+	Escaping and layout are the TiXmlPrinter's, so with the same settings
+	the writer and a printed document give the same bytes. The one
+	exception is text followed by more content in the same element: the
+	writer can't know what follows, so the text stays on the line of the
+	start tag.
+
+	The writer checks that the output is well formed: names are names, a
+	single root element, no text outside it, attributes only in a start
+	tag and only once each, elements closed in order, no "--" in a comment
+	and no "]]>" in CDATA. A call that would break that returns false and
+	writes nothing, and so do all calls after it; Good() tells.
+*/
+class TiXmlStreamWriter
+{
+public:
+	explicit TiXmlStreamWriter( TiXmlOutputSink* sink );
+
+	/// Set the indent, by default 4 spaces. See TiXmlPrinter::SetIndent().
+	void SetIndent( const std::string& _indent )		{ indent = _indent; }
+	/// Set the line break, by default "\n".
+	void SetLineBreak( const std::string& _lineBreak )	{ lineBreak = _lineBreak; }
+	/// No indentation and no line breaks, as TiXmlPrinter::SetStreamPrinting().
+	void SetStreamPrinting()							{ indent = ""; lineBreak = ""; }
+
+	/// The XML declaration. Only first, before anything else. Empty parts are left out.
+	bool PushDeclaration( const std::string& version, const std::string& encoding, const std::string& standalone );
+	/// Start an element. Its attributes may follow, until any content does.
+	bool OpenElement( const std::string& name );
+	/// Add an attribute to the element just opened.
+	bool PushAttribute( const std::string& name, const std::string& value );
+	bool PushAttribute( const std::string& name, int value );
+	bool PushAttribute( const std::string& name, double value );
+	/// Text, escaped, or a CDATA section.
+	bool PushText( const std::string& text, bool cdata = false );
+	bool PushComment( const std::string& comment );
+	/// End the innermost open element. One without content is written as <name />.
+	bool CloseElement();
+	/// Check the document is complete, and flush the sink.
+	bool Finish();
+
+	/// False once a call was refused, or the sink failed.
+	bool Good() const									{ return good && sink->Good(); }
+	/// How many elements are open.
+	int Depth() const									{ return (int) depth; }
+
+private:
+	TiXmlStreamWriter( const TiXmlStreamWriter& );		// not allowed.
+	void operator=( const TiXmlStreamWriter& );			// not allowed.
+
+	bool Fail()											{ good = false; return false; }
+	// Finish the start tag or inline text before other content.
+	void BeginContent( std::string& out, bool inlineText );
+	void DoIndent( std::string& out, size_t level );
+
+	TiXmlOutputSink* sink;
+	std::string indent;
+	std::string lineBreak;
+	std::vector< std::string > names;	// open elements; the strings are reused
+	size_t depth;
+	std::vector< std::string > attributeNames;
+	size_t attributeCount;
+	std::string number;		// numeric attribute values are formatted here
+	bool startOpen;			// the '>' of the innermost start tag is still to come
+	bool inlineText;		// text is on the line of the innermost start tag
+	bool begun;				// something has been written
+	bool rootSeen;
+	bool good;
+};
+
+
+/** Reads XML a piece at a time, without building a document. Each call to
+	Next() moves to the next start tag, end tag, text, comment, declaration
+	or unknown node and says which it is; the name, attributes and value of
+	that piece stay good until the next call. An empty element <a/> gives a
+	start and an end. Blank text is skipped, as it is in a document.
+	@verbatim
+	std::ifstream in( "orders.xml", std::ios::binary );
+	TiXmlPullParser parser( &in );
+	for( int event = parser.Next(); event != TiXmlPullParser::PULL_END; event = parser.Next() ) {
+		if ( event == TiXmlPullParser::PULL_ERROR )
+			...parser.ErrorDesc()
+		if ( event == TiXmlPullParser::PULL_START_ELEMENT && parser.Name() == "Order" )
+			parser.QueryValueAttribute( "id", &id );
+	}
+	@endverbatim
+	The parser reads from a string, or from a stream one block at a time.
+	Either way its memory follows the largest single piece and the depth of
+	nesting, not the size of the input. Names, text and attribute values are
+	read by the same code as TiXmlDocument::Parse(), with entities decoded
+	and white space condensed the same way.
+
+	End tags must match their start tags. Anything wrong stops the parser:
+	Next() returns PULL_ERROR from then on, and ErrorId() and ErrorDesc()
+	say what it was.
+*/
+class TiXmlPullParser
+{
+public:
+	enum Event
+	{
+		PULL_BEGIN,			///< Next() hasn't been called yet.
+		PULL_START_ELEMENT,	///< Name() and the attributes are set.
+		PULL_END_ELEMENT,	///< Name() is set.
+		PULL_TEXT,			///< Value() and CDATA() are set.
+		PULL_COMMENT,		///< Value() is set.
+		PULL_DECLARATION,	///< The attributes are the version, encoding and standalone.
+		PULL_UNKNOWN,		///< Value() is set, as TiXmlUnknown's.
+		PULL_END,			///< The input is done.
+		PULL_ERROR
+	};
+
+	/// Read 'xml', which must outlive the parser.
+	explicit TiXmlPullParser( const std::string& xml );
+	/// Read a stream, 'blockSize' bytes at a time.
+	explicit TiXmlPullParser( std::istream* in, size_t blockSize = 1 << 16 );
+
+	/// Move to the next piece.
+	Event Next();
+	/// The piece Next() last moved to.
+	Event Current() const								{ return event; }
+
+	/** Skip the rest of the element whose start Next() just returned, to
+		its end. False if the input ends or is broken first.
+	*/
+	bool SkipElement();
+
+	/// The name of the element, at its start or end.
+	const std::string& Name() const						{ return name; }
+	/// The text, comment or unknown.
+	const std::string& Value() const					{ return value; }
+	/// For text, whether it was CDATA.
+	bool CDATA() const									{ return cdata; }
+	/// Open elements, the current one included at its start but not at its end.
+	int Depth() const									{ return (int) depth; }
+
+	/// Number of attributes of the start tag or declaration.
+	int AttributeCount() const							{ return (int) attributeCount; }
+	const std::string& AttributeName( int i ) const		{ return attributeNames[i]; }	///< Name of the i'th attribute, in document order.
+	const std::string& AttributeValue( int i ) const	{ return attributeValues[i]; }	///< Value of the i'th attribute, in document order.
+	/// The value of the named attribute, or null if there is none.
+	const std::string* Attribute( std::string_view _name ) const;
+
+	/** Read an attribute as TiXmlElement::QueryValueAttribute() does, for
+		a number, bool, enum or string.
+		@return TIXML_SUCCESS, TIXML_WRONG_TYPE, or TIXML_NO_ATTRIBUTE
+	*/
+	template< typename T > int QueryValueAttribute( std::string_view _name, T* outValue ) const
+	{
+		const std::string* s = Attribute( _name );
+		if ( !s )
+			return TIXML_NO_ATTRIBUTE;
+		return TiXmlBase::ReadValue( *s, outValue );
+	}
+	int QueryValueAttribute( std::string_view _name, std::string* outValue ) const
+	{
+		const std::string* s = Attribute( _name );
+		if ( !s )
+			return TIXML_NO_ATTRIBUTE;
+		*outValue = *s;
+		return TIXML_SUCCESS;
+	}
+
+	bool Error() const									{ return errorId != 0; }
+	/// One of TiXmlBase's error codes, as TiXmlDocument::ErrorId().
+	int ErrorId() const									{ return errorId; }
+	const char* ErrorDesc() const;
+
+private:
+	TiXmlPullParser( const TiXmlPullParser& );		// not allowed.
+	void operator=( const TiXmlPullParser& );		// not allowed.
+
+	Event Fail( int error );
+	// More of the stream at the end of the buffer; false at its end.
+	bool Fill();
+	// At least 'n' bytes from 'pos', or as many as there are.
+	size_t Ensure( size_t n );
+	// Offsets from 'pos', or npos if the input ends first.
+	size_t Find( const char* terminator, size_t from );
+	size_t FindTagEnd();
+
+	Event ReadStartTag( size_t end );
+	Event ReadEndTag( size_t end );
+	Event ReadDeclaration( size_t end );
+	void AddAttribute( const std::string& _name, const std::string& _value );
+
+	std::istream* in;
+	size_t blockSize;
+	std::string buffer;			// the unread part of the stream
+	const std::string* text;	// the string or the buffer
+	size_t pos;
+
+	Event event;
+	std::string name;
+	std::string value;
+	bool cdata;
+	bool emptyElement;			// the end of <a/> is still to come
+	std::vector< std::string > names;	// open elements; the strings are reused
+	size_t depth;
+	std::vector< std::string > attributeNames;
+	std::vector< std::string > attributeValues;
+	size_t attributeCount;
+	TiXmlDeclaration declaration;
+	TiXmlEncoding encoding;
+	bool started;
+	bool rootSeen;
+	int errorId;
+};
+
+
+/** Runs an XPath over a TiXmlPullParser as it reads, with no document,
+	so it can search input of any size:
+	@verbatim
+	TiXmlStreamXPath open( "count(//Order[@status='open'])" );
+	std::ifstream in( "orders.xml", std::ios::binary );
+	TiXmlPullParser parser( &in );
+	if ( open.Run( &parser ) )
+		printf( "%d open orders\n", (int) open.MatchCount() );
+	@endverbatim
+	The expression is a forward-only part of TiXmlXPath's subset. Every
+	step and predicate has to be decided at the start tag, so [name='v']
+	is not allowed, since it needs children not yet read. A relative
+	path starts at the document, as an absolute one does. The whole path
+	can be wrapped in count(), which only changes IsCount().
+
+	Each match goes to the callback as soon as it is read, with the
+	parser on it: at the start tag of a matching element, on a matching
+	text, or at the start tag of the element whose attribute matched,
+	with the attribute's index. The callback returns false to stop. For
+	an element, it may read on to the element's end, with SkipElement()
+	or TiXmlBinder::Load() for instance; any matches inside are then
+	missed.
+
+	Memory follows the depth of the input and the number of steps that
+	could still match, not the size of the input. Elements that can't
+	hold a match are skipped without looking inside. A TiXmlStreamXPath
+	reuses its memory from one Run() to the next.
+*/
+class TiXmlStreamXPath
+{
+public:
+	/** Called for each match. 'attribute' is the index of the attribute
+		that matched, or -1 for an element or text. Return false to stop.
+	*/
+	typedef std::function< bool( TiXmlPullParser* parser, int attribute ) > Callback;
+
+	TiXmlStreamXPath() : count( false ), matches( 0 ), stopped( false )	{}
+	/// Compile 'expression'. Check Error().
+	explicit TiXmlStreamXPath( std::string_view expression ) : count( false ), matches( 0 ), stopped( false )	{ Compile( expression ); }
+
+	/// Compile 'expression'. False if it can't be run over a stream.
+	bool Compile( std::string_view expression );
+
+	/** Read 'parser' to the end of its input, passing each match to
+		'callback', which may be empty. False if the expression or the
+		input has an error; stopping early is not an error.
+	*/
+	bool Run( TiXmlPullParser* parser, const Callback& callback = Callback() );
+	/// The number of matches of the last Run().
+	size_t MatchCount() const						{ return matches; }
+
+	/// Whether the expression was wrapped in count().
+	bool IsCount() const							{ return count; }
+	const std::string& Expression() const			{ return expression; }
+	bool Error() const								{ return path.Error(); }
+	const char* ErrorDesc() const					{ return path.ErrorDesc(); }
+
+private:
+	// A step that the children of an open element might match.
+	struct State
+	{
+		size_t step;		// in 'plan'
+		size_t counters;	// where its positions are, in 'counters'
+	};
+	// Where each open element's states begin.
+	struct Frame
+	{
+		size_t states;
+		size_t counters;
+	};
+
+	friend class TiXmlXPathSet;
+
+	const TiXmlXPath::Step& StepAt( size_t i ) const	{ return path.steps[ plan[i] ]; }
+	static bool Matches( const TiXmlXPath::Step& step, const TiXmlPullParser& parser, int* positions );
+	void AddState( size_t step, size_t frameBegin );
+	bool StartElement( TiXmlPullParser* parser, const Callback& callback );
+	void Text( TiXmlPullParser* parser, const Callback& callback );
+	void Deliver( TiXmlPullParser* parser, int attribute, const Callback& callback );
+
+	TiXmlXPath path;
+	std::vector< size_t > plan;		// the steps of 'path', without any '.'
+	std::string expression;
+	bool count;
+
+	std::vector< State > states;	// of all open elements, innermost last
+	std::vector< Frame > frames;
+	std::vector< int > counters;
+	size_t matches;
+	bool stopped;
+};
+
+
+/** Many TiXmlXPath expressions, run together in one pass over a tree,
+	or over a TiXmlPullParser:
+	@verbatim
+	TiXmlXPathSet paths;
+	int id = paths.Add( "/Orders/Order/@id" );
+	int open = paths.Add( "//Order[@status='open']" );
+	std::vector< TiXmlXPathResult > results;
+	paths.Select( &doc, &results );
+	for( const TiXmlAttribute* attribute : results[id].Attributes() )
+		...
+	@endverbatim
+	Each expression fills its own TiXmlXPathResult, with what a
+	TiXmlXPath of it would select. Run() gives the matches of each to a
+	callback, with the limits of TiXmlStreamXPath: nothing that has to
+	look at children, and every path starts at the document.
+
+	The steps of all the paths go into one tree, where paths that start
+	with the same steps share them. While walking, each open element has
+	the set of steps its children might match. The set for a child comes
+	from the set of its parent and the child's name; that move is worked
+	out the first time it is needed and then looked up, so a node costs
+	about the same however many paths there are. Only predicates on
+	attributes and positions are tested node by node, and only for steps
+	whose name matched. Elements that can't hold a match are not walked.
+
+	The moves are kept from one Select() or Run() to the next. A set is
+	not for sharing between threads; give each its own.
+*/
+class TiXmlXPathSet
+{
+public:
+	/** Called for each match, with the index of the expression that
+		matched. 'attribute' is the index of the attribute that matched,
+		or -1 for an element or text. Return false to stop.
+	*/
+	typedef std::function< bool( TiXmlPullParser* parser, size_t query, int attribute ) > Callback;
+
+	TiXmlXPathSet() : stopped( false )				{}
+
+	/** Compile 'expression' and add it after the others. Returns its
+		index in the results, or -1 if it is not in TiXmlXPath's subset;
+		see ErrorDesc().
+	*/
+	int Add( std::string_view expression );
+	/// Remove all the expressions.
+	void Clear();
+
+	/// Number of expressions.
+	size_t Size() const								{ return queries.size(); }
+	const std::string& Expression( size_t query ) const	{ return queries[query].expression; }
+
+	/** Select every expression from 'context', in one walk; 'results'
+		gets one TiXmlXPathResult for each, in the order they were added.
+		An expression starting with '/' starts at the top of the tree
+		'context' is in.
+	*/
+	void Select( const TiXmlNode* context, std::vector< TiXmlXPathResult >* results );
+
+	/** Read 'parser' to the end of its input, passing each match of each
+		expression to 'callback', which may be empty. A callback may read
+		on from an element, as with TiXmlStreamXPath; the element's other
+		matches are then missed too. False if an expression can't be run
+		over a stream, or the input has an error; stopping early is not
+		an error.
+	*/
+	bool Run( TiXmlPullParser* parser, const Callback& callback = Callback() );
+	/// The number of matches of an expression, in the last Run().
+	size_t MatchCount( size_t query ) const			{ return query < matches.size() ? matches[query] : 0; }
+
+	bool Error() const								{ return !errorDesc.empty(); }
+	/// What is wrong with the last expression added, or the last Run().
+	const char* ErrorDesc() const					{ return errorDesc.c_str(); }
+
+private:
+	enum { NONE = -1, KIND_TEXT = 0, KIND_ELEMENT = 1 };
+
+	struct Query
+	{
+		std::string expression;
+		bool absolute;
+		bool attributes;		// whether it selects attributes
+		int first;				// its first step, or NONE if it selects the context
+		int state;				// its last step
+		std::string streamError;
+	};
+
+	// A step in the tree of steps. The root of the tree is not a state.
+	struct State
+	{
+		TiXmlXPath::Step step;
+		std::vector< int > next;		// the steps after it
+		std::vector< size_t > ends;		// the queries it is the last step of
+	};
+
+	// The states that might match the children of an open element, or,
+	// for an attribute step, its attributes.
+	struct StateSet
+	{
+		std::vector< int > states;		// sorted
+		std::vector< size_t > counters;	// where each state's positions are
+		size_t positions;
+		std::vector< int > attributes;	// the states with attribute steps
+		bool live;						// whether a child could match anything
+		std::vector< int > moves;		// by kind of child; NONE until needed
+	};
+
+	// From a set, for one kind of child.
+	struct Move
+	{
+		int next;						// the set for the child's children
+		std::vector< size_t > ends;		// the queries that select the child
+		std::vector< size_t > checks;	// indexes in the set of states with predicates to test
+		// The set for the child's children for each outcome of the checks seen so far.
+		std::map< std::vector< char >, int > outcomes;
+	};
+
+	struct Frame
+	{
+		const TiXmlNode* node;
+		int set;
+		size_t counters;
+	};
+
+	static bool Same( const TiXmlXPath::Step& a, const TiXmlXPath::Step& b );
+	int Kind( const std::string& name ) const;
+	int Intern( std::vector< int >* states );
+	int MoveFor( int set, int kind );
+	// The set after a move with checks, as 'passed' says they came out.
+	int Checked( int set, int move );
+	int Start( bool relative, bool absolute );
+	void Attributes( const TiXmlElement* element, int set, std::vector< TiXmlXPathResult >* results ) const;
+	void Walk( const TiXmlNode* top, int set, std::vector< TiXmlXPathResult >* results );
+	// False, without calling back, once stopped or once the callback has read past 'event'.
+	bool Deliver( TiXmlPullParser* parser, TiXmlPullParser::Event event, size_t query, int attribute, const Callback& callback );
+
+	std::vector< Query > queries;
+	std::vector< State > states;
+	std::unordered_map< std::string, int > kinds;	// names the steps test for
+	std::string errorDesc;
+
+	std::vector< StateSet > sets;
+	std::map< std::vector< int >, int > setIndex;
+	std::vector< Move > moves;
+
+	std::vector< Frame > frames;
+	std::vector< int > counters;
+	std::vector< char > passed;
+	std::vector< size_t > matches;
+	bool stopped;
+};
+
+
+/** The members of a struct that TiXmlBinder loads and saves. Describe a
+	struct by specializing TiXmlBind for it, with a tuple of members:
+	@verbatim
+	struct Item { std::string sku; int qty = 0; std::string label; };
+	struct Order { int id = 0; bool express = false; std::string note; std::vector< Item > items; };
+
+	template<> struct TiXmlBind< Item > {
+		static constexpr auto members = std::make_tuple(
+			TiXmlBindAttribute( "sku", &Item::sku ),
+			TiXmlBindAttribute( "qty", &Item::qty ),
+			TiXmlBindText( &Item::label ) );
+	};
+	template<> struct TiXmlBind< Order > {
+		static constexpr auto members = std::make_tuple(
+			TiXmlBindAttribute( "id", &Order::id ),
+			TiXmlBindAttribute( "express", &Order::express ),
+			TiXmlBindElement( "Note", &Order::note ),
+			TiXmlBindSequence( "Item", &Order::items ) );
+	};
+	@endverbatim
+	which reads and writes
+	@verbatim
+	<Order id="7" express="true">
+		<Note>fragile</Note>
+		<Item sku="A-1" qty="2">Widget</Item>
+		<Item sku="B-2" qty="1">Gadget</Item>
+	</Order>
+	@endverbatim
+	A value is a number, bool or enum, read and written with
+	TiXmlBase::ReadValue() and WriteValue(); a std::string; or a struct
+	that has a TiXmlBind of its own. Attributes and TiXmlBindText take
+	values only; TiXmlBindElement and TiXmlBindSequence take either, a
+	sequence in any container with emplace_back().
+
+	The description is all compile time: loading and saving are inlined
+	code for the one struct, with no tables or virtual calls.
+*/
+template< typename T > struct TiXmlBind {};
+
+template< typename T, typename M > struct TiXmlBindAttributeMember	{ const char* name; M T::* member; };
+template< typename T, typename M > struct TiXmlBindElementMember	{ const char* name; M T::* member; };
+template< typename T, typename C > struct TiXmlBindSequenceMember	{ const char* name; C T::* member; };
+template< typename T, typename M > struct TiXmlBindTextMember		{ M T::* member; };
+
+/// An attribute of the struct's element. See TiXmlBind.
+template< typename T, typename M > constexpr TiXmlBindAttributeMember< T, M > TiXmlBindAttribute( const char* name, M T::* member )	{ return { name, member }; }
+/// A child element, once. See TiXmlBind.
+template< typename T, typename M > constexpr TiXmlBindElementMember< T, M > TiXmlBindElement( const char* name, M T::* member )		{ return { name, member }; }
+/// A child element, any number of times. See TiXmlBind.
+template< typename T, typename C > constexpr TiXmlBindSequenceMember< T, C > TiXmlBindSequence( const char* name, C T::* member )	{ return { name, member }; }
+/// The text of the struct's element. See TiXmlBind.
+template< typename T, typename M > constexpr TiXmlBindTextMember< T, M > TiXmlBindText( M T::* member )								{ return { member }; }
+
+/// Whether a TiXmlBind describes T.
+template< typename T, typename = void > struct TiXmlIsBound : std::false_type {};
+template< typename T > struct TiXmlIsBound< T, std::void_t< decltype( TiXmlBind< T >::members ) > > : std::true_type {};
+
+
+/// What TiXmlBinder does with elements, and text, that no member takes.
+enum TiXmlBindUnknown
+{
+	TIXML_BIND_SKIP,		///< Pass over them.
+	TIXML_BIND_REJECT		///< Fail the load.
+};
+
+
+/** Loads and saves the structs TiXmlBind describes. A loader reads an
+	element of a document, or straight from a TiXmlPullParser with no
+	document at all; the saver writes through a TiXmlStreamWriter, so with
+	the printer's escaping and layout.
+	@verbatim
+	TiXmlPullParser parser( &in );
+	parser.Next();							// the <Orders> root
+	TiXmlBinder binder;
+	Order order;
+	while ( binder.Load( &parser, &order ) )	// each <Order> in it
+		Process( order );
+	if ( binder.Error() )
+		...binder.ErrorDesc()
+	@endverbatim
+	Members that are not in the input keep the values they had, except
+	that sequences and string text are emptied first. Attributes that no
+	member takes are passed over; elements and text are too, unless
+	SetUnknown( TIXML_BIND_REJECT ). The binder keeps some scratch space,
+	so reuse one for many loads.
+*/
+class TiXmlBinder
+{
+public:
+	TiXmlBinder() : unknown( TIXML_BIND_SKIP )		{}
+
+	void SetUnknown( TiXmlBindUnknown _unknown )	{ unknown = _unknown; }
+
+	/// Load 'object' from 'element', whatever its name.
+	template< typename T > bool Load( const TiXmlElement* element, T* object )
+	{
+		errorDesc.clear();
+		return LoadObject( element, object );
+	}
+
+	/** Load 'object' from the next element the parser comes to, and leave
+		the parser at its end. False if an end tag or the end of the input
+		comes first, or if the parser or the load fails.
+	*/
+	template< typename T > bool Load( TiXmlPullParser* parser, T* object )
+	{
+		errorDesc.clear();
+		for( ;; )
+		{
+			TiXmlPullParser::Event event = parser->Next();
+			if ( event == TiXmlPullParser::PULL_START_ELEMENT )
+				return LoadObject( parser, object );
+			if ( event == TiXmlPullParser::PULL_ERROR )
+				return Fail( parser->ErrorDesc(), "" );
+			if ( event == TiXmlPullParser::PULL_END_ELEMENT || event == TiXmlPullParser::PULL_END )
+				return false;
+		}
+	}
+
+	/// Write 'object' as an element called 'name'.
+	template< typename T > bool Save( TiXmlStreamWriter* writer, const std::string& name, const T& object )
+	{
+		SaveValue( writer, name, object );
+		return writer->Good();
+	}
+
+	/// Whether the last load failed for another reason than running out of input.
+	bool Error() const								{ return !errorDesc.empty(); }
+	/// What went wrong, and where.
+	const char* ErrorDesc() const					{ return errorDesc.c_str(); }
+
+private:
+	template< typename T, typename F > static bool ForEach( F f )
+	{
+		return std::apply( [&]( const auto&... member ) { return ( f( member ) && ... ); }, TiXmlBind< T >::members );
+	}
+	// Whether some member takes it.
+	template< typename T, typename F > static bool Any( F f )
+	{
+		return std::apply( [&]( const auto&... member ) { return ( f( member ) || ... ); }, TiXmlBind< T >::members );
+	}
+
+	bool Fail( const std::string& what, const std::string& where )
+	{
+		if ( errorDesc.empty() )
+			errorDesc = where.empty() ? what : what + " at " + where;
+		return false;
+	}
+
+	// Sequences and string text collect, so empty them before a load.
+	template< typename T > static void Clear( T* object )
+	{
+		ForEach< T >( [&]( const auto& m ) {
+			using Member = std::decay_t< decltype( m ) >;
+			if constexpr ( IsSequence< Member >::value )
+				( object->*m.member ).clear();
+			else if constexpr ( IsText< Member >::value )
+			{
+				if constexpr ( std::is_same_v< std::decay_t< decltype( object->*m.member ) >, std::string > )
+					( object->*m.member ).clear();
+			}
+			return true;
+		} );
+	}
+
+	template< typename X > struct IsAttribute : std::false_type {};
+	template< typename T, typename M > struct IsAttribute< TiXmlBindAttributeMember< T, M > > : std::true_type {};
+	template< typename X > struct IsElement : std::false_type {};
+	template< typename T, typename M > struct IsElement< TiXmlBindElementMember< T, M > > : std::true_type {};
+	template< typename X > struct IsSequence : std::false_type {};
+	template< typename T, typename C > struct IsSequence< TiXmlBindSequenceMember< T, C > > : std::true_type {};
+	template< typename X > struct IsText : std::false_type {};
+	template< typename T, typename M > struct IsText< TiXmlBindTextMember< T, M > > : std::true_type {};
+
+	// Attributes, then the child elements that a member names, then text.
+	template< typename T, typename Source > bool LoadAttributes( const Source& source, T* object )
+	{
+		return ForEach< T >( [&]( const auto& m ) {
+			if constexpr ( IsAttribute< std::decay_t< decltype( m ) > >::value )
+			{
+				if ( source->QueryValueAttribute( m.name, &( object->*m.member ) ) == TIXML_WRONG_TYPE )
+					return Fail( "Attribute has the wrong type", m.name );
+			}
+			return true;
+		} );
+	}
+
+	// True, or false with the error set, once a member takes the child;
+	// 'taken' says whether one did.
+	template< typename T, typename Source > bool LoadChild( const Source& child, const std::string& name, T* object, bool* taken )
+	{
+		*taken = false;
+		bool ok = true;
+		Any< T >( [&]( const auto& m ) {
+			using Member = std::decay_t< decltype( m ) >;
+			if constexpr ( IsElement< Member >::value )
+			{
+				if ( name != m.name )
+					return false;
+				ok = LoadValue( child, &( object->*m.member ) );
+				return *taken = true;
+			}
+			else if constexpr ( IsSequence< Member >::value )
+			{
+				if ( name != m.name )
+					return false;
+				auto& sequence = object->*m.member;
+				sequence.emplace_back();
+				ok = LoadValue( child, &sequence.back() );
+				return *taken = true;
+			}
+			else
+				return false;
+		} );
+		return ok;
+	}
+
+	template< typename T > bool LoadText( const std::string& text, T* object, bool* taken )
+	{
+		*taken = false;
+		bool ok = true;
+		Any< T >( [&]( const auto& m ) {
+			if constexpr ( IsText< std::decay_t< decltype( m ) > >::value )
+			{
+				auto& target = object->*m.member;
+				if constexpr ( std::is_same_v< std::decay_t< decltype( target ) >, std::string > )
+					target += text;
+				else if ( TiXmlBase::ReadValue( text, &target ) != TIXML_SUCCESS )
+					ok = Fail( "Text has the wrong type", text );
+				return *taken = true;
+			}
+			else
+				return false;
+		} );
+		return ok;
+	}
+
+	template< typename T > bool LoadObject( const TiXmlElement* element, T* object )
+	{
+		static_assert( TiXmlIsBound< T >::value, "TiXmlBinder loads structs that have a TiXmlBind" );
+		Clear( object );
+		if ( !LoadAttributes( element, object ) )
+			return false;
+
+		for( const TiXmlNode* node = element->FirstChild(); node; node = node->NextSibling() )
+		{
+			bool taken = false;
+			bool ok = true;
+			if ( node->Type() == TiXmlNode::TINYXML_ELEMENT )
+				ok = LoadChild( node->ToElement(), node->ValueStr(), object, &taken );
+			else if ( node->Type() == TiXmlNode::TINYXML_TEXT )
+				ok = LoadText( node->ValueStr(), object, &taken );
+			else
+				taken = true;
+
+			if ( !ok )
+				return false;
+			if ( !taken && unknown == TIXML_BIND_REJECT )
+				return Fail( "Unknown element or text", node->ValueStr() );
+		}
+		return true;
+	}
+
+	template< typename M > bool LoadValue( const TiXmlElement* element, M* value )
+	{
+		if constexpr ( TiXmlIsBound< M >::value )
+			return LoadObject( element, value );
+		else
+		{
+			// All the text children, as the pull parser reads them.
+			std::string* str = &scratch;
+			if constexpr ( std::is_same_v< M, std::string > )
+				str = value;
+			str->clear();
+			for( const TiXmlNode* node = element->FirstChild(); node; node = node->NextSibling() )
+			{
+				if ( node->Type() == TiXmlNode::TINYXML_TEXT )
+					*str += node->ValueStr();
+				else if ( node->Type() == TiXmlNode::TINYXML_ELEMENT && unknown == TIXML_BIND_REJECT )
+					return Fail( "Unknown element or text", node->ValueStr() );
+			}
+			if constexpr ( !std::is_same_v< M, std::string > )
+			{
+				if ( TiXmlBase::ReadValue( *str, value ) != TIXML_SUCCESS )
+					return Fail( "Element has the wrong type", element->ValueStr() );
+			}
+			return true;
+		}
+	}
+
+	template< typename T > bool LoadObject( TiXmlPullParser* parser, T* object )
+	{
+		static_assert( TiXmlIsBound< T >::value, "TiXmlBinder loads structs that have a TiXmlBind" );
+		Clear( object );
+		if ( !LoadAttributes( parser, object ) )
+			return false;
+
+		for( ;; )
+		{
+			bool taken = true;
+			bool ok = true;
+			switch ( parser->Next() )
+			{
+				case TiXmlPullParser::PULL_END_ELEMENT:
+					return true;
+				case TiXmlPullParser::PULL_START_ELEMENT:
+					ok = LoadChild( parser, parser->Name(), object, &taken );
+					if ( ok && !taken && unknown == TIXML_BIND_SKIP && !parser->SkipElement() )
+						return Fail( parser->ErrorDesc(), "" );
+					break;
+				case TiXmlPullParser::PULL_TEXT:
+					ok = LoadText( parser->Value(), object, &taken );
+					break;
+				case TiXmlPullParser::PULL_ERROR:
+				case TiXmlPullParser::PULL_END:
+					return Fail( parser->ErrorDesc(), "" );
+				default:
+					break;
+			}
+			if ( !ok )
+				return false;
+			if ( !taken && unknown == TIXML_BIND_REJECT )
+				return Fail( "Unknown element or text", parser->Current() == TiXmlPullParser::PULL_TEXT ? parser->Value() : parser->Name() );
+		}
+	}
+
+	// A value's element is at its start; leave it at its end.
+	template< typename M > bool LoadValue( TiXmlPullParser* parser, M* value )
+	{
+		if constexpr ( TiXmlIsBound< M >::value )
+			return LoadObject( parser, value );
+		else
+		{
+			// A string collects the text in place.
+			std::string* str = &scratch;
+			if constexpr ( std::is_same_v< M, std::string > )
+				str = value;
+			str->clear();
+			for( ;; )
+			{
+				TiXmlPullParser::Event event = parser->Next();
+				if ( event == TiXmlPullParser::PULL_END_ELEMENT )
+					break;
+				if ( event == TiXmlPullParser::PULL_TEXT )
+					*str += parser->Value();
+				else if ( event == TiXmlPullParser::PULL_START_ELEMENT )
+				{
+					if ( unknown == TIXML_BIND_REJECT )
+						return Fail( "Unknown element or text", parser->Name() );
+					if ( !parser->SkipElement() )
+						return Fail( parser->ErrorDesc(), "" );
+				}
+				else if ( event == TiXmlPullParser::PULL_ERROR || event == TiXmlPullParser::PULL_END )
+					return Fail( parser->ErrorDesc(), "" );
+			}
+			if constexpr ( !std::is_same_v< M, std::string > )
+			{
+				if ( TiXmlBase::ReadValue( *str, value ) != TIXML_SUCCESS )
+					return Fail( "Element has the wrong type", parser->Name() );
+			}
+			return true;
+		}
+	}
+
+	template< typename M > const std::string& WriteScalar( const M& value )
+	{
+		if constexpr ( std::is_same_v< M, std::string > )
+			return value;
+		else
+		{
+			scratch.clear();
+			TiXmlBase::WriteValue( value, &scratch );
+			return scratch;
+		}
+	}
+
+	template< typename M > void SaveValue( TiXmlStreamWriter* writer, const std::string& name, const M& value )
+	{
+		writer->OpenElement( name );
+		if constexpr ( TiXmlIsBound< M >::value )
+		{
+			ForEach< M >( [&]( const auto& m ) {
+				if constexpr ( IsAttribute< std::decay_t< decltype( m ) > >::value )
+					writer->PushAttribute( m.name, WriteScalar( value.*m.member ) );
+				return true;
+			} );
+			ForEach< M >( [&]( const auto& m ) {
+				using Member = std::decay_t< decltype( m ) >;
+				if constexpr ( IsElement< Member >::value )
+					SaveValue( writer, m.name, value.*m.member );
+				else if constexpr ( IsSequence< Member >::value )
+				{
+					for( const auto& item : value.*m.member )
+						SaveValue( writer, m.name, item );
+				}
+				else if constexpr ( IsText< Member >::value )
+				{
+					const std::string& text = WriteScalar( value.*m.member );
+					if ( !text.empty() )
+						writer->PushText( text );
+				}
+				return true;
+			} );
+		}
+		else
+		{
+			const std::string& text = WriteScalar( value );
+			if ( !text.empty() )
+				writer->PushText( text );
+		}
+		writer->CloseElement();
+	}
+
+	TiXmlBindUnknown unknown;
+	std::string scratch;
+	std::string errorDesc;
+};
+
+
+/** A read-only position in a TiXmlFrozenDocument. It is a node and a handle
+	at once: like TiXmlHandle, every navigation method can be called on a
+	handle that doesn't point at anything, and returns another such handle,
+	so chains need no null checks:
+	@verbatim
+	TiXmlFrozenDocument frozen = doc.Freeze();
+	const char* id = frozen.Handle().FirstChild( "Document" ).FirstChildElement( "Element" ).Attribute( "id" );
+	@endverbatim
+	A handle is two words and is meant to be passed by value. It stays
+	valid as long as its document.
+*/
+class TiXmlFrozenHandle
+{
+public:
+	/// A handle that points at nothing.
+	TiXmlFrozenHandle() : doc( 0 ), index( 0 )		{}
+	TiXmlFrozenHandle( const TiXmlFrozenDocument* _doc, unsigned _index ) : doc( _doc ), index( _index )	{}
+
+	/// True if the handle points at a node.
+	bool Valid() const							{ return doc != 0; }
+	explicit operator bool() const				{ return doc != 0; }
+	bool operator==( const TiXmlFrozenHandle& other ) const	{ return doc == other.doc && ( !doc || index == other.index ); }
+	bool operator!=( const TiXmlFrozenHandle& other ) const	{ return !( *this == other ); }
+
+	/// Position of the node in the document's preorder array.
+	unsigned Index() const						{ return index; }
+	/// One of TiXmlNode::NodeType, or TINYXML_TYPECOUNT for a null handle.
+	int Type() const;
+	bool IsElement() const						{ return Type() == TiXmlNode::TINYXML_ELEMENT; }
+	bool IsText() const							{ return Type() == TiXmlNode::TINYXML_TEXT; }
+	/// The value, as TiXmlNode::Value(). Empty for a null handle.
+	const char* Value() const;
+	/// Length of Value(), without the terminating null.
+	size_t ValueLength() const;
+	/// For a text node, whether it was CDATA.
+	bool CDATA() const;
+
+	/// Number of nodes in the subtree starting here, this one included.
+	unsigned SubtreeSize() const;
+
+	TiXmlFrozenHandle Parent() const;
+	TiXmlFrozenHandle FirstChild() const;
+	TiXmlFrozenHandle FirstChild( const char* value ) const;
+	TiXmlFrozenHandle FirstChildElement() const;
+	TiXmlFrozenHandle FirstChildElement( const char* value ) const;
+	TiXmlFrozenHandle NextSibling() const;
+	TiXmlFrozenHandle NextSibling( const char* value ) const;
+	TiXmlFrozenHandle NextSiblingElement() const;
+	TiXmlFrozenHandle NextSiblingElement( const char* value ) const;
+	/// The "index" child, counting from 0. See TiXmlHandle::Child().
+	TiXmlFrozenHandle Child( int index ) const;
+	TiXmlFrozenHandle Child( const char* value, int index ) const;
+	/// The "index" child element, counting from 0. See TiXmlHandle::ChildElement().
+	TiXmlFrozenHandle ChildElement( int index ) const;
+	TiXmlFrozenHandle ChildElement( const char* value, int index ) const;
+
+	/// Number of attributes. Declarations present version, encoding and standalone as attributes.
+	int AttributeCount() const;
+	const char* AttributeName( int i ) const;		///< Name of the i'th attribute, in document order.
+	const char* AttributeValue( int i ) const;		///< Value of the i'th attribute, in document order.
+	/// The value of the named attribute, or null if there is none.
+	const char* Attribute( const char* name ) const;
+	/// See TiXmlElement::QueryIntAttribute().
+	int QueryIntAttribute( const char* name, int* _value ) const;
+	/// See TiXmlElement::QueryDoubleAttribute().
+	int QueryDoubleAttribute( const char* name, double* _value ) const;
+
+	/// The text of the first child, if that is a text node, else null. See TiXmlElement::GetText().
+	const char* GetText() const;
+
+private:
+	const TiXmlFrozenDocument* doc;
+	unsigned index;
+};
+
+
+/** The frozen counterpart of TiXmlVisitor. The document and elements are
+	entered and exited, the other node types are visited; return values
+	have the same meaning as for TiXmlVisitor.
+*/
+class TiXmlFrozenVisitor
+{
+public:
+	virtual ~TiXmlFrozenVisitor() {}
+
+	/// Visit the document.
+	virtual bool VisitDocumentEnter( TiXmlFrozenHandle /*doc*/ )	{ return true; }
+	/// Visit the document.
+	virtual bool VisitDocumentExit( TiXmlFrozenHandle /*doc*/ )		{ return true; }
+	/// Visit an element.
+	virtual bool VisitEnter( TiXmlFrozenHandle /*element*/ )		{ return true; }
+	/// Visit an element.
+	virtual bool VisitExit( TiXmlFrozenHandle /*element*/ )			{ return true; }
+	/// Visit a declaration, text, comment or unknown node. Check Type().
+	virtual bool Visit( TiXmlFrozenHandle /*node*/ )				{ return true; }
+};
+
+
+/** A read-only copy of a TiXmlDocument, made by TiXmlDocument::Freeze(),
+	laid out for reading.
+
+	The nodes are records in one array, in document order (preorder). The
+	children of a node follow it directly, so a full traversal is a walk
+	through memory rather than a chase of pointers. Each record holds the
+	index of its parent and the end of its subtree; the next sibling of a
+	node starts where its subtree ends. Attributes are runs in a second
+	array, and every string lives in one pool, element and attribute names
+	stored once however often they repeat. All references are indexes or
+	offsets, never pointers.
+
+	Navigate with TiXmlFrozenHandle, from Handle() or RootElement(), or walk
+	it all with Accept().
+
+	Since nothing in the arrays depends on where they live, they can be
+	written to disk as they are with SaveBinary() and mapped back with
+	LoadBinary(): no parsing, no allocation per node, and processes that map
+	the same image share one copy in the page cache. Load() does the usual
+	dance: use the image if it is good and up to date, otherwise parse the
+	XML and write a new image for next time.
+	@verbatim
+	TiXmlFrozenDocument reference;
+	if ( !reference.Load( "reference.xml.bin", "reference.xml" ) )
+		// the XML itself could not be loaded
+	@endverbatim
+*/
+class TiXmlFrozenDocument
+{
+public:
+	/// One node. 'value' is an offset into the string pool.
+	struct Node
+	{
+		unsigned short	type;				// TiXmlNode::NodeType
+		unsigned short	flags;				// CDATA_FLAG
+		unsigned		value;
+		unsigned		valueLength;
+		unsigned		parent;				// NONE for the document
+		unsigned		end;				// one past the last node of the subtree
+		unsigned		firstAttribute;
+		unsigned		attributeCount;
+	};
+	/// One attribute: offsets of its name and value in the string pool.
+	struct Attribute
+	{
+		unsigned		name;
+		unsigned		value;
+	};
+	enum
+	{
+		NONE = 0xffffffffu,
+		CDATA_FLAG = 1
+	};
+
+	/// An empty frozen document: Handle() is a null handle.
+	TiXmlFrozenDocument();
+	/// Freezes 'document'. Same as document.Freeze().
+	explicit TiXmlFrozenDocument( const TiXmlDocument& document );
+
+	TiXmlFrozenDocument( TiXmlFrozenDocument&& other );
+	TiXmlFrozenDocument& operator=( TiXmlFrozenDocument&& other );
+	~TiXmlFrozenDocument();
+
+	/** Write the document as a binary image. If 'sourcePath' is given, the
+		size and modification time of that file are recorded, and LoadBinary()
+		will refuse the image once the file changes. The image is written
+		to a temporary file and renamed into place, so readers never see
+		half of one. Returns true if successful.
+	*/
+	bool SaveBinary( const std::string& path, const std::string& sourcePath = std::string() ) const;
+
+	/** Map an image written by SaveBinary(). The image is checked - format
+		version, layout, checksum and, if 'sourcePath' is given, that the
+		source is the one it was made from - before it replaces the contents
+		of this document. Returns false, and leaves the document as it was,
+		if the image is missing, damaged or stale.
+	*/
+	bool LoadBinary( const std::string& path, const std::string& sourcePath = std::string() );
+
+	/** Load the image at 'binaryPath' if it is good and was made from
+		'xmlPath'; otherwise parse 'xmlPath', freeze it, and try to write a
+		new image. Returns false only if the XML could not be loaded.
+	*/
+	bool Load( const std::string& binaryPath, const std::string& xmlPath );
+
+	/// True if the arrays are read from a mapped image.
+	bool Mapped() const						{ return mapping != 0; }
+
+	/// A handle to the document node: the start of every navigation.
+	TiXmlFrozenHandle Handle() const		{ return nodeCount ? TiXmlFrozenHandle( this, 0 ) : TiXmlFrozenHandle(); }
+	/// The first top level element. See TiXmlDocument::RootElement().
+	TiXmlFrozenHandle RootElement() const	{ return Handle().FirstChildElement(); }
+
+	/// Walk the document, in order, calling back the visitor.
+	bool Accept( TiXmlFrozenVisitor* visitor ) const;
+
+	unsigned NodeCount() const				{ return nodeCount; }
+	unsigned AttributeCount() const			{ return attributeCount; }
+	unsigned StringPoolSize() const			{ return stringSize; }
+	/// Bytes used by the node, attribute and string arrays.
+	size_t MemoryUsed() const;
+
+	// Raw access to the arrays, as used by TiXmlFrozenHandle.
+	const Node& NodeAt( unsigned i ) const					{ assert( i < nodeCount ); return nodes[i]; }
+	const Attribute& AttributeAt( unsigned i ) const		{ assert( i < attributeCount ); return attributes[i]; }
+	const char* String( unsigned offset ) const				{ assert( offset < stringSize ); return strings + offset; }
+
+private:
+	TiXmlFrozenDocument( const TiXmlFrozenDocument& )=delete;
+	void operator=( const TiXmlFrozenDocument& )=delete;
+
+	bool AcceptNode( unsigned i, TiXmlFrozenVisitor* visitor ) const;
+	void Adopt( TiXmlFrozenDocument& other );	// move implementation
+	void Release();								// unmap and free
+	bool WriteBinary( const std::string& path, long long sourceSize, long long sourceTime ) const;
+
+	// The arrays. They point into the owned vectors below, or into the mapping.
+	const Node*			nodes;
+	unsigned			nodeCount;
+	const Attribute*	attributes;
+	unsigned			attributeCount;
+	const char*			strings;
+	unsigned			stringSize;
+
+	std::vector<Node>		ownedNodes;
+	std::vector<Attribute>	ownedAttributes;
+	std::vector<char>		ownedStrings;
+
+	void*	mapping;
+	size_t	mappingSize;
+};
+
+
+/** Writes a document in a compact binary form, for sending between
+	programs that both use TinyXML. Read it back with TiXmlCompactDecoder,
+	which rebuilds the same DOM.
+
+	The format follows the built-in grammar of W3C EXI, without a schema
+	and with every event byte aligned. Each node is an event code: start
+	and end of element, text, CDATA, comment, declaration, unknown.
+	Names are sent in full the first time and as an index into a string
+	table after that; an element whose name has been seen is a single
+	byte, event code and name together. Short attribute values and text
+	go into a second table, so repeated values cost an index too. Numbers
+	are unsigned 7 bit groups, low group first.
+
+	Use it like TiXmlPrinter:
+	@verbatim
+	TiXmlCompactEncoder encoder;
+	doc.Accept( &encoder );
+	send( encoder.Str() );
+	@endverbatim
+	An encoder keeps its tables and its buffer from one document to the
+	next, so reuse one: once they have grown, encoding doesn't allocate.
+*/
+class TiXmlCompactEncoder : public TiXmlVisitor
+{
+public:
+	TiXmlCompactEncoder() {}
+
+	virtual bool VisitEnter( const TiXmlDocument& doc );
+
+	virtual bool VisitEnter( const TiXmlElement& element, const TiXmlAttribute* firstAttribute );
+	virtual bool VisitExit( const TiXmlElement& element );
+
+	virtual bool Visit( const TiXmlDeclaration& declaration );
+	virtual bool Visit( const TiXmlText& text );
+	virtual bool Visit( const TiXmlComment& comment );
+	virtual bool Visit( const TiXmlUnknown& unknown );
+
+	/// Return the length of the result.
+	size_t Size()									{ return buffer.size(); }
+	/// Return the result. It is binary: it may hold any byte, 0 included.
+	const std::string& Str()						{ return buffer; }
+
+private:
+	void Begin();
+	void WriteNumber( unsigned n );
+	void WriteLiteral( const std::string& s );
+	void WriteName( const std::string& name );
+	void WriteValue( const std::string& value );
+
+	// The strings sent so far, and their indexes. Clear() starts a new
+	// generation, so the slots and the strings keep their storage from
+	// one document to the next.
+	struct Table
+	{
+		enum { NOT_FOUND = ~0u };
+		struct Slot
+		{
+			unsigned generation;
+			unsigned index;
+		};
+
+		Table() : count( 0 ), generation( 1 )	{}
+		unsigned Size() const				{ return count; }
+		void Clear();
+		// The index of 's', or NOT_FOUND and the slot to Add() it in.
+		unsigned Find( const std::string& s, size_t* slot ) const;
+		void Add( const std::string& s, size_t slot );
+
+	private:
+		void Grow();
+
+		std::vector< std::string > strings;	// by index; the first 'count' are in use
+		std::vector< Slot > slots;			// open addressing, a power of two long
+		unsigned count;
+		unsigned generation;
+	};
+
+	std::string buffer;
+	Table names;
+	Table values;
+};
+
+
+/** Rebuilds a document from the output of TiXmlCompactEncoder. The
+	decoder keeps its string tables between calls, and decodes into a
+	document that has been Reset(), so decoding a stream of messages of
+	much the same shape settles down to no allocation at all.
+*/
+class TiXmlCompactDecoder
+{
+public:
+	TiXmlCompactDecoder() : nameCount( 0 ), valueCount( 0 ) {}
+
+	/** Replace the contents of 'document' with the decoded data. Returns
+		false, with the document's error set, if the data is not a valid
+		encoding.
+	*/
+	bool Decode( const char* data, size_t size, TiXmlDocument* document );
+	bool Decode( const std::string& data, TiXmlDocument* document )	{ return Decode( data.data(), data.size(), document ); }
+
+private:
+	bool ReadNumber( unsigned* n );
+	bool ReadLiteral( std::string* s );
+	bool ReadName( unsigned* index );
+	bool ReadNewName( unsigned* index );
+	bool ReadValue( const std::string** s );
+	bool AddString( std::vector<std::string>* table, unsigned* count, const char* s, size_t length );
+
+	const char* p;
+	const char* end;
+
+	// The tables only grow; nameCount and valueCount say how much is in use.
+	std::vector<std::string> names;
+	unsigned nameCount;
+	std::vector<std::string> values;
+	unsigned valueCount;
+	std::string scratch;
 };
 
 
@@ -0,0 +1,472 @@
+/*
+www.sourceforge.net/projects/tinyxml
+Original code by Lee Thomason (www.grinninglizard.com)
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must
+not claim that you wrote the original software. If you use this
+software in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#include "tinyxml.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace {
+
+// The stream starts with these three bytes and a version byte.
+const char COMPACT_MAGIC[3] = { 'T', 'X', 'C' };
+const char COMPACT_VERSION = 1;
+
+// Event codes. An element whose name is one of the first SHORT_NAMES in
+// the table is written as EVENT_START_SHORT + index, one byte in all.
+enum
+{
+	EVENT_END_ELEMENT,
+	EVENT_START_NEW,			// literal name follows
+	EVENT_START_INDEXED,		// name table index follows
+	EVENT_TEXT,
+	EVENT_CDATA,
+	EVENT_COMMENT,
+	EVENT_DECLARATION,			// version, encoding, standalone
+	EVENT_UNKNOWN,
+	EVENT_START_SHORT
+};
+const unsigned SHORT_NAMES = 256 - EVENT_START_SHORT;
+
+// Values longer than this, or arriving once the table is full, are
+// always sent in full. Both sides must agree on these.
+const size_t VALUE_MAX_LENGTH = 64;
+const unsigned VALUE_CAPACITY = 1 << 16;
+
+} // namespace
+
+
+void TiXmlCompactEncoder::Table::Clear()
+{
+	count = 0;
+	if ( ++generation == 0 )
+	{
+		// Wrapped: no stamp left in the slots can be trusted.
+		std::fill( slots.begin(), slots.end(), Slot{ 0, 0 } );
+		generation = 1;
+	}
+}
+
+
+unsigned TiXmlCompactEncoder::Table::Find( const std::string& s, size_t* slot ) const
+{
+	*slot = 0;
+	if ( slots.empty() )
+		return NOT_FOUND;
+	const size_t mask = slots.size() - 1;
+	size_t i = std::hash< std::string >()( s ) & mask;
+	while ( slots[i].generation == generation )
+	{
+		if ( strings[ slots[i].index ] == s )
+			return slots[i].index;
+		i = ( i + 1 ) & mask;
+	}
+	*slot = i;
+	return NOT_FOUND;
+}
+
+
+void TiXmlCompactEncoder::Table::Add( const std::string& s, size_t slot )
+{
+	if ( ( count + 1 ) * 2 > slots.size() )
+	{
+		Grow();
+		Find( s, &slot );
+	}
+	if ( count == strings.size() )
+		strings.emplace_back();
+	strings[ count ].assign( s );
+	slots[ slot ] = Slot{ generation, count };
+	++count;
+}
+
+
+void TiXmlCompactEncoder::Table::Grow()
+{
+	slots.assign( std::max( slots.size() * 2, (size_t) 64 ), Slot{ 0, 0 } );
+	const size_t mask = slots.size() - 1;
+	for( unsigned index = 0; index < count; ++index )
+	{
+		size_t i = std::hash< std::string >()( strings[ index ] ) & mask;
+		while ( slots[i].generation == generation )
+			i = ( i + 1 ) & mask;
+		slots[i] = Slot{ generation, index };
+	}
+}
+
+
+void TiXmlCompactEncoder::Begin()
+{
+	if ( !buffer.empty() )
+		return;
+	names.Clear();
+	values.Clear();
+	buffer.append( COMPACT_MAGIC, sizeof( COMPACT_MAGIC ) );
+	buffer += COMPACT_VERSION;
+}
+
+
+void TiXmlCompactEncoder::WriteNumber( unsigned n )
+{
+	while ( n >= 0x80 )
+	{
+		buffer += (char) ( ( n & 0x7f ) | 0x80 );
+		n >>= 7;
+	}
+	buffer += (char) n;
+}
+
+
+void TiXmlCompactEncoder::WriteLiteral( const std::string& s )
+{
+	WriteNumber( (unsigned) s.size() );
+	buffer += s;
+}
+
+
+// 0 and the literal for a new name, index + 1 for a known one.
+void TiXmlCompactEncoder::WriteName( const std::string& name )
+{
+	size_t slot;
+	const unsigned index = names.Find( name, &slot );
+	if ( index != Table::NOT_FOUND )
+	{
+		WriteNumber( index + 1 );
+		return;
+	}
+	WriteNumber( 0 );
+	WriteLiteral( name );
+	names.Add( name, slot );
+}
+
+
+// 0 and the index for a value in the table, length + 1 and the bytes
+// for any other.
+void TiXmlCompactEncoder::WriteValue( const std::string& value )
+{
+	size_t slot;
+	const unsigned index = values.Find( value, &slot );
+	if ( index != Table::NOT_FOUND )
+	{
+		WriteNumber( 0 );
+		WriteNumber( index );
+		return;
+	}
+	WriteNumber( (unsigned) value.size() + 1 );
+	buffer += value;
+	if ( !value.empty() && value.size() <= VALUE_MAX_LENGTH && values.Size() < VALUE_CAPACITY )
+		values.Add( value, slot );
+}
+
+
+bool TiXmlCompactEncoder::VisitEnter( const TiXmlDocument& )
+{
+	buffer.clear();
+	Begin();
+	return true;
+}
+
+
+bool TiXmlCompactEncoder::VisitEnter( const TiXmlElement& element, const TiXmlAttribute* firstAttribute )
+{
+	Begin();
+
+	const std::string& name = element.ValueStr();
+	size_t slot;
+	const unsigned index = names.Find( name, &slot );
+	if ( index == Table::NOT_FOUND )
+	{
+		buffer += (char) EVENT_START_NEW;
+		WriteLiteral( name );
+		names.Add( name, slot );
+	}
+	else if ( index < SHORT_NAMES )
+	{
+		buffer += (char) ( EVENT_START_SHORT + index );
+	}
+	else
+	{
+		buffer += (char) EVENT_START_INDEXED;
+		WriteNumber( index );
+	}
+
+	unsigned count = 0;
+	for( const TiXmlAttribute* attrib = firstAttribute; attrib; attrib = attrib->Next() )
+		++count;
+	WriteNumber( count );
+	for( const TiXmlAttribute* attrib = firstAttribute; attrib; attrib = attrib->Next() )
+	{
+		WriteName( attrib->NameTStr() );
+		WriteValue( attrib->ValueStr() );
+	}
+	return true;
+}
+
+
+bool TiXmlCompactEncoder::VisitExit( const TiXmlElement& )
+{
+	buffer += (char) EVENT_END_ELEMENT;
+	return true;
+}
+
+
+bool TiXmlCompactEncoder::Visit( const TiXmlDeclaration& declaration )
+{
+	Begin();
+	buffer += (char) EVENT_DECLARATION;
+	WriteLiteral( declaration.Version() );
+	WriteLiteral( declaration.Encoding() );
+	WriteLiteral( declaration.Standalone() );
+	return true;
+}
+
+
+bool TiXmlCompactEncoder::Visit( const TiXmlText& text )
+{
+	Begin();
+	buffer += (char) ( text.CDATA() ? EVENT_CDATA : EVENT_TEXT );
+	WriteValue( text.ValueStr() );
+	return true;
+}
+
+
+bool TiXmlCompactEncoder::Visit( const TiXmlComment& comment )
+{
+	Begin();
+	buffer += (char) EVENT_COMMENT;
+	WriteLiteral( comment.ValueStr() );
+	return true;
+}
+
+
+bool TiXmlCompactEncoder::Visit( const TiXmlUnknown& unknown )
+{
+	Begin();
+	buffer += (char) EVENT_UNKNOWN;
+	WriteLiteral( unknown.ValueStr() );
+	return true;
+}
+
+
+bool TiXmlCompactDecoder::ReadNumber( unsigned* n )
+{
+	unsigned result = 0;
+	for( int shift = 0; p < end; shift += 7 )
+	{
+		unsigned char byte = (unsigned char) *p++;
+		if ( shift == 28 && byte > 0x0f )
+			return false;		// more than 32 bits
+		result |= (unsigned) ( byte & 0x7f ) << shift;
+		if ( !( byte & 0x80 ) )
+		{
+			*n = result;
+			return true;
+		}
+		if ( shift == 28 )
+			return false;
+	}
+	return false;
+}
+
+
+bool TiXmlCompactDecoder::ReadLiteral( std::string* s )
+{
+	unsigned length;
+	if ( !ReadNumber( &length ) || length > (size_t) ( end - p ) )
+		return false;
+	s->assign( p, length );
+	p += length;
+	return true;
+}
+
+
+bool TiXmlCompactDecoder::AddString( std::vector<std::string>* table, unsigned* count, const char* s, size_t length )
+{
+	// Reuse the strings of earlier messages, and their capacity.
+	if ( *count < table->size() )
+		(*table)[ *count ].assign( s, length );
+	else
+		table->push_back( std::string( s, length ) );
+	++*count;
+	return true;
+}
+
+
+bool TiXmlCompactDecoder::ReadNewName( unsigned* index )
+{
+	unsigned length;
+	if ( !ReadNumber( &length ) || length > (size_t) ( end - p ) )
+		return false;
+	AddString( &names, &nameCount, p, length );
+	p += length;
+	*index = nameCount - 1;
+	return true;
+}
+
+
+bool TiXmlCompactDecoder::ReadName( unsigned* index )
+{
+	unsigned n;
+	if ( !ReadNumber( &n ) )
+		return false;
+	if ( n == 0 )
+		return ReadNewName( index );
+	if ( n - 1 >= nameCount )
+		return false;
+	*index = n - 1;
+	return true;
+}
+
+
+bool TiXmlCompactDecoder::ReadValue( const std::string** s )
+{
+	unsigned n;
+	if ( !ReadNumber( &n ) )
+		return false;
+	if ( n == 0 )
+	{
+		unsigned index;
+		if ( !ReadNumber( &index ) || index >= valueCount )
+			return false;
+		*s = &values[ index ];
+		return true;
+	}
+
+	size_t length = n - 1;
+	if ( length > (size_t) ( end - p ) )
+		return false;
+	scratch.assign( p, length );
+	p += length;
+	if ( length && length <= VALUE_MAX_LENGTH && valueCount < VALUE_CAPACITY )
+		AddString( &values, &valueCount, scratch.data(), length );
+	*s = &scratch;
+	return true;
+}
+
+
+bool TiXmlCompactDecoder::Decode( const char* data, size_t size, TiXmlDocument* document )
+{
+	document->Reset();
+	p = data;
+	end = data + size;
+	nameCount = 0;
+	valueCount = 0;
+
+	bool ok =    size >= sizeof( COMPACT_MAGIC ) + 1
+			  && memcmp( p, COMPACT_MAGIC, sizeof( COMPACT_MAGIC ) ) == 0
+			  && p[ sizeof( COMPACT_MAGIC ) ] == COMPACT_VERSION;
+	if ( ok )
+		p += sizeof( COMPACT_MAGIC ) + 1;
+
+	TiXmlNode* parent = document;
+	while ( ok && p < end )
+	{
+		unsigned char code = (unsigned char) *p++;
+
+		if ( code == EVENT_END_ELEMENT )
+		{
+			ok = ( parent != document );
+			if ( ok )
+				parent = parent->Parent();
+		}
+		else if ( code == EVENT_START_NEW || code == EVENT_START_INDEXED || code >= EVENT_START_SHORT )
+		{
+			unsigned index = 0;
+			if ( code == EVENT_START_NEW )
+				ok = ReadNewName( &index );
+			else if ( code == EVENT_START_INDEXED )
+				ok = ReadNumber( &index ) && index < nameCount;
+			else
+			{
+				index = code - EVENT_START_SHORT;
+				ok = index < nameCount;
+			}
+			if ( !ok )
+				break;
+
+			TiXmlElement* element = document->NewNode( TiXmlNode::TINYXML_ELEMENT )->ToElement();
+			element->SetValue( names[ index ] );
+			parent->LinkEndChild( element );
+			parent = element;
+
+			unsigned count = 0;
+			ok = ReadNumber( &count );
+			for( unsigned i=0; ok && i<count; ++i )
+			{
+				const std::string* value = 0;
+				ok = ReadName( &index ) && ReadValue( &value ) && !element->attributeSet.Find( names[ index ] );
+				if ( ok )
+				{
+					TiXmlAttribute* attrib = document->NewAttribute();
+					attrib->SetDocument( document );
+					attrib->SetName( names[ index ] );
+					attrib->SetValue( *value );
+					element->attributeSet.Add( attrib );
+				}
+			}
+		}
+		else if ( code == EVENT_TEXT || code == EVENT_CDATA )
+		{
+			const std::string* value = 0;
+			ok = ReadValue( &value );
+			if ( ok )
+			{
+				TiXmlText* text = document->NewNode( TiXmlNode::TINYXML_TEXT )->ToText();
+				text->SetValue( *value );
+				text->SetCDATA( code == EVENT_CDATA );
+				parent->LinkEndChild( text );
+			}
+		}
+		else if ( code == EVENT_COMMENT || code == EVENT_UNKNOWN )
+		{
+			ok = ReadLiteral( &scratch );
+			if ( ok )
+			{
+				TiXmlNode* node = document->NewNode( code == EVENT_COMMENT ? TiXmlNode::TINYXML_COMMENT : TiXmlNode::TINYXML_UNKNOWN );
+				node->SetValue( scratch );
+				parent->LinkEndChild( node );
+			}
+		}
+		else if ( code == EVENT_DECLARATION )
+		{
+			TiXmlDeclaration* declaration = document->NewNode( TiXmlNode::TINYXML_DECLARATION )->ToDeclaration();
+			parent->LinkEndChild( declaration );
+			ok =    ReadLiteral( &declaration->version )
+				 && ReadLiteral( &declaration->encoding )
+				 && ReadLiteral( &declaration->standalone );
+		}
+		else
+		{
+			ok = false;
+		}
+	}
+
+	if ( ok && parent == document )
+		return true;
+
+	std::string none;
+	document->SetError( TiXmlBase::TIXML_ERROR_DECODING_COMPACT, none.begin(), none.end(), 0, TIXML_ENCODING_UNKNOWN );
+	return false;
+}
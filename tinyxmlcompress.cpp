@@ -0,0 +1,454 @@
+/*
+www.sourceforge.net/projects/tinyxml
+Original code by Lee Thomason (www.grinninglizard.com)
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must
+not claim that you wrote the original software. If you use this
+software in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+
+#include "tinyxml.h"
+
+#include <cstring>
+#include <istream>
+
+#ifdef TIXML_USE_ZLIB
+#	include <zlib.h>
+#endif
+#ifdef TIXML_USE_ZSTD
+#	include <zstd.h>
+#endif
+
+
+namespace {
+
+// Compressed input is read, and output handed on, in blocks of this size.
+const size_t CHUNK = 64 * 1024;
+
+// Most a size hint is trusted for: it comes from the input, which may
+// claim anything.
+const size_t MAX_EXPECTED = 64 * 1024 * 1024;
+
+// deflate expands by at most this much, so no honest gzip file says more.
+const size_t MAX_GZIP_RATIO = 1032;
+
+// The free space after 'used' bytes of text. Space reserved for the
+// expected size is filled first; after that the string grows
+// geometrically.
+char* Room( std::string* text, size_t used )
+{
+	if ( text->size() == used )
+	{
+		size_t size = used + CHUNK > 2 * used ? used + CHUNK : 2 * used;
+		if ( used < text->capacity() && size > text->capacity() )
+			size = text->capacity();
+		text->resize( size );
+	}
+	return &(*text)[ used ];
+}
+
+#ifdef TIXML_USE_ZLIB
+
+// How large the text will be, when the format says so cheaply. For gzip
+// it is in the last four bytes (modulo 4 GB, and only for the last
+// member), so it is only a hint, and no more than the compressed size
+// allows.
+size_t SizeHint( std::istream& in )
+{
+	std::streampos start = in.tellg();
+	if ( start == std::streampos( -1 ) )
+		return 0;
+	unsigned char size[4] = { 0, 0, 0, 0 };
+	in.seekg( -4, std::ios::end );
+	std::streamoff compressed = in.tellg() - start + 4;
+	in.read( (char*) size, 4 );
+	size_t hint = in.gcount() == 4 ? ( size[0] | size[1] << 8 | size[2] << 16 | (size_t) size[3] << 24 ) : 0;
+	in.clear();
+	in.seekg( start );
+	if ( compressed > 0 && hint / MAX_GZIP_RATIO > (size_t) compressed )
+		hint = (size_t) compressed * MAX_GZIP_RATIO;
+	return hint < MAX_EXPECTED ? hint : MAX_EXPECTED;
+}
+
+#endif
+
+} // namespace
+
+
+TiXmlDecompressStream::TiXmlDecompressStream( std::istream* source )
+	: std::istream( 0 ), buffer( source, TIXML_COMPRESSION_NONE, true )
+{
+	rdbuf( &buffer );
+}
+
+
+TiXmlDecompressStream::TiXmlDecompressStream( std::istream* source, TiXmlCompression compression )
+	: std::istream( 0 ), buffer( source, compression, false )
+{
+	rdbuf( &buffer );
+}
+
+
+TiXmlDecompressStream::Buffer::Buffer( std::istream* _source, TiXmlCompression _compression, bool _detect )
+	: expected( 0 ), failed( false ), source( _source ), compression( _compression ), detect( _detect ), stream( 0 ),
+	  input( CHUNK, '\0' ), output( CHUNK, '\0' ), next( 0 ), available( 0 ), started( false ), ended( false ), pending( false )
+{
+}
+
+
+TiXmlDecompressStream::Buffer::~Buffer()
+{
+#ifdef TIXML_USE_ZLIB
+	if ( stream && compression == TIXML_COMPRESSION_GZIP )
+	{
+		z_stream* z = (z_stream*) stream;
+		inflateEnd( z );
+		delete z;
+	}
+#endif
+#ifdef TIXML_USE_ZSTD
+	if ( stream && compression == TIXML_COMPRESSION_ZSTD )
+		ZSTD_freeDStream( (ZSTD_DStream*) stream );
+#endif
+}
+
+
+std::streambuf::int_type TiXmlDecompressStream::Buffer::underflow()
+{
+	if ( gptr() == egptr() )
+	{
+		size_t got = Decompress( &output[0], output.size() );
+		if ( !got )
+			return traits_type::eof();
+		setg( &output[0], &output[0], &output[0] + got );
+	}
+	return traits_type::to_int_type( *gptr() );
+}
+
+
+std::streamsize TiXmlDecompressStream::Buffer::xsgetn( char* s, std::streamsize n )
+{
+	// What is buffered, then straight into 's'.
+	std::streamsize done = egptr() - gptr() < n ? egptr() - gptr() : n;
+	if ( done )
+	{
+		memcpy( s, gptr(), (size_t) done );
+		gbump( (int) done );
+	}
+	while ( done < n )
+	{
+		size_t got = Decompress( s + done, (size_t) ( n - done ) );
+		if ( !got )
+			break;
+		done += (std::streamsize) got;
+	}
+	return done;
+}
+
+
+bool TiXmlDecompressStream::Buffer::Fill()
+{
+	next = available = 0;
+	if ( !source || !*source )
+		return false;
+	source->read( &input[0], (std::streamsize) input.size() );
+	available = (size_t) source->gcount();
+	return available != 0;
+}
+
+
+void TiXmlDecompressStream::Buffer::Start()
+{
+	started = true;
+	if ( detect )
+	{
+		Fill();
+		const unsigned char* magic = (const unsigned char*) input.data();
+		if ( available >= 2 && magic[0] == 0x1f && magic[1] == 0x8b )
+			compression = TIXML_COMPRESSION_GZIP;
+		else if ( available >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd )
+			compression = TIXML_COMPRESSION_ZSTD;
+		else
+			compression = TIXML_COMPRESSION_NONE;
+	}
+
+	if ( compression == TIXML_COMPRESSION_NONE )
+		return;
+#ifdef TIXML_USE_ZLIB
+	if ( compression == TIXML_COMPRESSION_GZIP )
+	{
+		// The trailer is only looked for before anything is read.
+		if ( !detect && source )
+			expected = SizeHint( *source );
+		z_stream* z = new z_stream;
+		memset( z, 0, sizeof( *z ) );
+		if ( inflateInit2( z, 15 + 16 ) == Z_OK )		// gzip wrapper
+			stream = z;
+		else
+			delete z;
+	}
+#endif
+#ifdef TIXML_USE_ZSTD
+	if ( compression == TIXML_COMPRESSION_ZSTD )
+	{
+		ZSTD_DStream* z = ZSTD_createDStream();
+		if ( z && !ZSTD_isError( ZSTD_initDStream( z ) ) )
+			stream = z;
+		else if ( z )
+			ZSTD_freeDStream( z );
+		if ( stream && ( next < available || Fill() ) )
+		{
+			unsigned long long size = ZSTD_getFrameContentSize( input.data() + next, available - next );
+			if ( size != ZSTD_CONTENTSIZE_UNKNOWN && size != ZSTD_CONTENTSIZE_ERROR )
+				expected = size < MAX_EXPECTED ? (size_t) size : MAX_EXPECTED;
+		}
+	}
+#endif
+	failed = !stream;
+}
+
+
+size_t TiXmlDecompressStream::Buffer::Decompress( char* out, size_t size )
+{
+	if ( !started )
+		Start();
+	if ( failed || !size )
+		return 0;
+	if ( size > ( 1u << 30 ) )
+		size = 1u << 30;
+
+	if ( compression == TIXML_COMPRESSION_NONE )
+	{
+		if ( next == available && !Fill() )
+			return 0;
+		size_t got = available - next < size ? available - next : size;
+		memcpy( out, input.data() + next, got );
+		next += got;
+		return got;
+	}
+
+	size_t produced = 0;
+#ifdef TIXML_USE_ZLIB
+	if ( compression == TIXML_COMPRESSION_GZIP )
+	{
+		z_stream* z = (z_stream*) stream;
+		z->next_out = (Bytef*) out;
+		z->avail_out = (uInt) size;
+		while ( z->avail_out == size && !failed )
+		{
+			// zlib may hold more output after filling the last block.
+			if ( next == available && !pending && !Fill() )
+			{
+				failed = !ended;
+				break;
+			}
+			if ( ended && next < available )
+			{
+				failed = inflateReset( z ) != Z_OK;		// files may hold several gzip members
+				ended = false;
+			}
+			z->next_in = (Bytef*) input.data() + next;
+			z->avail_in = (uInt) ( available - next );
+			int result = inflate( z, Z_NO_FLUSH );
+			next = available - z->avail_in;
+			pending = z->avail_out == 0;
+			if ( result == Z_STREAM_END )
+				ended = true;
+			else if ( result == Z_BUF_ERROR )
+				pending = false;		// nothing to do without more input
+			else if ( result != Z_OK )
+				failed = true;
+		}
+		produced = size - z->avail_out;
+	}
+#endif
+#ifdef TIXML_USE_ZSTD
+	if ( compression == TIXML_COMPRESSION_ZSTD )
+	{
+		ZSTD_DStream* z = (ZSTD_DStream*) stream;
+		while ( !produced && !failed )
+		{
+			if ( next == available && !pending && !Fill() )
+			{
+				failed = !ended;
+				break;
+			}
+			ZSTD_inBuffer from = { input.data(), available, next };
+			ZSTD_outBuffer to = { out, size, 0 };
+			size_t result = ZSTD_decompressStream( z, &to, &from );
+			if ( ZSTD_isError( result ) )
+			{
+				failed = true;
+				break;
+			}
+			if ( to.pos || from.pos != next )
+				ended = ( result == 0 );	// 0: a frame is complete and flushed
+			next = from.pos;
+			produced = to.pos;
+			pending = to.pos == to.size;
+		}
+	}
+#endif
+	return produced;
+}
+
+
+bool TiXmlDocument::ReadCompressed( std::istream& in, TiXmlCompression compression, std::string* text )
+{
+	text->clear();
+	TiXmlDecompressStream source( &in, compression );
+	source.peek();
+	if ( source.ExpectedSize() )
+		text->reserve( source.ExpectedSize() + 1 );
+
+	size_t used = 0;
+	while ( source )
+	{
+		char* room = Room( text, used );
+		source.read( room, (std::streamsize) ( text->size() - used ) );
+		used += (size_t) source.gcount();
+	}
+	text->resize( used );
+	return !source.Error();
+}
+
+
+#ifdef TIXML_USE_ZLIB
+
+TiXmlGzipSink::TiXmlGzipSink( TiXmlOutputSink* _target, int level )
+	: target( _target ), stream( 0 ), chunk( CHUNK, '\0' ), finished( false )
+{
+	z_stream* z = new z_stream;
+	memset( z, 0, sizeof( *z ) );
+	if ( deflateInit2( z, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY ) == Z_OK )
+		stream = z;
+	else
+		delete z;
+}
+
+
+TiXmlGzipSink::~TiXmlGzipSink()
+{
+	if ( stream )
+	{
+		Finish();
+		z_stream* z = (z_stream*) stream;
+		deflateEnd( z );
+		delete z;
+	}
+}
+
+
+bool TiXmlGzipSink::Compress( const char* data, size_t size, bool end )
+{
+	if ( !stream || finished )
+		return false;
+	z_stream* z = (z_stream*) stream;
+	z->next_in = (Bytef*) data;
+	z->avail_in = (uInt) size;
+	int result;
+	do
+	{
+		z->next_out = (Bytef*) &chunk[0];
+		z->avail_out = (uInt) chunk.size();
+		result = deflate( z, end ? Z_FINISH : Z_NO_FLUSH );
+		if ( result == Z_STREAM_ERROR )
+			return false;
+		target->Write( chunk.data(), chunk.size() - z->avail_out );
+	} while ( z->avail_out == 0 || ( end && result != Z_STREAM_END ) );
+	return target->Good();
+}
+
+
+bool TiXmlGzipSink::Drain( const char* data, size_t size )
+{
+	return Compress( data, size, false );
+}
+
+
+bool TiXmlGzipSink::Finish()
+{
+	if ( finished )
+		return Good() && target->Good();
+	bool ok = Flush() && Compress( 0, 0, true );
+	finished = true;
+	return target->Flush() && ok;
+}
+
+#endif
+
+
+#ifdef TIXML_USE_ZSTD
+
+TiXmlZstdSink::TiXmlZstdSink( TiXmlOutputSink* _target, int level )
+	: target( _target ), stream( 0 ), chunk( ZSTD_CStreamOutSize(), '\0' ), finished( false )
+{
+	ZSTD_CStream* z = ZSTD_createCStream();
+	if ( z && !ZSTD_isError( ZSTD_initCStream( z, level ) ) )
+		stream = z;
+	else if ( z )
+		ZSTD_freeCStream( z );
+}
+
+
+TiXmlZstdSink::~TiXmlZstdSink()
+{
+	if ( stream )
+	{
+		Finish();
+		ZSTD_freeCStream( (ZSTD_CStream*) stream );
+	}
+}
+
+
+bool TiXmlZstdSink::Compress( const char* data, size_t size, bool end )
+{
+	if ( !stream || finished )
+		return false;
+	ZSTD_CStream* z = (ZSTD_CStream*) stream;
+	ZSTD_inBuffer source = { data, size, 0 };
+	size_t remaining;
+	do
+	{
+		ZSTD_outBuffer out = { &chunk[0], chunk.size(), 0 };
+		remaining = ZSTD_compressStream2( z, &out, &source, end ? ZSTD_e_end : ZSTD_e_continue );
+		if ( ZSTD_isError( remaining ) )
+			return false;
+		target->Write( chunk.data(), out.pos );
+	} while ( source.pos < source.size || ( end && remaining != 0 ) );
+	return target->Good();
+}
+
+
+bool TiXmlZstdSink::Drain( const char* data, size_t size )
+{
+	return Compress( data, size, false );
+}
+
+
+bool TiXmlZstdSink::Finish()
+{
+	if ( finished )
+		return Good() && target->Good();
+	bool ok = Flush() && Compress( 0, 0, true );
+	finished = true;
+	return target->Flush() && ok;
+}
+
+#endif
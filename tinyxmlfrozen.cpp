@@ -0,0 +1,901 @@
+/*
+www.sourceforge.net/projects/tinyxml
+Original code by Lee Thomason (www.grinninglizard.com)
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must
+not claim that you wrote the original software. If you use this
+software in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#include "tinyxml.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+
+#include <sys/stat.h>
+#if defined( _WIN32 )
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <unistd.h>
+#endif
+
+
+namespace {
+
+// Fills the arrays of a TiXmlFrozenDocument. Strings go into the pool once
+// per distinct name; text and other values are appended as they come.
+class TiXmlFreezer
+{
+public:
+	TiXmlFreezer( std::vector<TiXmlFrozenDocument::Node>& _nodes,
+				  std::vector<TiXmlFrozenDocument::Attribute>& _attributes,
+				  std::vector<char>& _strings )
+		: nodes( _nodes ), attributes( _attributes ), strings( _strings )
+	{}
+
+	void Run( const TiXmlDocument& document );
+
+private:
+	void Count( const TiXmlDocument& document );
+	unsigned Append( const TiXmlNode& node, unsigned parent );
+	void AppendAttribute( const std::string& name, const std::string& value );
+	unsigned Store( const std::string& s );
+	unsigned Intern( const std::string& s );
+
+	std::vector<TiXmlFrozenDocument::Node>& nodes;
+	std::vector<TiXmlFrozenDocument::Attribute>& attributes;
+	std::vector<char>& strings;
+	// Keys point into the source document, which outlives the freezer.
+	std::unordered_map<std::string_view, unsigned> names;
+};
+
+
+void TiXmlFreezer::Count( const TiXmlDocument& document )
+{
+	size_t nodeCount = 0, attributeCount = 0, stringBytes = 1;
+	for( const TiXmlNode* node = &document; node; )
+	{
+		++nodeCount;
+		stringBytes += node->ValueStr().size() + 1;
+		if ( const TiXmlElement* element = node->ToElement() )
+		{
+			for( const TiXmlAttribute* a = element->FirstAttribute(); a; a = a->Next() )
+			{
+				++attributeCount;
+				stringBytes += a->NameTStr().size() + a->ValueStr().size() + 2;
+			}
+		}
+		else if ( node->ToDeclaration() )
+		{
+			attributeCount += 3;
+			stringBytes += 64;
+		}
+
+		if ( node->FirstChild() )
+		{
+			node = node->FirstChild();
+			continue;
+		}
+		while ( node && !node->NextSibling() )
+			node = node->Parent();
+		if ( node )
+			node = node->NextSibling();
+	}
+	nodes.reserve( nodeCount );
+	attributes.reserve( attributeCount );
+	strings.reserve( stringBytes );
+}
+
+
+void TiXmlFreezer::Run( const TiXmlDocument& document )
+{
+	Count( document );
+
+	// Offset 0 is the empty string.
+	strings.push_back( 0 );
+
+	const TiXmlNode* node = &document;
+	unsigned parent = TiXmlFrozenDocument::NONE;
+	for( ;; )
+	{
+		unsigned i = Append( *node, parent );
+		if ( node->FirstChild() )
+		{
+			parent = i;
+			node = node->FirstChild();
+			continue;
+		}
+		nodes[i].end = i + 1;
+
+		// Close every subtree that ends here.
+		while ( node != &document && !node->NextSibling() )
+		{
+			node = node->Parent();
+			nodes[parent].end = (unsigned) nodes.size();
+			parent = nodes[parent].parent;
+		}
+		if ( node == &document )
+			break;
+		node = node->NextSibling();
+	}
+
+	strings.shrink_to_fit();
+	attributes.shrink_to_fit();
+}
+
+
+unsigned TiXmlFreezer::Append( const TiXmlNode& node, unsigned parent )
+{
+	TiXmlFrozenDocument::Node record;
+	record.type = (unsigned short) node.Type();
+	record.flags = 0;
+	record.parent = parent;
+	record.end = 0;
+	record.firstAttribute = (unsigned) attributes.size();
+	record.attributeCount = 0;
+
+	const std::string& value = node.ValueStr();
+	record.value = node.ToElement() ? Intern( value ) : Store( value );
+	record.valueLength = (unsigned) value.size();
+
+	if ( const TiXmlElement* element = node.ToElement() )
+	{
+		for( const TiXmlAttribute* a = element->FirstAttribute(); a; a = a->Next() )
+			AppendAttribute( a->NameTStr(), a->ValueStr() );
+	}
+	else if ( const TiXmlText* text = node.ToText() )
+	{
+		if ( text->CDATA() )
+			record.flags |= TiXmlFrozenDocument::CDATA_FLAG;
+	}
+	else if ( const TiXmlDeclaration* decl = node.ToDeclaration() )
+	{
+		static const std::string version( "version" ), encoding( "encoding" ), standalone( "standalone" );
+		if ( !decl->Version().empty() )
+			AppendAttribute( version, decl->Version() );
+		if ( !decl->Encoding().empty() )
+			AppendAttribute( encoding, decl->Encoding() );
+		if ( !decl->Standalone().empty() )
+			AppendAttribute( standalone, decl->Standalone() );
+	}
+	record.attributeCount = (unsigned) attributes.size() - record.firstAttribute;
+
+	nodes.push_back( record );
+	return (unsigned) nodes.size() - 1;
+}
+
+
+void TiXmlFreezer::AppendAttribute( const std::string& name, const std::string& value )
+{
+	TiXmlFrozenDocument::Attribute attribute;
+	attribute.name = Intern( name );
+	attribute.value = Store( value );
+	attributes.push_back( attribute );
+}
+
+
+unsigned TiXmlFreezer::Store( const std::string& s )
+{
+	if ( s.empty() )
+		return 0;
+	unsigned offset = (unsigned) strings.size();
+	strings.insert( strings.end(), s.begin(), s.end() );
+	strings.push_back( 0 );
+	return offset;
+}
+
+
+unsigned TiXmlFreezer::Intern( const std::string& s )
+{
+	std::string_view key( s );
+	auto it = names.find( key );
+	if ( it != names.end() )
+		return it->second;
+	unsigned offset = Store( s );
+	names.emplace( key, offset );
+	return offset;
+}
+
+
+// The binary image: this header, then the node, attribute and string
+// arrays exactly as they are in memory, each on an 8 byte boundary.
+struct TiXmlBinaryHeader
+{
+	char				magic[8];
+	unsigned			version;
+	unsigned			byteOrder;
+	unsigned			nodeSize;
+	unsigned			attributeSize;
+	unsigned			nodeCount;
+	unsigned			attributeCount;
+	unsigned			stringSize;
+	unsigned			reserved;
+	unsigned long long	nodesOffset;
+	unsigned long long	attributesOffset;
+	unsigned long long	stringsOffset;
+	unsigned long long	imageSize;
+	long long			sourceSize;			// -1 if the image isn't tied to a file
+	long long			sourceTime;
+	unsigned long long	checksum;			// of everything after the header
+};
+
+const char TIXML_BINARY_MAGIC[8] = { 'T', 'i', 'X', 'm', 'l', 'B', 'i', 'n' };
+const unsigned TIXML_BINARY_VERSION = 1;
+const unsigned TIXML_BINARY_BYTE_ORDER = 0x01020304;
+
+static_assert( sizeof( TiXmlBinaryHeader ) % 8 == 0, "header keeps the arrays aligned" );
+
+
+unsigned long long Align8( unsigned long long offset )
+{
+	return ( offset + 7 ) & ~7ull;
+}
+
+
+// Not cryptographic; it catches truncated and damaged images.
+unsigned long long Checksum( const char* p, size_t n )
+{
+	unsigned long long h = 0x9e3779b97f4a7c15ull ^ n;
+	size_t i = 0;
+	for( ; i + 8 <= n; i += 8 )
+	{
+		unsigned long long w;
+		memcpy( &w, p + i, 8 );
+		h ^= w * 0x87c37b91114253d5ull;
+		h = ( ( h << 31 ) | ( h >> 33 ) ) * 0x4cf5ad432745937full;
+	}
+	for( ; i < n; ++i )
+	{
+		h ^= (unsigned char) p[i];
+		h *= 0x100000001b3ull;
+	}
+	return h ^ ( h >> 29 );
+}
+
+
+// Size and modification time of a file. False if it can't be read.
+bool SourceStamp( const std::string& path, long long* size, long long* time )
+{
+	struct stat st;
+	if ( path.empty() || stat( path.c_str(), &st ) != 0 )
+		return false;
+	*size = (long long) st.st_size;
+	*time = (long long) st.st_mtime;
+	return true;
+}
+
+
+bool MapImage( const std::string& path, void** address, size_t* size )
+{
+#if defined( _WIN32 )
+	HANDLE file = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0 );
+	if ( file == INVALID_HANDLE_VALUE )
+		return false;
+	LARGE_INTEGER length;
+	void* view = 0;
+	if ( GetFileSizeEx( file, &length ) && length.QuadPart > 0 )
+	{
+		HANDLE mapping = CreateFileMappingA( file, 0, PAGE_READONLY, 0, 0, 0 );
+		if ( mapping )
+		{
+			view = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+			CloseHandle( mapping );
+		}
+	}
+	CloseHandle( file );
+	if ( !view )
+		return false;
+	*address = view;
+	*size = (size_t) length.QuadPart;
+	return true;
+#else
+	int fd = open( path.c_str(), O_RDONLY );
+	if ( fd < 0 )
+		return false;
+	struct stat st;
+	void* view = MAP_FAILED;
+	if ( fstat( fd, &st ) == 0 && st.st_size > 0 )
+		view = mmap( 0, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+	close( fd );
+	if ( view == MAP_FAILED )
+		return false;
+	*address = view;
+	*size = (size_t) st.st_size;
+	return true;
+#endif
+}
+
+
+void UnmapImage( void* address, size_t size )
+{
+#if defined( _WIN32 )
+	(void) size;
+	UnmapViewOfFile( address );
+#else
+	munmap( address, size );
+#endif
+}
+
+
+// Everything a reader relies on: every offset and index in range, every
+// string terminated, every subtree inside its parent.
+bool ValidImage( const char* image, size_t size )
+{
+	typedef TiXmlFrozenDocument::Node Node;
+	typedef TiXmlFrozenDocument::Attribute Attribute;
+
+	if ( size < sizeof( TiXmlBinaryHeader ) )
+		return false;
+	TiXmlBinaryHeader header;
+	memcpy( &header, image, sizeof( header ) );
+
+	if (    memcmp( header.magic, TIXML_BINARY_MAGIC, sizeof( header.magic ) ) != 0
+		 || header.version != TIXML_BINARY_VERSION
+		 || header.byteOrder != TIXML_BINARY_BYTE_ORDER
+		 || header.nodeSize != sizeof( Node )
+		 || header.attributeSize != sizeof( Attribute )
+		 || header.imageSize != size
+		 || header.nodeCount == 0
+		 || header.stringSize == 0 )
+		return false;
+
+	unsigned long long nodesEnd = header.nodesOffset + (unsigned long long) header.nodeCount * sizeof( Node );
+	unsigned long long attributesEnd = header.attributesOffset + (unsigned long long) header.attributeCount * sizeof( Attribute );
+	if (    header.nodesOffset != Align8( sizeof( header ) )
+		 || header.attributesOffset != Align8( nodesEnd )
+		 || header.stringsOffset != Align8( attributesEnd )
+		 || header.stringsOffset + header.stringSize != size )
+		return false;
+
+	if ( Checksum( image + sizeof( header ), size - sizeof( header ) ) != header.checksum )
+		return false;
+
+	const Node* nodes = (const Node*) ( image + header.nodesOffset );
+	const Attribute* attributes = (const Attribute*) ( image + header.attributesOffset );
+	const char* strings = image + header.stringsOffset;
+	unsigned stringSize = header.stringSize;
+
+	if ( strings[0] != 0 || strings[stringSize - 1] != 0 )
+		return false;
+
+	for( unsigned i=0; i<header.nodeCount; ++i )
+	{
+		const Node& node = nodes[i];
+		if (    node.type >= TiXmlNode::TINYXML_TYPECOUNT
+			 || node.value >= stringSize
+			 || node.valueLength >= stringSize - node.value
+			 || node.end <= i
+			 || node.firstAttribute > header.attributeCount
+			 || node.attributeCount > header.attributeCount - node.firstAttribute )
+			return false;
+		if ( i == 0 )
+		{
+			if (    node.type != TiXmlNode::TINYXML_DOCUMENT
+				 || node.parent != TiXmlFrozenDocument::NONE
+				 || node.end != header.nodeCount )
+				return false;
+		}
+		else if ( node.parent >= i || node.end > nodes[node.parent].end )
+		{
+			return false;
+		}
+	}
+	for( unsigned i=0; i<header.attributeCount; ++i )
+	{
+		if ( attributes[i].name >= stringSize || attributes[i].value >= stringSize )
+			return false;
+	}
+	return true;
+}
+
+} // namespace
+
+
+TiXmlFrozenDocument::TiXmlFrozenDocument()
+	: nodes( 0 ), nodeCount( 0 ), attributes( 0 ), attributeCount( 0 ), strings( 0 ), stringSize( 0 ),
+	  mapping( 0 ), mappingSize( 0 )
+{
+}
+
+
+TiXmlFrozenDocument::TiXmlFrozenDocument( const TiXmlDocument& document )
+	: mapping( 0 ), mappingSize( 0 )
+{
+	TiXmlFreezer freezer( ownedNodes, ownedAttributes, ownedStrings );
+	freezer.Run( document );
+
+	nodes = ownedNodes.data();
+	nodeCount = (unsigned) ownedNodes.size();
+	attributes = ownedAttributes.data();
+	attributeCount = (unsigned) ownedAttributes.size();
+	strings = ownedStrings.data();
+	stringSize = (unsigned) ownedStrings.size();
+}
+
+
+TiXmlFrozenDocument::TiXmlFrozenDocument( TiXmlFrozenDocument&& other )
+	: mapping( 0 ), mappingSize( 0 )
+{
+	Adopt( other );
+}
+
+
+TiXmlFrozenDocument::~TiXmlFrozenDocument()
+{
+	Release();
+}
+
+
+TiXmlFrozenDocument& TiXmlFrozenDocument::operator=( TiXmlFrozenDocument&& other )
+{
+	if ( this != &other )
+		Adopt( other );
+	return *this;
+}
+
+
+void TiXmlFrozenDocument::Adopt( TiXmlFrozenDocument& other )
+{
+	Release();
+
+	// Moving a vector keeps its buffer, so the raw pointers stay good.
+	ownedNodes = std::move( other.ownedNodes );
+	ownedAttributes = std::move( other.ownedAttributes );
+	ownedStrings = std::move( other.ownedStrings );
+	nodes = other.nodes;
+	nodeCount = other.nodeCount;
+	attributes = other.attributes;
+	attributeCount = other.attributeCount;
+	strings = other.strings;
+	stringSize = other.stringSize;
+	mapping = other.mapping;
+	mappingSize = other.mappingSize;
+
+	other.mapping = 0;
+	other.mappingSize = 0;
+	other.nodes = 0;
+	other.nodeCount = 0;
+	other.attributes = 0;
+	other.attributeCount = 0;
+	other.strings = 0;
+	other.stringSize = 0;
+}
+
+
+void TiXmlFrozenDocument::Release()
+{
+	if ( mapping )
+		UnmapImage( mapping, mappingSize );
+	mapping = 0;
+	mappingSize = 0;
+
+	std::vector<Node>().swap( ownedNodes );
+	std::vector<Attribute>().swap( ownedAttributes );
+	std::vector<char>().swap( ownedStrings );
+	nodes = 0;
+	nodeCount = 0;
+	attributes = 0;
+	attributeCount = 0;
+	strings = 0;
+	stringSize = 0;
+}
+
+
+bool TiXmlFrozenDocument::SaveBinary( const std::string& path, const std::string& sourcePath ) const
+{
+	long long sourceSize = -1, sourceTime = 0;
+	if ( !sourcePath.empty() && !SourceStamp( sourcePath, &sourceSize, &sourceTime ) )
+		return false;
+	return WriteBinary( path, sourceSize, sourceTime );
+}
+
+
+bool TiXmlFrozenDocument::WriteBinary( const std::string& path, long long sourceSize, long long sourceTime ) const
+{
+	if ( !nodeCount )
+		return false;
+
+	TiXmlBinaryHeader header;
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, TIXML_BINARY_MAGIC, sizeof( header.magic ) );
+	header.version = TIXML_BINARY_VERSION;
+	header.byteOrder = TIXML_BINARY_BYTE_ORDER;
+	header.nodeSize = sizeof( Node );
+	header.attributeSize = sizeof( Attribute );
+	header.nodeCount = nodeCount;
+	header.attributeCount = attributeCount;
+	header.stringSize = stringSize;
+	header.nodesOffset = Align8( sizeof( header ) );
+	header.attributesOffset = Align8( header.nodesOffset + (unsigned long long) nodeCount * sizeof( Node ) );
+	header.stringsOffset = Align8( header.attributesOffset + (unsigned long long) attributeCount * sizeof( Attribute ) );
+	header.imageSize = header.stringsOffset + stringSize;
+	header.sourceSize = sourceSize;
+	header.sourceTime = sourceTime;
+
+	// Assembled in memory: the checksum needs the padding bytes as well.
+	std::vector<char> body( (size_t) ( header.imageSize - sizeof( header ) ), 0 );
+	char* base = body.data() - sizeof( header );
+	memcpy( base + header.nodesOffset, nodes, nodeCount * sizeof( Node ) );
+	if ( attributeCount )
+		memcpy( base + header.attributesOffset, attributes, attributeCount * sizeof( Attribute ) );
+	memcpy( base + header.stringsOffset, strings, stringSize );
+	header.checksum = Checksum( body.data(), body.size() );
+
+	std::string temp = path + ".tmp";
+	FILE* fp = fopen( temp.c_str(), "wb" );
+	if ( !fp )
+		return false;
+	bool ok =    fwrite( &header, sizeof( header ), 1, fp ) == 1
+			  && fwrite( body.data(), 1, body.size(), fp ) == body.size();
+	ok = ( fclose( fp ) == 0 ) && ok;
+
+	if ( ok && rename( temp.c_str(), path.c_str() ) != 0 )
+	{
+		// Windows won't rename over an existing file.
+		remove( path.c_str() );
+		ok = rename( temp.c_str(), path.c_str() ) == 0;
+	}
+	if ( !ok )
+		remove( temp.c_str() );
+	return ok;
+}
+
+
+bool TiXmlFrozenDocument::LoadBinary( const std::string& path, const std::string& sourcePath )
+{
+	void* address = 0;
+	size_t size = 0;
+	if ( !MapImage( path, &address, &size ) )
+		return false;
+
+	const char* image = (const char*) address;
+	bool ok = ValidImage( image, size );
+
+	TiXmlBinaryHeader header;
+	if ( ok )
+	{
+		memcpy( &header, image, sizeof( header ) );
+		if ( !sourcePath.empty() )
+		{
+			long long sourceSize, sourceTime;
+			ok =    header.sourceSize >= 0
+				 && SourceStamp( sourcePath, &sourceSize, &sourceTime )
+				 && sourceSize == header.sourceSize
+				 && sourceTime == header.sourceTime;
+		}
+	}
+	if ( !ok )
+	{
+		UnmapImage( address, size );
+		return false;
+	}
+
+	Release();
+	mapping = address;
+	mappingSize = size;
+	nodes = (const Node*) ( image + header.nodesOffset );
+	nodeCount = header.nodeCount;
+	attributes = (const Attribute*) ( image + header.attributesOffset );
+	attributeCount = header.attributeCount;
+	strings = image + header.stringsOffset;
+	stringSize = header.stringSize;
+	return true;
+}
+
+
+bool TiXmlFrozenDocument::Load( const std::string& binaryPath, const std::string& xmlPath )
+{
+	if ( LoadBinary( binaryPath, xmlPath ) )
+		return true;
+
+	// Stamp the source before reading it: if it changes while we parse,
+	// the image is stale on the next load rather than silently wrong.
+	long long sourceSize = -1, sourceTime = 0;
+	if ( !SourceStamp( xmlPath, &sourceSize, &sourceTime ) )
+		return false;
+
+	TiXmlDocument document;
+	if ( !document.LoadFile( xmlPath ) )
+		return false;
+	*this = document.Freeze();
+	WriteBinary( binaryPath, sourceSize, sourceTime );
+	return true;
+}
+
+
+bool TiXmlDocument::SaveBinary( const std::string& path, const std::string& sourcePath ) const
+{
+	// The document's name is not a source: the DOM may have been edited,
+	// or never read from that file at all.
+	return Freeze().SaveBinary( path, sourcePath );
+}
+
+
+size_t TiXmlFrozenDocument::MemoryUsed() const
+{
+	return nodeCount * sizeof( Node ) + attributeCount * sizeof( Attribute ) + stringSize;
+}
+
+
+bool TiXmlFrozenDocument::Accept( TiXmlFrozenVisitor* visitor ) const
+{
+	if ( !nodeCount )
+		return true;
+	return AcceptNode( 0, visitor );
+}
+
+
+bool TiXmlFrozenDocument::AcceptNode( unsigned i, TiXmlFrozenVisitor* visitor ) const
+{
+	const Node& node = nodes[i];
+	TiXmlFrozenHandle handle( this, i );
+
+	switch ( node.type )
+	{
+	case TiXmlNode::TINYXML_DOCUMENT:
+		if ( visitor->VisitDocumentEnter( handle ) )
+		{
+			for( unsigned child = i + 1; child < node.end; child = nodes[child].end )
+			{
+				if ( !AcceptNode( child, visitor ) )
+					break;
+			}
+		}
+		return visitor->VisitDocumentExit( handle );
+
+	case TiXmlNode::TINYXML_ELEMENT:
+		if ( visitor->VisitEnter( handle ) )
+		{
+			for( unsigned child = i + 1; child < node.end; child = nodes[child].end )
+			{
+				if ( !AcceptNode( child, visitor ) )
+					break;
+			}
+		}
+		return visitor->VisitExit( handle );
+
+	default:
+		return visitor->Visit( handle );
+	}
+}
+
+
+TiXmlFrozenDocument TiXmlDocument::Freeze() const
+{
+	return TiXmlFrozenDocument( *this );
+}
+
+
+int TiXmlFrozenHandle::Type() const
+{
+	return doc ? doc->NodeAt( index ).type : TiXmlNode::TINYXML_TYPECOUNT;
+}
+
+
+const char* TiXmlFrozenHandle::Value() const
+{
+	return doc ? doc->String( doc->NodeAt( index ).value ) : "";
+}
+
+
+size_t TiXmlFrozenHandle::ValueLength() const
+{
+	return doc ? doc->NodeAt( index ).valueLength : 0;
+}
+
+
+bool TiXmlFrozenHandle::CDATA() const
+{
+	return doc && ( doc->NodeAt( index ).flags & TiXmlFrozenDocument::CDATA_FLAG );
+}
+
+
+unsigned TiXmlFrozenHandle::SubtreeSize() const
+{
+	return doc ? doc->NodeAt( index ).end - index : 0;
+}
+
+
+TiXmlFrozenHandle TiXmlFrozenHandle::Parent() const
+{
+	if ( doc )
+	{
+		unsigned parent = doc->NodeAt( index ).parent;
+		if ( parent != TiXmlFrozenDocument::NONE )
+			return TiXmlFrozenHandle( doc, parent );
+	}
+	return TiXmlFrozenHandle();
+}
+
+
+TiXmlFrozenHandle TiXmlFrozenHandle::FirstChild() const
+{
+	if ( doc && doc->NodeAt( index ).end > index + 1 )
+		return TiXmlFrozenHandle( doc, index + 1 );
+	return TiXmlFrozenHandle();
+}
+
+
+TiXmlFrozenHandle TiXmlFrozenHandle::FirstChild( const char* value ) const
+{
+	TiXmlFrozenHandle child = FirstChild();
+	if ( child && strcmp( child.Value(), value ) != 0 )
+		child = child.NextSibling( value );
+	return child;
+}
+
+
+TiXmlFrozenHandle TiXmlFrozenHandle::FirstChildElement() const
+{
+	TiXmlFrozenHandle child = FirstChild();
+	if ( child && !child.IsElement() )
+		child = child.NextSiblingElement();
+	return child;
+}
+
+
+TiXmlFrozenHandle TiXmlFrozenHandle::FirstChildElement( const char* value ) const
+{
+	TiXmlFrozenHandle child = FirstChildElement();
+	if ( child && strcmp( child.Value(), value ) != 0 )
+		child = child.NextSiblingElement( value );
+	return child;
+}
+
+
+TiXmlFrozenHandle TiXmlFrozenHandle::NextSibling() const
+{
+	if ( doc )
+	{
+		const TiXmlFrozenDocument::Node& node = doc->NodeAt( index );
+		if ( node.parent != TiXmlFrozenDocument::NONE && node.end < doc->NodeAt( node.parent ).end )
+			return TiXmlFrozenHandle( doc, node.end );
+	}
+	return TiXmlFrozenHandle();
+}
+
+
+TiXmlFrozenHandle TiXmlFrozenHandle::NextSibling( const char* value ) const
+{
+	TiXmlFrozenHandle sibling = NextSibling();
+	while ( sibling && strcmp( sibling.Value(), value ) != 0 )
+		sibling = sibling.NextSibling();
+	return sibling;
+}
+
+
+TiXmlFrozenHandle TiXmlFrozenHandle::NextSiblingElement() const
+{
+	TiXmlFrozenHandle sibling = NextSibling();
+	while ( sibling && !sibling.IsElement() )
+		sibling = sibling.NextSibling();
+	return sibling;
+}
+
+
+TiXmlFrozenHandle TiXmlFrozenHandle::NextSiblingElement( const char* value ) const
+{
+	TiXmlFrozenHandle sibling = NextSiblingElement();
+	while ( sibling && strcmp( sibling.Value(), value ) != 0 )
+		sibling = sibling.NextSiblingElement();
+	return sibling;
+}
+
+
+TiXmlFrozenHandle TiXmlFrozenHandle::Child( int count ) const
+{
+	TiXmlFrozenHandle child = FirstChild();
+	for( int i=0; child && i<count; ++i )
+		child = child.NextSibling();
+	return count >= 0 ? child : TiXmlFrozenHandle();
+}
+
+
+TiXmlFrozenHandle TiXmlFrozenHandle::Child( const char* value, int count ) const
+{
+	TiXmlFrozenHandle child = FirstChild( value );
+	for( int i=0; child && i<count; ++i )
+		child = child.NextSibling( value );
+	return count >= 0 ? child : TiXmlFrozenHandle();
+}
+
+
+TiXmlFrozenHandle TiXmlFrozenHandle::ChildElement( int count ) const
+{
+	TiXmlFrozenHandle child = FirstChildElement();
+	for( int i=0; child && i<count; ++i )
+		child = child.NextSiblingElement();
+	return count >= 0 ? child : TiXmlFrozenHandle();
+}
+
+
+TiXmlFrozenHandle TiXmlFrozenHandle::ChildElement( const char* value, int count ) const
+{
+	TiXmlFrozenHandle child = FirstChildElement( value );
+	for( int i=0; child && i<count; ++i )
+		child = child.NextSiblingElement( value );
+	return count >= 0 ? child : TiXmlFrozenHandle();
+}
+
+
+int TiXmlFrozenHandle::AttributeCount() const
+{
+	return doc ? (int) doc->NodeAt( index ).attributeCount : 0;
+}
+
+
+const char* TiXmlFrozenHandle::AttributeName( int i ) const
+{
+	if ( i < 0 || i >= AttributeCount() )
+		return 0;
+	return doc->String( doc->AttributeAt( doc->NodeAt( index ).firstAttribute + i ).name );
+}
+
+
+const char* TiXmlFrozenHandle::AttributeValue( int i ) const
+{
+	if ( i < 0 || i >= AttributeCount() )
+		return 0;
+	return doc->String( doc->AttributeAt( doc->NodeAt( index ).firstAttribute + i ).value );
+}
+
+
+const char* TiXmlFrozenHandle::Attribute( const char* name ) const
+{
+	if ( !doc )
+		return 0;
+	const TiXmlFrozenDocument::Node& node = doc->NodeAt( index );
+	for( unsigned i=0; i<node.attributeCount; ++i )
+	{
+		const TiXmlFrozenDocument::Attribute& a = doc->AttributeAt( node.firstAttribute + i );
+		if ( strcmp( doc->String( a.name ), name ) == 0 )
+			return doc->String( a.value );
+	}
+	return 0;
+}
+
+
+int TiXmlFrozenHandle::QueryIntAttribute( const char* name, int* _value ) const
+{
+	const char* s = Attribute( name );
+	if ( !s )
+		return TIXML_NO_ATTRIBUTE;
+	return TiXmlBase::ReadValue( std::string_view( s ), _value );
+}
+
+
+int TiXmlFrozenHandle::QueryDoubleAttribute( const char* name, double* _value ) const
+{
+	const char* s = Attribute( name );
+	if ( !s )
+		return TIXML_NO_ATTRIBUTE;
+	return TiXmlBase::ReadValue( std::string_view( s ), _value );
+}
+
+
+const char* TiXmlFrozenHandle::GetText() const
+{
+	TiXmlFrozenHandle child = FirstChild();
+	return child.IsText() ? child.Value() : 0;
+}
@@ -0,0 +1,595 @@
+/*
+www.sourceforge.net/projects/tinyxml
+Original code by Lee Thomason (www.grinninglizard.com)
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must
+not claim that you wrote the original software. If you use this
+software in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+
+#include "tinyxml.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+namespace {
+
+// A run of siblings for a worker to print, or, with no nodes, the start
+// or end tag of an element that was split, printed already.
+struct Piece
+{
+	const TiXmlNode* first;
+	const TiXmlNode* last;
+	int depth;
+	bool done;
+	std::string text;
+};
+
+
+// Rough printed size of a node by itself, at 'level', as
+// TiXmlPrinter::EstimateSize() counts it for a document.
+size_t EstimateNode( const TiXmlNode* node, size_t indentSize, size_t lineBreakSize, int level )
+{
+	size_t size = level * indentSize + lineBreakSize;
+	if ( const TiXmlElement* element = node->ToElement() )
+	{
+		size += level * indentSize + lineBreakSize + 2 * element->ValueStr().size() + 5;
+		for( const TiXmlAttribute* attrib = element->FirstAttribute(); attrib; attrib = attrib->Next() )
+			size += attrib->NameTStr().size() + attrib->ValueStr().size() + 4;
+	}
+	else
+	{
+		size += node->ValueStr().size() + 12;
+	}
+	return size;
+}
+
+
+// Rough printed size of a node and everything under it.
+size_t EstimateSubtree( const TiXmlNode* root, size_t indentSize, size_t lineBreakSize, int depth )
+{
+	size_t size = 0;
+	int level = depth;
+	for( const TiXmlNode* node = root; node; )
+	{
+		size += EstimateNode( node, indentSize, lineBreakSize, level );
+		if ( node->FirstChild() )
+		{
+			node = node->FirstChild();
+			++level;
+			continue;
+		}
+		while ( node != root && !node->NextSibling() )
+		{
+			node = node->Parent();
+			--level;
+		}
+		node = ( node == root ) ? 0 : node->NextSibling();
+	}
+	return size;
+}
+
+
+class Splitter
+{
+public:
+	Splitter( const std::string& _indent, const std::string& _lineBreak, size_t _grain, std::vector< Piece >* _pieces )
+		: indent( _indent ), lineBreak( _lineBreak ), grain( _grain ), pieces( _pieces )
+	{
+		tags.SetIndent( indent );
+		tags.SetLineBreak( lineBreak );
+	}
+
+	// Cut the siblings first..last, and what is under them, into pieces.
+	void Cut( const TiXmlNode* first, const TiXmlNode* last )
+	{
+		Measure( first, last, 0 );
+		Split( first, last, 0 );
+	}
+
+private:
+	// Sizes every subtree in one pass, children before parents, and keeps
+	// those bigger than a grain, which are the ones Split() goes into. So
+	// no node is measured again for each level split above it: a smaller
+	// subtree is measured once more, by itself, if its parent is split.
+	void Measure( const TiXmlNode* first, const TiXmlNode* last, int depth )
+	{
+		large.clear();
+		std::vector< size_t > open;		// the size so far of each node on the way down
+		int level = depth;
+		for( const TiXmlNode* node = first; node; )
+		{
+			open.push_back( EstimateNode( node, indent.size(), lineBreak.size(), level ) );
+			if ( node->FirstChild() )
+			{
+				node = node->FirstChild();
+				++level;
+				continue;
+			}
+			// Close the nodes that are done, adding each to its parent.
+			for( ;; )
+			{
+				size_t size = open.back();
+				open.pop_back();
+				if ( size > grain )
+					large[ node ] = size;
+				if ( open.empty() )
+				{
+					node = ( node == last ) ? 0 : node->NextSibling();
+					break;
+				}
+				open.back() += size;
+				if ( node->NextSibling() )
+				{
+					node = node->NextSibling();
+					break;
+				}
+				node = node->Parent();
+				--level;
+			}
+		}
+	}
+
+	void Split( const TiXmlNode* first, const TiXmlNode* last, int depth )
+	{
+		const TiXmlNode* runFirst = 0;
+		const TiXmlNode* runLast = 0;
+		size_t runSize = 0;
+
+		for( const TiXmlNode* node = first; node; node = ( node == last ) ? 0 : node->NextSibling() )
+		{
+			std::unordered_map< const TiXmlNode*, size_t >::const_iterator it = large.find( node );
+			size_t size = ( it != large.end() ) ? it->second : EstimateSubtree( node, indent.size(), lineBreak.size(), depth );
+			const TiXmlElement* element = node->ToElement();
+			if ( size > grain && element && element->FirstChild() && !SimpleText( element ) )
+			{
+				AddRun( &runFirst, &runLast, &runSize, depth );
+
+				// The printer's own code makes the tags, so they match.
+				tags.Clear();
+				tags.SetDepth( depth );
+				tags.VisitEnter( *element, element->FirstAttribute() );
+				AddText( tags.TakeStr() );
+
+				Split( element->FirstChild(), element->LastChild(), depth + 1 );
+
+				tags.Clear();
+				tags.SetDepth( depth + 1 );
+				tags.VisitExit( *element );
+				AddText( tags.TakeStr() );
+				continue;
+			}
+
+			if ( !runFirst )
+				runFirst = node;
+			runLast = node;
+			runSize += size;
+			if ( runSize >= grain )
+				AddRun( &runFirst, &runLast, &runSize, depth );
+		}
+		AddRun( &runFirst, &runLast, &runSize, depth );
+	}
+
+	// Printed on the start tag's line; never split.
+	static bool SimpleText( const TiXmlElement* element )
+	{
+		const TiXmlText* text = element->FirstChild()->ToText();
+		return text && element->FirstChild() == element->LastChild() && !text->CDATA();
+	}
+
+	void AddRun( const TiXmlNode** first, const TiXmlNode** last, size_t* size, int depth )
+	{
+		if ( !*first )
+			return;
+		Piece piece = { *first, *last, depth, false, std::string() };
+		pieces->push_back( std::move( piece ) );
+		*first = *last = 0;
+		*size = 0;
+	}
+
+	void AddText( std::string&& text )
+	{
+		Piece piece = { 0, 0, 0, true, std::move( text ) };
+		pieces->push_back( std::move( piece ) );
+	}
+
+	const std::string& indent;
+	const std::string& lineBreak;
+	size_t grain;
+	std::vector< Piece >* pieces;
+	TiXmlPrinter tags;
+	std::unordered_map< const TiXmlNode*, size_t > large;	// subtrees over a grain, from Measure()
+};
+
+
+// The nodes of the siblings first..last and everything under them,
+// counting no further than 'limit'. Sets 'whole' to the number of
+// siblings counted to the end.
+size_t CountUpTo( const TiXmlNode* first, const TiXmlNode* last, size_t limit, size_t* whole = 0 )
+{
+	size_t count = 0;
+	size_t siblings = 0;
+	const TiXmlNode* node = first;
+	while ( node && count < limit )
+	{
+		++count;
+		if ( node->FirstChild() )
+		{
+			node = node->FirstChild();
+			continue;
+		}
+		while ( node->Parent() != first->Parent() && !node->NextSibling() )
+			node = node->Parent();
+		if ( node->Parent() == first->Parent() )
+		{
+			++siblings;
+			node = ( node == last ) ? 0 : node->NextSibling();
+		}
+		else
+		{
+			node = node->NextSibling();
+		}
+	}
+	if ( whole )
+		*whole = siblings;
+	return count;
+}
+
+
+// Appends 'index' to a task's place, so that places sort by index.
+void AppendIndex( std::string* place, unsigned index )
+{
+	for( int shift = 24; shift >= 0; shift -= 8 )
+		place->push_back( char( ( index >> shift ) & 0xff ) );
+}
+
+
+// What one TiXmlParallelTraversal::Run() shares between its threads.
+class Traversal
+{
+public:
+	// A run of siblings to visit. The pieces cut from one run share a
+	// base, and are numbered along it, so that the places of the tasks
+	// sort into document order.
+	struct Task
+	{
+		const TiXmlNode* first;
+		const TiXmlNode* last;
+		std::string base;
+		unsigned index;
+
+		std::string Place() const		{ std::string place = base; AppendIndex( &place, index ); return place; }
+	};
+
+	// A visitor, and the place of the task that used it.
+	struct Part
+	{
+		std::string place;
+		std::unique_ptr< TiXmlVisitor > visitor;
+	};
+
+	Traversal( int threads, size_t _grain, const std::function< std::unique_ptr< TiXmlVisitor >() >& _copy )
+		: grain( _grain ), copy( _copy ), queues( threads ), parts( threads ), pending( 0 ), queued( 0 ) {}
+
+	void Push( int worker, const TiXmlNode* first, const TiXmlNode* last, const std::string& base, unsigned index )
+	{
+		++pending;
+		{
+			Queue& queue = queues[ worker ];
+			std::lock_guard< std::mutex > lock( queue.mutex );
+			queue.tasks.push_back( Task{ first, last, base, index } );
+		}
+		++queued;
+		std::lock_guard< std::mutex > lock( idle );
+		wake.notify_one();
+	}
+
+	// Take tasks, the newest from this worker's own queue first, else
+	// the oldest (so the biggest) from another's, until all are done.
+	void Work( int worker )
+	{
+		const int count = (int) queues.size();
+		for( ;; )
+		{
+			Task task;
+			bool found = Pop( &queues[ worker ], true, &task );
+			for( int i = 1; i < count && !found; ++i )
+				found = Pop( &queues[ ( worker + i ) % count ], false, &task );
+			if ( found )
+			{
+				--queued;
+				Execute( worker, std::move( task ) );
+				if ( --pending == 0 )
+				{
+					std::lock_guard< std::mutex > lock( idle );
+					wake.notify_all();
+				}
+				continue;
+			}
+
+			// Nothing to steal: sleep until there is, or all is done.
+			std::unique_lock< std::mutex > lock( idle );
+			wake.wait( lock, [this]() { return queued.load() > 0 || pending.load() == 0; } );
+			if ( pending.load() == 0 )
+				return;
+		}
+	}
+
+	// All the parts, in document order.
+	void Collect( std::vector< std::unique_ptr< TiXmlVisitor > >* copies )
+	{
+		std::vector< Part > all;
+		for( std::vector< Part >& own : parts )
+			std::move( own.begin(), own.end(), std::back_inserter( all ) );
+		std::sort( all.begin(), all.end(), []( const Part& a, const Part& b ) { return a.place < b.place; } );
+		for( Part& part : all )
+			copies->push_back( std::move( part.visitor ) );
+	}
+
+private:
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque< Task > tasks;
+	};
+
+	static bool Pop( Queue* queue, bool own, Task* task )
+	{
+		std::lock_guard< std::mutex > lock( queue->mutex );
+		if ( queue->tasks.empty() )
+			return false;
+		if ( own )
+		{
+			*task = std::move( queue->tasks.back() );
+			queue->tasks.pop_back();
+		}
+		else
+		{
+			*task = std::move( queue->tasks.front() );
+			queue->tasks.pop_front();
+		}
+		return true;
+	}
+
+	void Execute( int worker, Task&& task )
+	{
+		// Runs of up to two grains are visited as they are. From a bigger
+		// one, the siblings counted so far are cut off in two pieces of
+		// about a grain, and the rest goes back as one task, to be sized
+		// when it is taken. A first sibling too big by itself goes alone.
+		size_t whole = 0;
+		if ( !task.first->FirstChild() && task.first == task.last )
+		{
+			Visit( worker, std::move( task ) );
+		}
+		else if ( CountUpTo( task.first, task.last, 2 * grain, &whole ) < 2 * grain )
+		{
+			Visit( worker, std::move( task ) );
+		}
+		else if ( task.first == task.last )
+		{
+			Split( worker, std::move( task ) );
+		}
+		else
+		{
+			const size_t per = std::max( whole / 2, (size_t) 1 );
+			const TiXmlNode* node = task.first;
+			for( int piece = 0; piece < 2 && whole > 0; ++piece )
+			{
+				const TiXmlNode* first = node;
+				const size_t count = std::min( per, whole );
+				for( size_t i = 1; i < count; ++i )
+					node = node->NextSibling();
+				whole -= count;
+				Push( worker, first, node, task.base, task.index++ );
+				node = ( node == task.last ) ? 0 : node->NextSibling();
+			}
+			if ( node == task.first )
+			{
+				Push( worker, node, node, task.base, task.index++ );
+				node = ( node == task.last ) ? 0 : node->NextSibling();
+			}
+			if ( node )
+				Push( worker, node, task.last, task.base, task.index );
+		}
+	}
+
+	// One node, too big for a task: it gets a visitor of its own, and
+	// its children become a task.
+	void Split( int worker, Task&& task )
+	{
+		std::unique_ptr< TiXmlVisitor > visitor = copy();
+		const TiXmlNode* node = task.first;
+		bool enter;
+		if ( const TiXmlElement* element = node->ToElement() )
+			enter = visitor->VisitEnter( *element, element->FirstAttribute() );
+		else
+			enter = visitor->VisitEnter( *node->ToDocument() );
+		const std::string place = task.Place();
+		if ( enter )
+			Push( worker, node->FirstChild(), node->LastChild(), place + '\1', 0 );
+		if ( const TiXmlElement* element = node->ToElement() )
+			visitor->VisitExit( *element );
+		else
+			visitor->VisitExit( *node->ToDocument() );
+		parts[ worker ].push_back( Part{ place + '\0', std::move( visitor ) } );
+	}
+
+	void Visit( int worker, Task&& task )
+	{
+		std::unique_ptr< TiXmlVisitor > visitor = copy();
+		for( const TiXmlNode* node = task.first; node; node = ( node == task.last ) ? 0 : node->NextSibling() )
+		{
+			if ( !node->Accept( visitor.get() ) )
+				break;
+		}
+		parts[ worker ].push_back( Part{ task.Place(), std::move( visitor ) } );
+	}
+
+	const size_t grain;
+	const std::function< std::unique_ptr< TiXmlVisitor >() >& copy;
+	std::vector< Queue > queues;					// one per worker
+	std::vector< std::vector< Part > > parts;		// one per worker
+	std::atomic< size_t > pending;					// tasks pushed and not yet done
+	std::atomic< size_t > queued;					// tasks pushed and not yet taken
+	std::mutex idle;
+	std::condition_variable wake;					// a task was pushed, or the last one done
+};
+
+} // namespace
+
+
+TiXmlParallelPrinter::TiXmlParallelPrinter( int _threads )
+	: threads( _threads ), grain( DEFAULT_GRAIN ), indent( "    " ), lineBreak( "\n" )
+{
+	if ( threads <= 0 )
+		threads = std::max( 1, (int) std::thread::hardware_concurrency() );
+}
+
+
+bool TiXmlParallelPrinter::Print( const TiXmlNode& node, TiXmlOutputSink* sink )
+{
+	if ( threads == 1 )
+	{
+		TiXmlPrinter printer( sink );
+		printer.SetIndent( indent );
+		printer.SetLineBreak( lineBreak );
+		node.Accept( &printer );
+		return sink->Flush();
+	}
+
+	std::vector< Piece > pieces;
+	Splitter splitter( indent, lineBreak, grain, &pieces );
+	if ( node.ToDocument() )
+	{
+		if ( node.FirstChild() )
+			splitter.Cut( node.FirstChild(), node.LastChild() );
+	}
+	else
+	{
+		splitter.Cut( &node, &node );
+	}
+
+	// Workers take the pieces in order, but stay within a window of the
+	// one being written, so only so much output is held at once.
+	const size_t window = 4 * threads;
+	size_t next = 0;
+	size_t written = 0;
+	bool stop = false;
+	std::mutex mutex;
+	std::condition_variable ready;		// a piece is done
+	std::condition_variable room;		// a piece was written, or stop
+
+	auto work = [&]() {
+		TiXmlPrinter printer;
+		printer.SetIndent( indent );
+		printer.SetLineBreak( lineBreak );
+		for( ;; )
+		{
+			size_t i;
+			{
+				std::unique_lock< std::mutex > lock( mutex );
+				while ( next < pieces.size() && pieces[ next ].done )
+					++next;
+				if ( next >= pieces.size() || stop )
+					return;
+				i = next++;
+				room.wait( lock, [&]() { return stop || i < written + window; } );
+				if ( stop )
+					return;
+			}
+
+			Piece& piece = pieces[i];
+			printer.Clear();
+			printer.SetDepth( piece.depth );
+			for( const TiXmlNode* n = piece.first; n; n = ( n == piece.last ) ? 0 : n->NextSibling() )
+				n->Accept( &printer );
+			std::string text = printer.TakeStr();
+
+			std::lock_guard< std::mutex > lock( mutex );
+			piece.text = std::move( text );
+			piece.done = true;
+			ready.notify_all();
+		}
+	};
+
+	std::vector< std::thread > workers;
+	int count = (int) std::min( (size_t) threads, pieces.size() );
+	for( int i=0; i<count; ++i )
+		workers.emplace_back( work );
+
+	for( size_t i=0; i<pieces.size(); ++i )
+	{
+		std::string text;
+		{
+			std::unique_lock< std::mutex > lock( mutex );
+			ready.wait( lock, [&]() { return pieces[i].done; } );
+			text.swap( pieces[i].text );
+		}
+		sink->Write( text.data(), text.size() );
+
+		std::lock_guard< std::mutex > lock( mutex );
+		written = i + 1;
+		if ( !sink->Good() )
+			stop = true;
+		room.notify_all();
+		if ( stop )
+			break;
+	}
+
+	for( size_t i=0; i<workers.size(); ++i )
+		workers[i].join();
+	return sink->Flush();
+}
+
+
+TiXmlParallelTraversal::TiXmlParallelTraversal( int _threads )
+	: threads( _threads ), grain( DEFAULT_GRAIN ), serialLimit( DEFAULT_SERIAL_LIMIT ), tasks( 0 )
+{
+	if ( threads <= 0 )
+		threads = std::max( 1, (int) std::thread::hardware_concurrency() );
+}
+
+
+bool TiXmlParallelTraversal::Run( const TiXmlNode& node, const Copier& copy, std::vector< std::unique_ptr< TiXmlVisitor > >* copies )
+{
+	tasks = 0;
+	if ( threads == 1 || CountUpTo( &node, &node, serialLimit ) < serialLimit )
+		return false;
+
+	Traversal traversal( threads, grain, copy );
+	traversal.Push( 0, &node, &node, std::string(), 0 );
+	std::vector< std::thread > workers;
+	for( int i=1; i<threads; ++i )
+		workers.emplace_back( [&traversal, i]() { traversal.Work( i ); } );
+	traversal.Work( 0 );
+	for( size_t i=0; i<workers.size(); ++i )
+		workers[i].join();
+
+	traversal.Collect( copies );
+	tasks = copies->size();
+	return true;
+}
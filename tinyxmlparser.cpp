@@ -24,9 +24,7 @@ distribution.
 
 #include "tinyxml.h"
 
-#include <regex>
-#include <functional>
-#include <unordered_map>
+#include <cstring>
 
 //#include <ctype.h>
 //#include <stddef.h>
@@ -219,7 +217,7 @@ void TiXmlParsingData::Stamp( string::const_iterator first, std::string::const_i
 	while ( p < first )
 	{
 		// Treat p as unsigned, so we have a happy compiler.
-		auto pU = p;
+		const unsigned char* pU = (const unsigned char*) &*p;
 
 		// Code contributed by Fletcher Dunn: (modified by lee)
 		switch (*pU) {
@@ -293,7 +291,7 @@ void TiXmlParsingData::Stamp( string::const_iterator first, std::string::const_i
 				if ( encoding == TIXML_ENCODING_UTF8 )
 				{
 					// Eat the 1 to 4 byte utf8 character.
-					int step = TiXmlBase::utf8ByteTable[*(p)];
+					int step = TiXmlBase::utf8ByteTable[*(pU)];
 					if ( step == 0 )
 						step = 1;		// Error case from bad encoding, but handle gracefully.
 					p += step;
@@ -320,14 +318,8 @@ void TiXmlParsingData::Stamp( string::const_iterator first, std::string::const_i
 
 std::string::const_iterator TiXmlBase::SkipWhiteSpace( std::string::const_iterator first, std::string::const_iterator last)
 {
-	smatch m;
-	regex re("^[\\s]*");
-	auto res = regex_search(first, last, m, re);
-	if (!res)
-		return last;
-	first = m[0].second;
-	//while (first!=last && IsWhiteSpace(*first))
-	//	++first;
+	while (first!=last && IsWhiteSpace(*first))
+		++first;
 	return first;
 }
 
@@ -379,61 +371,92 @@ std::string::const_iterator TiXmlBase::ReadName( std::string::const_iterator fir
 	// After that, they can be letters, underscores, numbers,
 	// hyphens, or colons. (Colons are valid only for namespaces,
 	// but tinyxml can't tell namespaces from names.)
-	regex re("[[:alpha:]_][[:alnum:]_\\-\\.:]*");
-	smatch m;
-	auto res = regex_search(first, last, m, re);
-	if (!res)
+	if (    first==last
+		 || !( IsAlpha( (unsigned char) *first, encoding ) || *first == '_' ) )
 		return last;
-	name = m[0].str();
-	first = m[0].second;
+
+	auto start = first;
+	while (		first!=last
+			&& (	IsAlphaNum( (unsigned char) *first, encoding ) 
+				 || *first == '_'
+				 || *first == '-'
+				 || *first == '.'
+				 || *first == ':' ) )
+	{
+		++first;
+	}
+	// assign() reuses the capacity 'name' already has, which keeps
+	// re-parsing into recycled nodes off the heap.
+	name.assign( start, first );
 	return first;
 }
 
-string::const_iterator TiXmlBase::GetEntity( std::string::const_iterator first, std::string::const_iterator last, char & value, int & length, TiXmlEncoding encoding )
+string::const_iterator TiXmlBase::GetEntity( std::string::const_iterator first, std::string::const_iterator last, char* value, int & length, TiXmlEncoding encoding )
 {
 	// Presume an entity, and pull it out.
-	regex re("^&(?:#(?:x([[:xdigit:]]+)|([[:digit:]]+))+|amp|lt|gt|quot|apos);");
-	smatch m;
-	auto res = regex_search(first, last, m, re);
-	if (!res)
-		return last;
-	if (m[1].matched)
-	{
-		auto ucs = stoul(m[1].str(),nullptr,16);
-		value = (char)ucs;
-		length = 1;
-	}
-	else if (m[2].matched)
+	assert( first!=last && *first == '&' );
+	length = 1;
+
+	if ( last-first > 2 && *(first+1) == '#' )
 	{
-		auto ucs = stoul(m[2].str());
-		value = (char)ucs;
-		length = 1;
+		// Numeric: &#xA9; or &#169;
+		unsigned long ucs = 0;
+		auto q = first+2;
+		auto digits = q;
+		if ( *q == 'x' )
+		{
+			digits = ++q;
+			for( ; q!=last && isxdigit( (unsigned char) *q ); ++q )
+			{
+				unsigned char c = (unsigned char) *q;
+				ucs = ucs * 16 + ( isdigit( c ) ? c - '0' : tolower( c ) - 'a' + 10 );
+			}
+		}
+		else
+		{
+			for( ; q!=last && isdigit( (unsigned char) *q ); ++q )
+				ucs = ucs * 10 + ( *q - '0' );
+		}
+		if ( q==digits || q==last || *q != ';' )
+			return last;
+		if ( encoding == TIXML_ENCODING_UTF8 )
+			ConvertUTF32ToUTF8( ucs, value, &length );
+		else
+			*value = (char)ucs;
+		return q+1;
 	}
-	else
+
+	// Now try to match it.
+	for( int i=0; i<NUM_ENTITY; ++i )
 	{
-		// Now try to match it.
-		unordered_map<string, char> entity = {
-		{ "&amp;", '&' },
-		{ "&lt;",   '<' },
-		{ "&gt;",   '>' },
-		{ "&quot;", '\"' },
-		{ "&apos;", '\'' } };
-		value = entity[m[0].str()];
-		length = 1;
+		if ( StringEqual( first, last, entity[i].str, false ) )
+		{
+			*value = entity[i].chr;
+			return first + entity[i].strLength;
+		}
 	}
-	return m[0].second;
+	return last;
 }
 
 
 bool TiXmlBase::StringEqual( std::string::const_iterator first, std::string::const_iterator last, const std::string & tag, bool ignoreCase )
 {
-	function<bool(char,char)> comp[] = 
+	return StringEqual( first, last, tag.c_str(), ignoreCase );
+}
+
+
+bool TiXmlBase::StringEqual( std::string::const_iterator first, std::string::const_iterator last, const char* tag, bool ignoreCase )
+{
+	assert( tag );
+	for( ; *tag; ++tag, ++first )
 	{
-		equal_to(),
-		[](char c1,char c2) {return std::tolower(c1) == tolower(c2); }
-	};
-	auto res = equal(first, first+std::min(int(last-first),(int)tag.size()), tag.begin(), tag.end(),comp[ignoreCase]);
-	return res;
+		if ( first==last )
+			return false;
+		if ( ignoreCase ? tolower( (unsigned char) *first ) != tolower( (unsigned char) *tag )
+						: *first != *tag )
+			return false;
+	}
+	return true;
 }
 
 std::string::const_iterator TiXmlBase::ReadText(std::string::const_iterator first,
@@ -632,11 +655,11 @@ std::string::const_iterator TiXmlDocument::Parse(std::string::const_iterator fir
 			TiXmlDeclaration* dec = node->ToDeclaration();
 			auto enc = dec->Encoding();
 
-			if (!enc.empty())
+			if ( enc.empty() )
 				encoding = TIXML_ENCODING_UTF8;
-			else if ( StringEqual( first,last , "UTF-8", true ) )
+			else if ( StringEqual( enc.begin(), enc.end(), "UTF-8", true ) )
 				encoding = TIXML_ENCODING_UTF8;
-			else if ( StringEqual( first,last , "UTF8", true ) )
+			else if ( StringEqual( enc.begin(), enc.end(), "UTF8", true ) )
 				encoding = TIXML_ENCODING_UTF8;	// incorrect, but be nice
 			else 
 				encoding = TIXML_ENCODING_LEGACY;
@@ -678,6 +701,7 @@ void TiXmlDocument::SetError( int err, std::string::const_iterator first, std::s
 TiXmlNode* TiXmlNode::Identify( std::string::const_iterator first, std::string::const_iterator last, TiXmlEncoding encoding )
 {
 	TiXmlNode* returnNode = 0;
+	TiXmlDocument* document = GetDocument();
 
 	first = SkipWhiteSpace( first,last);
 	if( first==last || *first != '<' )
@@ -709,21 +733,21 @@ TiXmlNode* TiXmlNode::Identify( std::string::const_iterator first, std::string::
 		#ifdef DEBUG_PARSER
 			TIXML_LOG( "XML parsing Declaration\n" );
 		#endif
-		returnNode = new TiXmlDeclaration();
+		returnNode = document ? document->NewNode( TINYXML_DECLARATION ) : new TiXmlDeclaration();
 	}
 	else if ( StringEqual( first,last , commentHeader, false ) )
 	{
 		#ifdef DEBUG_PARSER
 			TIXML_LOG( "XML parsing Comment\n" );
 		#endif
-		returnNode = new TiXmlComment();
+		returnNode = document ? document->NewNode( TINYXML_COMMENT ) : new TiXmlComment();
 	}
 	else if ( StringEqual( first,last , cdataHeader, false ) )
 	{
 		#ifdef DEBUG_PARSER
 			TIXML_LOG( "XML parsing CDATA\n" );
 		#endif
-		TiXmlText* text = new TiXmlText( "" );
+		TiXmlText* text = document ? document->NewNode( TINYXML_TEXT )->ToText() : new TiXmlText( "" );
 		text->SetCDATA( true );
 		returnNode = text;
 	}
@@ -732,7 +756,7 @@ TiXmlNode* TiXmlNode::Identify( std::string::const_iterator first, std::string::
 		#ifdef DEBUG_PARSER
 			TIXML_LOG( "XML parsing Unknown(1)\n" );
 		#endif
-		returnNode = new TiXmlUnknown();
+		returnNode = document ? document->NewNode( TINYXML_UNKNOWN ) : new TiXmlUnknown();
 	}
 	else if (    IsAlpha( *(first+1), encoding )
 			  || *(first+1) == '_' )
@@ -740,14 +764,14 @@ TiXmlNode* TiXmlNode::Identify( std::string::const_iterator first, std::string::
 		#ifdef DEBUG_PARSER
 			TIXML_LOG( "XML parsing Element\n" );
 		#endif
-		returnNode = new TiXmlElement( "" );
+		returnNode = document ? document->NewNode( TINYXML_ELEMENT ) : new TiXmlElement( "" );
 	}
 	else
 	{
 		#ifdef DEBUG_PARSER
 			TIXML_LOG( "XML parsing Unknown(2)\n" );
 		#endif
-		returnNode = new TiXmlUnknown();
+		returnNode = document ? document->NewNode( TINYXML_UNKNOWN ) : new TiXmlUnknown();
 	}
 
 	if ( returnNode )
@@ -982,21 +1006,26 @@ std::string::const_iterator TiXmlElement::Parse(std::string::const_iterator firs
 			// </foo > and
 			// </foo> 
 			// are both valid end tags.
-			regex re("^</([[:alpha:]_][[:alnum:]_\\-\\.:]*)[\\s]*>");
-			smatch m;
-			auto res = regex_search(first, last, m, re);
-			if (!res||value!=m[1].str())
+			auto endTag = first;
+			if ( StringEqual( endTag, last, "</", false ) )
 			{
-				if ( document ) document->SetError( TIXML_ERROR_READING_END_TAG, first,last , data, encoding );
-				return last;
+				endTag += 2;
+				if (    StringEqual( endTag, last, value, false )
+					 && ( endTag += value.size() ) != last
+					 && ( *endTag == '>' || IsWhiteSpace( *endTag ) ) )
+				{
+					endTag = SkipWhiteSpace( endTag, last );
+					if ( endTag!=last && *endTag == '>' )
+						return endTag+1;
+				}
 			}
-			first = m[0].second;
-			return first;
+			if ( document ) document->SetError( TIXML_ERROR_READING_END_TAG, first,last , data, encoding );
+			return last;
 		}
 		else
 		{
 			// Try to read an attribute:
-			TiXmlAttribute* attrib = new TiXmlAttribute();
+			TiXmlAttribute* attrib = document ? document->NewAttribute() : new TiXmlAttribute();
 			if ( !attrib )
 			{
 				return last;
@@ -1042,7 +1071,7 @@ std::string::const_iterator TiXmlElement::ReadValue( std::string::const_iterator
 		if ( *first != '<' )
 		{
 			// Take what we have, make a text element.
-			TiXmlText* textNode = new TiXmlText( "" );
+			TiXmlText* textNode = document ? document->NewNode( TINYXML_TEXT )->ToText() : new TiXmlText( "" );
 
 			if ( !textNode )
 			{
@@ -1062,6 +1091,8 @@ std::string::const_iterator TiXmlElement::ReadValue( std::string::const_iterator
 
 			if ( !textNode->Blank() )
 				LinkEndChild( textNode );
+			else if ( document )
+				document->RecycleNode( textNode );
 			else
 				delete textNode;
 		} 
@@ -1189,15 +1220,26 @@ void TiXmlComment::StreamIn( std::istream * in, std::string * tag )
 string::const_iterator TiXmlComment::Parse( std::string::const_iterator first, std::string::const_iterator last, TiXmlParsingData* data, TiXmlEncoding encoding )
 {
 	TiXmlDocument* document = GetDocument();
-	value = "";
-	regex re("(?:^|[\\s]*)<!--([\\S\\s]*?)-->");
-	smatch m;
-	auto res = regex_search(first, last, m, re);
-	if (!res)
+	value.clear();
+
+	first = SkipWhiteSpace( first, last );
+	if ( data )
+	{
+		data->Stamp( first, last, encoding );
+		location = data->Cursor();
+	}
+	if ( !StringEqual( first, last, "<!--", false ) )
 		return last;
-	value = m[1].str();
-	first = m[0].second;
-	return first;
+	first += 4;
+
+	auto start = first;
+	while ( first!=last && !StringEqual( first, last, "-->", false ) )
+		++first;
+	if ( first==last )
+		return last;
+
+	value.assign( start, first );
+	return first+3;
 }
 
 
@@ -1400,51 +1442,69 @@ string::const_iterator TiXmlDeclaration::Parse(std::string::const_iterator first
 		data->Stamp( first, last, _encoding  );
 		location = data->Cursor();
 	}
-	regex re(
-		"(?:^|[\\s]*)<\\?xml"
-		"(?:[\\s]+(version)[\\s]*=[\\s]*(?:(?:\"([^\"]*)\")|(?:\'([^\']*)\')))"
-		"(?:[\\s]+(encoding)[\\s]*=[\\s]*(?:(?:\"([^\"]*)\")|(?:\'([^\']*)\')))?"
-		"(?:[\\s]+(standalone)[\\s]*=[\\s]*(?:(?:\"[^\"]*\")|(?:\'([^\']*)\')))?"
-		"[\\s]*\\??>",regex::icase
-	);
-	smatch m;
-	auto res = regex_search(first, last, m, re);
-	if (!res)
-		return last;
-	first =m[0].second;
+	first += 5;
 
-	version = "";
-	encoding = "";
-	standalone = "";
-	if (m[1].matched)
-	{
-		if (m[2].matched)
-			version = m[2].str();
-		else if (m[3].matched)
-			version = m[3].str();
-	}
-	if (m[1].matched)
-	{
-		if (m[2].matched)
-			version = m[2].str();
-		else if (m[3].matched)
-			version = m[3].str();
-	}
-	if (m[4].matched)
-	{
-		if (m[5].matched)
-			encoding = m[5].str();
-		else if (m[6].matched)
-			encoding = m[6].str();
-	}
-	if (m[7].matched)
+	version.clear();
+	encoding.clear();
+	standalone.clear();
+
+	while ( first!=last )
 	{
-		if (m[8].matched)
-			encoding = m[8].str();
-		else if (m[9].matched)
-			encoding = m[9].str();
+		// We expect whitespace before each attribute, but are tolerant.
+		first = SkipWhiteSpace( first, last );
+		if ( first==last )
+			break;
+		if ( *first == '>' )
+			return first+1;
+		if ( *first == '?' )
+		{
+			++first;
+			continue;
+		}
+
+		std::string* target = 0;
+		if ( StringEqual( first, last, "version", true ) )
+		{
+			target = &version;
+			first += 7;
+		}
+		else if ( StringEqual( first, last, "encoding", true ) )
+		{
+			target = &encoding;
+			first += 8;
+		}
+		else if ( StringEqual( first, last, "standalone", true ) )
+		{
+			target = &standalone;
+			first += 10;
+		}
+		else
+		{
+			// Read over whatever it is.
+			while( first!=last && !IsWhiteSpace( *first ) && *first != '>' && *first != '?' )
+				++first;
+			continue;
+		}
+
+		first = SkipWhiteSpace( first, last );
+		if ( first==last || *first != '=' )
+			break;
+		first = SkipWhiteSpace( first+1, last );
+		if ( first==last || ( *first != '\"' && *first != '\'' ) )
+			break;
+
+		const char quote = *first;
+		auto start = ++first;
+		while ( first!=last && *first != quote )
+			++first;
+		if ( first==last )
+			break;
+		target->assign( start, first );
+		++first;
 	}
-	return first;
+
+	if ( document ) document->SetError( TIXML_ERROR_PARSING_DECLARATION, first, last, data, _encoding );
+	return last;
 }
 
 bool TiXmlText::Blank() const
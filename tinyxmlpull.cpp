@@ -0,0 +1,363 @@
+/*
+www.sourceforge.net/projects/tinyxml
+Original code by Lee Thomason (www.grinninglizard.com)
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must
+not claim that you wrote the original software. If you use this
+software in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+
+#include "tinyxml.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+TiXmlPullParser::TiXmlPullParser( const std::string& xml )
+	: in( 0 ), blockSize( 0 ), text( &xml ), pos( 0 ), event( PULL_BEGIN ),
+	  cdata( false ), emptyElement( false ), depth( 0 ), attributeCount( 0 ),
+	  encoding( TIXML_ENCODING_UNKNOWN ), started( false ), rootSeen( false ), errorId( 0 )
+{
+}
+
+
+TiXmlPullParser::TiXmlPullParser( std::istream* _in, size_t _blockSize )
+	: in( _in ), blockSize( _blockSize ? _blockSize : 1 ), text( &buffer ), pos( 0 ), event( PULL_BEGIN ),
+	  cdata( false ), emptyElement( false ), depth( 0 ), attributeCount( 0 ),
+	  encoding( TIXML_ENCODING_UNKNOWN ), started( false ), rootSeen( false ), errorId( 0 )
+{
+}
+
+
+const char* TiXmlPullParser::ErrorDesc() const
+{
+	return TiXmlBase::errorString[ errorId ];
+}
+
+
+TiXmlPullParser::Event TiXmlPullParser::Fail( int error )
+{
+	if ( !errorId )
+		errorId = error;
+	return event = PULL_ERROR;
+}
+
+
+bool TiXmlPullParser::Fill()
+{
+	if ( !in || !in->good() )
+		return false;
+
+	// Drop what has been read; the block goes after what hasn't.
+	buffer.erase( 0, pos );
+	pos = 0;
+	size_t size = buffer.size();
+	buffer.resize( size + blockSize );
+	in->read( &buffer[ size ], blockSize );
+	buffer.resize( size + (size_t) in->gcount() );
+	return buffer.size() > size;
+}
+
+
+size_t TiXmlPullParser::Ensure( size_t n )
+{
+	while ( text->size() - pos < n && Fill() )
+		;
+	return text->size() - pos;
+}
+
+
+size_t TiXmlPullParser::Find( const char* terminator, size_t from )
+{
+	size_t length = strlen( terminator );
+	for( ;; )
+	{
+		size_t at = text->find( terminator, pos + from, length );
+		if ( at != std::string::npos )
+			return at - pos;
+
+		// The terminator may straddle the end of what there is.
+		size_t have = text->size() - pos;
+		from = ( have >= length ) ? have - length + 1 : 0;
+		if ( !Fill() )
+			return std::string::npos;
+	}
+}
+
+
+// The '>' of a tag, skipping any inside quoted attribute values.
+size_t TiXmlPullParser::FindTagEnd()
+{
+	char quote = 0;
+	for( size_t i=1; ; ++i )
+	{
+		if ( pos + i >= text->size() && !Fill() )
+			return std::string::npos;
+
+		char c = (*text)[ pos + i ];
+		if ( quote )
+		{
+			if ( c == quote )
+				quote = 0;
+		}
+		else if ( c == '\"' || c == '\'' )
+			quote = c;
+		else if ( c == '>' )
+			return i;
+	}
+}
+
+
+const std::string* TiXmlPullParser::Attribute( std::string_view _name ) const
+{
+	for( size_t i=0; i<attributeCount; ++i )
+	{
+		if ( attributeNames[i] == _name )
+			return &attributeValues[i];
+	}
+	return 0;
+}
+
+
+void TiXmlPullParser::AddAttribute( const std::string& _name, const std::string& _value )
+{
+	if ( attributeCount == attributeNames.size() )
+	{
+		attributeNames.emplace_back();
+		attributeValues.emplace_back();
+	}
+	attributeNames[ attributeCount ] = _name;
+	attributeValues[ attributeCount ] = _value;
+	++attributeCount;
+}
+
+
+TiXmlPullParser::Event TiXmlPullParser::Next()
+{
+	if ( event == PULL_ERROR || event == PULL_END )
+		return event;
+
+	attributeCount = 0;
+	if ( emptyElement )
+	{
+		emptyElement = false;
+		--depth;
+		return event = PULL_END_ELEMENT;
+	}
+
+	if ( !started )
+	{
+		started = true;
+		Ensure( 3 );
+		if ( text->compare( pos, 3, "\xef\xbb\xbf" ) == 0 )
+		{
+			encoding = TIXML_ENCODING_UTF8;
+			pos += 3;
+		}
+	}
+
+	for( ;; )
+	{
+		if ( Ensure( 1 ) == 0 )
+		{
+			if ( depth )
+				return Fail( TiXmlBase::TIXML_ERROR_READING_END_TAG );
+			if ( !rootSeen )
+				return Fail( TiXmlBase::TIXML_ERROR_DOCUMENT_EMPTY );
+			return event = PULL_END;
+		}
+
+		std::string::const_iterator first = text->begin() + pos;
+		if ( *first != '<' )
+		{
+			// Text, up to the next tag or the end of the input.
+			size_t end = Find( "<", 0 );
+			if ( end == std::string::npos )
+				end = text->size() - pos;
+			first = text->begin() + pos;
+			std::string::const_iterator last = first + end;
+
+			bool blank = true;
+			for( std::string::const_iterator p = first; blank && p != last; ++p )
+				blank = TiXmlBase::IsWhiteSpace( *p );
+			pos += end;
+			if ( blank )
+				continue;
+			if ( !depth )
+				return Fail( TiXmlBase::TIXML_ERROR_PARSING_ELEMENT );
+
+			// ReadText() stops at the '<', so hand it one; it is not consumed.
+			TiXmlBase::ReadText( first, ( pos < text->size() ) ? last + 1 : last, value, true, "<", false, encoding );
+			cdata = false;
+			return event = PULL_TEXT;
+		}
+
+		Ensure( 9 );
+		first = text->begin() + pos;
+		std::string::const_iterator last = text->end();
+		if ( TiXmlBase::StringEqual( first, last, "<!--", false ) )
+		{
+			size_t end = Find( "-->", 4 );
+			if ( end == std::string::npos )
+				return Fail( TiXmlBase::TIXML_ERROR_PARSING_COMMENT );
+			value.assign( text->begin() + pos + 4, text->begin() + pos + end );
+			pos += end + 3;
+			return event = PULL_COMMENT;
+		}
+		if ( TiXmlBase::StringEqual( first, last, "<![CDATA[", false ) )
+		{
+			size_t end = Find( "]]>", 9 );
+			if ( end == std::string::npos || !depth )
+				return Fail( TiXmlBase::TIXML_ERROR_PARSING_CDATA );
+			value.assign( text->begin() + pos + 9, text->begin() + pos + end );
+			pos += end + 3;
+			cdata = true;
+			return event = PULL_TEXT;
+		}
+
+		size_t end = FindTagEnd();
+		if ( end == std::string::npos )
+			return Fail( TiXmlBase::TIXML_ERROR_PARSING_ELEMENT );
+		first = text->begin() + pos;
+
+		if ( TiXmlBase::StringEqual( first, text->end(), "<?xml", true ) )
+			return ReadDeclaration( end );
+		if ( TiXmlBase::StringEqual( first, text->end(), "</", false ) )
+			return ReadEndTag( end );
+		if ( end > 1 && ( TiXmlBase::IsAlpha( (unsigned char) first[1], encoding ) || first[1] == '_' ) )
+			return ReadStartTag( end );
+
+		// <!DOCTYPE ...> and the like, kept as TiXmlUnknown keeps them.
+		value.assign( first + 1, first + end );
+		pos += end + 1;
+		return event = PULL_UNKNOWN;
+	}
+}
+
+
+TiXmlPullParser::Event TiXmlPullParser::ReadDeclaration( size_t end )
+{
+	std::string::const_iterator first = text->begin() + pos;
+	declaration.Parse( first, first + end + 1, 0, encoding );
+	pos += end + 1;
+
+	AddAttribute( "version", declaration.Version() );
+	AddAttribute( "encoding", declaration.Encoding() );
+	AddAttribute( "standalone", declaration.Standalone() );
+	if ( encoding == TIXML_ENCODING_UNKNOWN )
+	{
+		const std::string& enc = declaration.Encoding();
+		encoding = (    enc.empty()
+					 || TiXmlBase::StringEqual( enc, "UTF-8", true )
+					 || TiXmlBase::StringEqual( enc, "UTF8", true ) ) ? TIXML_ENCODING_UTF8 : TIXML_ENCODING_LEGACY;
+	}
+	return event = PULL_DECLARATION;
+}
+
+
+TiXmlPullParser::Event TiXmlPullParser::ReadStartTag( size_t end )
+{
+	std::string::const_iterator first = text->begin() + pos + 1;
+	std::string::const_iterator last = text->begin() + pos + end;		// at the '>'
+
+	// Next() checked the name starts well, so there is one.
+	first = TiXmlBase::ReadName( first, last, name, encoding );
+
+	// The attributes, as TiXmlAttribute::Parse() reads them.
+	for( ;; )
+	{
+		first = TiXmlBase::SkipWhiteSpace( first, last );
+		if ( first == last )
+			break;
+		if ( *first == '/' )
+		{
+			if ( first + 1 != last )
+				return Fail( TiXmlBase::TIXML_ERROR_PARSING_EMPTY );
+			emptyElement = true;
+			break;
+		}
+
+		if ( attributeCount == attributeNames.size() )
+		{
+			attributeNames.emplace_back();
+			attributeValues.emplace_back();
+		}
+		std::string& attributeName = attributeNames[ attributeCount ];
+		std::string& attributeValue = attributeValues[ attributeCount ];
+		first = TiXmlBase::ReadName( first, last, attributeName, encoding );
+		if ( first != last )
+			first = TiXmlBase::SkipWhiteSpace( first, last );
+		if ( first == last || *first != '=' )
+			return Fail( TiXmlBase::TIXML_ERROR_READING_ATTRIBUTES );
+		first = TiXmlBase::SkipWhiteSpace( first + 1, last );
+		if ( first == last || ( *first != '\"' && *first != '\'' ) )
+			return Fail( TiXmlBase::TIXML_ERROR_READING_ATTRIBUTES );
+
+		const char quote[2] = { *first, 0 };
+		std::string::const_iterator close = std::find( first + 1, last, *first );
+		if ( close == last )
+			return Fail( TiXmlBase::TIXML_ERROR_READING_ATTRIBUTES );
+		TiXmlBase::ReadText( first + 1, close + 1, attributeValue, false, quote, false, encoding );
+		first = close + 1;
+
+		if ( Attribute( attributeName ) )
+			return Fail( TiXmlBase::TIXML_ERROR_PARSING_ELEMENT );
+		++attributeCount;
+	}
+
+	if ( depth == names.size() )
+		names.emplace_back();
+	names[ depth ] = name;
+	++depth;
+	rootSeen = true;
+	pos += end + 1;
+	return event = PULL_START_ELEMENT;
+}
+
+
+TiXmlPullParser::Event TiXmlPullParser::ReadEndTag( size_t end )
+{
+	std::string::const_iterator first = text->begin() + pos + 2;
+	std::string::const_iterator last = text->begin() + pos + end;
+
+	first = TiXmlBase::ReadName( first, last, name, encoding );
+	if ( first != last )
+		first = TiXmlBase::SkipWhiteSpace( first, last );
+	if ( first != last || !depth || names[ depth - 1 ] != name )
+		return Fail( TiXmlBase::TIXML_ERROR_READING_END_TAG );
+
+	--depth;
+	pos += end + 1;
+	return event = PULL_END_ELEMENT;
+}
+
+
+bool TiXmlPullParser::SkipElement()
+{
+	if ( event != PULL_START_ELEMENT )
+		return false;
+	size_t level = depth;
+	while ( depth >= level )
+	{
+		Event e = Next();
+		if ( e == PULL_ERROR || e == PULL_END )
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,370 @@
+/*
+www.sourceforge.net/projects/tinyxml
+Original code by Lee Thomason (www.grinninglizard.com)
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must
+not claim that you wrote the original software. If you use this
+software in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+
+
+#include "tinyxml.h"
+
+#include <algorithm>
+#include <thread>
+#include <unordered_set>
+
+
+namespace {
+
+// Text below this many bytes is tokenized on the calling thread.
+const size_t PARALLEL_BYTES = 1 << 16;
+
+
+bool IsWordByte( unsigned char c )
+{
+	return ( c >= '0' && c <= '9' ) || ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || c >= 0x80;
+}
+
+
+char Lower( char c )
+{
+	return ( c >= 'A' && c <= 'Z' ) ? char( c - 'A' + 'a' ) : c;
+}
+
+
+// Calls f( word, position, offset ) for each word of 'text', lower cased
+// into 'word'.
+template< typename F > void ForEachWord( std::string_view text, std::string* word, F f )
+{
+	unsigned position = 0;
+	size_t i = 0;
+	while ( i < text.size() )
+	{
+		if ( !IsWordByte( (unsigned char) text[ i ] ) )
+		{
+			++i;
+			continue;
+		}
+		const size_t start = i;
+		word->clear();
+		for( ; i < text.size() && IsWordByte( (unsigned char) text[ i ] ); ++i )
+			word->push_back( Lower( text[ i ] ) );
+		f( *word, position++, (unsigned) start );
+	}
+}
+
+
+// The text nodes under 'node', in document order.
+void CollectTexts( const TiXmlNode* node, std::vector< const TiXmlText* >* texts )
+{
+	const TiXmlNode* n = node;
+	while ( n )
+	{
+		if ( n->Type() == TiXmlNode::TINYXML_TEXT )
+			texts->push_back( static_cast< const TiXmlText* >( n ) );
+		if ( n->FirstChild() )
+		{
+			n = n->FirstChild();
+			continue;
+		}
+		while ( n != node && !n->NextSibling() )
+			n = n->Parent();
+		n = ( n == node ) ? 0 : n->NextSibling();
+	}
+}
+
+
+bool ByText( const TiXmlTextIndex::Posting& posting, unsigned text )
+{
+	return posting.text < text;
+}
+
+
+bool ByPlace( const TiXmlTextIndex::Posting& posting, const TiXmlTextIndex::Posting& place )
+{
+	return posting.text < place.text || ( posting.text == place.text && posting.position < place.position );
+}
+
+}	// namespace
+
+
+TiXmlTextIndex::TiXmlTextIndex( int _threads ) : threads( _threads ), stale( true )
+{
+	if ( threads <= 0 )
+		threads = std::max( 1, (int) std::thread::hardware_concurrency() );
+}
+
+
+void TiXmlTextIndex::Tokenize( std::string_view text, std::vector< std::string >* terms )
+{
+	std::string word;
+	ForEachWord( text, &word, [terms]( const std::string& w, unsigned, unsigned ) { terms->push_back( w ); } );
+}
+
+
+void TiXmlTextIndex::Add( const TiXmlText* text, unsigned number, Terms* into )
+{
+	std::string word;
+	ForEachWord( text->ValueStr(), &word, [into, number]( const std::string& w, unsigned position, unsigned offset ) {
+		( *into )[ w ].push_back( Posting{ number, position, offset } );
+	} );
+}
+
+
+void TiXmlTextIndex::Build( const TiXmlNode* node )
+{
+	terms.clear();
+	texts.clear();
+	numbers.clear();
+	stale = false;
+	if ( !node )
+		return;
+
+	CollectTexts( node, &texts );
+	numbers.reserve( texts.size() );
+	size_t bytes = 0;
+	for( unsigned i = 0; i < texts.size(); ++i )
+	{
+		numbers.emplace( texts[ i ], i );
+		bytes += texts[ i ]->ValueStr().size();
+	}
+
+	const size_t runs = std::min( (size_t) threads, texts.size() );
+	if ( runs <= 1 || bytes < PARALLEL_BYTES )
+	{
+		for( unsigned i = 0; i < texts.size(); ++i )
+			Add( texts[ i ], i, &terms );
+		return;
+	}
+
+	// Contiguous runs of about the same number of bytes, so that joining
+	// the runs' lists in order keeps every list in document order.
+	std::vector< unsigned > bounds( 1, 0 );
+	size_t sum = 0;
+	for( unsigned i = 0; i < texts.size() && bounds.size() < runs; ++i )
+	{
+		sum += texts[ i ]->ValueStr().size();
+		if ( sum * runs >= bytes * bounds.size() )
+			bounds.push_back( i + 1 );
+	}
+	bounds.push_back( (unsigned) texts.size() );
+
+	std::vector< Terms > local( bounds.size() - 1 );
+	std::vector< std::thread > workers;
+	for( size_t r = 1; r < local.size(); ++r )
+	{
+		workers.emplace_back( [this, &bounds, &local, r]() {
+			for( unsigned i = bounds[ r ]; i < bounds[ r + 1 ]; ++i )
+				Add( texts[ i ], i, &local[ r ] );
+		} );
+	}
+	for( unsigned i = bounds[ 0 ]; i < bounds[ 1 ]; ++i )
+		Add( texts[ i ], i, &local[ 0 ] );
+	for( std::thread& worker : workers )
+		worker.join();
+
+	terms = std::move( local[ 0 ] );
+	for( size_t r = 1; r < local.size(); ++r )
+	{
+		for( Terms::value_type& term : local[ r ] )
+		{
+			std::vector< Posting >& list = terms[ term.first ];
+			if ( list.empty() )
+				list = std::move( term.second );
+			else
+				list.insert( list.end(), term.second.begin(), term.second.end() );
+		}
+	}
+}
+
+
+const std::vector< TiXmlTextIndex::Posting >* TiXmlTextIndex::Postings( std::string_view term ) const
+{
+	Terms::const_iterator it = terms.find( std::string( term ) );
+	return ( it == terms.end() ) ? 0 : &it->second;
+}
+
+
+void TiXmlTextIndex::Select( std::string_view query, Match match, std::vector< unsigned >* out ) const
+{
+	out->clear();
+	std::vector< std::string > words;
+	Tokenize( query, &words );
+	if ( words.empty() )
+		return;
+
+	std::vector< const std::vector< Posting >* > lists;
+	for( const std::string& word : words )
+	{
+		const std::vector< Posting >* list = Postings( word );
+		if ( list )
+			lists.push_back( list );
+		else if ( match != MATCH_ANY )
+			return;
+	}
+
+	if ( match == MATCH_ANY )
+	{
+		for( const std::vector< Posting >* list : lists )
+		{
+			for( const Posting& posting : *list )
+			{
+				if ( out->empty() || out->back() != posting.text )
+					out->push_back( posting.text );
+			}
+		}
+		std::sort( out->begin(), out->end() );
+		out->erase( std::unique( out->begin(), out->end() ), out->end() );
+	}
+	else if ( match == MATCH_ALL )
+	{
+		// Walk the rarest term's texts, looking each up in the others.
+		std::sort( lists.begin(), lists.end(), []( const std::vector< Posting >* a, const std::vector< Posting >* b ) {
+			return a->size() < b->size();
+		} );
+		for( const Posting& posting : *lists[ 0 ] )
+		{
+			if ( !out->empty() && out->back() == posting.text )
+				continue;
+			bool all = true;
+			for( size_t i = 1; i < lists.size() && all; ++i )
+			{
+				std::vector< Posting >::const_iterator it = std::lower_bound( lists[ i ]->begin(), lists[ i ]->end(), posting.text, ByText );
+				all = ( it != lists[ i ]->end() && it->text == posting.text );
+			}
+			if ( all )
+				out->push_back( posting.text );
+		}
+	}
+	else
+	{
+		// Each place the rarest word occurs, look for the others around it.
+		size_t rarest = 0;
+		for( size_t i = 1; i < lists.size(); ++i )
+		{
+			if ( lists[ i ]->size() < lists[ rarest ]->size() )
+				rarest = i;
+		}
+		for( const Posting& posting : *lists[ rarest ] )
+		{
+			if ( posting.position < rarest || ( !out->empty() && out->back() == posting.text ) )
+				continue;
+			const unsigned start = posting.position - (unsigned) rarest;
+			bool all = true;
+			for( size_t i = 0; i < lists.size() && all; ++i )
+			{
+				if ( i == rarest )
+					continue;
+				const Posting place = { posting.text, start + (unsigned) i, 0 };
+				std::vector< Posting >::const_iterator it = std::lower_bound( lists[ i ]->begin(), lists[ i ]->end(), place, ByPlace );
+				all = ( it != lists[ i ]->end() && it->text == place.text && it->position == place.position );
+			}
+			if ( all )
+				out->push_back( posting.text );
+		}
+	}
+}
+
+
+size_t TiXmlTextIndex::Find( std::string_view query, Match match, std::vector< const TiXmlText* >* found ) const
+{
+	std::vector< unsigned > selected;
+	Select( query, match, &selected );
+	found->clear();
+	found->reserve( selected.size() );
+	for( unsigned number : selected )
+		found->push_back( texts[ number ] );
+	return found->size();
+}
+
+
+size_t TiXmlTextIndex::FindElements( std::string_view query, Match match, std::vector< const TiXmlElement* >* found ) const
+{
+	std::vector< unsigned > selected;
+	Select( query, match, &selected );
+	found->clear();
+	// Mixed content puts an element's texts apart from each other.
+	std::unordered_set< const TiXmlElement* > seen;
+	for( unsigned number : selected )
+	{
+		const TiXmlNode* parent = texts[ number ]->Parent();
+		const TiXmlElement* element = parent ? parent->ToElement() : 0;
+		if ( element && seen.insert( element ).second )
+			found->push_back( element );
+	}
+	return found->size();
+}
+
+
+void TiXmlTextIndex::Append( const TiXmlNode* node )
+{
+	if ( stale )
+		return;
+	const size_t first = texts.size();
+	CollectTexts( node, &texts );
+	for( size_t i = first; i < texts.size(); ++i )
+	{
+		numbers.emplace( texts[ i ], (unsigned) i );
+		Add( texts[ i ], (unsigned) i, &terms );
+	}
+}
+
+
+void TiXmlTextIndex::Changing( const TiXmlText* text )
+{
+	if ( stale )
+		return;
+	std::unordered_map< const TiXmlText*, unsigned >::const_iterator it = numbers.find( text );
+	if ( it == numbers.end() )
+		return;
+	const unsigned number = it->second;
+	std::string word;
+	ForEachWord( text->ValueStr(), &word, [this, number]( const std::string& w, unsigned, unsigned ) {
+		Terms::iterator term = terms.find( w );
+		if ( term == terms.end() )
+			return;
+		std::vector< Posting >& list = term->second;
+		std::vector< Posting >::iterator first = std::lower_bound( list.begin(), list.end(), number, ByText );
+		std::vector< Posting >::iterator last = first;
+		while ( last != list.end() && last->text == number )
+			++last;
+		list.erase( first, last );
+		if ( list.empty() )
+			terms.erase( term );
+	} );
+}
+
+
+void TiXmlTextIndex::Changed( const TiXmlText* text )
+{
+	if ( stale )
+		return;
+	std::unordered_map< const TiXmlText*, unsigned >::const_iterator it = numbers.find( text );
+	if ( it == numbers.end() )
+		return;
+	const unsigned number = it->second;
+	Terms added;
+	Add( text, number, &added );
+	for( Terms::value_type& term : added )
+	{
+		std::vector< Posting >& list = terms[ term.first ];
+		list.insert( std::lower_bound( list.begin(), list.end(), number, ByText ), term.second.begin(), term.second.end() );
+	}
+}
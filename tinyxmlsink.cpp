@@ -0,0 +1,119 @@
+/*
+www.sourceforge.net/projects/tinyxml
+Original code by Lee Thomason (www.grinninglizard.com)
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must
+not claim that you wrote the original software. If you use this
+software in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+
+#include "tinyxml.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <ostream>
+
+#if defined( _WIN32 )
+#	include <io.h>
+#else
+#	include <unistd.h>
+#endif
+
+
+TiXmlOutputSink::TiXmlOutputSink( size_t _capacity ) : out( &buffer ), capacity( _capacity ), good( true )
+{
+	// Room for a full buffer and the node that overflows it, usually.
+	buffer.reserve( capacity + capacity / 8 );
+}
+
+
+void TiXmlOutputSink::Write( const char* data, size_t size )
+{
+	if ( size < capacity )
+	{
+		out->append( data, size );
+		Poll();
+	}
+	else if ( Flush() )
+	{
+		good = Drain( data, size );
+	}
+}
+
+
+bool TiXmlOutputSink::Flush()
+{
+	if ( !out->empty() )
+	{
+		if ( good )
+			good = Drain( out->data(), out->size() );
+		out->clear();
+	}
+	return good;
+}
+
+
+bool TiXmlFdSink::Drain( const char* data, size_t size )
+{
+	// write() may take less than it was given, or be interrupted.
+	while ( size > 0 )
+	{
+#if defined( _WIN32 )
+		unsigned chunk = size > 0x40000000 ? 0x40000000 : (unsigned) size;
+		int n = _write( fd, data, chunk );
+#else
+		ssize_t n = write( fd, data, size );
+		if ( n < 0 && errno == EINTR )
+			continue;
+#endif
+		if ( n <= 0 )
+			return false;
+		data += n;
+		size -= (size_t) n;
+	}
+	return true;
+}
+
+
+bool TiXmlFileSink::Drain( const char* data, size_t size )
+{
+	return fwrite( data, 1, size, file ) == size;
+}
+
+
+bool TiXmlFileSink::Flush()
+{
+	bool ok = TiXmlOutputSink::Flush();
+	return fflush( file ) == 0 && ok;
+}
+
+
+bool TiXmlStreamSink::Drain( const char* data, size_t size )
+{
+	stream.write( data, (std::streamsize) size );
+	return !stream.fail();
+}
+
+
+bool TiXmlStreamSink::Flush()
+{
+	bool ok = TiXmlOutputSink::Flush();
+	stream.flush();
+	return !stream.fail() && ok;
+}
@@ -0,0 +1,274 @@
+/*
+www.sourceforge.net/projects/tinyxml
+Original code by Lee Thomason (www.grinninglizard.com)
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must
+not claim that you wrote the original software. If you use this
+software in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+
+#include "tinyxml.h"
+
+#include <string>
+
+
+namespace {
+
+// Bytes above 127 are let through: they are parts of UTF-8 characters,
+// most of which are name characters.
+bool IsNameStart( unsigned char c )
+{
+	return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || c == '_' || c == ':' || c >= 0x80;
+}
+
+bool IsNameChar( unsigned char c )
+{
+	return IsNameStart( c ) || ( c >= '0' && c <= '9' ) || c == '-' || c == '.';
+}
+
+bool IsName( const std::string& name )
+{
+	if ( name.empty() || !IsNameStart( (unsigned char) name[0] ) )
+		return false;
+	for( size_t i=1; i<name.size(); ++i )
+	{
+		if ( !IsNameChar( (unsigned char) name[i] ) )
+			return false;
+	}
+	return true;
+}
+
+} // namespace
+
+
+TiXmlStreamWriter::TiXmlStreamWriter( TiXmlOutputSink* _sink )
+	: sink( _sink ), indent( "    " ), lineBreak( "\n" ), depth( 0 ), attributeCount( 0 ),
+	  startOpen( false ), inlineText( false ), begun( false ), rootSeen( false ), good( true )
+{
+}
+
+
+void TiXmlStreamWriter::DoIndent( std::string& out, size_t level )
+{
+	for( size_t i=0; i<level; ++i )
+		out += indent;
+}
+
+
+void TiXmlStreamWriter::BeginContent( std::string& out, bool text )
+{
+	if ( startOpen )
+	{
+		// Text right after the start tag stays on its line, as the
+		// printer does for an element holding just text.
+		out += '>';
+		if ( !text )
+			out += lineBreak;
+		startOpen = false;
+		inlineText = text;
+	}
+	else if ( inlineText && !text )
+	{
+		out += lineBreak;
+		inlineText = false;
+	}
+}
+
+
+bool TiXmlStreamWriter::PushDeclaration( const std::string& version, const std::string& encoding, const std::string& standalone )
+{
+	if ( !good || begun )
+		return Fail();
+	begun = true;
+
+	std::string& out = sink->Buffer();
+	out += "<?xml ";
+	if ( !version.empty() ) {
+		out += "version=\"";
+		out += version;
+		out += "\" ";
+	}
+	if ( !encoding.empty() ) {
+		out += "encoding=\"";
+		out += encoding;
+		out += "\" ";
+	}
+	if ( !standalone.empty() ) {
+		out += "standalone=\"";
+		out += standalone;
+		out += "\" ";
+	}
+	out += "?>";
+	out += lineBreak;
+	sink->Poll();
+	return true;
+}
+
+
+bool TiXmlStreamWriter::OpenElement( const std::string& name )
+{
+	if ( !good || !IsName( name ) || ( depth == 0 && rootSeen ) )
+		return Fail();
+	begun = true;
+	rootSeen = true;
+
+	std::string& out = sink->Buffer();
+	BeginContent( out, false );
+	DoIndent( out, depth );
+	out += '<';
+	out += name;
+
+	if ( depth < names.size() )
+		names[ depth ].assign( name );
+	else
+		names.push_back( name );
+	++depth;
+	attributeCount = 0;
+	startOpen = true;
+	sink->Poll();
+	return true;
+}
+
+
+bool TiXmlStreamWriter::PushAttribute( const std::string& name, const std::string& value )
+{
+	if ( !good || !startOpen || !IsName( name ) )
+		return Fail();
+	for( size_t i=0; i<attributeCount; ++i )
+	{
+		if ( attributeNames[i] == name )
+			return Fail();
+	}
+	if ( attributeCount < attributeNames.size() )
+		attributeNames[ attributeCount ].assign( name );
+	else
+		attributeNames.push_back( name );
+	++attributeCount;
+
+	std::string& out = sink->Buffer();
+	const char quote = ( value.find( '\"' ) == std::string::npos ) ? '\"' : '\'';
+	out += ' ';
+	out += name;
+	out += '=';
+	out += quote;
+	TiXmlBase::EncodeString( value, &out );
+	out += quote;
+	sink->Poll();
+	return true;
+}
+
+
+bool TiXmlStreamWriter::PushAttribute( const std::string& name, int value )
+{
+	number.clear();
+	TiXmlBase::WriteValue( value, &number );
+	return PushAttribute( name, number );
+}
+
+
+bool TiXmlStreamWriter::PushAttribute( const std::string& name, double value )
+{
+	number.clear();
+	TiXmlBase::WriteValue( value, &number );
+	return PushAttribute( name, number );
+}
+
+
+bool TiXmlStreamWriter::PushText( const std::string& text, bool cdata )
+{
+	if ( !good || depth == 0 || ( cdata && text.find( "]]>" ) != std::string::npos ) )
+		return Fail();
+
+	std::string& out = sink->Buffer();
+	if ( cdata )
+	{
+		BeginContent( out, false );
+		DoIndent( out, depth );
+		out += "<![CDATA[";
+		out += text;
+		out += "]]>";
+		out += lineBreak;
+	}
+	else
+	{
+		bool first = startOpen;
+		BeginContent( out, true );
+		if ( !first && !inlineText )
+			DoIndent( out, depth );
+		TiXmlBase::EncodeString( text, &out, TIXML_ESCAPE_TEXT );
+		if ( !first && !inlineText )
+			out += lineBreak;
+	}
+	sink->Poll();
+	return true;
+}
+
+
+bool TiXmlStreamWriter::PushComment( const std::string& comment )
+{
+	if ( !good || comment.find( "--" ) != std::string::npos || ( !comment.empty() && comment.back() == '-' ) )
+		return Fail();
+	begun = true;
+
+	std::string& out = sink->Buffer();
+	BeginContent( out, false );
+	DoIndent( out, depth );
+	out += "<!--";
+	out += comment;
+	out += "-->";
+	out += lineBreak;
+	sink->Poll();
+	return true;
+}
+
+
+bool TiXmlStreamWriter::CloseElement()
+{
+	if ( !good || depth == 0 )
+		return Fail();
+	--depth;
+
+	std::string& out = sink->Buffer();
+	if ( startOpen )
+	{
+		out += " />";
+		startOpen = false;
+	}
+	else
+	{
+		if ( inlineText )
+			inlineText = false;
+		else
+			DoIndent( out, depth );
+		out += "</";
+		out += names[ depth ];
+		out += '>';
+	}
+	out += lineBreak;
+	sink->Poll();
+	return true;
+}
+
+
+bool TiXmlStreamWriter::Finish()
+{
+	if ( !good || depth != 0 || !rootSeen )
+		return Fail();
+	return sink->Flush();
+}
@@ -0,0 +1,1281 @@
+/*
+www.sourceforge.net/projects/tinyxml
+Original code by Lee Thomason (www.grinninglizard.com)
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must
+not claim that you wrote the original software. If you use this
+software in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+
+#include "tinyxml.h"
+
+#include <algorithm>
+
+
+namespace {
+
+const char* SkipSpace( const char* p, const char* end )
+{
+	while ( p < end && ( *p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' ) )
+		++p;
+	return p;
+}
+
+bool IsNameStart( char c )
+{
+	return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || c == '_' || (unsigned char) c >= 0x80;
+}
+
+bool IsNameChar( char c )
+{
+	return IsNameStart( c ) || ( c >= '0' && c <= '9' ) || c == '-' || c == '.' || c == ':';
+}
+
+const TiXmlElement* AsElement( const TiXmlNode* node )
+{
+	return ( node->Type() == TiXmlNode::TINYXML_ELEMENT ) ? static_cast< const TiXmlElement* >( node ) : 0;
+}
+
+bool IsInside( const TiXmlNode* node, const TiXmlNode* ancestor )
+{
+	for( const TiXmlNode* p = node->Parent(); p; p = p->Parent() )
+	{
+		if ( p == ancestor )
+			return true;
+	}
+	return false;
+}
+
+int DepthOf( const TiXmlNode* node )
+{
+	int depth = 0;
+	for( ; node->Parent(); node = node->Parent() )
+		++depth;
+	return depth;
+}
+
+// Whether 'a' comes before 'b' in document order.
+bool Before( const TiXmlNode* a, const TiXmlNode* b )
+{
+	int depthA = DepthOf( a );
+	int depthB = DepthOf( b );
+	const TiXmlNode* x = a;
+	const TiXmlNode* y = b;
+	for( ; depthA > depthB; --depthA )
+		x = x->Parent();
+	for( ; depthB > depthA; --depthB )
+		y = y->Parent();
+	if ( x == y )
+		return y == a && a != b;		// an ancestor comes first
+	while ( x->Parent() != y->Parent() )
+	{
+		x = x->Parent();
+		y = y->Parent();
+	}
+	for( const TiXmlNode* node = x->NextSibling(); node; node = node->NextSibling() )
+	{
+		if ( node == y )
+			return true;
+	}
+	return false;
+}
+
+struct Cache
+{
+	std::mutex mutex;
+	std::unordered_map< std::string, std::shared_ptr< const TiXmlXPath > > plans;
+};
+
+Cache& TheCache()
+{
+	static Cache cache;
+	return cache;
+}
+
+} // namespace
+
+
+bool TiXmlXPath::Fail( const char* what, size_t offset )
+{
+	steps.clear();
+	errorDesc = what;
+	errorDesc += " at offset ";
+	errorDesc += std::to_string( offset );
+	errorDesc += " of '" + expression + "'";
+	return false;
+}
+
+
+bool TiXmlXPath::Compile( std::string_view _expression )
+{
+	expression.assign( _expression.data(), _expression.size() );
+	steps.clear();
+	errorDesc.clear();
+	absolute = false;
+
+	const char* const begin = expression.c_str();
+	const char* const end = begin + expression.size();
+	const char* p = SkipSpace( begin, end );
+
+	auto readName = [&]( std::string* name ) {
+		const char* start = p;
+		if ( p < end && IsNameStart( *p ) )
+		{
+			while ( p < end && IsNameChar( *p ) )
+				++p;
+		}
+		name->assign( start, p );
+		return p > start;
+	};
+	auto readLiteral = [&]( std::string* literal ) {
+		if ( p == end || ( *p != '\'' && *p != '\"' ) )
+			return false;
+		const char* close = std::find( p + 1, end, *p );
+		if ( close == end )
+			return false;
+		literal->assign( p + 1, close );
+		p = close + 1;
+		return true;
+	};
+
+	bool descendant = false;
+	if ( p < end && *p == '/' )
+	{
+		absolute = true;
+		descendant = ( p + 1 < end && p[1] == '/' );
+		p = SkipSpace( p + ( descendant ? 2 : 1 ), end );
+		if ( p == end && !descendant )
+			return true;		// "/" is the top of the tree
+	}
+
+	for( ;; )
+	{
+		Step step;
+		step.axis = AXIS_CHILD;
+		step.descendant = descendant;
+		step.test = TEST_NAME;
+		step.positions = 0;
+
+		if ( p == end )
+			return Fail( "Expected a step", p - begin );
+		if ( *p == '@' )
+		{
+			++p;
+			step.axis = AXIS_ATTRIBUTE;
+			if ( p < end && *p == '*' )
+			{
+				step.test = TEST_ELEMENT;
+				++p;
+			}
+			else if ( !readName( &step.name ) )
+				return Fail( "Expected an attribute name", p - begin );
+		}
+		else if ( *p == '*' )
+		{
+			step.test = TEST_ELEMENT;
+			++p;
+		}
+		else if ( *p == '.' )
+		{
+			if ( p + 1 < end && p[1] == '.' )
+				return Fail( "The parent step '..' is not supported", p - begin );
+			if ( descendant )
+				return Fail( "'//.' is not supported", p - begin );
+			step.axis = AXIS_SELF;
+			step.test = TEST_NODE;
+			++p;
+		}
+		else if ( readName( &step.name ) )
+		{
+			const char* q = SkipSpace( p, end );
+			if ( q < end && *q == '(' )
+			{
+				if ( step.name != "text" )
+					return Fail( "Unknown function", p - begin - step.name.size() );
+				q = SkipSpace( q + 1, end );
+				if ( q == end || *q != ')' )
+					return Fail( "Expected ')'", q - begin );
+				step.test = TEST_TEXT;
+				step.name.clear();
+				p = q + 1;
+			}
+		}
+		else
+			return Fail( "Expected a step", p - begin );
+
+		p = SkipSpace( p, end );
+		while ( p < end && *p == '[' )
+		{
+			if ( step.axis != AXIS_CHILD )
+				return Fail( "Predicates are only supported on element and text steps", p - begin );
+			p = SkipSpace( p + 1, end );
+
+			Predicate predicate;
+			predicate.position = 0;
+			if ( p < end && *p >= '0' && *p <= '9' )
+			{
+				predicate.kind = Predicate::POSITION;
+				std::from_chars_result number = std::from_chars( p, end, predicate.position );
+				if ( number.ec != std::errc() || predicate.position < 1 )
+					return Fail( "Positions count from 1", p - begin );
+				p = number.ptr;
+				++step.positions;
+			}
+			else
+			{
+				bool attribute = ( p < end && *p == '@' );
+				if ( attribute )
+					++p;
+				if ( !readName( &predicate.name ) )
+					return Fail( "Expected a name or a position", p - begin );
+				p = SkipSpace( p, end );
+
+				if ( p < end && *p == ']' && attribute )
+					predicate.kind = Predicate::HAS_ATTRIBUTE;
+				else
+				{
+					if ( p < end && *p == '=' )
+					{
+						predicate.kind = attribute ? Predicate::ATTRIBUTE_EQUALS : Predicate::CHILD_EQUALS;
+						++p;
+					}
+					else if ( attribute && p + 1 < end && p[0] == '!' && p[1] == '=' )
+					{
+						predicate.kind = Predicate::ATTRIBUTE_NOT_EQUALS;
+						p += 2;
+					}
+					else
+						return Fail( "Expected '='", p - begin );
+					p = SkipSpace( p, end );
+					if ( !readLiteral( &predicate.value ) )
+						return Fail( "Expected a quoted string", p - begin );
+				}
+			}
+			p = SkipSpace( p, end );
+			if ( p == end || *p != ']' )
+				return Fail( "Expected ']'", p - begin );
+			p = SkipSpace( p + 1, end );
+			step.predicates.push_back( std::move( predicate ) );
+		}
+		steps.push_back( std::move( step ) );
+
+		if ( p == end )
+			return true;
+		if ( *p != '/' )
+			return Fail( "Unexpected character", p - begin );
+		if ( steps.back().axis == AXIS_ATTRIBUTE )
+			return Fail( "An attribute step must be the last", p - begin );
+		descendant = ( p + 1 < end && p[1] == '/' );
+		p = SkipSpace( p + ( descendant ? 2 : 1 ), end );
+	}
+}
+
+
+std::shared_ptr< const TiXmlXPath > TiXmlXPath::Cached( const std::string& _expression )
+{
+	Cache& cache = TheCache();
+	{
+		std::lock_guard< std::mutex > lock( cache.mutex );
+		auto it = cache.plans.find( _expression );
+		if ( it != cache.plans.end() )
+			return it->second;
+	}
+
+	// Compile outside the lock; if another thread got there first, use its plan.
+	std::shared_ptr< const TiXmlXPath > plan = std::make_shared< TiXmlXPath >( _expression );
+	std::lock_guard< std::mutex > lock( cache.mutex );
+	if ( cache.plans.size() >= CACHE_SIZE )
+		cache.plans.clear();
+	return cache.plans.emplace( _expression, plan ).first->second;
+}
+
+
+void TiXmlXPath::ClearCache()
+{
+	Cache& cache = TheCache();
+	std::lock_guard< std::mutex > lock( cache.mutex );
+	cache.plans.clear();
+}
+
+
+bool TiXmlXPath::Matches( const Step& step, const TiXmlNode* node, int* counters )
+{
+	switch ( step.test )
+	{
+		case TEST_NAME:
+			if ( node->Type() != TiXmlNode::TINYXML_ELEMENT || node->ValueStr() != step.name )
+				return false;
+			break;
+		case TEST_ELEMENT:
+			if ( node->Type() != TiXmlNode::TINYXML_ELEMENT )
+				return false;
+			break;
+		case TEST_TEXT:
+			if ( node->Type() != TiXmlNode::TINYXML_TEXT )
+				return false;
+			break;
+		case TEST_NODE:
+			break;
+	}
+
+	// Each position counts the siblings that passed the predicates before it.
+	for( const Predicate& predicate : step.predicates )
+	{
+		if ( predicate.kind == Predicate::POSITION )
+		{
+			if ( ++*counters++ != predicate.position )
+				return false;
+			continue;
+		}
+
+		const TiXmlElement* element = AsElement( node );
+		if ( !element )
+			return false;
+		if ( predicate.kind == Predicate::CHILD_EQUALS )
+		{
+			const TiXmlElement* child = element->FirstChildElement( predicate.name );
+			for( ; child; child = child->NextSiblingElement( predicate.name ) )
+			{
+				const TiXmlNode* text = child->FirstChild();
+				if ( text && text->Type() == TiXmlNode::TINYXML_TEXT && text->ValueStr() == predicate.value )
+					break;
+			}
+			if ( !child )
+				return false;
+			continue;
+		}
+
+		const TiXmlAttribute* attribute = element->FindAttribute( predicate.name );
+		if (    !attribute
+			 || ( predicate.kind == Predicate::ATTRIBUTE_EQUALS && attribute->ValueStr() != predicate.value )
+			 || ( predicate.kind == Predicate::ATTRIBUTE_NOT_EQUALS && attribute->ValueStr() == predicate.value ) )
+			return false;
+	}
+	return true;
+}
+
+
+void TiXmlXPath::SelectChildren( const Step& step, const TiXmlNode* context, std::vector< const TiXmlNode* >* out, TiXmlXPathResult* result ) const
+{
+	if ( step.test == TEST_NAME && step.predicates.empty() )
+	{
+		for( const TiXmlElement* element = context->FirstChildElement( step.name ); element; element = element->NextSiblingElement( step.name ) )
+			out->push_back( element );
+		return;
+	}
+	if ( step.test == TEST_NAME && step.predicates.size() == 1 && step.positions == 1 )
+	{
+		if ( const TiXmlElement* element = context->ChildElementAt( step.name.c_str(), step.predicates[0].position - 1 ) )
+			out->push_back( element );
+		return;
+	}
+
+	result->counters.assign( step.positions, 0 );
+	for( const TiXmlNode* node = context->FirstChild(); node; node = node->NextSibling() )
+	{
+		if ( Matches( step, node, result->counters.data() ) )
+			out->push_back( node );
+	}
+}
+
+
+bool TiXmlXPath::SelectDescendants( const Step& step, const TiXmlNode* context, std::vector< const TiXmlNode* >* out, TiXmlXPathResult* result ) const
+{
+	// A preorder walk without recursion. Level 0 is the children of
+	// 'context'; each level has its own position counters, as the
+	// positions count among siblings.
+	std::vector< int >& counters = result->counters;
+	std::vector< char >& matched = result->matched;
+	const size_t k = step.positions;
+	size_t level = 0;
+	int open = 0;			// matches on the path above 'node'
+	bool nested = false;
+
+	auto enter = [&]( size_t _level ) {
+		if ( counters.size() < ( _level + 1 ) * k )
+			counters.resize( ( _level + 1 ) * k );
+		std::fill( counters.begin() + _level * k, counters.begin() + ( _level + 1 ) * k, 0 );
+		if ( matched.size() < _level + 1 )
+			matched.resize( _level + 1 );
+	};
+	enter( 0 );
+
+	const TiXmlNode* node = context->FirstChild();
+	while ( node )
+	{
+		bool hit = Matches( step, node, counters.data() + level * k );
+		if ( hit )
+		{
+			nested = nested || open > 0;
+			out->push_back( node );
+		}
+		matched[ level ] = hit;
+
+		if ( node->FirstChild() )
+		{
+			open += hit;
+			enter( ++level );
+			node = node->FirstChild();
+			continue;
+		}
+		while ( !node->NextSibling() )
+		{
+			node = node->Parent();
+			if ( node == context )
+				return nested;
+			--level;
+			open -= matched[ level ];
+		}
+		node = node->NextSibling();
+	}
+	return nested;
+}
+
+
+void TiXmlXPath::SelectAttributes( const Step& step, const TiXmlNode* context, TiXmlXPathResult* result ) const
+{
+	// The context itself, then (after '//') the elements below it, in document order.
+	const TiXmlNode* node = context;
+	while ( node )
+	{
+		if ( const TiXmlElement* element = AsElement( node ) )
+		{
+			if ( step.test == TEST_NAME )
+			{
+				if ( const TiXmlAttribute* attribute = element->FindAttribute( step.name ) )
+					result->attributes.push_back( attribute );
+			}
+			else
+			{
+				for( const TiXmlAttribute* attribute = element->FirstAttribute(); attribute; attribute = attribute->Next() )
+					result->attributes.push_back( attribute );
+			}
+		}
+		if ( !step.descendant )
+			return;
+
+		if ( node->FirstChild() )
+		{
+			node = node->FirstChild();
+			continue;
+		}
+		while ( node != context && !node->NextSibling() )
+			node = node->Parent();
+		if ( node == context )
+			return;
+		node = node->NextSibling();
+	}
+}
+
+
+bool TiXmlXPath::IndexedDescendants( const Step& step, const std::vector< const TiXmlNode* >& contexts, std::vector< const TiXmlNode* >* out, bool* nested ) const
+{
+	if (    contexts.size() != 1
+		 || contexts[0]->Type() != TiXmlNode::TINYXML_DOCUMENT
+		 || !step.descendant
+		 || step.axis != AXIS_CHILD
+		 || step.test != TEST_NAME
+		 || step.positions != 0 )
+		return false;
+	const TiXmlDocument* document = static_cast< const TiXmlDocument* >( contexts[0] );
+	if ( !document->HasElementIndex() )
+		return false;
+
+	// In document order, anything inside an earlier match is inside the
+	// last one that wasn't itself inside another.
+	const TiXmlNode* outer = 0;
+	*nested = false;
+	for( const TiXmlElement* element : document->GetElementsByTagName( step.name ) )
+	{
+		if ( !Matches( step, element, 0 ) )
+			continue;
+		if ( outer && IsInside( element, outer ) )
+			*nested = true;
+		else
+			outer = element;
+		out->push_back( element );
+	}
+	return true;
+}
+
+
+bool TiXmlXPath::Select( const TiXmlNode* context, TiXmlXPathResult* result ) const
+{
+	result->nodes.clear();
+	result->attributes.clear();
+	if ( Error() )
+		return false;
+	if ( !context )
+		return true;
+	if ( absolute )
+	{
+		while ( context->Parent() )
+			context = context->Parent();
+	}
+
+	// Each step reads 'in' and writes 'out', then they trade places. Both
+	// are always in document order without duplicates.
+	std::vector< const TiXmlNode* >* in = &result->scratch;
+	std::vector< const TiXmlNode* >* out = &result->nodes;
+	in->clear();
+	in->push_back( context );
+	bool nested = false;		// some node in 'in' is inside another
+
+	for( const Step& step : steps )
+	{
+		if ( step.axis == AXIS_SELF )
+			continue;
+
+		out->clear();
+		if ( IndexedDescendants( step, *in, out, &nested ) )
+		{
+			std::swap( in, out );
+			continue;
+		}
+		const TiXmlNode* last = 0;
+		bool stepNested = false;
+		for( const TiXmlNode* node : *in )
+		{
+			// Below a node already walked, everything has been seen.
+			if ( step.descendant && last && IsInside( node, last ) )
+				continue;
+			last = node;
+
+			if ( step.axis == AXIS_ATTRIBUTE )
+				SelectAttributes( step, node, result );
+			else if ( step.descendant )
+				stepNested = SelectDescendants( step, node, out, result ) || stepNested;
+			else
+				SelectChildren( step, node, out, result );
+		}
+
+		// The children of nodes inside one another can interleave.
+		if ( !step.descendant && nested && out->size() > 1 )
+			std::sort( out->begin(), out->end(), Before );
+		if ( step.descendant )
+			nested = stepNested;
+		std::swap( in, out );
+	}
+
+	if ( SelectsAttributes() )
+		result->nodes.clear();
+	else if ( in != &result->nodes )
+		result->nodes.swap( result->scratch );
+	return true;
+}
+
+
+bool TiXmlStreamXPath::Compile( std::string_view _expression )
+{
+	expression.assign( _expression.data(), _expression.size() );
+	plan.clear();
+	count = false;
+
+	const char* begin = expression.c_str();
+	const char* end = begin + expression.size();
+	begin = SkipSpace( begin, end );
+	while ( end > begin && ( end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\n' || end[-1] == '\r' ) )
+		--end;
+	if ( end - begin > 5 && std::string_view( begin, 5 ) == "count" )
+	{
+		const char* open = SkipSpace( begin + 5, end );
+		if ( open < end && *open == '(' && end[-1] == ')' )
+		{
+			count = true;
+			begin = open + 1;
+			--end;
+		}
+	}
+	if ( !path.Compile( std::string_view( begin, end - begin ) ) )
+		return false;
+
+	auto fail = [&]( const char* what ) {
+		path.steps.clear();
+		path.errorDesc = what;
+		path.errorDesc += " in '" + expression + "'";
+		return false;
+	};
+	for( size_t i=0; i<path.steps.size(); ++i )
+	{
+		const TiXmlXPath::Step& step = path.steps[i];
+		for( const TiXmlXPath::Predicate& predicate : step.predicates )
+		{
+			if ( predicate.kind == TiXmlXPath::Predicate::CHILD_EQUALS )
+				return fail( "A test on a child can't be decided at the start tag" );
+		}
+		if ( step.axis != TiXmlXPath::AXIS_SELF )
+			plan.push_back( i );
+	}
+	if ( plan.empty() )
+		return fail( "Selects only the document" );
+	return true;
+}
+
+
+bool TiXmlStreamXPath::Matches( const TiXmlXPath::Step& step, const TiXmlPullParser& parser, int* positions )
+{
+	bool element = ( parser.Current() == TiXmlPullParser::PULL_START_ELEMENT );
+	switch ( step.test )
+	{
+		case TiXmlXPath::TEST_NAME:
+			if ( !element || parser.Name() != step.name )
+				return false;
+			break;
+		case TiXmlXPath::TEST_ELEMENT:
+			if ( !element )
+				return false;
+			break;
+		case TiXmlXPath::TEST_TEXT:
+			if ( element )
+				return false;
+			break;
+		case TiXmlXPath::TEST_NODE:
+			break;
+	}
+
+	for( const TiXmlXPath::Predicate& predicate : step.predicates )
+	{
+		if ( predicate.kind == TiXmlXPath::Predicate::POSITION )
+		{
+			if ( ++*positions++ != predicate.position )
+				return false;
+			continue;
+		}
+		const std::string* value = element ? parser.Attribute( predicate.name ) : 0;
+		if (    !value
+			 || ( predicate.kind == TiXmlXPath::Predicate::ATTRIBUTE_EQUALS && *value != predicate.value )
+			 || ( predicate.kind == TiXmlXPath::Predicate::ATTRIBUTE_NOT_EQUALS && *value == predicate.value ) )
+			return false;
+	}
+	return true;
+}
+
+
+void TiXmlStreamXPath::AddState( size_t step, size_t frameBegin )
+{
+	for( size_t i=frameBegin; i<states.size(); ++i )
+	{
+		if ( states[i].step == step )
+			return;
+	}
+	State state = { step, counters.size() };
+	states.push_back( state );
+	counters.resize( counters.size() + StepAt( step ).positions, 0 );
+}
+
+
+void TiXmlStreamXPath::Deliver( TiXmlPullParser* parser, int attribute, const Callback& callback )
+{
+	++matches;
+	if ( callback && !callback( parser, attribute ) )
+		stopped = true;
+}
+
+
+bool TiXmlStreamXPath::StartElement( TiXmlPullParser* parser, const Callback& callback )
+{
+	const Frame parent = frames.back();
+	const size_t parentEnd = states.size();
+	const Frame frame = { states.size(), counters.size() };
+	bool selected = false;
+
+	for( size_t i=parent.states; i<parentEnd; ++i )
+	{
+		const State state = states[i];
+		const TiXmlXPath::Step& step = StepAt( state.step );
+		if ( step.descendant )
+			AddState( state.step, frame.states );
+		if ( step.axis == TiXmlXPath::AXIS_ATTRIBUTE || !Matches( step, *parser, counters.data() + state.counters ) )
+			continue;
+
+		// On to the next step, which the attributes of this element or
+		// its children may match.
+		if ( state.step + 1 == plan.size() )
+			selected = true;
+		else
+			AddState( state.step + 1, frame.states );
+	}
+
+	// Only the last step selects attributes, so at most one state does.
+	bool live = false;
+	for( size_t i=frame.states; i<states.size(); ++i )
+	{
+		const TiXmlXPath::Step& step = StepAt( states[i].step );
+		if ( step.axis == TiXmlXPath::AXIS_ATTRIBUTE )
+		{
+			for( int a=0; a<parser->AttributeCount() && !stopped; ++a )
+			{
+				if ( step.test != TiXmlXPath::TEST_NAME || parser->AttributeName( a ) == step.name )
+					Deliver( parser, a, callback );
+			}
+		}
+		live = live || step.axis != TiXmlXPath::AXIS_ATTRIBUTE || step.descendant;
+	}
+	if ( selected && !stopped )
+		Deliver( parser, -1, callback );
+	if ( stopped )
+		return false;
+
+	// The callback may have read to the element's end; otherwise skip
+	// what can't match.
+	if ( parser->Current() != TiXmlPullParser::PULL_START_ELEMENT || !live )
+	{
+		states.resize( frame.states );
+		counters.resize( frame.counters );
+		return parser->Current() != TiXmlPullParser::PULL_START_ELEMENT || parser->SkipElement();
+	}
+	frames.push_back( frame );
+	return true;
+}
+
+
+void TiXmlStreamXPath::Text( TiXmlPullParser* parser, const Callback& callback )
+{
+	const Frame frame = frames.back();
+	for( size_t i=frame.states; i<states.size() && !stopped; ++i )
+	{
+		const State state = states[i];
+		const TiXmlXPath::Step& step = StepAt( state.step );
+		if (    step.test == TiXmlXPath::TEST_TEXT
+			 && Matches( step, *parser, counters.data() + state.counters )
+			 && state.step + 1 == plan.size() )
+			Deliver( parser, -1, callback );
+	}
+}
+
+
+bool TiXmlStreamXPath::Run( TiXmlPullParser* parser, const Callback& callback )
+{
+	matches = 0;
+	stopped = false;
+	if ( Error() )
+		return false;
+
+	// The document is the first frame, where the first step starts.
+	states.clear();
+	counters.clear();
+	frames.clear();
+	const Frame document = { 0, 0 };
+	frames.push_back( document );
+	AddState( 0, 0 );
+
+	for( ;; )
+	{
+		switch ( parser->Next() )
+		{
+			case TiXmlPullParser::PULL_START_ELEMENT:
+				if ( !StartElement( parser, callback ) )
+					return !parser->Error();
+				break;
+			case TiXmlPullParser::PULL_END_ELEMENT:
+				if ( frames.size() > 1 )
+				{
+					states.resize( frames.back().states );
+					counters.resize( frames.back().counters );
+					frames.pop_back();
+				}
+				break;
+			case TiXmlPullParser::PULL_TEXT:
+				Text( parser, callback );
+				if ( stopped )
+					return true;
+				break;
+			case TiXmlPullParser::PULL_END:
+				return true;
+			case TiXmlPullParser::PULL_ERROR:
+				return false;
+			default:
+				break;
+		}
+	}
+}
+
+
+bool TiXmlXPathSet::Same( const TiXmlXPath::Step& a, const TiXmlXPath::Step& b )
+{
+	if (    a.axis != b.axis || a.descendant != b.descendant || a.test != b.test || a.name != b.name
+		 || a.predicates.size() != b.predicates.size() )
+		return false;
+	for( size_t i=0; i<a.predicates.size(); ++i )
+	{
+		const TiXmlXPath::Predicate& x = a.predicates[i];
+		const TiXmlXPath::Predicate& y = b.predicates[i];
+		if ( x.kind != y.kind || x.position != y.position || x.name != y.name || x.value != y.value )
+			return false;
+	}
+	return true;
+}
+
+
+int TiXmlXPathSet::Add( std::string_view expression )
+{
+	TiXmlXPath path( expression );
+	if ( path.Error() )
+	{
+		errorDesc = path.ErrorDesc();
+		return NONE;
+	}
+	errorDesc.clear();
+
+	Query query;
+	query.expression = path.expression;
+	query.absolute = path.absolute;
+	query.attributes = path.SelectsAttributes();
+	query.first = NONE;
+	query.state = NONE;
+	for( const TiXmlXPath::Step& step : path.steps )
+	{
+		for( const TiXmlXPath::Predicate& predicate : step.predicates )
+		{
+			if ( predicate.kind == TiXmlXPath::Predicate::CHILD_EQUALS )
+				query.streamError = "A test on a child can't be decided at the start tag";
+		}
+		if ( step.axis == TiXmlXPath::AXIS_SELF )
+			continue;
+
+		// Share the step with another query that starts the same way.
+		int state = NONE;
+		if ( query.state == NONE )
+		{
+			for( const Query& other : queries )
+			{
+				if ( other.first != NONE && other.absolute == query.absolute && Same( states[ other.first ].step, step ) )
+				{
+					state = other.first;
+					break;
+				}
+			}
+		}
+		else
+		{
+			for( int next : states[ query.state ].next )
+			{
+				if ( Same( states[ next ].step, step ) )
+				{
+					state = next;
+					break;
+				}
+			}
+		}
+		if ( state == NONE )
+		{
+			state = (int) states.size();
+			State added;
+			added.step = step;
+			states.push_back( std::move( added ) );
+			if ( query.state != NONE )
+				states[ query.state ].next.push_back( state );
+			if ( step.test == TiXmlXPath::TEST_NAME && step.axis != TiXmlXPath::AXIS_ATTRIBUTE )
+				kinds.emplace( step.name, (int) kinds.size() + 2 );
+		}
+		if ( query.first == NONE )
+			query.first = state;
+		query.state = state;
+	}
+	if ( query.state == NONE )
+		query.streamError = "Selects only the document";
+	else
+		states[ query.state ].ends.push_back( queries.size() );
+	queries.push_back( std::move( query ) );
+
+	// The moves worked out so far don't know the new steps.
+	sets.clear();
+	setIndex.clear();
+	moves.clear();
+	return (int) queries.size() - 1;
+}
+
+
+void TiXmlXPathSet::Clear()
+{
+	queries.clear();
+	states.clear();
+	kinds.clear();
+	errorDesc.clear();
+	sets.clear();
+	setIndex.clear();
+	moves.clear();
+	matches.clear();
+}
+
+
+int TiXmlXPathSet::Kind( const std::string& name ) const
+{
+	std::unordered_map< std::string, int >::const_iterator it = kinds.find( name );
+	return ( it == kinds.end() ) ? KIND_ELEMENT : it->second;
+}
+
+
+int TiXmlXPathSet::Intern( std::vector< int >* _states )
+{
+	std::sort( _states->begin(), _states->end() );
+	_states->erase( std::unique( _states->begin(), _states->end() ), _states->end() );
+	std::map< std::vector< int >, int >::const_iterator it = setIndex.find( *_states );
+	if ( it != setIndex.end() )
+		return it->second;
+
+	StateSet set;
+	set.positions = 0;
+	set.live = false;
+	for( int id : *_states )
+	{
+		const TiXmlXPath::Step& step = states[ id ].step;
+		set.counters.push_back( set.positions );
+		set.positions += step.positions;
+		if ( step.axis == TiXmlXPath::AXIS_ATTRIBUTE )
+			set.attributes.push_back( id );
+		set.live = set.live || step.axis != TiXmlXPath::AXIS_ATTRIBUTE || step.descendant;
+	}
+	set.states = *_states;
+	set.moves.assign( kinds.size() + 2, NONE );
+	sets.push_back( std::move( set ) );
+	setIndex.emplace( *_states, (int) sets.size() - 1 );
+	return (int) sets.size() - 1;
+}
+
+
+int TiXmlXPathSet::MoveFor( int set, int kind )
+{
+	if ( sets[ set ].moves[ kind ] != NONE )
+		return sets[ set ].moves[ kind ];
+
+	Move move;
+	std::vector< int > next;
+	const std::vector< int > here = sets[ set ].states;
+	for( size_t i=0; i<here.size(); ++i )
+	{
+		const State& state = states[ here[i] ];
+		const TiXmlXPath::Step& step = state.step;
+		if ( step.descendant )
+			next.push_back( here[i] );
+		if ( step.axis == TiXmlXPath::AXIS_ATTRIBUTE )
+			continue;
+
+		bool named;
+		switch ( step.test )
+		{
+			case TiXmlXPath::TEST_NAME:		named = ( Kind( step.name ) == kind );	break;
+			case TiXmlXPath::TEST_ELEMENT:	named = ( kind != KIND_TEXT );			break;
+			case TiXmlXPath::TEST_TEXT:		named = ( kind == KIND_TEXT );			break;
+			default:						named = false;							break;
+		}
+		if ( !named )
+			continue;
+		if ( !step.predicates.empty() )
+		{
+			move.checks.push_back( i );
+			continue;
+		}
+		move.ends.insert( move.ends.end(), state.ends.begin(), state.ends.end() );
+		next.insert( next.end(), state.next.begin(), state.next.end() );
+	}
+	move.next = Intern( &next );
+	moves.push_back( std::move( move ) );
+	sets[ set ].moves[ kind ] = (int) moves.size() - 1;
+	return (int) moves.size() - 1;
+}
+
+
+int TiXmlXPathSet::Checked( int set, int move )
+{
+	if ( std::find( passed.begin(), passed.end(), 1 ) == passed.end() )
+		return moves[ move ].next;
+	std::map< std::vector< char >, int >::const_iterator it = moves[ move ].outcomes.find( passed );
+	if ( it != moves[ move ].outcomes.end() )
+		return it->second;
+
+	std::vector< int > next = sets[ moves[ move ].next ].states;
+	const std::vector< size_t >& checks = moves[ move ].checks;
+	for( size_t i=0; i<checks.size(); ++i )
+	{
+		if ( passed[i] )
+		{
+			const State& state = states[ sets[ set ].states[ checks[i] ] ];
+			next.insert( next.end(), state.next.begin(), state.next.end() );
+		}
+	}
+	const int result = Intern( &next );
+	moves[ move ].outcomes.emplace( passed, result );
+	return result;
+}
+
+
+int TiXmlXPathSet::Start( bool relative, bool absolute )
+{
+	std::vector< int > first;
+	for( const Query& query : queries )
+	{
+		if ( query.first != NONE && ( query.absolute ? absolute : relative ) )
+			first.push_back( query.first );
+	}
+	return Intern( &first );
+}
+
+
+void TiXmlXPathSet::Attributes( const TiXmlElement* element, int set, std::vector< TiXmlXPathResult >* results ) const
+{
+	for( int id : sets[ set ].attributes )
+	{
+		const State& state = states[ id ];
+		for( size_t query : state.ends )
+		{
+			std::vector< const TiXmlAttribute* >& out = (*results)[ query ].attributes;
+			if ( state.step.test == TiXmlXPath::TEST_NAME )
+			{
+				if ( const TiXmlAttribute* attribute = element->FindAttribute( state.step.name ) )
+					out.push_back( attribute );
+			}
+			else
+			{
+				for( const TiXmlAttribute* attribute = element->FirstAttribute(); attribute; attribute = attribute->Next() )
+					out.push_back( attribute );
+			}
+		}
+	}
+}
+
+
+void TiXmlXPathSet::Walk( const TiXmlNode* top, int set, std::vector< TiXmlXPathResult >* results )
+{
+	if ( const TiXmlElement* element = AsElement( top ) )
+		Attributes( element, set, results );
+	if ( !sets[ set ].live || !top->FirstChild() )
+		return;
+
+	// A preorder walk without recursion, a frame for each open node.
+	frames.clear();
+	counters.assign( sets[ set ].positions, 0 );
+	frames.push_back( Frame{ top, set, 0 } );
+	const TiXmlNode* node = top->FirstChild();
+	while ( !frames.empty() )
+	{
+		if ( !node )
+		{
+			node = frames.back().node;
+			counters.resize( frames.back().counters );
+			frames.pop_back();
+			node = frames.empty() ? 0 : node->NextSibling();
+			continue;
+		}
+
+		int kind;
+		if ( node->Type() == TiXmlNode::TINYXML_ELEMENT )
+			kind = Kind( node->ValueStr() );
+		else if ( node->Type() == TiXmlNode::TINYXML_TEXT )
+			kind = KIND_TEXT;
+		else
+		{
+			node = node->NextSibling();
+			continue;
+		}
+
+		const Frame parent = frames.back();
+		const int move = MoveFor( parent.set, kind );
+		for( size_t query : moves[ move ].ends )
+			(*results)[ query ].nodes.push_back( node );
+		int next = moves[ move ].next;
+		if ( !moves[ move ].checks.empty() )
+		{
+			const std::vector< size_t >& checks = moves[ move ].checks;
+			passed.assign( checks.size(), 0 );
+			for( size_t i=0; i<checks.size(); ++i )
+			{
+				const StateSet& here = sets[ parent.set ];
+				const State& state = states[ here.states[ checks[i] ] ];
+				if ( TiXmlXPath::Matches( state.step, node, counters.data() + parent.counters + here.counters[ checks[i] ] ) )
+				{
+					passed[i] = 1;
+					for( size_t query : state.ends )
+						(*results)[ query ].nodes.push_back( node );
+				}
+			}
+			next = Checked( parent.set, move );
+		}
+
+		if ( kind != KIND_TEXT )
+		{
+			Attributes( static_cast< const TiXmlElement* >( node ), next, results );
+			if ( sets[ next ].live && node->FirstChild() )
+			{
+				frames.push_back( Frame{ node, next, counters.size() } );
+				counters.resize( counters.size() + sets[ next ].positions, 0 );
+				node = node->FirstChild();
+				continue;
+			}
+		}
+		node = node->NextSibling();
+	}
+}
+
+
+void TiXmlXPathSet::Select( const TiXmlNode* context, std::vector< TiXmlXPathResult >* results )
+{
+	results->resize( queries.size() );
+	for( TiXmlXPathResult& result : *results )
+	{
+		result.nodes.clear();
+		result.attributes.clear();
+	}
+	if ( !context )
+		return;
+
+	const TiXmlNode* top = context;
+	while ( top->Parent() )
+		top = top->Parent();
+	bool relative = false;
+	bool absolute = false;
+	for( size_t i=0; i<queries.size(); ++i )
+	{
+		if ( queries[i].first == NONE )
+			(*results)[i].nodes.push_back( queries[i].absolute ? top : context );
+		else if ( queries[i].absolute )
+			absolute = true;
+		else
+			relative = true;
+	}
+
+	// One walk, unless the absolute paths start above the context.
+	if ( context == top )
+	{
+		Walk( top, Start( true, true ), results );
+		return;
+	}
+	if ( absolute )
+		Walk( top, Start( false, true ), results );
+	if ( relative )
+		Walk( context, Start( true, false ), results );
+}
+
+
+bool TiXmlXPathSet::Deliver( TiXmlPullParser* parser, TiXmlPullParser::Event event, size_t query, int attribute, const Callback& callback )
+{
+	if ( stopped || parser->Current() != event )
+		return false;
+	++matches[ query ];
+	if ( callback && !callback( parser, query, attribute ) )
+		stopped = true;
+	return !stopped && parser->Current() == event;
+}
+
+
+bool TiXmlXPathSet::Run( TiXmlPullParser* parser, const Callback& callback )
+{
+	matches.assign( queries.size(), 0 );
+	stopped = false;
+	errorDesc.clear();
+	for( const Query& query : queries )
+	{
+		if ( !query.streamError.empty() )
+		{
+			errorDesc = query.streamError + " in '" + query.expression + "'";
+			return false;
+		}
+	}
+
+	// Every path starts at the document, which is the first frame.
+	const int start = Start( true, true );
+	frames.clear();
+	counters.assign( sets[ start ].positions, 0 );
+	frames.push_back( Frame{ 0, start, 0 } );
+
+	for( ;; )
+	{
+		const TiXmlPullParser::Event event = parser->Next();
+		switch ( event )
+		{
+			case TiXmlPullParser::PULL_START_ELEMENT:
+			case TiXmlPullParser::PULL_TEXT:
+			{
+				const bool element = ( event == TiXmlPullParser::PULL_START_ELEMENT );
+				const Frame parent = frames.back();
+				const int move = MoveFor( parent.set, element ? Kind( parser->Name() ) : (int) KIND_TEXT );
+				for( size_t query : moves[ move ].ends )
+					Deliver( parser, event, query, -1, callback );
+				int next = moves[ move ].next;
+				if ( !moves[ move ].checks.empty() )
+				{
+					const std::vector< size_t >& checks = moves[ move ].checks;
+					passed.assign( checks.size(), 0 );
+					for( size_t i=0; i<checks.size(); ++i )
+					{
+						const StateSet& here = sets[ parent.set ];
+						const State& state = states[ here.states[ checks[i] ] ];
+						if ( TiXmlStreamXPath::Matches( state.step, *parser, counters.data() + parent.counters + here.counters[ checks[i] ] ) )
+						{
+							passed[i] = 1;
+							for( size_t query : state.ends )
+								Deliver( parser, event, query, -1, callback );
+						}
+					}
+					next = Checked( parent.set, move );
+				}
+				if ( !element )
+					break;
+
+				for( int id : sets[ next ].attributes )
+				{
+					const State& state = states[ id ];
+					for( size_t query : state.ends )
+					{
+						for( int a=0; a<parser->AttributeCount(); ++a )
+						{
+							if ( state.step.test != TiXmlXPath::TEST_NAME || parser->AttributeName( a ) == state.step.name )
+								Deliver( parser, event, query, a, callback );
+						}
+					}
+				}
+				if ( stopped )
+					return true;
+
+				// The callback may have read to the element's end; otherwise skip
+				// what can't match.
+				if ( parser->Current() != TiXmlPullParser::PULL_START_ELEMENT )
+					break;
+				if ( !sets[ next ].live )
+				{
+					if ( !parser->SkipElement() )
+					{
+						errorDesc = parser->ErrorDesc();
+						return false;
+					}
+					break;
+				}
+				frames.push_back( Frame{ 0, next, counters.size() } );
+				counters.resize( counters.size() + sets[ next ].positions, 0 );
+				break;
+			}
+			case TiXmlPullParser::PULL_END_ELEMENT:
+				if ( frames.size() > 1 )
+				{
+					counters.resize( frames.back().counters );
+					frames.pop_back();
+				}
+				break;
+			case TiXmlPullParser::PULL_END:
+				return true;
+			case TiXmlPullParser::PULL_ERROR:
+				errorDesc = parser->ErrorDesc();
+				return false;
+			default:
+				break;
+		}
+		if ( stopped )
+			return true;
+	}
+}
@@ -0,0 +1,1358 @@
+/*
+   Benchmarks for TinyXML. Not part of the library or of the test suite;
+   build with "make xmlbench" and run from the tinyxml directory.
+
+   Every allocation made through operator new is counted, so besides the
+   time each benchmark reports how much heap traffic one iteration causes.
+   The bytes live on the heap are tracked as well, for footprint figures.
+*/
+
+#include "tinyxml.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+static unsigned long long allocations = 0;
+static long long liveBytes = 0;
+
+// Each block carries its size in front, so the live heap can be measured.
+static const size_t HEADER = 16;
+
+void* operator new( size_t size )
+{
+	++allocations;
+	if ( char* p = (char*) malloc( size + HEADER ) )
+	{
+		*(size_t*) p = size;
+		liveBytes += size;
+		return p + HEADER;
+	}
+	throw bad_alloc();
+}
+
+void operator delete( void* p ) noexcept
+{
+	if ( p )
+	{
+		char* block = (char*) p - HEADER;
+		liveBytes -= *(size_t*) block;
+		free( block );
+	}
+}
+
+void operator delete( void* p, size_t ) noexcept
+{
+	operator delete( p );
+}
+
+
+// A message of the usual shape: a header, then a run of records with a
+// few attributes and some text each.
+static string MakeMessage( int records )
+{
+	string msg = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<!-- generated -->\n<Orders batch=\"42\">\n";
+	for( int i=0; i<records; ++i )
+	{
+		char buf[512];
+		snprintf( buf, sizeof( buf ),
+			"  <Order id=\"%d\" customer=\"c%05d\" priority=\"%d\" express=\"%s\">\n"
+			"    <Item sku=\"SKU-%04d\" qty=\"%d\">Widget &amp; gadget #%d</Item>\n"
+			"    <Note><![CDATA[fragile <handle with care>]]></Note>\n"
+			"  </Order>\n",
+			i, i * 7, i % 5, ( i & 1 ) ? "yes" : "no", i % 1000, 1 + i % 9, i );
+		msg += buf;
+	}
+	msg += "</Orders>\n";
+	return msg;
+}
+
+
+// The records of MakeMessage(), as plain structs.
+struct BenchItem
+{
+	string sku;
+	int qty = 0;
+	string label;
+};
+
+struct BenchOrder
+{
+	int id = 0;
+	string customer;
+	int priority = 0;
+	bool express = false;
+	BenchItem item;
+	string note;
+};
+
+template<> struct TiXmlBind< BenchItem >
+{
+	static constexpr auto members = make_tuple(
+		TiXmlBindAttribute( "sku", &BenchItem::sku ),
+		TiXmlBindAttribute( "qty", &BenchItem::qty ),
+		TiXmlBindText( &BenchItem::label ) );
+};
+
+template<> struct TiXmlBind< BenchOrder >
+{
+	static constexpr auto members = make_tuple(
+		TiXmlBindAttribute( "id", &BenchOrder::id ),
+		TiXmlBindAttribute( "customer", &BenchOrder::customer ),
+		TiXmlBindAttribute( "priority", &BenchOrder::priority ),
+		TiXmlBindAttribute( "express", &BenchOrder::express ),
+		TiXmlBindElement( "Item", &BenchOrder::item ),
+		TiXmlBindElement( "Note", &BenchOrder::note ) );
+};
+
+
+struct Result
+{
+	double usPerIteration;
+	double allocsPerIteration;
+};
+
+
+template< typename F > static Result Measure( int iterations, F f )
+{
+	unsigned long long startAllocs = allocations;
+	auto start = chrono::steady_clock::now();
+	for( int i=0; i<iterations; ++i )
+		f();
+	auto stop = chrono::steady_clock::now();
+
+	Result r;
+	r.usPerIteration = chrono::duration<double, micro>( stop - start ).count() / iterations;
+	r.allocsPerIteration = double( allocations - startAllocs ) / iterations;
+	return r;
+}
+
+
+static void Report( const char* name, const Result& r )
+{
+	printf( "%-40s %12.1f us %14.1f allocs\n", name, r.usPerIteration, r.allocsPerIteration );
+}
+
+
+static bool BenchParse( int records, int iterations )
+{
+	const string msg = MakeMessage( records );
+	printf( "\nParse: %d records, %d bytes\n", records, (int) msg.size() );
+
+	Result fresh = Measure( iterations, [&]() {
+		TiXmlDocument doc;
+		doc.Parse( msg.begin(), msg.end() );
+	} );
+	Report( "new document per message", fresh );
+
+	// Warm up: the first parse creates the nodes, the first Reset() grows
+	// the free lists that hold them.
+	TiXmlDocument doc;
+	for( int i=0; i<2; ++i )
+	{
+		doc.Reset();
+		doc.Parse( msg.begin(), msg.end() );
+	}
+	Result reused = Measure( iterations, [&]() {
+		doc.Reset();
+		doc.Parse( msg.begin(), msg.end() );
+	} );
+	Report( "Reset() and reparse", reused );
+
+	if ( doc.Error() )
+	{
+		printf( "parse error: %s\n", doc.ErrorDesc() );
+		return false;
+	}
+	if ( reused.allocsPerIteration != 0 )
+	{
+		printf( "FAIL: steady state parsing allocated\n" );
+		return false;
+	}
+	return true;
+}
+
+
+static bool BenchClone( int records, int iterations )
+{
+	const string msg = MakeMessage( records );
+	TiXmlDocument tmpl;
+	tmpl.Parse( msg.begin(), msg.end() );
+
+	int nodes = 0;
+	for( const TiXmlNode* node = &tmpl; node; )
+	{
+		++nodes;
+		if ( node->FirstChild() )
+		{
+			node = node->FirstChild();
+			continue;
+		}
+		while ( node && !node->NextSibling() )
+			node = node->Parent();
+		if ( node )
+			node = node->NextSibling();
+	}
+	printf( "\nClone: %d nodes\n", nodes );
+
+	Result fresh = Measure( iterations, [&]() {
+		TiXmlDocument copy( tmpl );
+	} );
+	Report( "copy constructor", fresh );
+
+	TiXmlDocument job;
+	for( int i=0; i<2; ++i )
+		job = tmpl;
+	Result reused = Measure( iterations, [&]() {
+		job = tmpl;
+	} );
+	Report( "assign into a used document", reused );
+
+	if ( reused.allocsPerIteration != 0 )
+	{
+		printf( "FAIL: assigning into a used document allocated\n" );
+		return false;
+	}
+	return true;
+}
+
+
+// Counts the elements and attribute bytes, so both visitors do the same work.
+class DomCounter : public TiXmlVisitor
+{
+public:
+	DomCounter() : elements( 0 ), bytes( 0 ) {}
+	virtual bool VisitEnter( const TiXmlElement& element, const TiXmlAttribute* attribute )
+	{
+		++elements;
+		for( ; attribute; attribute = attribute->Next() )
+			bytes += attribute->ValueStr().size();
+		return true;
+	}
+	virtual bool Visit( const TiXmlText& text )		{ bytes += text.ValueStr().size(); return true; }
+
+	size_t elements, bytes;
+};
+
+
+class FrozenCounter : public TiXmlFrozenVisitor
+{
+public:
+	FrozenCounter() : elements( 0 ), bytes( 0 ) {}
+	virtual bool VisitEnter( TiXmlFrozenHandle element )
+	{
+		++elements;
+		for( int i=0; i<element.AttributeCount(); ++i )
+			bytes += strlen( element.AttributeValue( i ) );
+		return true;
+	}
+	virtual bool Visit( TiXmlFrozenHandle node )
+	{
+		if ( node.IsText() )
+			bytes += node.ValueLength();
+		return true;
+	}
+
+	size_t elements, bytes;
+};
+
+
+static bool BenchFreeze( int records, int iterations )
+{
+	const string msg = MakeMessage( records );
+
+	long long before = liveBytes;
+	TiXmlDocument* doc = new TiXmlDocument;
+	doc->Parse( msg.begin(), msg.end() );
+	long long domBytes = liveBytes - before;
+
+	before = liveBytes;
+	TiXmlFrozenDocument* frozen = new TiXmlFrozenDocument( doc->Freeze() );
+	long long frozenBytes = liveBytes - before;
+
+	printf( "\nFrozen: %d records, %u nodes\n", records, frozen->NodeCount() );
+	printf( "%-40s %12lld bytes\n", "DOM", domBytes );
+	printf( "%-40s %12lld bytes (%u in arrays)\n", "frozen", frozenBytes, (unsigned) frozen->MemoryUsed() );
+
+	Result freeze = Measure( iterations, [&]() {
+		TiXmlFrozenDocument f = doc->Freeze();
+	} );
+	Report( "Freeze()", freeze );
+
+	DomCounter domCount;
+	Result dom = Measure( iterations, [&]() {
+		doc->Accept( &domCount );
+	} );
+	Report( "DOM Accept()", dom );
+
+	FrozenCounter frozenCount;
+	Result flat = Measure( iterations, [&]() {
+		frozen->Accept( &frozenCount );
+	} );
+	Report( "frozen Accept()", flat );
+
+	bool ok = domCount.elements == frozenCount.elements && domCount.bytes == frozenCount.bytes;
+	if ( !ok )
+		printf( "FAIL: the traversals disagree\n" );
+	if ( frozenBytes >= domBytes )
+	{
+		printf( "FAIL: the frozen document is not smaller\n" );
+		ok = false;
+	}
+	delete frozen;
+	delete doc;
+	return ok;
+}
+
+
+static bool BenchBinary( int records, int iterations )
+{
+	const char* xmlPath = "xmlbench.xml";
+	const char* binPath = "xmlbench.xml.bin";
+	{
+		TiXmlDocument doc;
+		const string msg = MakeMessage( records );
+		doc.Parse( msg.begin(), msg.end() );
+		doc.SaveFile( xmlPath );
+	}
+	TiXmlDocument loaded;
+	loaded.LoadFile( xmlPath );
+	bool ok = loaded.SaveBinary( binPath, xmlPath );
+	printf( "\nBinary image: %d records\n", records );
+
+	Result parse = Measure( iterations, [&]() {
+		TiXmlDocument doc;
+		doc.LoadFile( xmlPath );
+	} );
+	Report( "LoadFile()", parse );
+
+	TiXmlFrozenDocument frozen;
+	Result map = Measure( iterations, [&]() {
+		ok = frozen.LoadBinary( binPath, xmlPath ) && ok;
+	} );
+	Report( "LoadBinary()", map );
+
+	if ( !ok || !frozen.Mapped() )
+	{
+		printf( "FAIL: the image did not load\n" );
+		ok = false;
+	}
+	frozen = TiXmlFrozenDocument();
+	remove( binPath );
+	remove( xmlPath );
+	return ok;
+}
+
+
+static bool BenchCompact( int records, int iterations )
+{
+	const string msg = MakeMessage( records );
+	TiXmlDocument doc;
+	doc.Parse( msg.begin(), msg.end() );
+
+	TiXmlPrinter printer;
+	printer.SetStreamPrinting();
+	doc.Accept( &printer );
+	const string text = printer.Str();
+	TiXmlCompactEncoder encoder;
+	doc.Accept( &encoder );
+	const string compact = encoder.Str();
+
+	printf( "\nCompact binary: %d records\n", records );
+	printf( "%-40s %12d bytes\n", "text", (int) text.size() );
+	printf( "%-40s %12d bytes\n", "compact", (int) compact.size() );
+
+	Result print = Measure( iterations, [&]() {
+		TiXmlPrinter p;
+		p.SetStreamPrinting();
+		doc.Accept( &p );
+	} );
+	Report( "TiXmlPrinter", print );
+
+	Result encode = Measure( iterations, [&]() {
+		TiXmlCompactEncoder e;
+		doc.Accept( &e );
+	} );
+	Report( "TiXmlCompactEncoder", encode );
+
+	// Reused, the encoder keeps its tables and its buffer.
+	Result reencode = Measure( iterations, [&]() {
+		doc.Accept( &encoder );
+	} );
+	Report( "TiXmlCompactEncoder, reused", reencode );
+
+	TiXmlDocument parsed;
+	for( int i=0; i<2; ++i )
+	{
+		parsed.Reset();
+		parsed.Parse( text.begin(), text.end() );
+	}
+	Result parse = Measure( iterations, [&]() {
+		parsed.Reset();
+		parsed.Parse( text.begin(), text.end() );
+	} );
+	Report( "Reset() and Parse()", parse );
+
+	TiXmlCompactDecoder decoder;
+	TiXmlDocument decoded;
+	for( int i=0; i<2; ++i )
+		decoder.Decode( compact, &decoded );
+	Result decode = Measure( iterations, [&]() {
+		decoder.Decode( compact, &decoded );
+	} );
+	Report( "TiXmlCompactDecoder", decode );
+
+	TiXmlPrinter check;
+	check.SetStreamPrinting();
+	decoded.Accept( &check );
+	if ( decoded.Error() || check.Str() != text )
+	{
+		printf( "FAIL: decoded document differs\n" );
+		return false;
+	}
+	if ( compact.size() >= text.size() )
+	{
+		printf( "FAIL: the compact form is not smaller\n" );
+		return false;
+	}
+	if ( encoder.Str() != compact || reencode.allocsPerIteration != 0 )
+	{
+		printf( "FAIL: a reused encoder wrote something else, or allocated\n" );
+		return false;
+	}
+	return true;
+}
+
+
+static bool BenchPrint( int records, int iterations )
+{
+	const string msg = MakeMessage( records );
+	TiXmlDocument doc;
+	doc.Parse( msg.begin(), msg.end() );
+
+	TiXmlPrinter printer;
+	doc.Accept( &printer );
+	const string expected = printer.Str();
+	printf( "\nPrint: %d records, %d bytes\n", records, (int) expected.size() );
+
+	Result fresh = Measure( iterations, [&]() {
+		TiXmlPrinter p;
+		doc.Accept( &p );
+	} );
+	Report( "new printer per document", fresh );
+
+	Result reused = Measure( iterations, [&]() {
+		printer.Clear();
+		doc.Accept( &printer );
+	} );
+	Report( "Clear() and print", reused );
+
+	// The floor: copying the same number of bytes.
+	string copy;
+	copy.reserve( expected.size() );
+	Result floor = Measure( iterations, [&]() {
+		copy.assign( expected );
+	} );
+	Report( "copy of the output", floor );
+
+	if ( printer.Str() != expected )
+	{
+		printf( "FAIL: printing again gave different output\n" );
+		return false;
+	}
+	if ( reused.allocsPerIteration != 0 )
+	{
+		printf( "FAIL: printing into a cleared printer allocated\n" );
+		return false;
+	}
+	return true;
+}
+
+
+static bool BenchEscape( int paragraphs, int iterations )
+{
+	// Long text with an entity every few hundred bytes, as in prose.
+	string text;
+	for( int i=0; i<paragraphs; ++i )
+		text += "The quick brown fox jumps over the lazy dog, again and again, "
+				"until the dog finally wakes up & chases it out of the garden <gate>. ";
+	printf( "\nEscape: %d bytes of text\n", (int) text.size() );
+
+	// The old way: one character at a time.
+	string slow;
+	Result bytewise = Measure( iterations, [&]() {
+		slow.clear();
+		for( size_t i=0; i<text.size(); ++i )
+		{
+			char c = text[i];
+			if ( c == '&' )			slow += "&amp;";
+			else if ( c == '<' )	slow += "&lt;";
+			else if ( c == '>' )	slow += "&gt;";
+			else					slow += c;
+		}
+	} );
+	Report( "one byte at a time", bytewise );
+
+	string fast;
+	Result encoded = Measure( iterations, [&]() {
+		fast.clear();
+		TiXmlBase::EncodeString( text, &fast, TIXML_ESCAPE_TEXT );
+	} );
+	Report( "EncodeString", encoded );
+
+	string copy;
+	copy.reserve( fast.size() );
+	Result floor = Measure( iterations, [&]() {
+		copy.assign( fast );
+	} );
+	Report( "copy of the output", floor );
+
+	if ( fast != slow )
+	{
+		printf( "FAIL: EncodeString disagrees with the byte loop\n" );
+		return false;
+	}
+	return true;
+}
+
+
+static bool BenchSave( int records, int iterations )
+{
+	const string msg = MakeMessage( records );
+	TiXmlDocument doc;
+	doc.Parse( msg.begin(), msg.end() );
+	printf( "\nSave: %d records\n", records );
+
+	// Into memory first, whole, as a string sink does.
+	string all;
+	Result whole = Measure( iterations, [&]() {
+		all.clear();
+		TiXmlStringSink sink( &all );
+		doc.Save( &sink );
+	} );
+	Report( "whole document in a string", whole );
+
+	// Then through a buffer that is drained as it fills.
+	size_t bytes = 0;
+	int blocks = 0;
+	long long peak = 0;
+	Result drained = Measure( iterations, [&]() {
+		bytes = 0;
+		blocks = 0;
+		long long before = liveBytes;
+		TiXmlCallbackSink sink( [&]( const char*, size_t size ) {
+			bytes += size;
+			++blocks;
+			if ( liveBytes - before > peak )
+				peak = liveBytes - before;
+			return true;
+		} );
+		doc.Save( &sink );
+	} );
+	Report( "64 KB sink", drained );
+	printf( "%d bytes in %d writes, %lld KB held at most\n", (int) bytes, blocks, peak / 1024 );
+
+	if ( bytes != all.size() )
+	{
+		printf( "FAIL: the sink wrote %d bytes, not %d\n", (int) bytes, (int) all.size() );
+		return false;
+	}
+	return true;
+}
+
+
+static bool BenchWriter( int records, int iterations )
+{
+	printf( "\nWriter: %d records\n", records );
+
+	size_t domBytes = 0;
+	long long domPeak = 0;
+	Result dom = Measure( iterations, [&]() {
+		long long before = liveBytes;
+		TiXmlDocument doc;
+		TiXmlElement* root = new TiXmlElement( "Orders" );
+		doc.LinkEndChild( root );
+		for( int i=0; i<records; ++i )
+		{
+			TiXmlElement* order = new TiXmlElement( "Order" );
+			order->SetAttribute( "id", i );
+			order->SetAttribute( "express", ( i & 1 ) ? "yes" : "no" );
+			TiXmlElement* item = new TiXmlElement( "Item" );
+			item->LinkEndChild( new TiXmlText( "Widget & gadget" ) );
+			order->LinkEndChild( item );
+			root->LinkEndChild( order );
+		}
+		domPeak = liveBytes - before;
+		domBytes = 0;
+		TiXmlCallbackSink sink( [&]( const char*, size_t size ) { domBytes += size; return true; } );
+		doc.Save( &sink );
+	} );
+	Report( "build a document and save it", dom );
+	printf( "%lld KB held\n", domPeak / 1024 );
+
+	size_t writerBytes = 0;
+	long long writerPeak = 0;
+	Result streamed = Measure( iterations, [&]() {
+		long long before = liveBytes;
+		writerBytes = 0;
+		TiXmlCallbackSink sink( [&]( const char*, size_t size ) {
+			writerBytes += size;
+			if ( liveBytes - before > writerPeak )
+				writerPeak = liveBytes - before;
+			return true;
+		} );
+		TiXmlStreamWriter writer( &sink );
+		writer.OpenElement( "Orders" );
+		for( int i=0; i<records; ++i )
+		{
+			writer.OpenElement( "Order" );
+			writer.PushAttribute( "id", i );
+			writer.PushAttribute( "express", ( i & 1 ) ? "yes" : "no" );
+			writer.OpenElement( "Item" );
+			writer.PushText( "Widget & gadget" );
+			writer.CloseElement();
+			writer.CloseElement();
+		}
+		writer.CloseElement();
+		writer.Finish();
+	} );
+	Report( "stream writer", streamed );
+	printf( "%lld KB held\n", writerPeak / 1024 );
+
+	if ( writerBytes != domBytes )
+	{
+		printf( "FAIL: the writer wrote %d bytes, the document %d\n", (int) writerBytes, (int) domBytes );
+		return false;
+	}
+	return true;
+}
+
+
+static bool BenchParallelPrint( int records, int iterations )
+{
+	const string msg = MakeMessage( records );
+	TiXmlDocument doc;
+	doc.Parse( msg.begin(), msg.end() );
+	printf( "\nParallel print: %d records, %u cores\n", records, thread::hardware_concurrency() );
+
+	string expected;
+	Result single = Measure( iterations, [&]() {
+		expected.clear();
+		TiXmlStringSink sink( &expected );
+		doc.Save( &sink );
+	} );
+	Report( "TiXmlPrinter", single );
+
+	bool same = true;
+	const int threads[] = { 2, 4, 8 };
+	for( int t : threads )
+	{
+		string out;
+		out.reserve( expected.size() );
+		Result parallel = Measure( iterations, [&]() {
+			out.clear();
+			TiXmlStringSink sink( &out );
+			TiXmlParallelPrinter printer( t );
+			printer.Print( doc, &sink );
+		} );
+		char label[64];
+		snprintf( label, sizeof( label ), "%d threads", t );
+		Report( label, parallel );
+		same = same && out == expected;
+	}
+
+	if ( !same )
+	{
+		printf( "FAIL: parallel printing gave different output\n" );
+		return false;
+	}
+	return true;
+}
+
+
+static bool BenchNumbers( int records, int iterations )
+{
+	const string msg = MakeMessage( records );
+	TiXmlDocument doc;
+	doc.Parse( msg.begin(), msg.end() );
+	printf( "\nNumbers: %d records, 4 values each\n", records );
+
+	// The old way: a stringstream for each value.
+	long long streamSum = 0;
+	Result streamed = Measure( iterations, [&]() {
+		streamSum = 0;
+		for( TiXmlElement* order = doc.RootElement()->FirstChildElement(); order; order = order->NextSiblingElement() )
+		{
+			int id = 0, priority = 0, qty = 0;
+			stringstream( *order->Attribute( "id", (int*) 0 ) ) >> id;
+			stringstream( *order->Attribute( "priority", (int*) 0 ) ) >> priority;
+			stringstream( *order->FirstChildElement()->Attribute( "qty", (int*) 0 ) ) >> qty;
+			streamSum += id + priority + qty + ( *order->Attribute( "express", (int*) 0 ) == "yes" );
+		}
+	} );
+	Report( "stringstream", streamed );
+
+	long long sum = 0;
+	Result queried = Measure( iterations, [&]() {
+		sum = 0;
+		for( TiXmlElement* order = doc.RootElement()->FirstChildElement(); order; order = order->NextSiblingElement() )
+		{
+			int id = 0, priority = 0, qty = 0;
+			bool express = false;
+			order->QueryIntAttribute( "id", &id );
+			order->QueryIntAttribute( "priority", &priority );
+			order->FirstChildElement()->QueryIntAttribute( "qty", &qty );
+			order->QueryBoolAttribute( "express", &express );
+			sum += id + priority + qty + express;
+		}
+	} );
+	Report( "Query*Attribute", queried );
+
+	// Attributes that exist are rewritten in place.
+	int round = 0;
+	Result set = Measure( iterations, [&]() {
+		++round;
+		for( TiXmlElement* order = doc.RootElement()->FirstChildElement(); order; order = order->NextSiblingElement() )
+		{
+			order->SetAttribute( "priority", round );
+			order->FirstChildElement()->SetDoubleAttribute( "qty", round * 0.25 );
+		}
+	} );
+	Report( "SetAttribute in place", set );
+
+	if ( sum != streamSum || queried.allocsPerIteration != 0 || set.allocsPerIteration != 0 )
+	{
+		printf( "FAIL: the sums differ, or reading and writing numbers allocated\n" );
+		return false;
+	}
+	return true;
+}
+
+
+static bool BenchBind( int records, int iterations )
+{
+	const string msg = MakeMessage( records );
+	printf( "\nBind: %d records into structs\n", records );
+
+	// The usual way: parse a document, then copy the fields out by hand.
+	long long handSum = 0;
+	TiXmlDocument doc;
+	BenchOrder order;
+	Result byHand = Measure( iterations, [&]() {
+		handSum = 0;
+		doc.Parse( msg.begin(), msg.end() );
+		for( TiXmlElement* e = doc.RootElement()->FirstChildElement(); e; e = e->NextSiblingElement() )
+		{
+			e->QueryIntAttribute( "id", &order.id );
+			e->QueryStringAttribute( "customer", order.customer );
+			e->QueryIntAttribute( "priority", &order.priority );
+			e->QueryBoolAttribute( "express", &order.express );
+			TiXmlElement* item = e->FirstChildElement( "Item" );
+			item->QueryStringAttribute( "sku", order.item.sku );
+			item->QueryIntAttribute( "qty", &order.item.qty );
+			order.item.label = item->GetText();
+			order.note = e->FirstChildElement( "Note" )->GetText();
+			handSum += order.id + order.priority + order.express + order.item.qty + order.item.label.size() + order.note.size();
+		}
+	} );
+	Report( "document and Query calls", byHand );
+
+	// Straight from the text, with no document.
+	long long boundSum = 0;
+	TiXmlBinder binder;
+	Result bound = Measure( iterations, [&]() {
+		boundSum = 0;
+		TiXmlPullParser parser( msg );
+		while ( parser.Next() != TiXmlPullParser::PULL_START_ELEMENT )
+			;
+		while ( binder.Load( &parser, &order ) )
+			boundSum += order.id + order.priority + order.express + order.item.qty + order.item.label.size() + order.note.size();
+	} );
+	Report( "TiXmlBinder on the pull parser", bound );
+
+	if ( handSum != boundSum || binder.Error() )
+	{
+		printf( "FAIL: the binder read something else: %s\n", binder.ErrorDesc() );
+		return false;
+	}
+	return true;
+}
+
+
+static bool BenchXPath( int records, int iterations )
+{
+	const string msg = MakeMessage( records );
+	TiXmlDocument doc;
+	doc.Parse( msg.begin(), msg.end() );
+	printf( "\nXPath: %d records, the items of priority 2 orders\n", records );
+
+	// The usual way: a loop over the children, by hand.
+	size_t handCount = 0;
+	Result byHand = Measure( iterations, [&]() {
+		handCount = 0;
+		for( TiXmlElement* order = doc.RootElement()->FirstChildElement( "Order" ); order; order = order->NextSiblingElement( "Order" ) )
+		{
+			const TiXmlAttribute* priority = order->FindAttribute( "priority" );
+			if ( !priority || priority->ValueStr() != "2" )
+				continue;
+			for( TiXmlElement* item = order->FirstChildElement( "Item" ); item; item = item->NextSiblingElement( "Item" ) )
+			{
+				if ( item->FirstChild() && item->FirstChild()->ToText() )
+					++handCount;
+			}
+		}
+	} );
+	Report( "loops by hand", byHand );
+
+	const char* expression = "/Orders/Order[@priority='2']/Item/text()";
+	TiXmlXPath xpath( expression );
+	TiXmlXPathResult result;
+	xpath.Select( &doc, &result );		// grow the result once
+	size_t compiledCount = 0;
+	Result compiled = Measure( iterations, [&]() {
+		xpath.Select( &doc, &result );
+		compiledCount = result.Size();
+	} );
+	Report( "TiXmlXPath, compiled once", compiled );
+
+	size_t cachedCount = 0;
+	Result cached = Measure( iterations, [&]() {
+		TiXmlXPath::Cached( expression )->Select( &doc, &result );
+		cachedCount = result.Size();
+	} );
+	Report( "TiXmlXPath::Cached", cached );
+
+	size_t descendantCount = 0;
+	TiXmlXPath descendant( "//Item[@qty='3']" );
+	Result anywhere = Measure( iterations, [&]() {
+		descendant.Select( &doc, &result );
+		descendantCount = result.Size();
+	} );
+	Report( "TiXmlXPath, '//' with a filter", anywhere );
+
+	if ( handCount != compiledCount || handCount != cachedCount || descendantCount == 0 || compiled.allocsPerIteration != 0 )
+	{
+		printf( "FAIL: the paths found something else, or a compiled path allocated\n" );
+		return false;
+	}
+	return true;
+}
+
+
+static bool BenchStreamXPath( int records, int iterations )
+{
+	const string msg = MakeMessage( records );
+	printf( "\nStream XPath: %d records, %d bytes\n", records, (int) msg.size() );
+
+	// A document first, then the path.
+	size_t domOrders = 0, domLabels = 0;
+	Result dom = Measure( iterations, [&]() {
+		TiXmlDocument doc;
+		doc.Parse( msg.begin(), msg.end() );
+		TiXmlXPathResult result;
+		TiXmlXPath::Cached( "//Order[@priority='2']" )->Select( &doc, &result );
+		domOrders = result.Size();
+		TiXmlXPath::Cached( "//Order/Item/text()" )->Select( &doc, &result );
+		domLabels = result.Size();
+	} );
+	Report( "Parse, then TiXmlXPath", dom );
+
+	// Straight off the parser.
+	size_t streamOrders = 0, streamLabels = 0;
+	TiXmlStreamXPath count( "count(//Order[@priority='2'])" );
+	TiXmlStreamXPath labels( "//Order/Item/text()" );
+	bool ok = true;
+	Result stream = Measure( iterations, [&]() {
+		TiXmlPullParser orderParser( msg );
+		ok = count.Run( &orderParser ) && ok;
+		streamOrders = count.MatchCount();
+		TiXmlPullParser labelParser( msg );
+		ok = labels.Run( &labelParser ) && ok;
+		streamLabels = labels.MatchCount();
+	} );
+	Report( "TiXmlStreamXPath", stream );
+
+	if ( !ok || domOrders != streamOrders || domLabels != streamLabels )
+	{
+		printf( "FAIL: the stream found something else\n" );
+		return false;
+	}
+	return true;
+}
+
+
+static bool BenchElementIndex( int records, int iterations )
+{
+	const string msg = MakeMessage( records );
+	printf( "\nElement index: %d records, %d lookups by id\n", records, iterations );
+
+	TiXmlDocument plain;
+	plain.Parse( msg.begin(), msg.end() );
+	TiXmlDocument indexed;
+	indexed.EnableElementIndex();
+	indexed.IndexAttribute( "id" );
+	Result build = Measure( 1, [&]() {
+		indexed.Parse( msg.begin(), msg.end() );
+		indexed.GetElementsByTagName( "Order" );
+	} );
+	Report( "Parse and build the index", build );
+
+	char id[16];
+	int walked = 0, found = 0;
+	Result walk = Measure( iterations, [&]() {
+		snprintf( id, sizeof( id ), "%d", ( walked * 7919 ) % records );
+		walked += plain.GetElementByAttribute( "id", id ) != 0;
+	} );
+	Report( "GetElementByAttribute, walking", walk );
+	Result lookup = Measure( iterations, [&]() {
+		snprintf( id, sizeof( id ), "%d", ( found * 7919 ) % records );
+		found += indexed.GetElementByAttribute( "id", id ) != 0;
+	} );
+	Report( "GetElementByAttribute, indexed", lookup );
+
+	size_t walkedItems = 0, indexedItems = 0;
+	vector< const TiXmlElement* > items;
+	Result byNameWalk = Measure( 10, [&]() { plain.GetElementsByTagName( "Item", &items ); walkedItems = items.size(); } );
+	Report( "GetElementsByTagName, walking", byNameWalk );
+	Result byName = Measure( 10, [&]() { indexedItems = indexed.GetElementsByTagName( "Item" ).size(); } );
+	Report( "GetElementsByTagName, indexed", byName );
+
+	// Changing indexed attributes keeps the index up to date as it goes.
+	int round = 0;
+	Result update = Measure( iterations, [&]() {
+		TiXmlElement* order = indexed.GetElementByAttribute( "id", "0" );
+		if ( !order )
+			order = indexed.GetElementByAttribute( "id", "renamed" );
+		order->SetAttribute( "id", ( ++round & 1 ) ? "renamed" : "0" );
+	} );
+	Report( "SetAttribute on an indexed attribute", update );
+
+	if ( walked != iterations || found != iterations || walkedItems != (size_t) records || indexedItems != walkedItems )
+	{
+		printf( "FAIL: the index found something else\n" );
+		return false;
+	}
+	return true;
+}
+
+
+// Finds the texts holding a phrase the slow way, for BenchTextIndex().
+class PhraseScan : public TiXmlVisitor
+{
+public:
+	explicit PhraseScan( const char* phrase )	{ TiXmlTextIndex::Tokenize( phrase, &query ); }
+
+	virtual bool Visit( const TiXmlText& text )
+	{
+		words.clear();
+		TiXmlTextIndex::Tokenize( text.ValueStr(), &words );
+		if ( std::search( words.begin(), words.end(), query.begin(), query.end() ) != words.end() )
+			found.push_back( &text );
+		return true;
+	}
+
+	vector< string > query;
+	vector< string > words;
+	vector< const TiXmlText* > found;
+};
+
+
+static bool BenchTextIndex( int records, int iterations )
+{
+	const string msg = MakeMessage( records );
+	printf( "\nText index: %d records, %d phrase queries\n", records, iterations );
+
+	TiXmlDocument doc;
+	doc.Parse( msg.begin(), msg.end() );
+	doc.EnableTextIndex();
+	for( int threads : { 1, 4 } )
+	{
+		TiXmlTextIndex index( threads );
+		Result build = Measure( 1, [&]() { index.Build( &doc ); } );
+		Report( threads == 1 ? "Build, 1 thread" : "Build, 4 threads", build );
+	}
+	doc.TextIndex();
+
+	char phrase[32];
+	int scanned = 0, found = 0;
+	Result scan = Measure( iterations, [&]() {
+		snprintf( phrase, sizeof( phrase ), "gadget %d", ( scanned * 7919 ) % records );
+		PhraseScan visitor( phrase );
+		doc.Accept( &visitor );
+		scanned += (int) visitor.found.size();
+	} );
+	Report( "Accept, tokenizing every text", scan );
+	vector< const TiXmlText* > texts;
+	Result query = Measure( iterations, [&]() {
+		snprintf( phrase, sizeof( phrase ), "gadget %d", ( found * 7919 ) % records );
+		found += (int) doc.TextIndex()->Find( phrase, TiXmlTextIndex::MATCH_PHRASE, &texts );
+	} );
+	Report( "TextIndex()->Find, phrase", query );
+
+	// Changing a text takes its old words out and puts the new ones in.
+	TiXmlText* text = doc.RootElement()->FirstChildElement()->FirstChildElement()->FirstChild()->ToText();
+	int round = 0;
+	Result update = Measure( iterations, [&]() {
+		text->SetValue( ( ++round & 1 ) ? "Sprocket & cog" : "Widget & gadget #0" );
+	} );
+	Report( "SetValue on an indexed text", update );
+
+	if ( scanned != iterations || found != iterations )
+	{
+		printf( "FAIL: the index found something else\n" );
+		return false;
+	}
+	return true;
+}
+
+
+static bool BenchRanges( int records, int iterations )
+{
+	const string msg = MakeMessage( records );
+	TiXmlDocument doc;
+	doc.Parse( msg.begin(), msg.end() );
+	const TiXmlElement* root = doc.RootElement();
+	printf( "\nRanges: %d records\n", records );
+
+	int looped = 0, ranged = 0;
+	Result loop = Measure( iterations, [&]() {
+		for( const TiXmlElement* order = root->FirstChildElement( "Order" ); order; order = order->NextSiblingElement( "Order" ) )
+			for( const TiXmlElement* item = order->FirstChildElement( "Item" ); item; item = item->NextSiblingElement( "Item" ) )
+				++looped;
+	} );
+	Report( "FirstChildElement/NextSiblingElement", loop );
+	Result range = Measure( iterations, [&]() {
+		for( const TiXmlElement* order : root->Elements( "Order" ) )
+			for( const TiXmlElement* item : order->Elements( "Item" ) )
+			{
+				(void) item;
+				++ranged;
+			}
+	} );
+	Report( "Elements( name )", range );
+
+	int iterated = 0, children = 0;
+	Result iterate = Measure( iterations, [&]() {
+		for( const TiXmlNode* order = 0; ( order = root->IterateChildren( order ) ) != 0; )
+			for( const TiXmlNode* child = 0; ( child = order->IterateChildren( child ) ) != 0; )
+				++iterated;
+	} );
+	Report( "IterateChildren", iterate );
+	Result childRange = Measure( iterations, [&]() {
+		for( const TiXmlNode* order : root->Children() )
+			children += (int) std::distance( order->Children().begin(), order->Children().end() );
+	} );
+	Report( "Children()", childRange );
+
+	int descended = 0;
+	Result descend = Measure( iterations, [&]() {
+		for( const TiXmlElement* element : doc.DescendantElements() )
+		{
+			(void) element;
+			++descended;
+		}
+	} );
+	Report( "DescendantElements()", descend );
+
+	if ( looped != ranged || iterated != children || looped != records * iterations || descended != ( 1 + 3 * records ) * iterations )
+	{
+		printf( "FAIL: the ranges visited something else\n" );
+		return false;
+	}
+	return true;
+}
+
+
+// Counts the Item elements and the bytes of text, through Accept().
+class ItemCounter : public TiXmlVisitor
+{
+public:
+	virtual bool VisitEnter( const TiXmlElement& element, const TiXmlAttribute* )
+	{
+		items += element.ValueStr() == "Item";
+		return true;
+	}
+	virtual bool Visit( const TiXmlText& text )
+	{
+		bytes += text.ValueStr().size();
+		return true;
+	}
+
+	size_t items = 0;
+	size_t bytes = 0;
+};
+
+// The same, for TiXmlWalk().
+struct ItemWalker
+{
+	bool VisitEnter( const TiXmlElement& element, const TiXmlAttribute* )
+	{
+		items += element.ValueStr() == "Item";
+		return true;
+	}
+	bool Visit( const TiXmlText& text )
+	{
+		bytes += text.ValueStr().size();
+		return true;
+	}
+
+	size_t items = 0;
+	size_t bytes = 0;
+};
+
+
+static bool BenchWalk( int nodes, int iterations )
+{
+	// Groups of a thousand items, each item an element and its text.
+	TiXmlDocument doc;
+	TiXmlElement* root = doc.LinkEndChild( new TiXmlElement( "Root" ) )->ToElement();
+	TiXmlElement* group = 0;
+	for( int i = 0; i < nodes / 2; ++i )
+	{
+		if ( i % 1000 == 0 )
+			group = root->LinkEndChild( new TiXmlElement( "Group" ) )->ToElement();
+		group->LinkEndChild( new TiXmlElement( "Item" ) )->LinkEndChild( new TiXmlText( "value" ) );
+	}
+	printf( "\nWalk: %d nodes\n", nodes );
+
+	ItemCounter counter;
+	Result accept = Measure( iterations, [&]() { doc.Accept( &counter ); } );
+	Report( "Accept", accept );
+	ItemWalker walker;
+	Result walk = Measure( iterations, [&]() { TiXmlWalk( doc, walker ); } );
+	Report( "TiXmlWalk", walk );
+
+	if ( counter.items != walker.items || counter.bytes != walker.bytes || walker.items != (size_t) ( nodes / 2 ) * iterations )
+	{
+		printf( "FAIL: the walk saw something else\n" );
+		return false;
+	}
+	return true;
+}
+
+
+// Totals the quantities of MakeMessage()'s items, and counts bad ones.
+class QuantityVisitor : public TiXmlVisitor
+{
+public:
+	virtual bool VisitEnter( const TiXmlElement& element, const TiXmlAttribute* )
+	{
+		if ( element.ValueStr() != "Item" )
+			return true;
+		int qty = 0;
+		if ( element.QueryIntAttribute( "qty", &qty ) == TIXML_SUCCESS && qty > 0 )
+			total += qty;
+		else
+			++bad;
+		return false;
+	}
+
+	long long total = 0;
+	int bad = 0;
+};
+
+
+static bool BenchParallelTraversal( int records, int iterations )
+{
+	const string msg = MakeMessage( records );
+	TiXmlDocument doc;
+	doc.Parse( msg.begin(), msg.end() );
+	printf( "\nParallel traversal: %d records, %u cores\n", records, std::thread::hardware_concurrency() );
+
+	QuantityVisitor serial;
+	Result accept = Measure( iterations, [&]() { serial = QuantityVisitor(); doc.Accept( &serial ); } );
+	Report( "Accept", accept );
+
+	auto reduce = []( QuantityVisitor& into, const QuantityVisitor& part ) {
+		into.total += part.total;
+		into.bad += part.bad;
+	};
+	QuantityVisitor parallel;
+	size_t tasks = 0;
+	for( int threads : { 2, 4 } )
+	{
+		TiXmlParallelTraversal traversal( threads );
+		Result result = Measure( iterations, [&]() {
+			parallel = QuantityVisitor();
+			traversal.Accept( doc, &parallel, reduce );
+		} );
+		tasks = traversal.Tasks();
+		Report( threads == 2 ? "TiXmlParallelTraversal, 2 threads" : "TiXmlParallelTraversal, 4 threads", result );
+	}
+	printf( "%u tasks\n", (unsigned) tasks );
+
+	if ( serial.total != parallel.total || serial.bad != parallel.bad || tasks < 2 )
+	{
+		printf( "FAIL: the parallel traversal found something else\n" );
+		return false;
+	}
+	return true;
+}
+
+
+static bool BenchXPathSet( int records, int iterations )
+{
+	const string msg = MakeMessage( records );
+	TiXmlDocument doc;
+	doc.Parse( msg.begin(), msg.end() );
+
+	// The lookups one message might get: by priority, by quantity, a few
+	// customers and positions, and some whole columns.
+	vector< string > expressions;
+	char buf[128];
+	for( int i=0; i<5; ++i )
+	{
+		snprintf( buf, sizeof( buf ), "/Orders/Order[@priority='%d']/@id", i );
+		expressions.push_back( buf );
+	}
+	for( int i=1; i<=9; ++i )
+	{
+		snprintf( buf, sizeof( buf ), "//Item[@qty='%d']", i );
+		expressions.push_back( buf );
+	}
+	for( int i=0; i<10; ++i )
+	{
+		snprintf( buf, sizeof( buf ), "//Order[@customer='c%05d']/Item/@sku", ( i * records / 10 ) * 7 );
+		expressions.push_back( buf );
+		snprintf( buf, sizeof( buf ), "/Orders/Order[%d]/Note/text()", 1 + i * records / 10 );
+		expressions.push_back( buf );
+	}
+	const char* columns[] = { "/Orders/@batch", "//Item/text()", "/Orders/Order[@express='yes']/Item/@qty", "//Note", "//@sku", "/Orders/Order/Item" };
+	expressions.insert( expressions.end(), columns, columns + sizeof( columns ) / sizeof( columns[0] ) );
+	printf( "\nXPath set: %d records, %d paths\n", records, (int) expressions.size() );
+
+	// One walk for each.
+	vector< TiXmlXPath > paths( expressions.begin(), expressions.end() );
+	TiXmlXPathResult result;
+	size_t oneByOne = 0;
+	Result each = Measure( iterations, [&]() {
+		oneByOne = 0;
+		for( const TiXmlXPath& path : paths )
+		{
+			path.Select( &doc, &result );
+			oneByOne += result.Size();
+		}
+	} );
+	Report( "TiXmlXPath, one path at a time", each );
+
+	// One walk for all.
+	TiXmlXPathSet set;
+	for( const string& expression : expressions )
+		set.Add( expression );
+	vector< TiXmlXPathResult > results;
+	set.Select( &doc, &results );		// work out the moves once
+	size_t together = 0;
+	Result all = Measure( iterations, [&]() {
+		set.Select( &doc, &results );
+		together = 0;
+		for( const TiXmlXPathResult& one : results )
+			together += one.Size();
+	} );
+	Report( "TiXmlXPathSet::Select", all );
+
+	// Over the raw input, against reading it alone.
+	Result read = Measure( iterations, [&]() {
+		TiXmlPullParser parser( msg );
+		while ( parser.Next() != TiXmlPullParser::PULL_END && !parser.Error() )
+			;
+	} );
+	Report( "TiXmlPullParser, reading only", read );
+	size_t streamed = 0;
+	bool ok = true;
+	Result run = Measure( iterations, [&]() {
+		TiXmlPullParser parser( msg );
+		ok = set.Run( &parser ) && ok;
+		streamed = 0;
+		for( size_t i=0; i<set.Size(); ++i )
+			streamed += set.MatchCount( i );
+	} );
+	Report( "TiXmlXPathSet::Run", run );
+
+	if ( !ok || oneByOne != together || oneByOne != streamed || oneByOne == 0 )
+	{
+		printf( "FAIL: the set found something else\n" );
+		return false;
+	}
+	return true;
+}
+
+
+#ifdef TIXML_USE_ZLIB
+static bool BenchGzip( int records, int iterations )
+{
+	const string msg = MakeMessage( records );
+	TiXmlDocument doc;
+	doc.Parse( msg.begin(), msg.end() );
+	printf( "\nGzip: %d records\n", records );
+
+	Result savePlain = Measure( iterations, [&]() { doc.SaveFile( "bench.xml" ); } );
+	Report( "SaveFile", savePlain );
+	Result saveGzip = Measure( iterations, [&]() { doc.SaveFile( "bench.xml.gz" ); } );
+	Report( "SaveFile, gzip", saveGzip );
+
+	long long plainSize = 0, gzipSize = 0;
+	if ( FILE* f = fopen( "bench.xml", "rb" ) ) { fseek( f, 0, SEEK_END ); plainSize = ftell( f ); fclose( f ); }
+	if ( FILE* f = fopen( "bench.xml.gz", "rb" ) ) { fseek( f, 0, SEEK_END ); gzipSize = ftell( f ); fclose( f ); }
+	printf( "%lld KB plain, %lld KB compressed\n", plainSize / 1024, gzipSize / 1024 );
+
+	TiXmlDocument loaded;
+	Result loadPlain = Measure( iterations, [&]() { loaded.LoadFile( "bench.xml" ); } );
+	Report( "LoadFile", loadPlain );
+	bool ok = true;
+	Result loadGzip = Measure( iterations, [&]() { ok = loaded.LoadFile( "bench.xml.gz" ) && ok; } );
+	Report( "LoadFile, gzip", loadGzip );
+
+	remove( "bench.xml" );
+	remove( "bench.xml.gz" );
+	if ( !ok )
+	{
+		printf( "FAIL: the compressed file didn't load\n" );
+		return false;
+	}
+	return true;
+}
+#endif
+
+
+int main( int argc, char* argv[] )
+{
+	int scale = ( argc > 1 ) ? atoi( argv[1] ) : 1;
+	if ( scale < 1 )
+		scale = 1;
+
+	bool ok = true;
+	ok = BenchParse( 10, 2000 * scale ) && ok;
+	ok = BenchParse( 1000, 50 * scale ) && ok;
+	ok = BenchClone( 40000, 5 * scale ) && ok;
+	ok = BenchFreeze( 40000, 5 * scale ) && ok;
+	ok = BenchBinary( 40000, 5 * scale ) && ok;
+	ok = BenchCompact( 1000, 50 * scale ) && ok;
+	ok = BenchPrint( 1000, 50 * scale ) && ok;
+	ok = BenchEscape( 10000, 50 * scale ) && ok;
+	ok = BenchSave( 40000, 5 * scale ) && ok;
+	ok = BenchWriter( 40000, 5 * scale ) && ok;
+	ok = BenchParallelPrint( 40000, 5 * scale ) && ok;
+	ok = BenchNumbers( 10000, 20 * scale ) && ok;
+	ok = BenchBind( 10000, 10 * scale ) && ok;
+	ok = BenchXPath( 10000, 50 * scale ) && ok;
+	ok = BenchStreamXPath( 40000, 5 * scale ) && ok;
+	ok = BenchElementIndex( 40000, 200 * scale ) && ok;
+	ok = BenchTextIndex( 40000, 20 * scale ) && ok;
+	ok = BenchRanges( 40000, 20 * scale ) && ok;
+	ok = BenchWalk( 10000, 3000 * scale ) && ok;
+	ok = BenchParallelTraversal( 200000, 5 * scale ) && ok;
+	ok = BenchWalk( 10000000, 3 * scale ) && ok;
+	ok = BenchXPathSet( 40000, 5 * scale ) && ok;
+#ifdef TIXML_USE_ZLIB
+	ok = BenchGzip( 40000, 5 * scale ) && ok;
+#endif
+	return ok ? 0 : 1;
+}
@@ -4,10 +4,14 @@
 
 #include "tinyxml.h"
 
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <regex>
+#include <algorithm>
+#include <typeinfo>
+#include <thread>
 using namespace std;
 
 #if defined( WIN32 ) && defined( TUNE )
@@ -78,6 +82,1907 @@ void NullLineEndings( char* p )
 	}
 }
 
+// Structs for the TiXmlBind tests.
+enum BindPriority { BIND_LOW, BIND_HIGH };
+
+struct BindItem
+{
+	string sku;
+	int qty = 0;
+	string label;
+};
+
+struct BindOrder
+{
+	int id = 0;
+	bool express = false;
+	BindPriority priority = BIND_LOW;
+	string note;
+	vector< BindItem > items;
+	vector< string > tags;
+};
+
+template<> struct TiXmlBind< BindItem >
+{
+	static constexpr auto members = make_tuple(
+		TiXmlBindAttribute( "sku", &BindItem::sku ),
+		TiXmlBindAttribute( "qty", &BindItem::qty ),
+		TiXmlBindText( &BindItem::label ) );
+};
+
+template<> struct TiXmlBind< BindOrder >
+{
+	static constexpr auto members = make_tuple(
+		TiXmlBindAttribute( "id", &BindOrder::id ),
+		TiXmlBindAttribute( "express", &BindOrder::express ),
+		TiXmlBindElement( "Priority", &BindOrder::priority ),
+		TiXmlBindElement( "Note", &BindOrder::note ),
+		TiXmlBindSequence( "Item", &BindOrder::items ),
+		TiXmlBindSequence( "Tag", &BindOrder::tags ) );
+};
+
+
+// The tests of what this copy adds to TinyXML. main() runs them first,
+// while the global settings are the defaults, then the original tests.
+static void TestExtensions()
+{
+	{
+		// Attributes are kept in document order, and found through the
+		// hash index once an element has more than a few of them.
+		TiXmlDocument doc;
+		string str = "<wide a0='0' a1='1' a2='2' a3='3' a4='4' a5='5' a6='6' a7='7' a8='8' a9='9' />";
+		doc.Parse( str.begin(), str.end() );
+		TiXmlElement* ele = doc.FirstChildElement();
+
+		int count = 0;
+		string order;
+		for( const TiXmlAttribute* a = ele->FirstAttribute(); a; a = a->Next(), ++count )
+			order += a->ValueStr();
+		XmlTest( "Wide element: attribute count.", 10, count );
+		XmlTest( "Wide element: document order.", "0123456789", order );
+		XmlTest( "Wide element: find last.", "9", ele->Attribute( "a9" ) );
+
+		ele->RemoveAttribute( "a4" );
+		ele->SetAttribute( "a10", "10" );
+		XmlTest( "Wide element: removed.", true, ele->Attribute( "a4" ).empty() );
+		XmlTest( "Wide element: find after remove.", "5", ele->Attribute( "a5" ) );
+		XmlTest( "Wide element: appended last.", "10", ele->LastAttribute()->ValueStr() );
+		XmlTest( "Wide element: previous.", "9", ele->LastAttribute()->Previous()->ValueStr() );
+
+		str = "<dup a='1' b='2' a='3' />";
+		doc.Parse( str.begin(), str.end() );
+		XmlTest( "Duplicate attribute is an error.", true, doc.Error() );
+	}
+
+	{
+		// Child index: positional and by-name lookups, kept up to date
+		// through appends, and rebuilt after other changes.
+		TiXmlDocument doc;
+		string str = "<list><a i='0'/><b i='1'/><!--c--><a i='2'/><b i='3'/><a i='4'/></list>";
+		doc.Parse( str.begin(), str.end() );
+		TiXmlElement* list = doc.RootElement();
+		list->EnableChildIndex();
+		TiXmlHandle handle( list );
+
+		XmlTest( "Child index: count.", 6, list->ChildCount() );
+		XmlTest( "Child index: Child(int).", "c", handle.Child( 2 ).ToNode()->Value() );
+		XmlTest( "Child index: ChildElement(int).", "2", handle.ChildElement( 2 ).ToElement()->Attribute( "i" ) );
+		XmlTest( "Child index: ChildElement(name, int).", "4", handle.ChildElement( "a", 2 ).ToElement()->Attribute( "i" ) );
+		XmlTest( "Child index: FirstChildElement(name).", "1", list->FirstChildElement( "b" )->Attribute( "i" ) );
+		XmlTest( "Child index: NextSiblingElement(name).", "3", list->FirstChildElement( "b" )->NextSiblingElement( "b" )->Attribute( "i" ) );
+		XmlTest( "Child index: NextSibling(other name).", "2", list->FirstChild( "b" )->NextSibling( "a" )->ToElement()->Attribute( "i" ) );
+
+		TiXmlElement* a5 = new TiXmlElement( "a" );
+		a5->SetAttribute( "i", "5" );
+		list->LinkEndChild( a5 );
+		XmlTest( "Child index: append.", "5", handle.ChildElement( "a", 3 ).ToElement()->Attribute( "i" ) );
+
+		list->RemoveChild( list->FirstChild( "a" ) );
+		XmlTest( "Child index: remove.", "2", handle.ChildElement( "a", 0 ).ToElement()->Attribute( "i" ) );
+		list->FirstChildElement( "b" )->SetValue( "a" );
+		XmlTest( "Child index: rename.", "1", handle.ChildElement( "a", 0 ).ToElement()->Attribute( "i" ) );
+		XmlTest( "Child index: out of range.", true, handle.Child( 99 ).ToNode() == 0 );
+
+		int count = 0;
+		for( const TiXmlNode* node = list->IterateChildren( "a", 0 ); node; node = list->IterateChildren( "a", node ) )
+			++count;
+		XmlTest( "Child index: IterateChildren(name).", 4, count );
+	}
+
+	{
+		// Reset: the content goes away, but the next parse reuses the
+		// nodes and attributes, which must come back clean.
+		TiXmlDocument doc;
+		string first = "<?xml version='1.0' standalone='yes'?><a x='1' y='2'><![CDATA[<raw>]]><b>text</b></a>";
+		string second = "<c><d z='3'>more text</d><!--note--></c>";
+		doc.Parse( first.begin(), first.end() );
+		XmlTest( "Declaration: standalone.", "yes", doc.FirstChild()->ToDeclaration()->Standalone() );
+		const TiXmlElement* a = doc.RootElement();
+
+		doc.Reset();
+		XmlTest( "Reset: empty.", true, doc.FirstChild() == 0 );
+
+		doc.Parse( second.begin(), second.end() );
+		XmlTest( "Reset: no error.", false, doc.Error() );
+		XmlTest( "Reset: nodes reused.", true, doc.RootElement() == a );
+
+		TiXmlPrinter printer;
+		printer.SetStreamPrinting();
+		doc.Accept( &printer );
+		XmlTest( "Reset: reparsed.", "<c><d z=\"3\">more text</d><!--note--></c>", printer.Str() );
+
+		const TiXmlElement* d = doc.RootElement()->FirstChildElement();
+		XmlTest( "Reset: attributes reused clean.", true, d->FirstAttribute() == d->LastAttribute() );
+		XmlTest( "Reset: CDATA flag cleared.", false, d->FirstChild()->ToText()->CDATA() );
+
+		doc.Reset();
+		doc.Parse( first.begin(), first.end() );
+		printer = TiXmlPrinter();
+		printer.SetStreamPrinting();
+		doc.Accept( &printer );
+		XmlTest( "Reset: reparsed again.", "<?xml version=\"1.0\" standalone=\"yes\" ?><a x=\"1\" y=\"2\"><![CDATA[<raw>]]><b>text</b></a>", printer.Str() );
+
+		// Nodes of the application's own subclasses are deleted, not reused.
+		static int deleted = 0;
+		class MyElement : public TiXmlElement
+		{
+		public:
+			MyElement() : TiXmlElement( "mine" )	{}
+			~MyElement()							{ ++deleted; }
+		};
+		doc.RootElement()->LinkEndChild( new MyElement() )->LinkEndChild( new TiXmlText( "inside" ) );
+		doc.Reset();
+		XmlTest( "Reset: subclass deleted.", 1, deleted );
+		doc.Parse( first.begin(), first.end() );
+		bool plain = true;
+		for( const TiXmlElement* element : doc.DescendantElements() )
+			plain = plain && typeid( *element ) == typeid( TiXmlElement );
+		XmlTest( "Reset: only plain nodes reused.", true, plain && doc.RootElement()->FirstChildElement( "b" )->GetText() == string( "text" ) );
+	}
+
+	{
+		// Move semantics: content is moved into the tree, not cloned.
+		TiXmlDocument doc;
+		TiXmlElement* root = doc.LinkEndChild( std::unique_ptr<TiXmlNode>( new TiXmlElement( "root" ) ) )->ToElement();
+
+		TiXmlElement item( "Item" );
+		std::string value = "a long attribute value, long enough to live on the heap";
+		const char* buffer = value.data();
+		item.SetAttribute( "note", std::move( value ) );
+		item.LinkEndChild( new TiXmlText( "text" ) );
+		TiXmlNode* itemText = item.FirstChild();
+
+		TiXmlNode* moved = root->InsertEndChild( std::move( item ) );
+		XmlTest( "Move: moved-from is empty.", true, item.FirstChild() == 0 && item.FirstAttribute() == 0 );
+		XmlTest( "Move: children not copied.", true, moved->FirstChild() == itemText );
+		XmlTest( "Move: children reparented.", true, itemText->Parent() == moved );
+		XmlTest( "Move: attribute string not copied.", true, moved->ToElement()->FirstAttribute()->ValueStr().data() == buffer );
+
+		root->InsertBeforeChild( moved, TiXmlComment( "first" ) );
+		root->ReplaceChild( root->FirstChild(), TiXmlText( std::string( "replaced" ) ) );
+		XmlTest( "Move: insert and replace.", "replaced", root->FirstChild()->Value() );
+
+		TiXmlElement copy( *moved->ToElement() );
+		TiXmlElement assigned( "x" );
+		assigned = std::move( copy );
+		XmlTest( "Move: assignment.", "Item", assigned.Value() );
+		XmlTest( "Move: assignment attributes.", true, assigned.FirstAttribute() != 0 && copy.FirstAttribute() == 0 );
+
+		// A subtree goes to another document without a copy.
+		TiXmlDocument other;
+		TiXmlNode* otherRoot = other.LinkEndChild( new TiXmlElement( "other" ) );
+		otherRoot->LinkEndChild( root->DetachChild( moved ) );
+		XmlTest( "Move: detached.", true, root->FirstChildElement( "Item" ) == 0 );
+		XmlTest( "Move: subtree in other document.", true, moved->GetDocument() == &other && itemText->GetDocument() == &other );
+
+		TiXmlDocument movedDoc( std::move( other ) );
+		XmlTest( "Move: document.", true, moved->GetDocument() == &movedDoc && other.FirstChild() == 0 );
+
+		// A node type of the application's own, written before moves, is copied.
+		class Legacy : public TiXmlNode
+		{
+		public:
+			Legacy() : TiXmlNode( TiXmlNode::TINYXML_UNKNOWN )	{ SetValue( "legacy" ); }
+			virtual void Print( std::ostream&, int ) const		{}
+			virtual std::string::const_iterator Parse( std::string::const_iterator, std::string::const_iterator last, TiXmlParsingData*, TiXmlEncoding )	{ return last; }
+			virtual TiXmlNode* Clone() const					{ return new Legacy(); }
+			virtual bool Accept( TiXmlVisitor* ) const			{ return true; }
+		protected:
+			virtual void StreamIn( std::istream*, std::string* )	{}
+		};
+		Legacy legacy;
+		TiXmlNode* copied = otherRoot->InsertEndChild( std::move( legacy ) );
+		XmlTest( "Move: a node type without MoveClone() is copied.", true, copied && copied != &legacy && copied->ValueStr() == "legacy" && legacy.ValueStr() == "legacy" );
+
+		// So is a subclass of a library node that only overrides Clone().
+		class Marked : public TiXmlElement
+		{
+		public:
+			Marked() : TiXmlElement( "marked" ), mark( 3 )	{}
+			virtual TiXmlNode* Clone() const
+			{
+				Marked* clone = new Marked();
+				CopyTo( clone );
+				clone->mark = mark;
+				return clone;
+			}
+			int mark;
+		};
+		auto marked = []( const TiXmlNode* node ) {
+			const Marked* m = dynamic_cast<const Marked*>( node );
+			return m && m->mark == 3;
+		};
+		TiXmlNode* endChild = otherRoot->InsertEndChild( Marked() );
+		TiXmlNode* beforeChild = otherRoot->InsertBeforeChild( endChild, Marked() );
+		TiXmlNode* afterChild = otherRoot->InsertAfterChild( endChild, Marked() );
+		bool after = marked( afterChild );
+		TiXmlNode* replaced = otherRoot->ReplaceChild( afterChild, Marked() );
+		XmlTest( "Move: a subclass is inserted by its Clone().", true, marked( endChild ) && marked( beforeChild ) && after && marked( replaced ) );
+	}
+
+	{
+		// Clone: one pass over the tree, attributes copied as a block.
+		string str = "<?xml version='1.0'?><!--c--><a><b x='1' y='2'><c><![CDATA[raw]]></c>text<d/></b><e/>"
+					 "<wide a0='0' a1='1' a2='2' a3='3' a4='4' a5='5' a6='6' a7='7' a8='8' a9='9'/></a>";
+		TiXmlDocument doc;
+		doc.Parse( str.begin(), str.end() );
+
+		TiXmlPrinter original;
+		original.SetStreamPrinting();
+		doc.Accept( &original );
+
+		TiXmlDocument clone( doc );
+		TiXmlPrinter cloned;
+		cloned.SetStreamPrinting();
+		clone.Accept( &cloned );
+		XmlTest( "Clone: same document.", original.Str(), cloned.Str() );
+		XmlTest( "Clone: CDATA kept.", true, TiXmlHandle( &clone ).FirstChild( "a" ).FirstChild( "b" ).FirstChild( "c" ).FirstChild().Text()->CDATA() );
+		XmlTest( "Clone: wide element lookup.", "8", clone.RootElement()->FirstChildElement( "wide" )->Attribute( "a8" ) );
+
+		// Assignment copies into the nodes the target already has.
+		TiXmlDocument target;
+		target.Parse( str.begin(), str.end() );
+		const TiXmlNode* oldRoot = target.RootElement();
+		target = doc;
+		TiXmlPrinter assigned;
+		assigned.SetStreamPrinting();
+		target.Accept( &assigned );
+		XmlTest( "Clone: assignment.", original.Str(), assigned.Str() );
+		XmlTest( "Clone: assignment reuses nodes.", true, target.RootElement() == oldRoot );
+
+		// A child of the application's own subclass is copied by its Clone().
+		class Tagged : public TiXmlElement
+		{
+		public:
+			Tagged() : TiXmlElement( "tagged" ), tag( 0 )	{}
+			virtual TiXmlNode* Clone() const
+			{
+				Tagged* clone = new Tagged();
+				CopyTo( clone );
+				clone->tag = tag;
+				return clone;
+			}
+			int tag;
+		};
+		TiXmlElement parent( "parent" );
+		Tagged* tagged = new Tagged();
+		tagged->tag = 7;
+		tagged->LinkEndChild( new TiXmlText( "inside" ) );
+		parent.LinkEndChild( tagged );
+		parent.LinkEndChild( new TiXmlElement( "after" ) );
+
+		auto keeps = []( const TiXmlNode* node ) {
+			const TiXmlElement* child = node->FirstChildElement();
+			const Tagged* copy = dynamic_cast<const Tagged*>( child );
+			return copy && copy->tag == 7 && copy->GetText() == string( "inside" ) && copy->FirstChild() == copy->LastChild()
+				&& child->NextSiblingElement() && child->NextSiblingElement()->ValueStr() == "after";
+		};
+		TiXmlElement parentCopy( parent );
+		std::unique_ptr<TiXmlNode> parentClone( parent.Clone() );
+		TiXmlElement parentAssigned( "x" );
+		parentAssigned = parent;
+		XmlTest( "Clone: subclass child kept by copy.", true, keeps( &parentCopy ) );
+		XmlTest( "Clone: subclass child kept by Clone().", true, keeps( parentClone.get() ) );
+		XmlTest( "Clone: subclass child kept by assignment.", true, keeps( &parentAssigned ) );
+	}
+
+	{
+		// Double buffered document: readers keep the version they took, edits
+		// publish a new one.
+		string str = "<config><limits max='10'/></config>";
+		TiXmlDocument loaded;
+		loaded.Parse( str.begin(), str.end() );
+		TiXmlDoubleBufferedDocument config( std::move( loaded ) );
+
+		TiXmlDoubleBufferedDocument::Snapshot before = config.Current();
+		bool updated = config.Update( []( TiXmlDocument& doc ) {
+			doc.RootElement()->FirstChildElement( "limits" )->SetAttribute( "max", 20 );
+			return true;
+		} );
+		TiXmlDoubleBufferedDocument::Snapshot after = config.Current();
+
+		XmlTest( "Double buffered: updated.", true, updated );
+		XmlTest( "Double buffered: version.", 1, (int) config.Version() );
+		XmlTest( "Double buffered: old snapshot unchanged.", "10", before->RootElement()->FirstChildElement( "limits" )->Attribute( "max" ) );
+		XmlTest( "Double buffered: new snapshot.", "20", after->RootElement()->FirstChildElement( "limits" )->Attribute( "max" ) );
+
+		// Once no reader holds the old version, the next edit reuses it.
+		const TiXmlDocument* oldStorage = before.get();
+		before.reset();
+		config.Update( []( TiXmlDocument& doc ) {
+			doc.RootElement()->SetAttribute( "edits", 2 );
+			return true;
+		} );
+		XmlTest( "Double buffered: storage reused.", true, config.Current().get() == oldStorage );
+		XmlTest( "Double buffered: edits accumulate.", "20", config.Current()->RootElement()->FirstChildElement( "limits" )->Attribute( "max" ) );
+
+		TiXmlDoubleBufferedDocument::Snapshot last = config.Current();
+		bool discarded = config.Update( []( TiXmlDocument& doc ) {
+			doc.Clear();
+			return false;
+		} );
+		XmlTest( "Double buffered: discarded edit.", true, !discarded && config.Current() == last );
+
+		// A child index left stale by an edit is rebuilt once, by whichever
+		// reader gets to it first.
+		config.Update( []( TiXmlDocument& doc ) {
+			TiXmlElement* root = doc.RootElement();
+			root->EnableChildIndex();
+			for( int i = 0; i < 100; ++i )
+				root->LinkEndChild( new TiXmlElement( "entry" ) )->ToElement()->SetAttribute( "n", i );
+			root->InsertBeforeChild( root->FirstChild(), TiXmlElement( "first" ) );
+			return true;
+		} );
+		TiXmlDoubleBufferedDocument::Snapshot indexed = config.Current();
+		std::atomic< int > agreed( 0 );
+		vector< std::thread > readers;
+		for( int t = 0; t < 4; ++t )
+		{
+			readers.emplace_back( [&]() {
+				const TiXmlElement* root = indexed->RootElement();
+				const TiXmlElement* entry = root->ChildElementAt( "entry", 50 );
+				if ( root->ChildCount() == 102 && entry && entry->Attribute( string( "n" ) ) == "50" )
+					++agreed;
+			} );
+		}
+		for( std::thread& reader : readers )
+			reader.join();
+		XmlTest( "Double buffered: child index shared by readers.", 4, agreed.load() );
+	}
+
+	{
+		// Frozen document: the same content, read only, in flat arrays.
+		string str = "<?xml version='1.0' encoding='UTF-8'?><!--c--><a n='1'><b x='1' y='2.5'><c><![CDATA[raw]]></c>text<d/></b>"
+					 "<b x='2'/><e>done</e></a>";
+		TiXmlDocument doc;
+		doc.Parse( str.begin(), str.end() );
+		TiXmlFrozenDocument frozen = doc.Freeze();
+
+		XmlTest( "Frozen: node count.", 12, (int) frozen.NodeCount() );
+		XmlTest( "Frozen: root.", "a", frozen.RootElement().Value() );
+		XmlTest( "Frozen: declaration.", "UTF-8", frozen.Handle().FirstChild().Attribute( "encoding" ) );
+		XmlTest( "Frozen: comment.", "c", frozen.Handle().Child( 1 ).Value() );
+
+		TiXmlFrozenHandle b = frozen.RootElement().FirstChildElement( "b" );
+		int x = 0;
+		double y = 0;
+		XmlTest( "Frozen: int attribute.", TIXML_SUCCESS, b.QueryIntAttribute( "x", &x ) );
+		XmlTest( "Frozen: double attribute.", TIXML_SUCCESS, b.QueryDoubleAttribute( "y", &y ) );
+		XmlTest( "Frozen: attribute values.", true, x == 1 && y == 2.5 );
+		XmlTest( "Frozen: missing attribute.", TIXML_NO_ATTRIBUTE, b.QueryIntAttribute( "z", &x ) );
+		XmlTest( "Frozen: attribute order.", "y", b.AttributeName( 1 ) );
+		XmlTest( "Frozen: CDATA.", true, b.FirstChild( "c" ).FirstChild().CDATA() );
+		XmlTest( "Frozen: mixed content.", "text", b.Child( 1 ).Value() );
+		XmlTest( "Frozen: next element.", "2", b.NextSiblingElement( "b" ).Attribute( "x" ) );
+		XmlTest( "Frozen: GetText.", "done", frozen.RootElement().ChildElement( 2 ).GetText() );
+		XmlTest( "Frozen: parent.", true, b.FirstChild().Parent() == b );
+		XmlTest( "Frozen: null chain.", false, (bool) b.FirstChild( "nope" ).FirstChild().NextSibling() );
+
+		// The visitor sees the nodes in the same order as the DOM's.
+		struct Names : public TiXmlFrozenVisitor
+		{
+			string out;
+			virtual bool VisitEnter( TiXmlFrozenHandle e )	{ out += "<"; out += e.Value(); return e.Attribute( "x" ) == 0 || strcmp( e.Attribute( "x" ), "1" ) != 0; }
+			virtual bool VisitExit( TiXmlFrozenHandle e )	{ out += "/"; out += e.Value(); return true; }
+			virtual bool Visit( TiXmlFrozenHandle n )		{ out += "."; out += n.Value(); return true; }
+		} names;
+		frozen.Accept( &names );
+		XmlTest( "Frozen: visitor.", "..c<a<b/b<b/b<e.done/e/a", names.out.c_str() );
+
+		// Moving hands over the arrays.
+		TiXmlFrozenDocument moved( std::move( frozen ) );
+		XmlTest( "Frozen: moved.", "a", moved.RootElement().Value() );
+		XmlTest( "Frozen: moved from.", false, (bool) frozen.Handle() );
+	}
+
+	{
+		// Binary images: written once, mapped back without parsing.
+		const char* xmlPath = "binarytest.xml";
+		const char* binPath = "binarytest.xml.bin";
+		remove( binPath );
+
+		string str = "<?xml version='1.0'?><catalog><item id='1'>one</item><item id='2'><![CDATA[two]]></item></catalog>";
+		TiXmlDocument source;
+		source.Parse( str.begin(), str.end() );
+		source.SaveFile( xmlPath );
+
+		TiXmlFrozenDocument first;
+		bool loaded = first.Load( binPath, xmlPath );
+		XmlTest( "Binary: first load parses.", true, loaded && !first.Mapped() );
+
+		TiXmlFrozenDocument mapped;
+		loaded = mapped.Load( binPath, xmlPath );
+		XmlTest( "Binary: second load maps.", true, loaded && mapped.Mapped() );
+		XmlTest( "Binary: same nodes.", (int) first.NodeCount(), (int) mapped.NodeCount() );
+		XmlTest( "Binary: attribute.", "2", mapped.RootElement().ChildElement( 1 ).Attribute( "id" ) );
+		XmlTest( "Binary: CDATA.", true, mapped.RootElement().ChildElement( 1 ).FirstChild().CDATA() );
+		XmlTest( "Binary: declaration.", "1.0", mapped.Handle().FirstChild().Attribute( "version" ) );
+
+		TiXmlFrozenDocument moved( std::move( mapped ) );
+		XmlTest( "Binary: moved mapping.", true, moved.Mapped() && !mapped.Mapped() );
+		XmlTest( "Binary: moved text.", "one", moved.RootElement().FirstChildElement().GetText() );
+
+		// A damaged image is refused, and the document is left alone.
+		FILE* fp = fopen( binPath, "r+b" );
+		fseek( fp, -3, SEEK_END );
+		fputc( 'X', fp );
+		fclose( fp );
+		TiXmlFrozenDocument damaged = source.Freeze();
+		XmlTest( "Binary: damaged image refused.", false, damaged.LoadBinary( binPath ) );
+		XmlTest( "Binary: refused load keeps contents.", "catalog", damaged.RootElement().Value() );
+
+		// A changed source makes the image stale; Load() parses and rewrites it.
+		source.RootElement()->SetAttribute( "edition", 2 );
+		source.SaveFile( xmlPath );
+		TiXmlDocument reloaded;
+		reloaded.LoadFile( xmlPath );
+		reloaded.SaveBinary( binPath, xmlPath );
+		TiXmlFrozenDocument fresh;
+		XmlTest( "Binary: saved from document.", true, fresh.LoadBinary( binPath, xmlPath ) );
+		XmlTest( "Binary: saved content.", "2", fresh.RootElement().Attribute( "edition" ) );
+
+		// Without a source path the image is tied to no file, even one
+		// that exists under the document's name.
+		reloaded.RootElement()->SetAttribute( "edition", "edited" );
+		reloaded.SaveBinary( binPath );
+		XmlTest( "Binary: edited document not tied to its file.", false, fresh.LoadBinary( binPath, xmlPath ) );
+		loaded = fresh.Load( binPath, xmlPath );
+		XmlTest( "Binary: file read instead.", "2", loaded ? fresh.RootElement().Attribute( "edition" ) : "" );
+		TiXmlDocument named( xmlPath );
+		string other = "<x/>";
+		named.Parse( other.begin(), other.end() );
+		named.SaveBinary( binPath );
+		XmlTest( "Binary: parsed document not tied to its name.", false, fresh.LoadBinary( binPath, xmlPath ) );
+
+		source.RootElement()->SetAttribute( "edition", 30 );
+		source.SaveFile( xmlPath );
+		XmlTest( "Binary: stale image refused.", false, fresh.LoadBinary( binPath, xmlPath ) );
+		loaded = fresh.Load( binPath, xmlPath );
+		XmlTest( "Binary: stale image reparsed.", "30", loaded ? fresh.RootElement().Attribute( "edition" ) : "" );
+
+		fresh = TiXmlFrozenDocument();
+		remove( binPath );
+		remove( xmlPath );
+	}
+
+	{
+		// Compact binary encoding: decodes to the same document, smaller.
+		string str = "<?xml version='1.0' encoding='UTF-8'?><!--list--><list kind='a'>"
+					 "<item id='1' state='open'>same</item><item id='2' state='open'>same</item>"
+					 "<item id='3' state='closed'><![CDATA[<raw>]]></item><!DOCTYPE x><empty a=''/></list>";
+		TiXmlDocument doc;
+		doc.Parse( str.begin(), str.end() );
+
+		TiXmlCompactEncoder encoder;
+		doc.Accept( &encoder );
+		TiXmlPrinter printer;
+		printer.SetStreamPrinting();
+		doc.Accept( &printer );
+		XmlTest( "Compact: smaller than text.", true, encoder.Size() < printer.Size() );
+
+		TiXmlCompactDecoder decoder;
+		TiXmlDocument decoded;
+		XmlTest( "Compact: decoded.", true, decoder.Decode( encoder.Str(), &decoded ) );
+		TiXmlPrinter decodedPrinter;
+		decodedPrinter.SetStreamPrinting();
+		decoded.Accept( &decodedPrinter );
+		XmlTest( "Compact: same document.", printer.Str(), decodedPrinter.Str() );
+		XmlTest( "Compact: CDATA kept.", true, decoded.RootElement()->LastChild( "item" )->FirstChild()->ToText()->CDATA() );
+
+		// More names than fit in a one byte event code.
+		TiXmlDocument wide;
+		TiXmlElement* root = new TiXmlElement( "root" );
+		wide.LinkEndChild( root );
+		for( int i=0; i<600; ++i )
+		{
+			TiXmlElement* child = new TiXmlElement( "e" + std::to_string( i % 300 ) );
+			child->SetAttribute( "n" + std::to_string( i % 200 ), i );
+			root->LinkEndChild( child );
+		}
+		TiXmlCompactEncoder wideEncoder;
+		wide.Accept( &wideEncoder );
+		TiXmlPrinter widePrinter;
+		wide.Accept( &widePrinter );
+		decoder.Decode( wideEncoder.Str(), &decoded );
+		TiXmlPrinter wideDecoded;
+		decoded.Accept( &wideDecoded );
+		XmlTest( "Compact: many names.", widePrinter.Str(), wideDecoded.Str(), true );
+
+		// A reused encoder starts its tables afresh for each document.
+		const string first = encoder.Str();
+		wide.Accept( &encoder );
+		XmlTest( "Compact: reused on another document.", true, encoder.Str() == wideEncoder.Str() );
+		doc.Accept( &encoder );
+		XmlTest( "Compact: reused on the first again.", true, encoder.Str() == first );
+
+		// Damaged input is an error, not a crash.
+		string truncated = encoder.Str().substr( 0, encoder.Size() - 3 );
+		XmlTest( "Compact: truncated.", false, decoder.Decode( truncated, &decoded ) );
+		XmlTest( "Compact: truncated error.", TiXmlBase::TIXML_ERROR_DECODING_COMPACT, decoded.ErrorId() );
+		string garbage = encoder.Str().substr( 0, 4 ) + "\x02\x7f\x00";
+		XmlTest( "Compact: bad name index.", false, decoder.Decode( garbage, &decoded ) );
+	}
+
+	{
+		// Printer: one buffer, reusable, result taken without a copy.
+		string str = "<?xml version='1.0' standalone='yes'?><a q='say \"hi\"' b='x&amp;y'>1 &lt; 2<c/></a>";
+		TiXmlDocument doc;
+		doc.Parse( str.begin(), str.end() );
+
+		TiXmlPrinter printer;
+		printer.SetStreamPrinting();
+		doc.Accept( &printer );
+		const string expected = "<?xml version=\"1.0\" standalone=\"yes\" ?><a q='say &quot;hi&quot;' b=\"x&amp;y\">1 &lt; 2<c /></a>";
+		XmlTest( "Printer: output.", expected, printer.Str() );
+		XmlTest( "Printer: view.", true, printer.View() == expected );
+
+		const char* storage = printer.Str().data();
+		printer.Clear();
+		doc.Accept( &printer );
+		XmlTest( "Printer: cleared and reused.", expected, printer.Str() );
+		XmlTest( "Printer: storage kept.", true, printer.Str().data() == storage );
+
+		string taken = printer.TakeStr();
+		XmlTest( "Printer: taken.", expected, taken );
+		XmlTest( "Printer: empty after take.", 0, (int) printer.Size() );
+	}
+
+	{
+		// Escaping: attributes escape quotes, text does not; long clean
+		// runs are copied in blocks, so put specials at every offset.
+		string out;
+		TiXmlBase::EncodeString( "say \"hi\" & 'bye'", &out );
+		XmlTest( "Escape: attribute.", "say &quot;hi&quot; &amp; &apos;bye&apos;", out );
+		out.clear();
+		TiXmlBase::EncodeString( "say \"hi\" & 'bye'", &out, TIXML_ESCAPE_TEXT );
+		XmlTest( "Escape: text.", "say \"hi\" &amp; 'bye'", out );
+		out.clear();
+		TiXmlBase::EncodeString( "a\x01" "b&#xA9;c<", &out, TIXML_ESCAPE_TEXT );
+		XmlTest( "Escape: control and character reference.", "a&#x01;b&#xA9;c&lt;", out );
+
+		bool same = true;
+		for( int at=0; at<40; ++at )
+		{
+			string in( 40, 'x' );
+			in[at] = "<&>\"\x1f"[ at % 5 ];
+			static const char* entities[] = { "&lt;", "&amp;", "&gt;", "&quot;", "&#x1F;" };
+			string expected = in.substr( 0, at ) + entities[ at % 5 ] + in.substr( at + 1 );
+			out.clear();
+			TiXmlBase::EncodeString( in, &out );
+			same = same && out == expected;
+		}
+		XmlTest( "Escape: special at every offset.", true, same );
+
+		string str = "<a t='\"'>say &quot;hi&quot;</a>";
+		TiXmlDocument doc;
+		doc.Parse( str.begin(), str.end() );
+		TiXmlPrinter printer;
+		printer.SetStreamPrinting();
+		doc.Accept( &printer );
+		XmlTest( "Escape: printed.", "<a t='&quot;'>say \"hi\"</a>", printer.Str() );
+	}
+
+	{
+		// Output sinks: every way out gives the printer's bytes, in blocks
+		// of the sink's capacity.
+		string str = "<?xml version=\"1.0\" ?><root a='1'><item>one &amp; two</item><item><![CDATA[<raw>]]></item><!--c--></root>";
+		TiXmlDocument doc;
+		doc.Parse( str.begin(), str.end() );
+		TiXmlPrinter printer;
+		doc.Accept( &printer );
+		const string expected = printer.Str();
+
+		string saved;
+		TiXmlStringSink stringSink( &saved );
+		XmlTest( "Sink: string.", true, doc.Save( &stringSink ) && saved == expected );
+
+		string joined;
+		int blocks = 0;
+		bool full = true;
+		TiXmlCallbackSink callbackSink( [&]( const char* data, size_t size ) {
+			full = full && ( size >= 16 || joined.size() + size == expected.size() );
+			joined.append( data, size );
+			++blocks;
+			return true;
+		}, 16 );
+		XmlTest( "Sink: callback.", true, doc.Save( &callbackSink ) && joined == expected );
+		XmlTest( "Sink: callback blocks.", true, blocks > 1 && full );
+
+		TiXmlCallbackSink failing( []( const char*, size_t ) { return false; } );
+		XmlTest( "Sink: failed write.", false, doc.Save( &failing ) );
+		XmlTest( "Sink: not good.", false, failing.Good() );
+
+		// Only a sink that keeps all the output is told its size.
+		class Draining : public TiXmlOutputSink
+		{
+		public:
+			Draining() : reserved( 0 )						{}
+			virtual void Reserve( size_t )					{ ++reserved; }
+			int reserved;
+		protected:
+			virtual bool Drain( const char*, size_t )		{ return true; }
+		};
+		Draining draining;
+		doc.Save( &draining );
+		XmlTest( "Sink: draining sink not sized.", 0, draining.reserved );
+
+		ostringstream stream;
+		doc.Print( stream );
+		XmlTest( "Sink: stream.", true, stream.str() == expected );
+
+		FILE* file = tmpfile();
+		if ( file )
+		{
+			{
+				TiXmlFileSink fileSink( file );
+				doc.Save( &fileSink );
+			}
+			string read( expected.size() + 1, '\0' );
+			rewind( file );
+			read.resize( fread( &read[0], 1, read.size(), file ) );
+			XmlTest( "Sink: FILE.", true, read == expected );
+
+			rewind( file );
+			TiXmlFdSink fdSink( fileno( file ), 16 );
+			XmlTest( "Sink: fd.", true, doc.Save( &fdSink ) );
+			read.assign( expected.size() + 1, '\0' );
+			rewind( file );
+			read.resize( fread( &read[0], 1, read.size(), file ) );
+			XmlTest( "Sink: fd written.", true, read == expected );
+			fclose( file );
+		}
+
+		doc.SaveFile( "sinktest.xml" );
+		TiXmlDocument loaded;
+		loaded.LoadFile( "sinktest.xml" );
+		TiXmlPrinter reloaded;
+		loaded.Accept( &reloaded );
+		XmlTest( "Sink: SaveFile round trip.", expected, reloaded.Str(), true );
+	}
+
+	{
+		// Stream writer: the same bytes as printing the document, without
+		// the document.
+		string str = "<?xml version=\"1.0\" encoding=\"UTF-8\" ?><!--orders--><Orders batch='4&amp;2'>"
+					 "<Order id=\"1\" note='say \"hi\"'><Item>a &lt; b</Item><Note><![CDATA[<raw>]]></Note></Order>"
+					 "<Order id=\"2\" /></Orders>";
+		TiXmlDocument doc;
+		doc.Parse( str.begin(), str.end() );
+
+		for( int stream=0; stream<2; ++stream )
+		{
+			TiXmlPrinter printer;
+			if ( stream )
+				printer.SetStreamPrinting();
+			doc.Accept( &printer );
+
+			string written;
+			TiXmlStringSink sink( &written );
+			TiXmlStreamWriter writer( &sink );
+			if ( stream )
+				writer.SetStreamPrinting();
+			writer.PushDeclaration( "1.0", "UTF-8", "" );
+			writer.PushComment( "orders" );
+			writer.OpenElement( "Orders" );
+			writer.PushAttribute( "batch", "4&2" );
+			writer.OpenElement( "Order" );
+			writer.PushAttribute( "id", 1 );
+			writer.PushAttribute( "note", "say \"hi\"" );
+			writer.OpenElement( "Item" );
+			writer.PushText( "a < b" );
+			writer.CloseElement();
+			writer.OpenElement( "Note" );
+			writer.PushText( "<raw>", true );
+			writer.CloseElement();
+			writer.CloseElement();
+			writer.OpenElement( "Order" );
+			writer.PushAttribute( "id", 2 );
+			writer.CloseElement();
+			writer.CloseElement();
+			XmlTest( "Stream writer: finished.", true, writer.Finish() );
+			XmlTest( stream ? "Stream writer: as printed, stream." : "Stream writer: as printed.", printer.Str(), written, true );
+		}
+
+		string out;
+		TiXmlStringSink sink( &out );
+		TiXmlStreamWriter writer( &sink );
+		XmlTest( "Stream writer: text outside root.", false, writer.PushText( "x" ) );
+		XmlTest( "Stream writer: refused for good.", false, writer.OpenElement( "a" ) );
+		XmlTest( "Stream writer: nothing written.", true, out.empty() );
+
+		TiXmlStreamWriter second( &sink );
+		second.OpenElement( "a" );
+		XmlTest( "Stream writer: bad name.", false, TiXmlStreamWriter( &sink ).OpenElement( "1a" ) );
+		second.PushAttribute( "x", "1" );
+		XmlTest( "Stream writer: duplicate attribute.", false, second.PushAttribute( "x", "2" ) );
+
+		TiXmlStreamWriter third( &sink );
+		third.OpenElement( "a" );
+		third.PushText( "t" );
+		XmlTest( "Stream writer: attribute after content.", false, third.PushAttribute( "x", "1" ) );
+
+		TiXmlStreamWriter fourth( &sink );
+		fourth.OpenElement( "a" );
+		XmlTest( "Stream writer: open at finish.", false, fourth.Finish() );
+
+		TiXmlStreamWriter fifth( &sink );
+		fifth.OpenElement( "a" );
+		fifth.CloseElement();
+		XmlTest( "Stream writer: second root.", false, fifth.OpenElement( "b" ) );
+
+		TiXmlStreamWriter sixth( &sink );
+		sixth.OpenElement( "a" );
+		XmlTest( "Stream writer: bad comment.", false, sixth.PushComment( "a--b" ) );
+	}
+
+	{
+		// Parallel printing: the printer's bytes exactly, however finely
+		// the tree is cut.
+		string str = "<?xml version=\"1.0\" ?><!--head--><root a='1'>";
+		for( int i=0; i<200; ++i )
+		{
+			str += "<rec id='" + to_string( i ) + "'><name>n &amp; " + to_string( i ) + "</name>";
+			if ( i % 7 == 0 )
+				str += "<deep><x/><y>t</y><![CDATA[c]]><!--k--></deep>";
+			str += "</rec>";
+		}
+		str += "</root><!--tail-->";
+		TiXmlDocument doc;
+		doc.Parse( str.begin(), str.end() );
+		const TiXmlNode* rec = doc.RootElement()->FirstChild()->NextSibling();
+
+		bool same = true;
+		for( int stream=0; stream<2; ++stream )
+		{
+			for( size_t grain=1; grain<=1<<16; grain*=16 )
+			{
+				for( int which=0; which<2; ++which )
+				{
+					const TiXmlNode& node = which ? *rec : (const TiXmlNode&) doc;
+					TiXmlPrinter printer;
+					if ( stream )
+						printer.SetStreamPrinting();
+					node.Accept( &printer );
+
+					string out;
+					TiXmlStringSink sink( &out );
+					TiXmlParallelPrinter parallel( 4 );
+					parallel.SetGrainSize( grain );
+					if ( stream )
+						parallel.SetStreamPrinting();
+					same = parallel.Print( node, &sink ) && out == printer.Str() && same;
+				}
+			}
+		}
+		XmlTest( "Parallel printing: same bytes.", true, same );
+
+		// A deep chain of elements, each bigger than a grain, is cut at
+		// every level.
+		TiXmlDocument chain;
+		TiXmlNode* link = chain.LinkEndChild( new TiXmlElement( "link" ) );
+		for( int i=0; i<2000; ++i )
+		{
+			link->LinkEndChild( new TiXmlText( "t" ) );
+			link = link->LinkEndChild( new TiXmlElement( "link" ) );
+		}
+		TiXmlPrinter chainPrinter;
+		chain.Accept( &chainPrinter );
+		string chainOut;
+		TiXmlStringSink chainSink( &chainOut );
+		TiXmlParallelPrinter chainParallel( 4 );
+		chainParallel.SetGrainSize( 16 );
+		XmlTest( "Parallel printing: deep chain.", true, chainParallel.Print( chain, &chainSink ) && chainOut == chainPrinter.Str() );
+
+		TiXmlCallbackSink failing( []( const char*, size_t ) { return false; }, 16 );
+		TiXmlParallelPrinter parallel( 4 );
+		parallel.SetGrainSize( 64 );
+		XmlTest( "Parallel printing: failed write.", false, parallel.Print( doc, &failing ) );
+	}
+
+	{
+		// Compressed files: told by their first bytes when loading, by the
+		// name when saving.
+		string str = "<?xml version=\"1.0\" ?><root>";
+		for( int i=0; i<5000; ++i )
+			str += "<rec id='" + to_string( i ) + "'>text " + to_string( i * 7919 ) + "</rec>";
+		str += "</root>";
+		TiXmlDocument doc;
+		doc.Parse( str.begin(), str.end() );
+		TiXmlPrinter printer;
+		doc.Accept( &printer );
+
+		XmlTest( "Compression: of name.", (int) TIXML_COMPRESSION_GZIP, (int) TiXmlDocument::CompressionOf( "a.xml.gz" ) );
+		XmlTest( "Compression: of plain name.", (int) TIXML_COMPRESSION_NONE, (int) TiXmlDocument::CompressionOf( "a.xml" ) );
+
+		#ifdef TIXML_USE_ZLIB
+		XmlTest( "Compression: gzip saved.", true, doc.SaveFile( "compressed.xml.gz" ) );
+		unsigned char magic[2] = { 0, 0 };
+		if ( FILE* file = fopen( "compressed.xml.gz", "rb" ) )
+		{
+			fread( magic, 1, 2, file );
+			fclose( file );
+		}
+		XmlTest( "Compression: gzip magic.", true, magic[0] == 0x1f && magic[1] == 0x8b );
+
+		TiXmlDocument loaded;
+		XmlTest( "Compression: gzip loaded.", true, loaded.LoadFile( "compressed.xml.gz" ) );
+		TiXmlPrinter reloaded;
+		loaded.Accept( &reloaded );
+		XmlTest( "Compression: gzip round trip.", true, reloaded.Str() == printer.Str() );
+
+		// Several gzip members, one after another, are one file.
+		string members;
+		TiXmlStringSink membersSink( &members );
+		{
+			TiXmlGzipSink first( &membersSink );
+			first.Write( "<root><x />" );
+			first.Finish();
+			TiXmlGzipSink second( &membersSink );
+			second.Write( "</root>" );
+			second.Finish();
+		}
+		if ( FILE* file = fopen( "members.xml.gz", "wb" ) )
+		{
+			fwrite( members.data(), 1, members.size(), file );
+			fclose( file );
+		}
+		TiXmlDocument joined;
+		joined.LoadFile( "members.xml.gz" );
+		XmlTest( "Compression: gzip members.", true, !joined.Error() && joined.RootElement()->FirstChildElement( "x" ) != 0 );
+
+		// Read as a stream, a block at a time, by a pull parser.
+		std::ifstream gzFile( "compressed.xml.gz", std::ios::binary );
+		TiXmlDecompressStream gzText( &gzFile );
+		TiXmlPullParser pull( &gzText, 4096 );
+		TiXmlStreamXPath records( "count(//rec)" );
+		XmlTest( "Compression: pull parsed.", true, records.Run( &pull ) && records.MatchCount() == 5000 && !gzText.Error() );
+		std::istringstream plainText( str );
+		TiXmlDecompressStream passed( &plainText );
+		string passedStr( ( std::istreambuf_iterator< char >( passed ) ), std::istreambuf_iterator< char >() );
+		XmlTest( "Compression: plain passed through.", true, passedStr == str && !passed.Error() );
+
+		// A size in the trailer is a hint, never trusted past what the file could hold.
+		string gz;
+		{
+			std::ifstream in( "compressed.xml.gz", std::ios::binary );
+			gz.assign( ( std::istreambuf_iterator< char >( in ) ), std::istreambuf_iterator< char >() );
+		}
+		string forged = gz;
+		forged.replace( forged.size() - 4, 4, "\xff\xff\xff\xff" );
+		std::istringstream forgedIn( forged );
+		TiXmlDecompressStream forgedText( &forgedIn, TIXML_COMPRESSION_GZIP );
+		forgedText.peek();
+		XmlTest( "Compression: forged size.", true, forgedText.ExpectedSize() > 0 && forgedText.ExpectedSize() <= gz.size() * 1032 );
+		if ( FILE* file = fopen( "forged.xml.gz", "wb" ) )
+		{
+			fwrite( forged.data(), 1, forged.size(), file );
+			fclose( file );
+		}
+		TiXmlDocument forgedDoc;
+		XmlTest( "Compression: forged size loaded.", false, forgedDoc.LoadFile( "forged.xml.gz" ) );
+		std::istringstream cutIn( gz.substr( 0, gz.size() / 2 ) );
+		TiXmlDecompressStream cut( &cutIn );
+		string cutStr( ( std::istreambuf_iterator< char >( cut ) ), std::istreambuf_iterator< char >() );
+		XmlTest( "Compression: cut short.", true, cut.Error() && cutStr.size() < printer.Str().size() );
+		#endif
+
+		#ifdef TIXML_USE_ZSTD
+		XmlTest( "Compression: zstd saved.", true, doc.SaveFile( "compressed.xml.zst" ) );
+		unsigned char zstdMagic[4] = { 0, 0, 0, 0 };
+		if ( FILE* file = fopen( "compressed.xml.zst", "rb" ) )
+		{
+			fread( zstdMagic, 1, 4, file );
+			fclose( file );
+		}
+		XmlTest( "Compression: zstd magic.", true, zstdMagic[0] == 0x28 && zstdMagic[1] == 0xb5 && zstdMagic[2] == 0x2f && zstdMagic[3] == 0xfd );
+
+		TiXmlDocument zstdLoaded;
+		XmlTest( "Compression: zstd loaded.", true, zstdLoaded.LoadFile( "compressed.xml.zst" ) );
+		TiXmlPrinter zstdReloaded;
+		zstdLoaded.Accept( &zstdReloaded );
+		XmlTest( "Compression: zstd round trip.", true, zstdReloaded.Str() == printer.Str() );
+
+		// Several frames, one after another, are one file.
+		string frames;
+		TiXmlStringSink framesSink( &frames );
+		{
+			TiXmlZstdSink first( &framesSink );
+			first.Write( "<root><x />" );
+			first.Finish();
+			TiXmlZstdSink second( &framesSink );
+			second.Write( "</root>" );
+			second.Finish();
+		}
+		std::istringstream framesIn( frames );
+		TiXmlDecompressStream framesText( &framesIn );
+		string framesStr( ( std::istreambuf_iterator< char >( framesText ) ), std::istreambuf_iterator< char >() );
+		XmlTest( "Compression: zstd frames.", true, framesStr == "<root><x /></root>" && !framesText.Error() );
+
+		// Read as a stream, a block at a time, by a pull parser.
+		std::ifstream zstdFile( "compressed.xml.zst", std::ios::binary );
+		TiXmlDecompressStream zstdText( &zstdFile );
+		TiXmlPullParser zstdPull( &zstdText, 4096 );
+		TiXmlStreamXPath zstdRecords( "count(//rec)" );
+		XmlTest( "Compression: zstd pull parsed.", true, zstdRecords.Run( &zstdPull ) && zstdRecords.MatchCount() == 5000 && !zstdText.Error() );
+
+		string zst;
+		{
+			std::ifstream in( "compressed.xml.zst", std::ios::binary );
+			zst.assign( ( std::istreambuf_iterator< char >( in ) ), std::istreambuf_iterator< char >() );
+		}
+		std::istringstream zstdCutIn( zst.substr( 0, zst.size() / 2 ) );
+		TiXmlDecompressStream zstdCut( &zstdCutIn );
+		string zstdCutStr( ( std::istreambuf_iterator< char >( zstdCut ) ), std::istreambuf_iterator< char >() );
+		XmlTest( "Compression: zstd cut short.", true, zstdCut.Error() && zstdCutStr.size() < printer.Str().size() );
+		#endif
+
+		// Corrupt, or compressed in a way this build can't read.
+		if ( FILE* file = fopen( "corrupt.xml.gz", "wb" ) )
+		{
+			fputs( "\x1f\x8b not really gzip", file );
+			fclose( file );
+		}
+		TiXmlDocument corrupt;
+		XmlTest( "Compression: corrupt.", false, corrupt.LoadFile( "corrupt.xml.gz" ) );
+		XmlTest( "Compression: corrupt error.", (int) TiXmlBase::TIXML_ERROR_COMPRESSION, corrupt.ErrorId() );
+	}
+
+	{
+		// Numbers: every width, no exceptions, and doubles written so
+		// they read back exactly.
+		enum Colour { RED = 1, GREEN = 2 };
+		string str = "<n small='-12' big='18446744073709551615' huge='99999999999999999999' "
+					 "word='abc' negative='-1' plus=' +7' frac='2.5' yes='YES' no=' 0 ' colour='2'>"
+					 " 42 </n>";
+		TiXmlDocument doc;
+		doc.Parse( str.begin(), str.end() );
+		TiXmlElement* n = doc.RootElement();
+
+		signed char small = 0;
+		unsigned long long big = 0;
+		long long wide = 0;
+		int i = 5;
+		unsigned u = 5;
+		XmlTest( "Numbers: int8.", true, n->QueryValueAttribute( "small", &small ) == TIXML_SUCCESS && small == -12 );
+		XmlTest( "Numbers: uint64.", true, n->QueryValueAttribute( "big", &big ) == TIXML_SUCCESS && big == 18446744073709551615ull );
+		XmlTest( "Numbers: long long overflow.", TIXML_WRONG_TYPE, n->QueryValueAttribute( "huge", &wide ) );
+		XmlTest( "Numbers: not a number.", TIXML_WRONG_TYPE, n->QueryIntAttribute( "word", &i ) );
+		XmlTest( "Numbers: left as it was.", 5, i );
+		XmlTest( "Numbers: unsigned negative.", TIXML_WRONG_TYPE, n->QueryUnsignedAttribute( "negative", &u ) );
+		XmlTest( "Numbers: space and plus.", true, n->QueryIntAttribute( "plus", &i ) == TIXML_SUCCESS && i == 7 );
+		XmlTest( "Numbers: int prefix.", true, n->QueryIntAttribute( "frac", &i ) == TIXML_SUCCESS && i == 2 );
+
+		float f = 0;
+		bool b = false;
+		Colour colour = RED;
+		XmlTest( "Numbers: float.", true, n->QueryFloatAttribute( "frac", &f ) == TIXML_SUCCESS && f == 2.5f );
+		XmlTest( "Numbers: bool word.", true, n->QueryBoolAttribute( "yes", &b ) == TIXML_SUCCESS && b );
+		XmlTest( "Numbers: bool digit.", true, n->QueryBoolAttribute( "no", &b ) == TIXML_SUCCESS && !b );
+		XmlTest( "Numbers: bool wrong.", TIXML_WRONG_TYPE, n->QueryBoolAttribute( "small", &b ) );
+		XmlTest( "Numbers: enum.", true, n->QueryValueAttribute( "colour", &colour ) == TIXML_SUCCESS && colour == GREEN );
+		XmlTest( "Numbers: text.", true, n->QueryText( &i ) == TIXML_SUCCESS && i == 42 );
+		TiXmlElement empty( "empty" );
+		XmlTest( "Numbers: no text.", TIXML_NO_TEXT, empty.QueryText( &i ) );
+
+		const std::string* value = n->Attribute( "small", &i );
+		XmlTest( "Numbers: Attribute() value.", true, value && *value == "-12" && i == -12 );
+		XmlTest( "Numbers: Attribute() missing.", true, n->Attribute( "missing", &i ) == 0 );
+
+		n->SetDoubleAttribute( "d", 0.1 );
+		XmlTest( "Numbers: shortest double.", "0.1", n->Attribute( "d" ) );
+		n->SetDoubleAttribute( "d", 3.0 );
+		XmlTest( "Numbers: whole double.", "3", n->Attribute( "d" ) );
+		double third = 1.0 / 3.0, back = 0;
+		n->SetDoubleAttribute( "d", third );
+		XmlTest( "Numbers: double round trip.", true, n->QueryDoubleAttribute( "d", &back ) == TIXML_SUCCESS && back == third );
+		n->SetValueAttribute( "flag", true );
+		n->SetValueAttribute( "max", 18446744073709551615ull );
+		n->SetAttribute( "int", -7 );
+		XmlTest( "Numbers: written.", "true 18446744073709551615 -7",
+				 n->Attribute( "flag" ) + " " + n->Attribute( "max" ) + " " + n->Attribute( "int" ) );
+	}
+
+	{
+		// Pull parsing: the pieces of a document in order, the same from a
+		// string and from a stream read a few bytes at a time.
+		string str = "\xef\xbb\xbf<?xml version=\"1.0\" encoding=\"UTF-8\"?><!DOCTYPE x>"
+					 "<a x='1' y=\"a &amp; b\"><!--c-->  one &lt; two  <b/><![CDATA[<raw>]]></a >  ";
+		const string expected =
+			"D[1.0 UTF-8] U[!DOCTYPE x] S[a x=1 y=a & b] C[c] T[one < two] S[b] E[b] T[<raw>] E[a] .";
+
+		auto events = []( TiXmlPullParser& parser ) {
+			string out;
+			for( TiXmlPullParser::Event event = parser.Next(); ; event = parser.Next() )
+			{
+				switch ( event )
+				{
+					case TiXmlPullParser::PULL_START_ELEMENT:
+						out += "S[" + parser.Name();
+						for( int i=0; i<parser.AttributeCount(); ++i )
+							out += " " + parser.AttributeName( i ) + "=" + parser.AttributeValue( i );
+						out += "] ";
+						break;
+					case TiXmlPullParser::PULL_END_ELEMENT:	out += "E[" + parser.Name() + "] ";	break;
+					case TiXmlPullParser::PULL_TEXT:		out += "T[" + parser.Value() + "] ";	break;
+					case TiXmlPullParser::PULL_COMMENT:		out += "C[" + parser.Value() + "] ";	break;
+					case TiXmlPullParser::PULL_UNKNOWN:		out += "U[" + parser.Value() + "] ";	break;
+					case TiXmlPullParser::PULL_DECLARATION:	out += "D[" + parser.AttributeValue( 0 ) + " " + parser.AttributeValue( 1 ) + "] "; break;
+					case TiXmlPullParser::PULL_ERROR:		return out + "error " + parser.ErrorDesc();
+					default:								return out + ".";
+				}
+			}
+		};
+		TiXmlPullParser fromString( str );
+		XmlTest( "Pull: string.", expected, events( fromString ) );
+		bool same = true;
+		for( size_t block=1; block<12; ++block )
+		{
+			istringstream in( str );
+			TiXmlPullParser fromStream( &in, block );
+			same = same && events( fromStream ) == expected;
+		}
+		XmlTest( "Pull: stream in small blocks.", true, same );
+
+		string bad = "<a><b></a></b>";
+		TiXmlPullParser mismatched( bad );
+		XmlTest( "Pull: mismatched end tag.", true, events( mismatched ).find( "error" ) != string::npos && mismatched.ErrorId() == TiXmlBase::TIXML_ERROR_READING_END_TAG );
+		string open = "<a><b>";
+		TiXmlPullParser unclosed( open );
+		XmlTest( "Pull: unclosed.", true, events( unclosed ).find( "error" ) != string::npos );
+
+		string nested = "<a><skip><x>1</x><y/></skip><keep n='2'/></a>";
+		TiXmlPullParser skipping( nested );
+		skipping.Next();
+		skipping.Next();
+		int n = 0;
+		XmlTest( "Pull: skip element.", true, skipping.SkipElement() && skipping.Next() == TiXmlPullParser::PULL_START_ELEMENT
+											  && skipping.Name() == "keep" && skipping.QueryValueAttribute( "n", &n ) == TIXML_SUCCESS && n == 2 );
+	}
+
+	{
+		// Binding: a struct loads from a document and from the pull parser
+		// alike, and saves back to the same XML.
+		string str =
+			"<Orders>"
+				"<Order id='7' express='yes'><Priority>1</Priority><Note>fragile &amp; heavy</Note>"
+					"<Item sku='A-1' qty='2'>Widget</Item><Extra>ignored</Extra><Item sku='B-2' qty='1'>Gadget</Item>"
+					"<Tag>red</Tag><Tag>blue</Tag></Order>"
+				"<Order id='8'><Item sku='C-3' qty='5'/></Order>"
+			"</Orders>";
+		auto describe = []( const BindOrder& order ) {
+			string out = to_string( order.id ) + ( order.express ? " express " : " " ) + to_string( (int) order.priority ) + " " + order.note;
+			for( const BindItem& item : order.items )
+				out += " [" + item.sku + " " + to_string( item.qty ) + " " + item.label + "]";
+			for( const string& tag : order.tags )
+				out += " " + tag;
+			return out;
+		};
+
+		TiXmlDocument doc;
+		doc.Parse( str.begin(), str.end() );
+		TiXmlBinder binder;
+		BindOrder order;
+		XmlTest( "Bind: from a document.", "7 express 1 fragile & heavy [A-1 2 Widget] [B-2 1 Gadget] red blue",
+				 binder.Load( doc.RootElement()->FirstChildElement(), &order ) ? describe( order ) : binder.ErrorDesc() );
+
+		TiXmlPullParser parser( str );
+		parser.Next();
+		string pulled;
+		BindOrder reused;
+		while ( binder.Load( &parser, &reused ) )
+			pulled += describe( reused ) + "; ";
+		XmlTest( "Bind: from the pull parser.", "7 express 1 fragile & heavy [A-1 2 Widget] [B-2 1 Gadget] red blue; 8 express 1 fragile & heavy [C-3 5 ]; ", pulled );
+		XmlTest( "Bind: stops at the end.", false, binder.Error() );
+
+		string saved;
+		{
+			TiXmlStringSink sink( &saved );
+			TiXmlStreamWriter writer( &sink );
+			writer.SetStreamPrinting();
+			XmlTest( "Bind: save.", true, binder.Save( &writer, "Order", order ) && writer.Finish() );
+		}
+		XmlTest( "Bind: saved.", "<Order id=\"7\" express=\"true\"><Priority>1</Priority><Note>fragile &amp; heavy</Note>"
+								 "<Item sku=\"A-1\" qty=\"2\">Widget</Item><Item sku=\"B-2\" qty=\"1\">Gadget</Item>"
+								 "<Tag>red</Tag><Tag>blue</Tag></Order>", saved );
+		TiXmlPullParser again( saved );
+		BindOrder copy;
+		XmlTest( "Bind: round trip.", describe( order ), binder.Load( &again, &copy ) ? describe( copy ) : binder.ErrorDesc() );
+
+		binder.SetUnknown( TIXML_BIND_REJECT );
+		TiXmlPullParser strict( str );
+		strict.Next();
+		XmlTest( "Bind: reject unknown.", true, !binder.Load( &strict, &order ) && binder.Error() && string( binder.ErrorDesc() ).find( "Extra" ) != string::npos );
+		XmlTest( "Bind: reject unknown in a document.", false, binder.Load( doc.RootElement()->FirstChildElement(), &order ) );
+
+		string wrong = "<Order id='seven'/>";
+		TiXmlPullParser wrongParser( wrong );
+		XmlTest( "Bind: wrong type.", true, !binder.Load( &wrongParser, &order ) && string( binder.ErrorDesc() ).find( "id" ) != string::npos );
+
+		// The document and the pull parser load the same input the same way:
+		// all the text of a value, and the same policy for elements in it.
+		string mixed = "<Order id='9'><Priority>1<x/></Priority><Note>ab<!--c-->cd</Note></Order>";
+		TiXmlDocument mixedDoc;
+		mixedDoc.Parse( mixed.begin(), mixed.end() );
+		for( TiXmlBindUnknown policy : { TIXML_BIND_SKIP, TIXML_BIND_REJECT } )
+		{
+			binder.SetUnknown( policy );
+			BindOrder fromDoc, fromPull;
+			string docResult = binder.Load( mixedDoc.RootElement(), &fromDoc ) ? describe( fromDoc ) : binder.ErrorDesc();
+			TiXmlPullParser mixedParser( mixed );
+			string pullResult = binder.Load( &mixedParser, &fromPull ) ? describe( fromPull ) : binder.ErrorDesc();
+			XmlTest( policy == TIXML_BIND_SKIP ? "Bind: document and pull agree, skipping." : "Bind: document and pull agree, rejecting.", pullResult, docResult );
+			XmlTest( policy == TIXML_BIND_SKIP ? "Bind: all the text." : "Bind: element in a value rejected.",
+					 policy == TIXML_BIND_SKIP ? "9 1 abcd" : "Unknown element or text at x", docResult );
+		}
+	}
+
+	{
+		// XPath: a compiled subset, evaluated straight over the tree.
+		string str =
+			"<Orders>"
+				"<Order id='1' status='open'><Item sku='A'>Widget</Item><Item sku='B'>Gadget</Item><Total>10</Total></Order>"
+				"<Order id='2' status='closed'><Item sku='C'>Bolt</Item><Total>5</Total></Order>"
+				"<Order id='3' status='open'><Item sku='A'>Widget</Item><Total>7</Total></Order>"
+				"<Group><Group name='inner'><Order id='4'/></Group></Group>"
+			"</Orders>";
+		TiXmlDocument doc;
+		doc.Parse( str.begin(), str.end() );
+
+		// Element names, text values and attribute values, in order.
+		auto select = []( const TiXmlNode* context, const char* expression ) {
+			TiXmlXPath xpath( expression );
+			TiXmlXPathResult result;
+			if ( !xpath.Select( context, &result ) )
+				return string( xpath.ErrorDesc() );
+			string out;
+			for( const TiXmlNode* node : result.Nodes() )
+				out += ( out.empty() ? "" : " " ) + node->ValueStr();
+			for( const TiXmlAttribute* attribute : result.Attributes() )
+				out += ( out.empty() ? "" : " " ) + attribute->ValueStr();
+			return out;
+		};
+
+		XmlTest( "XPath: child steps.", "1 2 3", select( &doc, "/Orders/Order/@id" ) );
+		XmlTest( "XPath: descendant step.", "1 2 3 4", select( &doc, "//Order/@id" ) );
+		XmlTest( "XPath: wildcard.", "Order Order Order Group", select( &doc, "/Orders/*" ) );
+		XmlTest( "XPath: text().", "10 7", select( &doc, "//Order[@status='open']/Total/text()" ) );
+		XmlTest( "XPath: not equal.", "2", select( &doc, "//Order[@status!='open']/@id" ) );
+		XmlTest( "XPath: has attribute.", "1 2 3", select( &doc, "//Order[@status]/@id" ) );
+		XmlTest( "XPath: child equals.", "2", select( &doc, "//Order[Item='Bolt']/@id" ) );
+		XmlTest( "XPath: position.", "2", select( &doc, "/Orders/Order[2]/@id" ) );
+		XmlTest( "XPath: position per parent.", "A C A", select( &doc, "//Item[1]/@sku" ) );
+		XmlTest( "XPath: position after a filter.", "3", select( &doc, "/Orders/Order[@status='open'][2]/@id" ) );
+		XmlTest( "XPath: all attributes.", "2 closed", select( &doc, "/Orders/Order[2]/@*" ) );
+		XmlTest( "XPath: descendant attributes.", "inner", select( &doc, "//@name" ) );
+		XmlTest( "XPath: nested descendants once.", "4", select( &doc, "//Group//Order/@id" ) );
+		XmlTest( "XPath: nested matches.", "Group Group", select( &doc, "//Group" ) );
+		TiXmlXPathResult top;
+		XmlTest( "XPath: the document.", true, TiXmlXPath( "/" ).Select( doc.RootElement(), &top ) && top.FirstNode() == &doc );
+
+		const TiXmlElement* first = doc.RootElement()->FirstChildElement();
+		XmlTest( "XPath: relative.", "Widget Gadget", select( first, "Item/text()" ) );
+		XmlTest( "XPath: self.", "10", select( first, "./Total/text()" ) );
+		XmlTest( "XPath: absolute from inside.", "3", select( first->FirstChildElement(), "/Orders/Order[3]/@id" ) );
+		XmlTest( "XPath: nothing found.", "", select( &doc, "/Orders/Missing" ) );
+
+		// Children of nodes inside one another come out in document order.
+		string nestedStr = "<a><b><c n='1'/></b><c n='2'/></a>";
+		TiXmlDocument nested;
+		nested.Parse( nestedStr.begin(), nestedStr.end() );
+		XmlTest( "XPath: document order.", "1 2", select( &nested, "//*/c/@n" ) );
+
+		// With the child index, names and positions are looked up.
+		doc.RootElement()->EnableChildIndex();
+		XmlTest( "XPath: with the child index.", "2", select( &doc, "/Orders/Order[2]/@id" ) );
+		XmlTest( "XPath: names with the child index.", "1 2 3", select( &doc, "/Orders/Order/@id" ) );
+
+		TiXmlXPath xpath( "/Orders/Order[@status='open']" );
+		TiXmlXPathResult result;
+		XmlTest( "XPath: select.", true, xpath.Select( &doc, &result ) && result.Size() == 2 && result.FirstElement() == first );
+
+		TiXmlXPath bad( "//Order[@status='open'" );
+		XmlTest( "XPath: error.", true, bad.Error() && !bad.Select( &doc, &result ) && result.Empty() );
+		XmlTest( "XPath: unsupported.", true, TiXmlXPath( "Order/.." ).Error() && TiXmlXPath( "count(//Order)" ).Error() && TiXmlXPath( "@id/x" ).Error() );
+
+		XmlTest( "XPath: cached.", true, TiXmlXPath::Cached( "//Order" ) == TiXmlXPath::Cached( "//Order" ) && !TiXmlXPath::Cached( "//Order" )->Error() );
+		TiXmlXPath::ClearCache();
+	}
+
+	{
+		// Stream XPath: the same paths, run over the pull parser as it reads.
+		string str =
+			"<?xml version='1.0'?>"
+			"<Orders>"
+				"<Order id='1' status='open'><Item sku='A'>Widget</Item><Item sku='B'>Gadget</Item><Total>10</Total></Order>"
+				"<Order id='2' status='closed'><Item sku='C'>Bolt</Item><Total>5</Total></Order>"
+				"<Order id='3' status='open'><Item sku='A'>Widget</Item><Total>7</Total></Order>"
+				"<Group><Group name='inner'><Order id='4' status='open'><Order id='5'/></Order></Group></Group>"
+			"</Orders>";
+
+		// Element names, text values and attribute values, in order.
+		auto run = [&]( const char* expression ) {
+			TiXmlStreamXPath xpath( expression );
+			TiXmlPullParser parser( str );
+			string out;
+			bool ok = xpath.Run( &parser, [&]( TiXmlPullParser* p, int attribute ) {
+				out += out.empty() ? "" : " ";
+				if ( attribute >= 0 )
+					out += p->AttributeValue( attribute );
+				else
+					out += ( p->Current() == TiXmlPullParser::PULL_TEXT ) ? p->Value() : p->Name();
+				return true;
+			} );
+			return ok ? out : string( xpath.ErrorDesc() );
+		};
+
+		TiXmlStreamXPath open( "count( //Order[@status='open'] )" );
+		TiXmlPullParser parser( str );
+		XmlTest( "Stream XPath: count.", true, open.IsCount() && open.Run( &parser ) && open.MatchCount() == 3 );
+		XmlTest( "Stream XPath: text.", "10 5 7", run( "//Order/Total/text()" ) );
+		XmlTest( "Stream XPath: attributes.", "1 2 3 4 5", run( "//Order/@id" ) );
+		XmlTest( "Stream XPath: nested.", "Order", run( "//Order//Order" ) );
+		XmlTest( "Stream XPath: descendant attributes.", "1 open A B 2 closed C 3 open A 4 open 5", run( "//Order//@*" ) );
+
+		// Each of these gives what TiXmlXPath gives on a document.
+		TiXmlDocument doc;
+		doc.Parse( str.begin(), str.end() );
+		const char* same[] = {
+			"/Orders/Order/@id", "/Orders/*", "//Item[1]/@sku", "/Orders/Order[2]/@id",
+			"/Orders/Order[@status='open'][2]/@id", "//Order[@status!='open']/@id", "//Group//Order/@id",
+			"//Order[@status]/Item/text()", "Orders/Order[3]/./Total/text()", "//@name", "/Orders/Missing"
+		};
+		for( const char* expression : same )
+		{
+			TiXmlXPath xpath( expression );
+			TiXmlXPathResult result;
+			xpath.Select( &doc, &result );
+			string expected;
+			for( const TiXmlNode* node : result.Nodes() )
+				expected += ( expected.empty() ? "" : " " ) + node->ValueStr();
+			for( const TiXmlAttribute* attribute : result.Attributes() )
+				expected += ( expected.empty() ? "" : " " ) + attribute->ValueStr();
+			XmlTest( ( string( "Stream XPath: as on a document: " ) + expression ).c_str(), expected, run( expression ) );
+		}
+
+		// Matches come as they are read, from a stream, and the callback can stop.
+		istringstream in( str );
+		TiXmlPullParser streamed( &in, 16 );
+		TiXmlStreamXPath totals( "//Total/text()" );
+		string first;
+		XmlTest( "Stream XPath: stop.", true, totals.Run( &streamed, [&]( TiXmlPullParser* p, int ) { first = p->Value(); return false; } ) );
+		XmlTest( "Stream XPath: first match.", "10", first );
+		XmlTest( "Stream XPath: one match.", 1, (int) totals.MatchCount() );
+
+		// The callback can read the element it was given.
+		TiXmlStreamXPath orders( "//Order" );
+		TiXmlPullParser skipping( str );
+		int skipped = 0;
+		orders.Run( &skipping, [&]( TiXmlPullParser* p, int ) { skipped += p->SkipElement(); return true; } );
+		XmlTest( "Stream XPath: callback reads on.", 4, skipped );
+
+		XmlTest( "Stream XPath: needs children.", true, TiXmlStreamXPath( "//Order[Item='Bolt']" ).Error() );
+		XmlTest( "Stream XPath: bad expression.", true, TiXmlStreamXPath( "count(//Order" ).Error() && TiXmlStreamXPath( "/" ).Error() );
+		string broken = "<Orders><Order id='1'></Orders>";
+		TiXmlPullParser brokenParser( broken );
+		XmlTest( "Stream XPath: broken input.", false, orders.Run( &brokenParser ) );
+	}
+
+	{
+		// Element index: by name and by attribute value, kept up to date.
+		string str =
+			"<Orders>"
+				"<Order id='1' key='a'><Item sku='A'/></Order>"
+				"<Order id='2' key='b'><Item sku='B'/></Order>"
+				"<Order id='3' key='a'><Item sku='C'/></Order>"
+				"<Group><Order id='4'><Order id='5'/></Order></Group>"
+			"</Orders>";
+		TiXmlDocument doc;
+		doc.EnableElementIndex();
+		doc.IndexAttribute( "id" );
+		doc.IndexAttribute( "key" );
+		doc.Parse( str.begin(), str.end() );
+		TiXmlDocument plain;
+		plain.Parse( str.begin(), str.end() );
+
+		auto ids = []( const vector< const TiXmlElement* >& elements ) {
+			string out;
+			for( const TiXmlElement* element : elements )
+				out += ( out.empty() ? "" : " " ) + element->Attribute( string( "id" ) );
+			return out;
+		};
+		auto idOf = []( const TiXmlElement* element ) { return element ? element->Attribute( string( "id" ) ) : string( "none" ); };
+
+		XmlTest( "Element index: by name.", "1 2 3 4 5", ids( doc.GetElementsByTagName( "Order" ) ) );
+		vector< const TiXmlElement* > walked;
+		plain.GetElementsByTagName( "Order", &walked );
+		XmlTest( "Element index: without the index.", "1 2 3 4 5", ids( walked ) );
+		XmlTest( "Element index: no list without the index.", true, plain.GetElementsByTagName( "Order" ).empty() );
+		XmlTest( "Element index: list not copied.", true, &doc.GetElementsByTagName( "Order" ) == &doc.GetElementsByTagName( "Order" ) );
+		XmlTest( "Element index: no such name.", 0, (int) doc.GetElementsByTagName( "Missing" ).size() );
+		XmlTest( "Element index: by attribute.", "3", idOf( doc.GetElementByAttribute( "id", "3" ) ) );
+		XmlTest( "Element index: first of equal values.", "1", idOf( doc.GetElementByAttribute( "key", "a" ) ) );
+		XmlTest( "Element index: no such value.", "none", idOf( doc.GetElementByAttribute( "id", "9" ) ) );
+		XmlTest( "Element index: attribute not indexed.", "2", idOf( doc.GetElementByAttribute( "sku", "B" )->Parent()->ToElement() ) );
+		XmlTest( "Element index: attribute without the index.", "3", idOf( plain.GetElementByAttribute( "id", "3" ) ) );
+
+		// Appending at the end, removing, renaming and changing attributes.
+		TiXmlElement* orders = doc.RootElement();
+		TiXmlElement* added = orders->LinkEndChild( new TiXmlElement( "Order" ) )->ToElement();
+		added->SetAttribute( "id", "6" );
+		XmlTest( "Element index: appended.", "1 2 3 4 5 6", ids( doc.GetElementsByTagName( "Order" ) ) );
+		XmlTest( "Element index: appended attribute.", true, doc.GetElementByAttribute( "id", "6" ) == added );
+
+		orders->RemoveChild( orders->FirstChildElement() );
+		XmlTest( "Element index: removed.", "2 3 4 5 6", ids( doc.GetElementsByTagName( "Order" ) ) );
+		XmlTest( "Element index: removed attribute.", "none", idOf( doc.GetElementByAttribute( "id", "1" ) ) );
+		XmlTest( "Element index: removed children.", 2, (int) doc.GetElementsByTagName( "Item" ).size() );
+		XmlTest( "Element index: next of equal values.", "3", idOf( doc.GetElementByAttribute( "key", "a" ) ) );
+
+		TiXmlElement* three = doc.GetElementByAttribute( "id", "3" );
+		three->SetAttribute( "id", 30 );
+		XmlTest( "Element index: old value.", "none", idOf( doc.GetElementByAttribute( "id", "3" ) ) );
+		XmlTest( "Element index: new value.", true, doc.GetElementByAttribute( "id", "30" ) == three );
+		three->RemoveAttribute( "key" );
+		XmlTest( "Element index: attribute removed.", "none", idOf( doc.GetElementByAttribute( "key", "a" ) ) );
+
+		doc.GetElementByAttribute( "id", "4" )->SetValue( "Archived" );
+		XmlTest( "Element index: renamed from.", "2 30 5 6", ids( doc.GetElementsByTagName( "Order" ) ) );
+		XmlTest( "Element index: renamed to.", "4", ids( doc.GetElementsByTagName( "Archived" ) ) );
+		three->SetValue( "Archived" );
+		XmlTest( "Element index: renamed in order.", "30 4", ids( doc.GetElementsByTagName( "Archived" ) ) );
+
+		// Inserted in the middle: found in document order all the same.
+		TiXmlElement inserted( "Order" );
+		inserted.SetAttribute( "id", "7" );
+		orders->InsertBeforeChild( orders->FirstChildElement(), inserted );
+		XmlTest( "Element index: inserted.", "7 2 5 6", ids( doc.GetElementsByTagName( "Order" ) ) );
+		XmlTest( "Element index: inserted attribute.", "7", idOf( doc.GetElementByAttribute( "id", "7" ) ) );
+
+		orders->Clear();
+		XmlTest( "Element index: cleared.", true, doc.GetElementsByTagName( "Order" ).empty() && !doc.GetElementByAttribute( "id", "2" ) );
+
+		// '//name' from the document comes from the index.
+		doc.Parse( str.begin(), str.end() );
+		TiXmlXPath xpath( "//Order//Order/@id" );
+		TiXmlXPathResult result;
+		xpath.Select( &doc, &result );
+		XmlTest( "Element index: XPath.", true, result.Size() == 1 && result.FirstAttribute()->ValueStr() == "5" );
+		TiXmlXPath open( "//Order[@key='a']/Item" );
+		open.Select( &doc, &result );
+		XmlTest( "Element index: XPath filter.", 2, (int) result.Size() );
+
+		// Each walk fills its own list.
+		vector< const TiXmlElement* > orderList, itemList;
+		plain.GetElementsByTagName( "Order", &orderList );
+		plain.GetElementsByTagName( "Item", &itemList );
+		XmlTest( "Element index: lists are kept.", "1 2 3 4 5", ids( orderList ) );
+		XmlTest( "Element index: second list.", 3, (int) itemList.size() );
+
+		// Copies are indexed as the original is.
+		TiXmlDocument copy( doc );
+		XmlTest( "Element index: copied.", true, copy.HasElementIndex() && ids( copy.GetElementsByTagName( "Order" ) ) == "1 2 3 4 5"
+											&& copy.GetElementByAttribute( "key", "b" ) == copy.GetElementsByTagName( "Order" )[1] );
+		TiXmlDocument assigned;
+		assigned = doc;
+		XmlTest( "Element index: assigned.", true, assigned.HasElementIndex() && assigned.GetElementByAttribute( "id", "2" )->GetDocument() == &assigned );
+		assigned = plain;
+		XmlTest( "Element index: assigned without.", false, assigned.HasElementIndex() );
+		TiXmlDocument moved( std::move( copy ) );
+		XmlTest( "Element index: moved.", true, moved.HasElementIndex() && idOf( moved.GetElementByAttribute( "id", "4" ) ) == "4" );
+
+		// A version is published with its index built, so readers share it.
+		TiXmlDoubleBufferedDocument versions( std::move( moved ) );
+		versions.Update( []( TiXmlDocument& draft ) {
+			TiXmlElement first( "Order" );
+			first.SetAttribute( "id", "0" );
+			TiXmlElement* one = draft.GetElementByAttribute( "id", "1" );
+			one->Parent()->InsertBeforeChild( one, first );
+			return true;
+		} );
+		TiXmlDoubleBufferedDocument::Snapshot version = versions.Current();
+		string byName, byAttribute;
+		std::thread reader( [&]() { byName = ids( version->GetElementsByTagName( "Order" ) ); } );
+		byAttribute = idOf( version->GetElementByAttribute( "id", "0" ) );
+		reader.join();
+		XmlTest( "Element index: versions.", true, version->HasElementIndex() && byName == "0 1 2 3 4 5" && byAttribute == "0" );
+	}
+
+	{
+		// Text index: words of the text nodes, and queries over them.
+		string str =
+			"<Catalog>"
+				"<Item id='1'><Name>Stainless Steel Pan</Name><Note>steel, not stainless</Note></Item>"
+				"<Item id='2'><Name>Cast iron pan</Name><Note>Heavy<b>steel</b>handle</Note></Item>"
+				"<Item id='3'><Name>Caf\xc3\xa9 cups</Name><Note><![CDATA[Stainless steel rim]]></Note></Item>"
+			"</Catalog>";
+		TiXmlDocument doc;
+		doc.Parse( str.begin(), str.end() );
+		doc.EnableTextIndex();
+		const TiXmlTextIndex* index = doc.TextIndex();
+
+		auto values = [&]( string query, TiXmlTextIndex::Match match ) {
+			vector< const TiXmlText* > found;
+			doc.TextIndex()->Find( query, match, &found );
+			string out;
+			for( const TiXmlText* text : found )
+				out += ( out.empty() ? "" : "|" ) + text->ValueStr();
+			return out;
+		};
+		auto ids = [&]( string query, TiXmlTextIndex::Match match ) {
+			vector< const TiXmlElement* > found;
+			doc.TextIndex()->FindElements( query, match, &found );
+			string out;
+			for( const TiXmlElement* element : found )
+				out += ( out.empty() ? "" : " " ) + element->ValueStr();
+			return out;
+		};
+
+		vector< string > words;
+		TiXmlTextIndex::Tokenize( "Steel, 2-ply caf\xc3\xa9!", &words );
+		XmlTest( "Text index: tokenize.", "steel 2 ply caf\xc3\xa9", words[ 0 ] + " " + words[ 1 ] + " " + words[ 2 ] + " " + words[ 3 ] );
+		XmlTest( "Text index: texts.", 8, (int) index->TextCount() );
+		const vector< TiXmlTextIndex::Posting >* steel = index->Postings( "steel" );
+		XmlTest( "Text index: postings.", 4, steel ? (int) steel->size() : 0 );
+		XmlTest( "Text index: offset.", true, steel && ( *steel )[ 0 ].position == 1 && ( *steel )[ 0 ].offset == 10 );
+		XmlTest( "Text index: no such term.", true, index->Postings( "copper" ) == 0 );
+
+		XmlTest( "Text index: all.", "Stainless Steel Pan|steel, not stainless|Stainless steel rim", values( "STEEL stainless", TiXmlTextIndex::MATCH_ALL ) );
+		XmlTest( "Text index: any.", "Stainless Steel Pan|steel, not stainless|Cast iron pan|steel|Stainless steel rim", values( "pan steel", TiXmlTextIndex::MATCH_ANY ) );
+		XmlTest( "Text index: phrase.", "Stainless Steel Pan|Stainless steel rim", values( "stainless steel", TiXmlTextIndex::MATCH_PHRASE ) );
+		XmlTest( "Text index: phrase out of order.", "", values( "steel stainless", TiXmlTextIndex::MATCH_PHRASE ) );
+		XmlTest( "Text index: missing word.", "", values( "steel copper", TiXmlTextIndex::MATCH_ALL ) );
+		XmlTest( "Text index: empty query.", "", values( " ,. ", TiXmlTextIndex::MATCH_ANY ) );
+		XmlTest( "Text index: UTF-8 word.", "Caf\xc3\xa9 cups", values( "CAF\xc3\xa9", TiXmlTextIndex::MATCH_ALL ) );
+		XmlTest( "Text index: elements.", "Name Note b Note", ids( "steel", TiXmlTextIndex::MATCH_ANY ) );
+
+		// Changed text is indexed again; other changes rebuild it.
+		TiXmlText* cups = doc.RootElement()->LastChild()->FirstChild()->FirstChild()->ToText();
+		cups->SetValue( "Steel mugs" );
+		XmlTest( "Text index: changed, old words.", "", values( "cups", TiXmlTextIndex::MATCH_ANY ) );
+		XmlTest( "Text index: changed, new words.", "Stainless Steel Pan|Steel mugs", values( "steel", TiXmlTextIndex::MATCH_ALL ).substr( 0, 19 ) + "|" + values( "mugs", TiXmlTextIndex::MATCH_ALL ) );
+		XmlTest( "Text index: changed in place.", true, doc.TextIndex() == index && index->Postings( "steel" )->size() == 5 );
+
+		TiXmlElement* item = doc.RootElement()->LinkEndChild( new TiXmlElement( "Item" ) )->ToElement();
+		item->LinkEndChild( new TiXmlText( "copper pan" ) );
+		XmlTest( "Text index: appended.", "Stainless Steel Pan|Cast iron pan|copper pan", values( "pan", TiXmlTextIndex::MATCH_ANY ) );
+
+		doc.RootElement()->RemoveChild( doc.RootElement()->FirstChild() );
+		XmlTest( "Text index: removed.", "Cast iron pan|copper pan", values( "pan", TiXmlTextIndex::MATCH_ANY ) );
+		doc.RootElement()->InsertBeforeChild( doc.RootElement()->FirstChild(), *item );
+		XmlTest( "Text index: inserted.", "copper pan|Cast iron pan|copper pan", values( "pan", TiXmlTextIndex::MATCH_ANY ) );
+
+		// Built on several threads, the lists come out the same.
+		string big = "<Log>";
+		for( int i = 0; i < 4000; ++i )
+			big += "<Entry>request " + std::to_string( i ) + " served from cache node " + std::to_string( i % 7 ) + "</Entry>";
+		big += "</Log>";
+		TiXmlDocument log;
+		log.Parse( big.begin(), big.end() );
+		TiXmlTextIndex serial( 1 ), parallel( 4 );
+		serial.Build( &log );
+		parallel.Build( &log );
+		bool same = serial.TermCount() == parallel.TermCount();
+		for( const char* term : { "request", "cache", "3", "3999" } )
+		{
+			const vector< TiXmlTextIndex::Posting >* a = serial.Postings( term );
+			const vector< TiXmlTextIndex::Posting >* b = parallel.Postings( term );
+			same = same && a && b && a->size() == b->size()
+				&& std::equal( a->begin(), a->end(), b->begin(), []( const TiXmlTextIndex::Posting& x, const TiXmlTextIndex::Posting& y ) {
+					return x.text == y.text && x.position == y.position && x.offset == y.offset;
+				} );
+		}
+		XmlTest( "Text index: parallel build.", true, same );
+		vector< const TiXmlText* > found;
+		XmlTest( "Text index: parallel phrase.", 571, (int) parallel.Find( "cache node 3", TiXmlTextIndex::MATCH_PHRASE, &found ) );
+
+		// Copies keep the text index, and versions are published with it built.
+		log.EnableTextIndex();
+		TiXmlDocument logCopy( log );
+		XmlTest( "Text index: copied.", true, logCopy.TextIndex() && logCopy.TextIndex()->Find( "cache node 3", TiXmlTextIndex::MATCH_PHRASE, &found ) == 571
+											&& found[ 0 ]->GetDocument() == &logCopy );
+		TiXmlDocument logMoved( std::move( logCopy ) );
+		XmlTest( "Text index: moved.", 571, logMoved.TextIndex() ? (int) logMoved.TextIndex()->Find( "cache node 3", TiXmlTextIndex::MATCH_PHRASE, &found ) : 0 );
+
+		TiXmlDoubleBufferedDocument versions( std::move( logMoved ) );
+		versions.Update( []( TiXmlDocument& draft ) {
+			TiXmlElement first( "Entry" );
+			first.LinkEndChild( new TiXmlText( "restarted cache node 3" ) );
+			draft.RootElement()->InsertBeforeChild( draft.RootElement()->FirstChild(), first );
+			return true;
+		} );
+		TiXmlDoubleBufferedDocument::Snapshot version = versions.Current();
+		size_t fromReader = 0;
+		std::thread reader( [&]() {
+			vector< const TiXmlText* > readerFound;
+			fromReader = version->TextIndex()->Find( "cache node 3", TiXmlTextIndex::MATCH_PHRASE, &readerFound );
+		} );
+		size_t restarted = version->TextIndex()->Find( "restarted", TiXmlTextIndex::MATCH_ALL, &found );
+		reader.join();
+		XmlTest( "Text index: versions.", true, fromReader == 572 && restarted == 1 );
+	}
+
+	{
+		// Ranges: Children(), Elements(), Descendants() and Attributes().
+		string str =
+			"<Order id='1' customer='c7' express='yes'>"
+				"<!-- first -->"
+				"<Item sku='A'>one</Item>"
+				"<Note>fragile</Note>"
+				"<Item sku='B'><Item sku='B1'/></Item>"
+				"text"
+			"</Order>";
+		TiXmlDocument doc;
+		doc.Parse( str.begin(), str.end() );
+		TiXmlElement* order = doc.RootElement();
+		const TiXmlElement* constOrder = order;
+
+		string children;
+		for( const TiXmlNode* child : constOrder->Children() )
+			children += std::to_string( child->Type() );
+		XmlTest( "Ranges: children.", "21114", children );
+
+		string skus;
+		for( TiXmlElement* item : order->Elements( "Item" ) )
+			skus += item->Attribute( string( "sku" ) );
+		XmlTest( "Ranges: elements by name.", "AB", skus );
+		XmlTest( "Ranges: elements.", 3, (int) std::distance( order->Elements().begin(), order->Elements().end() ) );
+		XmlTest( "Ranges: no such elements.", true, order->Elements( "Missing" ).empty() && order->FirstChildElement( "Note" )->Elements().empty() );
+
+		string all;
+		for( const TiXmlNode* node : doc.Descendants() )
+			all += node->ToElement() ? node->ValueStr() + " " : "";
+		XmlTest( "Ranges: descendants in document order.", "Order Item Note Item Item ", all );
+		XmlTest( "Ranges: descendants of a subtree.", 1, (int) std::distance( order->LastChild()->PreviousSibling()->Descendants().begin(), order->LastChild()->PreviousSibling()->Descendants().end() ) );
+		string nested;
+		for( const TiXmlElement* item : constOrder->DescendantElements( "Item" ) )
+			nested += item->Attribute( string( "sku" ) );
+		XmlTest( "Ranges: descendant elements.", "ABB1", nested );
+
+		string names;
+		for( const TiXmlAttribute* attribute : constOrder->Attributes() )
+			names += attribute->NameTStr();
+		XmlTest( "Ranges: attributes in order.", "idcustomerexpress", names );
+		for( TiXmlAttribute* attribute : order->Attributes() )
+			attribute->SetValue( "x" );
+		XmlTest( "Ranges: attributes to change.", "x", order->Attribute( string( "express" ) ) );
+		XmlTest( "Ranges: no attributes.", true, order->FirstChildElement()->NextSiblingElement()->Attributes().empty() );
+
+		// With the standard algorithms.
+		TiXmlNodeRange< TiXmlElement > items = order->Elements( "Item" );
+		TiXmlNodeRange< TiXmlElement >::iterator b = std::find_if( items.begin(), items.end(), []( const TiXmlElement* item ) { return !item->NoChildren() && item->FirstChild()->ToElement(); } );
+		XmlTest( "Ranges: find_if.", true, b != items.end() && *b == order->LastChild()->PreviousSibling() );
+		auto descendants = doc.Descendants();
+		XmlTest( "Ranges: count_if.", 3, (int) std::count_if( descendants.begin(), descendants.end(), []( const TiXmlNode* node ) { return node->ToText(); } ) );
+		vector< TiXmlElement* > copied( items.begin(), items.end() );
+		XmlTest( "Ranges: into a vector.", 2, (int) copied.size() );
+		#ifdef __cpp_lib_ranges
+		XmlTest( "Ranges: std::ranges.", 3, (int) std::ranges::distance( order->DescendantElements( "Item" ) ) );
+		auto named = order->Children() | std::views::filter( []( const TiXmlNode* node ) { return node->ValueStr() == "Note"; } );
+		XmlTest( "Ranges: std::views.", true, std::ranges::begin( named ) != std::ranges::end( named ) && ( *std::ranges::begin( named ) )->ToElement() );
+		#endif
+	}
+
+	{
+		// TiXmlWalk: the same calls, and the same pruning, as Accept().
+		class Recorder : public TiXmlVisitor
+		{
+		public:
+			string log, skip, stop, close;
+
+			virtual bool VisitEnter( const TiXmlDocument& )						{ log += "D("; return true; }
+			virtual bool VisitExit( const TiXmlDocument& )						{ log += ")D"; return true; }
+			virtual bool VisitEnter( const TiXmlElement& element, const TiXmlAttribute* first )
+			{
+				log += element.ValueStr() + ( first ? "@" : "" ) + "(";
+				return element.ValueStr() != skip;
+			}
+			virtual bool VisitExit( const TiXmlElement& element )
+			{
+				log += ")";
+				return element.ValueStr() != close;
+			}
+			virtual bool Visit( const TiXmlText& text )					{ log += "'" + text.ValueStr() + "'"; return text.ValueStr() != stop; }
+			virtual bool Visit( const TiXmlComment& )					{ log += "!"; return true; }
+			virtual bool Visit( const TiXmlDeclaration& )				{ log += "?"; return true; }
+			virtual bool Visit( const TiXmlUnknown& )					{ log += "~"; return true; }
+		};
+
+		string str =
+			"<?xml version='1.0'?>"
+			"<A id='1'>"
+				"<!-- c -->"
+				"<B>b<X/></B>"
+				"<C>one<!DOCTYPE y>two<Y/></C>"
+				"<D>d</D>"
+			"</A>";
+		TiXmlDocument doc;
+		doc.Parse( str.begin(), str.end() );
+
+		struct Case { const char* name; const char* skip; const char* stop; const char* close; };
+		const Case cases[] = {
+			{ "TiXmlWalk: everything.", "", "", "" },
+			{ "TiXmlWalk: VisitEnter false skips the children.", "B", "", "" },
+			{ "TiXmlWalk: Visit false skips the siblings.", "", "one", "" },
+			{ "TiXmlWalk: VisitExit false skips the siblings.", "", "", "B" },
+			{ "TiXmlWalk: pruned up to the top.", "", "", "A" },
+		};
+		for( const Case& c : cases )
+		{
+			Recorder accepted, walked;
+			accepted.skip = walked.skip = c.skip;
+			accepted.stop = walked.stop = c.stop;
+			accepted.close = walked.close = c.close;
+			bool a = doc.Accept( &accepted );
+			bool w = TiXmlWalk( doc, walked );
+			XmlTest( c.name, accepted.log, walked.log );
+			XmlTest( ( string( c.name ) + " Result." ).c_str(), a, w );
+		}
+		Recorder all;
+		TiXmlWalk( doc, all );
+		XmlTest( "TiXmlWalk: the order.", "D(?A@(!B('b'X())C('one'~'two'Y())D('d')))D", all.log );
+
+		Recorder accepted, walked;
+		doc.RootElement()->FirstChildElement( "C" )->Accept( &accepted );
+		TiXmlWalk( *doc.RootElement()->FirstChildElement( "C" ), walked );
+		XmlTest( "TiXmlWalk: a subtree.", accepted.log, walked.log );
+		Recorder leaf;
+		XmlTest( "TiXmlWalk: a leaf.", true, TiXmlWalk( *doc.RootElement()->FirstChildElement( "D" )->FirstChild(), leaf ) && leaf.log == "'d'" );
+
+		// Members the walker doesn't have count as returning true.
+		struct TextOnly
+		{
+			string text;
+			bool Visit( const TiXmlText& node )		{ text += node.ValueStr(); return true; }
+		} textOnly;
+		XmlTest( "TiXmlWalk: only some members.", true, TiXmlWalk( doc, textOnly ) && textOnly.text == "bonetwod" );
+		struct FirstElements
+		{
+			int count = 0;
+			bool VisitEnter( const TiXmlElement& element, const TiXmlAttribute* )	{ ++count; return element.ValueStr() == "A"; }
+		};
+		FirstElements firstElements;
+		TiXmlWalk( doc, firstElements );
+		XmlTest( "TiXmlWalk: pruned without VisitExit.", 4, firstElements.count );
+		XmlTest( "TiXmlWalk: a temporary walker.", true, TiXmlWalk( doc, TextOnly() ) );
+
+		// A TiXmlPrinter prints the same through either.
+		TiXmlPrinter byAccept, byWalk;
+		doc.Accept( &byAccept );
+		TiXmlWalk( doc, byWalk );
+		XmlTest( "TiXmlWalk: printer.", byAccept.Str(), byWalk.Str() );
+	}
+
+	{
+		// Parallel traversal: the same totals as Accept(), reduced in document order.
+		class Census : public TiXmlVisitor
+		{
+		public:
+			virtual bool VisitEnter( const TiXmlElement& element, const TiXmlAttribute* first )
+			{
+				++elements;
+				attributes += first ? 1 : 0;
+				names += element.ValueStr()[ 0 ];
+				return element.ValueStr() != "Skip";
+			}
+			virtual bool Visit( const TiXmlText& text )		{ bytes += text.ValueStr().size(); return true; }
+
+			int elements = 0;
+			int attributes = 0;
+			size_t bytes = 0;
+			string names;
+		};
+		auto reduce = []( Census& into, const Census& part ) {
+			into.elements += part.elements;
+			into.attributes += part.attributes;
+			into.bytes += part.bytes;
+			into.names += part.names;
+		};
+
+		TiXmlDocument doc;
+		TiXmlElement* root = doc.LinkEndChild( new TiXmlElement( "Root" ) )->ToElement();
+		for( int i = 0; i < 60; ++i )
+		{
+			TiXmlElement* group = root->LinkEndChild( new TiXmlElement( ( i % 7 == 3 ) ? "Skip" : "Group" ) )->ToElement();
+			group->SetAttribute( "n", i );
+			for( int j = 0; j < 3 * i; ++j )
+			{
+				TiXmlElement* item = group->LinkEndChild( new TiXmlElement( "Item" ) )->ToElement();
+				item->LinkEndChild( new TiXmlText( std::to_string( j ) ) );
+				if ( j % 10 == 0 )
+					item->LinkEndChild( new TiXmlElement( "Value" ) )->LinkEndChild( new TiXmlText( "v" ) );
+			}
+		}
+
+		Census serial;
+		doc.Accept( &serial );
+		Census parallel;
+		TiXmlParallelTraversal traversal( 4 );
+		traversal.SetGrainSize( 16 );
+		traversal.SetSerialLimit( 0 );
+		traversal.Accept( doc, &parallel, reduce );
+		XmlTest( "Parallel traversal: tasks.", true, traversal.Tasks() > 20 );
+		XmlTest( "Parallel traversal: elements.", serial.elements, parallel.elements );
+		XmlTest( "Parallel traversal: attributes.", serial.attributes, parallel.attributes );
+		XmlTest( "Parallel traversal: text.", (int) serial.bytes, (int) parallel.bytes );
+		XmlTest( "Parallel traversal: reduced in document order.", serial.names, parallel.names );
+
+		Census sub, subParallel;
+		const TiXmlElement* group = root->FirstChildElement()->NextSiblingElement( "Group" )->NextSiblingElement()->NextSiblingElement()->NextSiblingElement();
+		group->Accept( &sub );
+		traversal.SetGrainSize( 4 );
+		traversal.Accept( *group, &subParallel, reduce );
+		XmlTest( "Parallel traversal: a subtree.", true, traversal.Tasks() > 1 && sub.elements == subParallel.elements && sub.names == subParallel.names );
+
+		// A first child too big for one task doesn't make a task of every sibling after it.
+		TiXmlDocument lopsided;
+		TiXmlElement* top = lopsided.LinkEndChild( new TiXmlElement( "Top" ) )->ToElement();
+		TiXmlElement* huge = top->LinkEndChild( new TiXmlElement( "Huge" ) )->ToElement();
+		for( int i = 0; i < 200; ++i )
+			huge->LinkEndChild( new TiXmlElement( "In" ) );
+		for( int i = 0; i < 2000; ++i )
+			top->LinkEndChild( new TiXmlElement( "After" ) );
+		Census lopsidedSerial, lopsidedParallel;
+		lopsided.Accept( &lopsidedSerial );
+		traversal.SetGrainSize( 16 );
+		traversal.Accept( lopsided, &lopsidedParallel, reduce );
+		XmlTest( "Parallel traversal: a big first child.", true, lopsidedSerial.names == lopsidedParallel.names && traversal.Tasks() < 400 );
+
+		Census one;
+		TiXmlParallelTraversal single( 1 );
+		single.SetSerialLimit( 0 );
+		single.Accept( doc, &one, reduce );
+		XmlTest( "Parallel traversal: one thread is serial.", true, single.Tasks() == 0 && one.elements == serial.elements );
+		Census small;
+		TiXmlParallelTraversal defaults( 4 );
+		defaults.Accept( doc, &small, reduce );
+		XmlTest( "Parallel traversal: a small tree is serial.", true, defaults.Tasks() == 0 && small.names == serial.names );
+
+		// A snapshot holds its version for the traversal.
+		TiXmlDoubleBufferedDocument versions( std::move( doc ) );
+		Census snapshot;
+		traversal.Accept( versions.Current(), &snapshot, reduce );
+		XmlTest( "Parallel traversal: a snapshot.", serial.elements, snapshot.elements );
+	}
+
+	{
+		// XPath set: many paths in one walk, each giving what its TiXmlXPath gives.
+		string str =
+			"<?xml version='1.0'?>"
+			"<Orders>"
+				"<Order id='1' status='open'><Item sku='A'>Widget</Item><Item sku='B'>Gadget</Item><Total>10</Total></Order>"
+				"<Order id='2' status='closed'><Item sku='C'>Bolt</Item><Total>5</Total></Order>"
+				"<Order id='3' status='open'><Item sku='A'>Widget</Item><Total>7</Total></Order>"
+				"<Group><Group name='inner'><Order id='4' status='open'><Order id='5'/></Order></Group></Group>"
+			"</Orders>";
+		TiXmlDocument doc;
+		doc.Parse( str.begin(), str.end() );
+
+		auto describe = []( const TiXmlXPathResult& result ) {
+			string out;
+			for( const TiXmlNode* node : result.Nodes() )
+				out += ( out.empty() ? "" : " " ) + node->ValueStr();
+			for( const TiXmlAttribute* attribute : result.Attributes() )
+				out += ( out.empty() ? "" : " " ) + attribute->ValueStr();
+			return out;
+		};
+
+		const char* expressions[] = {
+			"/Orders/Order/@id", "//Order/@id", "/Orders/*", "//Order[@status='open']/Total/text()",
+			"//Order[@status!='open']/@id", "//Order[@status]/@id", "//Order[Item='Bolt']/@id", "/Orders/Order[2]/@id",
+			"//Item[1]/@sku", "/Orders/Order[@status='open'][2]/@id", "/Orders/Order[2]/@*", "//@name",
+			"//Group//Order/@id", "//Group", "//Order//Order", "//Order//@*", "/Orders/Order/Item", "/Orders/Order/Item[2]",
+			"Order/Total/text()", "./Item/text()", "@id", "/", ".", "/Orders/Missing", "//*/Item[@sku='A']"
+		};
+		TiXmlXPathSet set;
+		bool added = true;
+		for( const char* expression : expressions )
+			added = set.Add( expression ) == (int) set.Size() - 1 && added;
+		XmlTest( "XPath set: added in order.", true, added && set.Size() == sizeof( expressions ) / sizeof( expressions[0] ) && set.Expression( 2 ) == "/Orders/*" );
+
+		// From the document, and from inside, where the absolute paths start above.
+		const TiXmlNode* contexts[] = { &doc, doc.RootElement(), doc.RootElement()->FirstChildElement() };
+		vector< TiXmlXPathResult > results;
+		for( const TiXmlNode* context : contexts )
+		{
+			set.Select( context, &results );
+			for( size_t i=0; i<set.Size(); ++i )
+			{
+				TiXmlXPathResult one;
+				TiXmlXPath( expressions[i] ).Select( context, &one );
+				XmlTest( ( string( "XPath set: as alone from " ) + context->Value() + ": " + expressions[i] ).c_str(), describe( one ), describe( results[i] ) );
+			}
+		}
+
+		// The same again, with the moves already worked out, and with one more path.
+		set.Select( &doc, &results );
+		XmlTest( "XPath set: again.", "1 2 3 4 5", describe( results[1] ) );
+		int totals = set.Add( "//Total/text()" );
+		set.Select( &doc, &results );
+		XmlTest( "XPath set: added later.", "10 5 7", describe( results[ totals ] ) );
+		XmlTest( "XPath set: the others still.", "A C A", describe( results[8] ) );
+
+		XmlTest( "XPath set: bad expression.", true, set.Add( "//Order[@status='open'" ) == -1 && set.Error() && set.Size() == (size_t) totals + 1 );
+
+		// Over the pull parser: the matches of each, as TiXmlStreamXPath gives them.
+		const char* streamed[] = {
+			"/Orders/Order/@id", "//Order/Total/text()", "//Order//Order", "//Order//@*", "//Item[1]/@sku",
+			"/Orders/Order[@status='open'][2]/@id", "Orders/Order[3]/./Total/text()", "//Order[@status]/Item/text()"
+		};
+		TiXmlXPathSet stream;
+		for( const char* expression : streamed )
+			stream.Add( expression );
+		vector< string > outs( stream.Size() );
+		TiXmlPullParser parser( str );
+		bool ran = stream.Run( &parser, [&]( TiXmlPullParser* p, size_t query, int attribute ) {
+			string& out = outs[ query ];
+			out += out.empty() ? "" : " ";
+			if ( attribute >= 0 )
+				out += p->AttributeValue( attribute );
+			else
+				out += ( p->Current() == TiXmlPullParser::PULL_TEXT ) ? p->Value() : p->Name();
+			return true;
+		} );
+		XmlTest( "XPath set: run.", true, ran );
+		for( size_t i=0; i<stream.Size(); ++i )
+		{
+			TiXmlStreamXPath one( streamed[i] );
+			TiXmlPullParser oneParser( str );
+			string expected;
+			one.Run( &oneParser, [&]( TiXmlPullParser* p, int attribute ) {
+				expected += expected.empty() ? "" : " ";
+				if ( attribute >= 0 )
+					expected += p->AttributeValue( attribute );
+				else
+					expected += ( p->Current() == TiXmlPullParser::PULL_TEXT ) ? p->Value() : p->Name();
+				return true;
+			} );
+			XmlTest( ( string( "XPath set: as a stream alone: " ) + streamed[i] ).c_str(), expected, outs[i] );
+			XmlTest( ( string( "XPath set: count: " ) + streamed[i] ).c_str(), (int) one.MatchCount(), (int) stream.MatchCount( i ) );
+		}
+
+		// The callback can stop, or read on from an element.
+		istringstream in( str );
+		TiXmlPullParser reading( &in, 16 );
+		size_t stoppedAt = 99;
+		XmlTest( "XPath set: stop.", true, stream.Run( &reading, [&]( TiXmlPullParser*, size_t query, int ) { stoppedAt = query; return false; } ) );
+		XmlTest( "XPath set: first match.", true, stoppedAt == 0 && stream.MatchCount( 0 ) == 1 && stream.MatchCount( 1 ) == 0 );
+		TiXmlXPathSet skipping;
+		skipping.Add( "//Order" );
+		skipping.Add( "//Item" );
+		TiXmlPullParser skipParser( str );
+		int skipped = 0;
+		skipping.Run( &skipParser, [&]( TiXmlPullParser* p, size_t, int ) { skipped += p->SkipElement(); return true; } );
+		XmlTest( "XPath set: callback reads on.", true, skipped == 4 && skipping.MatchCount( 1 ) == 0 );
+
+		TiXmlPullParser again( str );
+		XmlTest( "XPath set: can't stream a test on a child.", true, !set.Run( &again ) && set.Error() );
+		string broken = "<Orders><Order id='1'></Orders>";
+		TiXmlPullParser brokenParser( broken );
+		XmlTest( "XPath set: broken input.", false, skipping.Run( &brokenParser ) );
+	}
+}
+
+
 //
 // This file demonstrates some basic functionality of TinyXml.
 // Note that the example is very contrived. It presumes you know
@@ -94,6 +1999,9 @@ int main()
 	smatch m;
 	auto res=regex_search(str.cbegin(),str.cend(),m, re);
 
+	// The newer features first, while the settings are the defaults.
+	TestExtensions();
+
 	//
 	// We start with the 'demoStart' todo list. Process it. And
 	// should hopefully end up with the todo list as illustrated.
@@ -150,7 +2058,6 @@ int main()
 			}
 			doc.SaveFile();
 		}
-		return 0;
 		TiXmlDocument doc( "demotest.xml" );
 		bool loadOkay = doc.LoadFile();
 
@@ -924,7 +2831,7 @@ int main()
 	{
 		TiXmlDocument doc( "midsummerNightsDreamWithAVeryLongFilenameToConfuseTheStringHandlingRoutines.xml" );
 		bool loadOkay = doc.LoadFile();
-		loadOkay = true;	// get rid of compiler warning.
+		(void) loadOkay;	// get rid of compiler warning.
 		// Won't pass on non-dev systems. Just a "no crash" check.
 		//XmlTest( "Long filename. ", true, loadOkay );
 	}
@@ -958,8 +2865,8 @@ int main()
 		assert( textfile );
 		if ( textfile )
 		{
-			string buf( 1024,'\0' );
-			textfile.getline( buf.data(), buf.size()  );
+			string buf;
+			getline( textfile, buf );
 			XmlTest( "Entity transformation: write. ",
 
 					 "<psg context=\'Line 5 has &quot;quotation marks&quot; and &apos;apostrophe marks&apos;."
@@ -1117,19 +3024,19 @@ int main()
             // Legacy mode test. (This test may only pass on a western system)
             string str =
                         "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>"
-                        "<kl>"
-                        "C"
-                        "</kj>";
+                        "<\xe4>"
+                        "C\xf6nt\xe4nt\xdf\xe4\xf6\xfc\xc4\xd6\xdc"
+                        "</\xe4>";
 
             TiXmlDocument doc;
             doc.Parse( str.begin(),str.end() );
 
             TiXmlHandle docHandle( &doc );
-            TiXmlHandle aHandle = docHandle.FirstChildElement( "C" );
+            TiXmlHandle aHandle = docHandle.FirstChildElement( "\xe4" );
             TiXmlHandle tHandle = aHandle.Child( 0 );
             assert( aHandle.Element() );
             assert( tHandle.Text() );
-            XmlTest( "ISO-8859-1 Parsing.", "Cntnt", tHandle.Text()->Value() );
+            XmlTest( "ISO-8859-1 Parsing.", "C\xf6nt\xe4nt\xdf\xe4\xf6\xfc\xc4\xd6\xdc", tHandle.Text()->Value() );
     }
 
 	{